@@ -1,78 +1,97 @@
-#include "mto_common.h"
-#include "tga.h"
-
-
-int main(int argc, char* argv[])
-{
-	SET_CRTDBG();
-
-	// 引数チェック
-	if (argc <= 1) return 1;
-
-	// 拡張子チェック
-	const char *pStr = strrchr(argv[1], '.');
-	if (pStr == NULL) return 1;
-
-	char ext[8] = {0};
-	strcpy(ext, pStr);
-	if (strcmp(ext, ".tga") != 0 && strcmp(ext, ".TGA") != 0) return 1;
-
-	// TGA作成
-	struct TGA tga;
-	memcls(&tga, sizeof(tga));
-	int ret = tgaCreateFile(&tga, argv[1]);
-
-	if (ret < 0) {
-		switch (ret) {
-			case TGA_ERROR_OPEN:
-				printf("File open error!!\n");
-				break;
-			case TGA_ERROR_MEMORY:
-				printf("Memory alloc error!!\n");
-				break;
-			case TGA_ERROR_HEADER:
-				printf("Not support error!!\n");
-				break;
-			case TGA_ERROR_PALETTE:
-				printf("Not support palette data\n");
-				break;
-			case TGA_ERROR_IMAGE:
-				printf("Not support image data\n");
-				break;
-			case TGA_ERROR_OUTPUT:
-				printf("Output error!!\n");
-				break;
-		}
-	}
-
-	// TGA出力
-	tgaConvertType(&tga, TGA_IMAGE_LINE_RLDU);
-	ret = tgaOutput(&tga, "output.tga");
-	if (ret < 0) {
-		switch (ret) {
-			case TGA_ERROR_OPEN:
-				printf("File open error!!\n");
-				break;
-			case TGA_ERROR_OUTPUT:
-				printf("Output error!!\n");
-				break;
-		}
-	}
-
-	// BMP出力
-//	tga.ConvertRGBA(); // BGR->RGB
-	ret = tgaOutputBMP(&tga, "output.bmp");
-	if (ret < 0) {
-		switch (ret) {
-			case TGA_ERROR_OPEN:
-				printf("File open error!!\n");
-				break;
-			case TGA_ERROR_OUTPUT:
-				printf("Output error!!\n");
-				break;
-		}
-	}
-
-	return 0;
-}
-
+#include "mto_common.h"
+#include "tga.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+
+int main(int argc, char* argv[])
+{
+	SET_CRTDBG();
+
+	// 引数チェック(tgarw 入力 [出力]、"-"なら標準入出力)
+	if (argc <= 1) return 1;
+
+	const bool bStdin  = (strcmp(argv[1], "-") == 0);
+	const char *pOut   = (argc > 2) ? argv[2] : "output.tga";
+	const bool bStdout = (strcmp(pOut, "-") == 0);
+
+	// 拡張子チェック
+	if (!bStdin) {
+		const char *pStr = strrchr(argv[1], '.');
+		if (pStr == NULL) return 1;
+
+		char ext[8] = {0};
+		if (strlen(pStr) >= sizeof(ext)) return 1;
+		strcpy(ext, pStr);
+		if (strcmp(ext, ".tga") != 0 && strcmp(ext, ".TGA") != 0) return 1;
+	}
+
+#if defined(_WIN32)
+	_setmode(_fileno(stdin),  _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+	// TGA作成
+	struct TGA tga;
+	memcls(&tga, sizeof(tga));
+	int fdIn  = 0;
+	int fdOut = 1;
+	int ret = bStdin ? tgaCreateStream(&tga, tgaReadFd, &fdIn) : tgaCreateFile(&tga, argv[1]);
+
+	if (ret < 0) {
+		switch (ret) {
+			case TGA_ERROR_OPEN:
+				fprintf(stderr, "File open error!!\n");
+				break;
+			case TGA_ERROR_MEMORY:
+				fprintf(stderr, "Memory alloc error!!\n");
+				break;
+			case TGA_ERROR_HEADER:
+				fprintf(stderr, "Not support error!!\n");
+				break;
+			case TGA_ERROR_PALETTE:
+				fprintf(stderr, "Not support palette data\n");
+				break;
+			case TGA_ERROR_IMAGE:
+				fprintf(stderr, "Not support image data\n");
+				break;
+			case TGA_ERROR_OUTPUT:
+				fprintf(stderr, "Output error!!\n");
+				break;
+		}
+	}
+
+	// TGA出力
+	tgaConvertType(&tga, TGA_IMAGE_LINE_RLDU);
+	ret = bStdout ? tgaOutputStream(&tga, tgaWriteFd, &fdOut) : tgaOutput(&tga, pOut);
+	if (ret < 0) {
+		switch (ret) {
+			case TGA_ERROR_OPEN:
+				fprintf(stderr, "File open error!!\n");
+				break;
+			case TGA_ERROR_OUTPUT:
+				fprintf(stderr, "Output error!!\n");
+				break;
+		}
+	}
+
+	// BMP出力
+//	tga.ConvertRGBA(); // BGR->RGB
+	ret = bStdout ? TGA_ERROR_NONE : tgaOutputBMP(&tga, "output.bmp");
+	if (ret < 0) {
+		switch (ret) {
+			case TGA_ERROR_OPEN:
+				fprintf(stderr, "File open error!!\n");
+				break;
+			case TGA_ERROR_OUTPUT:
+				fprintf(stderr, "Output error!!\n");
+				break;
+		}
+	}
+
+	return 0;
+}
+
@@ -1,743 +1,1143 @@
-#include "mto_common.h"
-#include "tga.h"
-
-/*=======================================================================
-【機能】RLE圧縮解凍
-【引数】pTga：TGA構造体のアドレス
-        pDst：展開先
-        pSrc：画像データアドレス
-        size：画像データサイズ
-【備考】非公開
- =======================================================================*/
-uint32 _tgaUnpackRLE(struct TGA *pTga, uint8 *pDst, const uint8 *pSrc, const uint32 size)
-{
-#ifndef NDEBUG
-	_ASSERT(pSrc != NULL);
-	_ASSERT(pDst != NULL);
-#else
-	if (pSrc == NULL || pDst == NULL) return false;
-#endif
-
-	bool bFlg;
-	uint16 loop;
-	uint32 offset  = 0;
-	uint32 count   = 0;
-
-	uint8 byte = pTga->header.imageBit >> 3; // バイトサイズ
-
-	while (count < pTga->imageSize) {
-		bFlg = (pSrc[offset] & 0x80) ? false : true; // 上位ビットが0ならリテラルグループ
-		loop = (pSrc[offset] & 0x7f) + 1;
-		offset++;
-
-		if (bFlg) {
-			// リテラルグループ
-			// 制御バイトの後ろ（pSrc[offset] & 0x7f)+1個のデータ（ピクセルバイト単位）をコピーする
-			for (uint16 i = 0; i < loop; i++) {
-				for (uint32 j = 0; j < byte; j++) {
-					pDst[count++] = pSrc[offset++];
-				}
-			}
-		} else {
-			// 反復
-			// 次に続くデータバイト（ピクセルバイト単位）を（pSrc[offset] & 0x7f)+1回繰り返す
-			for (uint16 i = 0; i < loop; i++) {
-				for (uint32 j = 0; j < byte; j++) {
-					pDst[count++] = pSrc[offset + j];
-				}
-			}
-			offset += byte;
-		}
-
-		// 解凍のしすぎチェック
-		if (offset > size) {
-			DBG_PRINT("UnpackRLE error!!\n");
-			_ASSERT(0);
-			return -1;
-		}
-	}
-
-	_ASSERT(count == pTga->imageSize);
-
-	return offset;
-}
-
-/*=======================================================================
-【機能】対応チェック
-【引数】pHeader：TGAヘッダーアドレス
-【備考】非公開
- =======================================================================*/
-bool _tgaCheckSupport(const struct TGAHeader *pHeader)
-{
-#ifndef NDEBUG
-	_ASSERT(pHeader != NULL);
-#else
-	if (pHeader == NULL) return false;
-#endif
-
-	// 原点が0ではない？
-	if (pHeader->imageX != 0 && pHeader->imageY != 0) return false;
-	
-	// 対応していないイメージタイプ？
-	if (!((TGA_IMAGE_TYPE_NONE < pHeader->imageType && pHeader->imageType < TGA_IMAGE_TYPE_MAX) ||
-		  (TGA_IMAGE_TYPE_INDEX_RLE <= pHeader->imageType && pHeader->imageType < TGA_IMAGE_TYPE_RLE_MAX))) {
-		return false;
-	}
-
-	// 対応ビット？
-	if (pHeader->imageBit !=  8 && pHeader->imageBit != 16 &&
-		pHeader->imageBit != 24 && pHeader->imageBit != 32) {
-		return false;
-	}
-
-	// 対応パレット？
-	if (pHeader->usePalette) {
-		if (pHeader->paletteIndex != 0) return false;
-		if (pHeader->paletteBit != 24 && pHeader->paletteBit != 32) return false;
-	}
-
-	return true;
-}
-
-/*=======================================================================
-【機能】TGAヘッダー読み込み
-【引数】pSrc   ：画像データアドレス
-        pHeader：TGAヘッダーアドレス
-【備考】非公開
- =======================================================================*/
-bool _tgaReadHeader(const uint8 *pSrc, struct TGAHeader *pHeader)
-{
-#ifndef NDEBUG
-	_ASSERT(pSrc != NULL);
-	_ASSERT(pHeader != NULL);
-#else
-	if (pSrc == NULL || pHeader == NULL) return false;
-#endif
-
-	uint32 offset = 0;
-
-	pHeader->IDField      = pSrc[offset++];
-	pHeader->usePalette   = pSrc[offset++];
-	pHeader->imageType    = pSrc[offset++];
-	pHeader->paletteIndex = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
-	pHeader->paletteColor = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
-	pHeader->paletteBit   = pSrc[offset++];
-	pHeader->imageX       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
-	pHeader->imageY       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
-	pHeader->imageW       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
-	pHeader->imageH       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
-	pHeader->imageBit     = pSrc[offset++];
-	pHeader->discripter   = pSrc[offset++];
-
-	_ASSERT(offset == TGA_HEADER_SIZE);
-
-	return _tgaCheckSupport(pHeader);
-}
-
-/*=======================================================================
-【機能】TGAフッター読み込み
-【引数】pSrc　 ：画像データアドレス
-        offset ：フッターまでのオフセット
-		pFooter：TGAフッターアドレス
-【備考】非公開
- =======================================================================*/
-void _tgaReadFooter(const uint8 *pSrc, const uint32 offset, struct TGAFooter *pFooter)
-{
-#ifndef NDEBUG
-	_ASSERT(pSrc != NULL);
-	_ASSERT(pFooter != NULL);
-#else
-	if (pSrc == NULL || pFooter == NULL) return;
-#endif
-
-	uint32 offs = offset;
-
-	memcpy(&pFooter->filePos, &pSrc[offs], sizeof(pFooter->filePos)); offs += sizeof(pFooter->filePos);
-	memcpy(&pFooter->fileDev, &pSrc[offs], sizeof(pFooter->fileDev)); offs += sizeof(pFooter->fileDev);
-	memcpy(pFooter->version,  &pSrc[offs], sizeof(pFooter->version)); offs += sizeof(pFooter->version);
-
-	_ASSERT((offs - offset) == TGA_FOOTER_SIZE);
-}
-
-/*=======================================================================
-【機能】Image/Paletteサイズを求める
-【引数】pTga：TGA構造体アドレス
-        bFlg：メモリ確保を行う？
-【備考】非公開
- =======================================================================*/
-bool _tgaCalcSize(struct TGA *pTga, const bool bFlg)
-{
-	pTga->imageSize   = pTga->header.imageW * pTga->header.imageH * (pTga->header.imageBit >> 3);
-	pTga->paletteSize = pTga->header.usePalette * pTga->header.paletteColor * (pTga->header.paletteBit >> 3);
-
-	if (bFlg) {
-		if ((pTga->pImage = (uint8*)malloc(pTga->imageSize)) == NULL) return false;
-
-		// パレットありならメモリ確保
-		if (pTga->header.usePalette) {
-			if ((pTga->pPalette = (uint8*)malloc(pTga->paletteSize)) == NULL) return false;
-		}
-	}
-
-	return true;
-}
-
-/*=======================================================================
-【機能】Image読み込み
-【引数】pTga  ：TGA構造体のアドレス
-        pSrc  ：画像データアドレス
-        size  ：画像データサイズ
-        offset：保存先元イメージサイズ（RLEの場合は圧縮時のサイズ）
-【備考】非公開
- =======================================================================*/
-bool _tgaReadImage(struct TGA *pTga, const uint8 *pSrc, const uint32 size, uint32 *pOffset)
-{
-#ifndef NDEBUG
-	_ASSERT(pSrc != NULL);
-	_ASSERT(pTga != NULL);
-	_ASSERT(pTga->pImage != NULL);
-#else
-	if (pSrc == NULL || pTga == NULL || pTga->pImage == NULL) return false;
-#endif
-
-	uint8 *pWork  = (uint8*)pSrc + TGA_HEADER_SIZE + pTga->header.IDField + pTga->paletteSize;
-	uint8 *pImage = pTga->pImage;
-	uint32 offset = 0;
-
-	if (TGA_IMAGE_TYPE_INDEX_RLE <= pTga->header.imageType && pTga->header.imageType < TGA_IMAGE_TYPE_RLE_MAX) {
-		// RLE圧縮
-		offset = _tgaUnpackRLE(pTga, pImage, pWork, size);
-		if (offset == (uint32)(-1)) return false;
-	} else {
-		// 非圧縮
-		memcpy(pImage, pWork, pTga->imageSize);
-		offset = pTga->imageSize;
-	}
-
-	if (pOffset != NULL) *pOffset = offset;
-
-	return true;
-}
-
-/*=======================================================================
-【機能】Palette読み込み
-【引数】pTga：TGA構造体のアドレス
-        pSrc：画像データアドレス
-【備考】非公開
- =======================================================================*/
-bool _tgaReadPalette(struct TGA *pTga, const uint8 *pSrc)
-{
-#ifndef NDEBUG
-	_ASSERT(pSrc != NULL);
-	_ASSERT(pTga != NULL);
-#else
-	if (pSrc == NULL || pTga == NULL) return false;
-#endif
-
-	// IndexColor?
-	if (pTga->header.imageType != TGA_IMAGE_TYPE_INDEX && pTga->header.imageType != TGA_IMAGE_TYPE_INDEX_RLE) {
-		return true;
-	}
-
-	// Palette OK?
-	if (pTga->pPalette == NULL) return false;
-
-	uint8 *pWork = (uint8*)pSrc + TGA_HEADER_SIZE + pTga->header.IDField;
-	uint8 *pPalette = pTga->pPalette;
-	uint16 i; // VC6.0ではコンパイルが通らないので外に出す
-
-	switch (pTga->header.paletteBit) {
-	case 24:
-		for (i = 0; i < pTga->header.paletteColor; i++) {
-			*pPalette++ = *pWork++;
-			*pPalette++ = *pWork++;
-			*pPalette++ = *pWork++;
-		}
-		break;
-	case 32:
-		for (i = 0; i < pTga->header.paletteColor; i++) {
-			*pPalette++ = *pWork++;
-			*pPalette++ = *pWork++;
-			*pPalette++ = *pWork++;
-			*pPalette++ = *pWork++;
-		}
-		break;
-	default:
-		DBG_PRINT("not support palette data!!\n");
-		return false;
-	}
-
-	return true;
-}
-
-
-
-
-/*=======================================================================
-【機能】ファイル読み込み
-【引数】pTga     ： TGA構造体のアドレス
-        pFileName：ファイル名
- =======================================================================*/
-int tgaCreateFile(struct TGA *pTga, const char *pFileName)
-{
-	FILE *fp;
-	uint8 *mem;
-	uint32 size;
-
-#ifndef NDEBUG
-	_ASSERT(pTga != NULL);
-	_ASSERT(pFileName != NULL);
-#else
-	if (pTga == NULL || pFileName == NULL) return TGA_ERROR_OPEN;
-#endif
-
-	if ((fp = fopen(pFileName, "rb")) == NULL) {
-		DBG_PRINT("file not found!\n");
-		return TGA_ERROR_OPEN;
-	}
-
-	// get file size
-	fseek(fp, 0, SEEK_END);
-	size = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
-
-	// read file to memory
-	if ((mem = (uint8*)malloc(size)) == NULL) {
-		fclose(fp);
-		return TGA_ERROR_MEMORY;
-	}
-	fread(mem, size, 1, fp);
-	fclose(fp);
-
-	// 読み込み
-	int ret = tgaCreateMemory(pTga, mem, size);
-	SAFE_FREE(mem);
-
-	return ret;
-}
-
-/*=======================================================================
-【機能】メモリから作成
-【引数】pTga：TGA構造体のアドレス
-        pSrc：画像データアドレス
-        size：画像データサイズ
- =======================================================================*/
-int tgaCreateMemory(struct TGA *pTga, const void *pSrc, const uint32 size)
-{
-	uint32 offset;
-
-#ifndef NDEBUG
-	_ASSERT(pTga != NULL);
-	_ASSERT(pSrc != NULL);
-	_ASSERT(size);
-#else
-	if (pTga == NULL || pSrc == NULL || size == 0) return TGA_ERROR_HEADER;
-#endif
-
-	// 既に作成しているなら削除
-	if (pTga->pImage != NULL) {
-		tgaRelease(pTga);
-	}
-
-	// ヘッダー読み込み
-	if (!_tgaReadHeader((const uint8*)pSrc, &pTga->header)) {
-		return TGA_ERROR_HEADER;
-	}
-
-	// ImageとPaletteのサイズを求める
-	if (!_tgaCalcSize(pTga, true)) {
-		tgaRelease(pTga);
-		return TGA_ERROR_MEMORY;
-	}
-
-	// パレット読み込み
-	if (!_tgaReadPalette(pTga, (const uint8*)pSrc)) {
-		tgaRelease(pTga);
-		return TGA_ERROR_PALETTE;
-	}
-
-	// イメージ読み込み
-	if (!_tgaReadImage(pTga, (const uint8*)pSrc, size, &offset)) {
-		tgaRelease(pTga);
-		return TGA_ERROR_IMAGE;
-	}
-
-	// フッター読み込み
-	offset += TGA_HEADER_SIZE + pTga->header.IDField + pTga->paletteSize;
-	if ((size - offset) >= TGA_FOOTER_SIZE) {
-		_tgaReadFooter((const uint8*)pSrc, offset, &pTga->footer);
-	}
-
-	return TGA_ERROR_NONE;
-}
-
-/*=======================================================================
-【機能】指定データから作成
-【引数】pTga       ：TGA構造体のアドレス
-        pHeader    ：TGAヘッダーのアドレス
-        pImage     ：イメージデータアドレス
-        imageSize  ：イメージデータサイズ
-        pPalette   ：パレットデータアドレス
-        paletteSize：パレットデータサイズ
- =======================================================================*/
-int tgaCreateHeader(struct TGA *pTga, const struct TGAHeader *pHeader, uint8 *pImage, const uint32 imageSize, uint8 *pPalette, const uint32 paletteSize)
-{
-	// 引数チェック
-	if (pTga == NULL) return TGA_ERROR_IMAGE;
-	if (pImage == NULL || imageSize == 0) return TGA_ERROR_IMAGE;
-	if (pPalette != NULL && paletteSize == 0) return TGA_ERROR_PALETTE;
-	if (pPalette == NULL && paletteSize != 0) return TGA_ERROR_PALETTE;
-
-	// ヘッダーチェック
-	if (!_tgaCheckSupport(pHeader)) return TGA_ERROR_HEADER;
-
-	// 既に作成しているなら削除
-	if (pTga->pImage != NULL) {
-		tgaRelease(pTga);
-	}
-
-	memcpy(&pTga->header, pHeader, sizeof(pTga->header));
-	pTga->pImage      = pImage;
-	pTga->imageSize   = imageSize;
-	pTga->pPalette    = pPalette;
-	pTga->paletteSize = paletteSize;
-
-	return TGA_ERROR_NONE;
-}
-
-/*=======================================================================
-【機能】ファイル出力
-【引数】pTga     ：TGA構造体のアドレス
-        pFileName：出力ファイル名
- =======================================================================*/
-int tgaOutput(struct TGA *pTga, const char *pFileName)
-{
-#ifndef NDEBUG
-	_ASSERT(pTga != NULL);
-	_ASSERT(pFileName != NULL);
-#else
-	if (pTga == NULL || pFileName == NULL) return TGA_ERROR_OUTPUT;
-#endif
-
-	// 読み込まれていない？
-	if (pTga->pImage == NULL) return TGA_ERROR_NONE;
-
-	// 出力ファイルオープン
-	FILE *fp;
-	if ((fp = fopen(pFileName, "wb")) == NULL) {
-		DBG_PRINT("file can't open!\n");
-		return TGA_ERROR_OPEN;
-	}
-
-	// ヘッダー出力
-	tgaWriteHeader(fp, &pTga->header);
-
-	// パレット出力
-	if (pTga->pPalette != NULL) {
-		fwrite(pTga->pPalette, pTga->paletteSize, 1, fp);
-	}
-
-	// イメージ出力
-	fwrite(pTga->pImage, pTga->imageSize, 1, fp);
-
-	// フッター出力
-	tgaWriteFooter(fp, &pTga->footer);
-
-	fclose(fp);
-
-	return TGA_ERROR_NONE;
-}
-
-/*=======================================================================
-【機能】BMP出力
-【引数】pTga     ：TGA構造体のアドレス
-        pFileName：出力ファイル名
- =======================================================================*/
-int tgaOutputBMP(struct TGA *pTga, const char *pFileName)
-{
-#ifndef NDEBUG
-	_ASSERT(pTga != NULL);
-	_ASSERT(pFileName != NULL);
-#else
-	if (pTga == NULL) return TGA_ERROR_IMAGE;
-	if (pFileName == NULL) return TGA_ERROR_OUTPUT;
-#endif
-
-	// 読み込まれていない？
-	if (pTga->pImage == NULL) return TGA_ERROR_NONE;
-
-	// 出力ファイルオープン
-	FILE *fp;
-	if ((fp = fopen(pFileName, "wb")) == NULL) {
-		DBG_PRINT("file can't open!\n");
-		return TGA_ERROR_OPEN;
-	}
-
-	// BMPヘッダー作成
-	uint32 hsize, isize, psize;
-	BITMAPFILEHEADER bmHead;
-	BITMAPINFOHEADER bmInfo;
-
-	memset(&bmHead, 0, sizeof(bmHead));
-	memset(&bmInfo, 0, sizeof(bmInfo));
-
-	hsize = sizeof(BITMAPFILEHEADER);
-	isize = sizeof(BITMAPINFOHEADER);
-	psize = sizeof(RGBQUAD) * pTga->header.paletteColor;
-
-	bmHead.bfType = 0x4D42; //BM
-	bmHead.bfSize = pTga->imageSize + hsize + isize + psize;
-	bmHead.bfReserved1 = 0;
-	bmHead.bfReserved2 = 0;
-	bmHead.bfOffBits   = hsize + isize + psize;
-
-	bmInfo.biSize   = isize;
-	bmInfo.biWidth  = pTga->header.imageW;
-	bmInfo.biHeight = pTga->header.imageH;
-	bmInfo.biPlanes = 1;
-	bmInfo.biBitCount = pTga->header.imageBit;
-
-
-	// ヘッダー出力
-	fwrite(&bmHead, hsize, 1, fp);
-	fwrite(&bmInfo, isize, 1, fp);
-
-	// パレット出力
-	if (pTga->pPalette != NULL) {
-		if (pTga->header.paletteBit == 24) {
-			uint8 *pPalette = pTga->pPalette;
-			uint8 alpha = 0x00;
-
-			for (int i = 0; i < pTga->header.paletteColor; i++) {
-				fwrite(pPalette++, sizeof(uint8), 1, fp);
-				fwrite(pPalette++, sizeof(uint8), 1, fp);
-				fwrite(pPalette++, sizeof(uint8), 1, fp);
-				fwrite(&alpha    , sizeof(uint8), 1, fp);
-			}
-		} else {
-			fwrite(pTga->pPalette, pTga->paletteSize, 1, fp);
-		}
-	}
-
-	// イメージ出力（幅が4で割れない画像への対応はしていません）
-	tgaConvertType(pTga, TGA_IMAGE_LINE_LRDU); // 左→右、下→上配列に変換
-	fwrite(pTga->pImage, pTga->imageSize, 1, fp);
-
-	fclose(fp);
-
-	return TGA_ERROR_NONE;
-}
-
-/*=======================================================================
-【機能】BGRA配列をRGBA配列に変更
-【引数】pTga：TGA構造体のアドレス
-【備考】RGBAに変更したあと再度呼ぶとBGRA配列になります。
- =======================================================================*/
-bool tgaConvertRGBA(struct TGA *pTga)
-{
-	if (pTga == NULL || pTga->pImage == NULL) return false;
-
-	uint8 r, b;
-	uint8 byte;
-	uint32 offset;
-
-	// パレット
-	if (pTga->pPalette) {
-		byte = pTga->header.paletteBit >> 3;
-
-		for (offset = 0; offset < pTga->paletteSize; offset += byte) {
-			r = pTga->pPalette[offset + 2];
-			b = pTga->pPalette[offset + 0];
-			pTga->pPalette[offset + 2] = b;
-			pTga->pPalette[offset + 0] = r;
-		}
-	}
-
-	// イメージ
-	byte = pTga->header.imageBit >> 3;
-
-	if (pTga->header.imageBit <= 8) {
-		// IndexColorなら処理しない
-		return true;
-	} else if (pTga->header.imageBit == 16) {
-		uint16 r, g, b, a;
-		uint16 *pImage = (uint16*)pTga->pImage;
-
-		// RGBA:5551
-		for (offset = 0; offset < pTga->imageSize; offset += byte) {
-			a = (*pImage & 0x8000);
-			r = (*pImage & 0x7c00) >> 10;
-			g = (*pImage & 0x03e0);
-			b = (*pImage & 0x001f) << 10;
-			*pImage++ = (a | r | g | b);
-		}
-	} else {
-		for (offset = 0; offset < pTga->imageSize; offset += byte) {
-			r = pTga->pImage[offset + 2];
-			b = pTga->pImage[offset + 0];
-			pTga->pImage[offset + 2] = b;
-			pTga->pImage[offset + 0] = r;
-		}
-	}
-
-	return true;
-}
-
-/*=======================================================================
-【機能】指定のビット配列に変換
-【引数】pTga：TGA構造体のアドレス
-        type：ラインタイプ
- =======================================================================*/
-bool tgaConvertType(struct TGA *pTga, const sint32 type)
-{
-	if (type >= TGA_IMAGE_LINE_MAX) return false;
-	if (pTga == NULL || pTga->pImage == NULL) return false;
-
-	// 一緒なら処理なし
-	if ((pTga->header.discripter & 0xf0) == type) return true;
-
-	uint8 *pImage;
-
-	// 変換用のメモリ確保
-	if ((pImage = (uint8*)malloc(pTga->imageSize)) == NULL) {
-		return false;
-	}
-
-	// 配列変換
-	uint16 tx, ty;
-	uint32 ofsSrc, ofsDst;
-
-	ofsDst = 0;
-	for (int y = 0; y < pTga->header.imageH; y++) {
-		ty = y;
-		if ((pTga->header.discripter & 0x20) != (type & 0x20)) {
-			// お互いのY方向が一致しないなら反転
-			ty = pTga->header.imageH - y - 1;
-		}
-
-		for (int x = 0; x < pTga->header.imageW; x++) {
-			tx = x;
-			if ((pTga->header.discripter & 0x10) != (type & 0x10)) {
-				// お互いのX方向が一致しないなら反転
-				tx = pTga->header.imageW - x - 1;
-			}
-			ofsSrc = (ty * pTga->header.imageW) + tx;
-
-			if (pTga->header.imageBit == 8) {
-				pImage[ofsDst++] = pTga->pImage[ofsSrc];
-
-			} else if (pTga->header.imageBit == 16) {
-				uint16 *pSrc = (uint16*)pTga->pImage;
-				uint16 *pDst = (uint16*)pImage;
-				pDst[ofsDst++] = pSrc[ofsSrc];
-
-			} else if (pTga->header.imageBit == 24) {
-				ofsSrc *= 3;
-				pImage[ofsDst++] = pTga->pImage[ofsSrc++];
-				pImage[ofsDst++] = pTga->pImage[ofsSrc++];
-				pImage[ofsDst++] = pTga->pImage[ofsSrc++];
-
-			} else if (pTga->header.imageBit == 32) {
-				ofsSrc *= 4;
-				pImage[ofsDst++] = pTga->pImage[ofsSrc++];
-				pImage[ofsDst++] = pTga->pImage[ofsSrc++];
-				pImage[ofsDst++] = pTga->pImage[ofsSrc++];
-				pImage[ofsDst++] = pTga->pImage[ofsSrc++];
-			}
-		}
-	}
-
-	// 元を破棄して変換後のデータを保持
-	SAFE_FREE(pTga->pImage);
-	pTga->pImage = pImage;
-
-	// イメージ記述子を変更
-	pTga->header.discripter = type;
-
-	return true;
-}
-
-/*=======================================================================
-【機能】構造体情報の解放
-【引数】pTga：TGA構造体のアドレス
- =======================================================================*/
-void tgaRelease(struct TGA *pTga)
-{
-	SAFE_FREE(pTga->pImage);
-	SAFE_FREE(pTga->pPalette);
-
-	memset(&pTga->header, 0, sizeof(pTga->header));
-	memset(&pTga->footer, 0, sizeof(pTga->footer));
-
-	pTga->imageSize   = 0;
-	pTga->paletteSize = 0;
-}
-
-/*=======================================================================
-【機能】TGAヘッダー出力
-【引数】fp     ：FILEポインタ
-        pHeader：出力するTGAヘッダー
-【備考】アライメントに沿っていないので個別出力。
- =======================================================================*/
-bool tgaWriteHeader(FILE *fp, struct TGAHeader *pHeader)
-{
-#ifndef NDEBUG
-	_ASSERT(fp != NULL);
-	_ASSERT(pHeader != NULL);
-#else
-	if (fp == NULL || pHeader == NULL) return false;
-#endif
-
-	// TODO:RLE圧縮出力対応
-	//      2008/04/01時点では非対応
-	if (TGA_IMAGE_TYPE_INDEX_RLE <= pHeader->imageType && pHeader->imageType < TGA_IMAGE_TYPE_RLE_MAX) {
-		pHeader->imageType -= 8; // 非圧縮にする
-	}
-
-	fwrite(&pHeader->IDField     , sizeof(pHeader->IDField)     , 1, fp);
-	fwrite(&pHeader->usePalette  , sizeof(pHeader->usePalette)  , 1, fp);
-	fwrite(&pHeader->imageType   , sizeof(pHeader->imageType)   , 1, fp);
-	fwrite(&pHeader->paletteIndex, sizeof(pHeader->paletteIndex), 1, fp);
-	fwrite(&pHeader->paletteColor, sizeof(pHeader->paletteColor), 1, fp);
-	fwrite(&pHeader->paletteBit  , sizeof(pHeader->paletteBit)  , 1, fp);
-	fwrite(&pHeader->imageX      , sizeof(pHeader->imageX)      , 1, fp);
-	fwrite(&pHeader->imageY      , sizeof(pHeader->imageY)      , 1, fp);
-	fwrite(&pHeader->imageW      , sizeof(pHeader->imageW)      , 1, fp);
-	fwrite(&pHeader->imageH      , sizeof(pHeader->imageH)      , 1, fp);
-	fwrite(&pHeader->imageBit    , sizeof(pHeader->imageBit)    , 1, fp);
-	fwrite(&pHeader->discripter  , sizeof(pHeader->discripter)  , 1, fp);
-
-	return true;
-}
-
-/*=======================================================================
-【機能】TGAフッター出力
-【引数】fp     ：FILEポインタ
-        pHeader：出力するTGAフッター
-【備考】アライメントに沿っていないので個別出力。
- =======================================================================*/
-bool tgaWriteFooter(FILE *fp, struct TGAFooter *pFooter)
-{
-#ifndef NDEBUG
-	_ASSERT(fp != NULL);
-	_ASSERT(pFooter != NULL);
-#else
-	if (fp == NULL || pFooter == NULL) return false;
-#endif
-
-	// 元画像にフッターが付いていたかチェック
-	int ret = 0;
-	for (int i = 0; i < 18; i++) {
-		ret += pFooter->version[i];
-	}
-
-	fwrite(&pFooter->filePos, sizeof(pFooter->filePos), 1, fp);
-	fwrite(&pFooter->fileDev, sizeof(pFooter->fileDev), 1, fp);
-
-	if (ret == 0) {
-		strcpy((char*)pFooter->version, "TRUEVISION-TARGA");
-	}
-	fwrite(pFooter->version, sizeof(pFooter->version), 1, fp);
-
-	return true;
-}
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+
+#include <errno.h>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// ストリーム読み込み
+struct TGAReader {
+	TGAReadFunc	func;
+	void		*pUser;
+	uint8		*pBuffer;
+	uint32		pos;			// バッファ内の読み込み位置
+	uint32		end;			// バッファ内のデータの終わり
+	bool		bEnd;			// 終わりまで読んだ？
+};
+
+// ストリーム書き込み
+struct TGAWriter {
+	TGAWriteFunc	func;
+	void			*pUser;
+	uint8			*pBuffer;
+	uint32			size;		// バッファ内のデータサイズ
+	bool			bError;		// 書き込みに失敗した？
+};
+
+/*=======================================================================
+【機能】RLE圧縮解凍
+【引数】pTga：TGA構造体のアドレス
+        pDst：展開先
+        pSrc：圧縮データアドレス
+        size：圧縮データサイズ
+【戻値】読み込んだ圧縮データのサイズ(失敗なら0xffffffff)
+【備考】非公開
+        展開はカーネル(C++版と共通)で行う。
+ =======================================================================*/
+uint32 _tgaUnpackRLE(struct TGA *pTga, uint8 *pDst, const uint8 *pSrc, const uint32 size)
+{
+#ifndef NDEBUG
+	_ASSERT(pSrc != NULL);
+	_ASSERT(pDst != NULL);
+#else
+	if (pSrc == NULL || pDst == NULL) return (uint32)(-1);
+#endif
+
+	const uint32 offset = TgaKernelUnpackRLE(pDst, pTga->imageSize, pSrc, size, pTga->header.imageBit >> 3);
+
+	// 解凍のしすぎチェック
+	if (offset == (uint32)(-1)) {
+		DBG_PRINT("UnpackRLE error!!\n");
+	}
+
+	return offset;
+}
+
+/*=======================================================================
+【機能】対応チェック
+【引数】pHeader：TGAヘッダーアドレス
+【備考】非公開
+ =======================================================================*/
+bool _tgaCheckSupport(const struct TGAHeader *pHeader)
+{
+#ifndef NDEBUG
+	_ASSERT(pHeader != NULL);
+#else
+	if (pHeader == NULL) return false;
+#endif
+
+	// 原点が0ではない？
+	if (pHeader->imageX != 0 && pHeader->imageY != 0) return false;
+	
+	// 対応していないイメージタイプ？
+	if (!((TGA_IMAGE_TYPE_NONE < pHeader->imageType && pHeader->imageType < TGA_IMAGE_TYPE_MAX) ||
+		  (TGA_IMAGE_TYPE_INDEX_RLE <= pHeader->imageType && pHeader->imageType < TGA_IMAGE_TYPE_RLE_MAX))) {
+		return false;
+	}
+
+	// 対応ビット？
+	if (pHeader->imageBit !=  8 && pHeader->imageBit != 16 &&
+		pHeader->imageBit != 24 && pHeader->imageBit != 32) {
+		return false;
+	}
+
+	// 対応パレット？
+	if (pHeader->usePalette) {
+		if (pHeader->paletteIndex != 0) return false;
+		if (pHeader->paletteBit != 24 && pHeader->paletteBit != 32) return false;
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】TGAヘッダー読み込み
+【引数】pSrc   ：画像データアドレス
+        pHeader：TGAヘッダーアドレス
+【備考】非公開
+ =======================================================================*/
+bool _tgaReadHeader(const uint8 *pSrc, struct TGAHeader *pHeader)
+{
+#ifndef NDEBUG
+	_ASSERT(pSrc != NULL);
+	_ASSERT(pHeader != NULL);
+#else
+	if (pSrc == NULL || pHeader == NULL) return false;
+#endif
+
+	uint32 offset = 0;
+
+	pHeader->IDField      = pSrc[offset++];
+	pHeader->usePalette   = pSrc[offset++];
+	pHeader->imageType    = pSrc[offset++];
+	pHeader->paletteIndex = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
+	pHeader->paletteColor = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
+	pHeader->paletteBit   = pSrc[offset++];
+	pHeader->imageX       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
+	pHeader->imageY       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
+	pHeader->imageW       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
+	pHeader->imageH       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
+	pHeader->imageBit     = pSrc[offset++];
+	pHeader->discripter   = pSrc[offset++];
+
+	_ASSERT(offset == TGA_HEADER_SIZE);
+
+	return _tgaCheckSupport(pHeader);
+}
+
+/*=======================================================================
+【機能】TGAフッター読み込み
+【引数】pSrc　 ：画像データアドレス
+        offset ：フッターまでのオフセット
+		pFooter：TGAフッターアドレス
+【備考】非公開
+ =======================================================================*/
+void _tgaReadFooter(const uint8 *pSrc, const uint32 offset, struct TGAFooter *pFooter)
+{
+#ifndef NDEBUG
+	_ASSERT(pSrc != NULL);
+	_ASSERT(pFooter != NULL);
+#else
+	if (pSrc == NULL || pFooter == NULL) return;
+#endif
+
+	uint32 offs = offset;
+
+	memcpy(&pFooter->filePos, &pSrc[offs], sizeof(pFooter->filePos)); offs += sizeof(pFooter->filePos);
+	memcpy(&pFooter->fileDev, &pSrc[offs], sizeof(pFooter->fileDev)); offs += sizeof(pFooter->fileDev);
+	memcpy(pFooter->version,  &pSrc[offs], sizeof(pFooter->version)); offs += sizeof(pFooter->version);
+
+	_ASSERT((offs - offset) == TGA_FOOTER_SIZE);
+}
+
+/*=======================================================================
+【機能】Image/Paletteサイズを求める
+【引数】pTga：TGA構造体アドレス
+        bFlg：メモリ確保を行う？
+【備考】非公開
+ =======================================================================*/
+bool _tgaCalcSize(struct TGA *pTga, const bool bFlg)
+{
+	pTga->imageSize   = pTga->header.imageW * pTga->header.imageH * (pTga->header.imageBit >> 3);
+	pTga->paletteSize = pTga->header.usePalette * pTga->header.paletteColor * (pTga->header.paletteBit >> 3);
+
+	if (bFlg) {
+		if ((pTga->pImage = (uint8*)malloc(pTga->imageSize)) == NULL) return false;
+
+		// パレットありならメモリ確保
+		if (pTga->header.usePalette) {
+			if ((pTga->pPalette = (uint8*)malloc(pTga->paletteSize)) == NULL) return false;
+		}
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】Image読み込み
+【引数】pTga  ：TGA構造体のアドレス
+        pSrc  ：画像データアドレス
+        size  ：画像データサイズ
+        offset：保存先元イメージサイズ（RLEの場合は圧縮時のサイズ）
+【備考】非公開
+ =======================================================================*/
+bool _tgaReadImage(struct TGA *pTga, const uint8 *pSrc, const uint32 size, uint32 *pOffset)
+{
+#ifndef NDEBUG
+	_ASSERT(pSrc != NULL);
+	_ASSERT(pTga != NULL);
+	_ASSERT(pTga->pImage != NULL);
+#else
+	if (pSrc == NULL || pTga == NULL || pTga->pImage == NULL) return false;
+#endif
+
+	uint8 *pWork  = (uint8*)pSrc + TGA_HEADER_SIZE + pTga->header.IDField + pTga->paletteSize;
+	uint8 *pImage = pTga->pImage;
+	uint32 offset = 0;
+
+	if (TGA_IMAGE_TYPE_INDEX_RLE <= pTga->header.imageType && pTga->header.imageType < TGA_IMAGE_TYPE_RLE_MAX) {
+		// RLE圧縮
+		const uint32 head = TGA_HEADER_SIZE + pTga->header.IDField + pTga->paletteSize;
+		if (size < head) return false;
+
+		offset = _tgaUnpackRLE(pTga, pImage, pWork, size - head);
+		if (offset == (uint32)(-1)) return false;
+	} else {
+		// 非圧縮
+		memcpy(pImage, pWork, pTga->imageSize);
+		offset = pTga->imageSize;
+	}
+
+	if (pOffset != NULL) *pOffset = offset;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】Palette読み込み
+【引数】pTga：TGA構造体のアドレス
+        pSrc：画像データアドレス
+【備考】非公開
+ =======================================================================*/
+bool _tgaReadPalette(struct TGA *pTga, const uint8 *pSrc)
+{
+#ifndef NDEBUG
+	_ASSERT(pSrc != NULL);
+	_ASSERT(pTga != NULL);
+#else
+	if (pSrc == NULL || pTga == NULL) return false;
+#endif
+
+	// IndexColor?
+	if (pTga->header.imageType != TGA_IMAGE_TYPE_INDEX && pTga->header.imageType != TGA_IMAGE_TYPE_INDEX_RLE) {
+		return true;
+	}
+
+	// Palette OK?
+	if (pTga->pPalette == NULL) return false;
+
+	uint8 *pWork = (uint8*)pSrc + TGA_HEADER_SIZE + pTga->header.IDField;
+	uint8 *pPalette = pTga->pPalette;
+	uint16 i; // VC6.0ではコンパイルが通らないので外に出す
+
+	switch (pTga->header.paletteBit) {
+	case 24:
+		for (i = 0; i < pTga->header.paletteColor; i++) {
+			*pPalette++ = *pWork++;
+			*pPalette++ = *pWork++;
+			*pPalette++ = *pWork++;
+		}
+		break;
+	case 32:
+		for (i = 0; i < pTga->header.paletteColor; i++) {
+			*pPalette++ = *pWork++;
+			*pPalette++ = *pWork++;
+			*pPalette++ = *pWork++;
+			*pPalette++ = *pWork++;
+		}
+		break;
+	default:
+		DBG_PRINT("not support palette data!!\n");
+		return false;
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】ストリームの先読み
+【引数】pReader：読み込み元
+        size   ：サイズ(TGA_STREAM_BUFFER_SIZE以下)
+【戻値】バッファ内のアドレス(NULL：sizeバイト読めない)
+【備考】非公開
+        読み込み位置は進めないので、_tgaSkipで進める。
+ =======================================================================*/
+const uint8 *_tgaPeek(struct TGAReader *pReader, const uint32 size)
+{
+	if (pReader->end - pReader->pos >= size) return &pReader->pBuffer[pReader->pos];
+	if (size > TGA_STREAM_BUFFER_SIZE || pReader->bEnd) return NULL;
+
+	// 残りを先頭に詰めて、足りない分を読む
+	memmove(pReader->pBuffer, &pReader->pBuffer[pReader->pos], pReader->end - pReader->pos);
+	pReader->end -= pReader->pos;
+	pReader->pos  = 0;
+
+	while (pReader->end < size) {
+		const uint32 n = pReader->func(&pReader->pBuffer[pReader->end], TGA_STREAM_BUFFER_SIZE - pReader->end, pReader->pUser);
+		if (n == 0) {
+			pReader->bEnd = true;
+			return NULL;
+		}
+		pReader->end += n;
+	}
+
+	return pReader->pBuffer;
+}
+
+/*=======================================================================
+【機能】ストリームの読み飛ばし
+【引数】pReader：読み込み元
+        size   ：サイズ(_tgaPeekで先読みした範囲内)
+【備考】非公開
+ =======================================================================*/
+void _tgaSkip(struct TGAReader *pReader, const uint32 size)
+{
+	_ASSERT(pReader->end - pReader->pos >= size);
+
+	pReader->pos += size;
+}
+
+/*=======================================================================
+【機能】ストリームから読み込み
+【引数】pReader：読み込み元
+        pDst   ：格納先
+        size   ：サイズ
+【戻値】読み込んだバイト数(sizeより少なければ終わりに達した)
+【備考】非公開
+        バッファサイズ以上残っている分はバッファを通さずに直接読み込む。
+ =======================================================================*/
+uint32 _tgaRead(struct TGAReader *pReader, void *pDst, const uint32 size)
+{
+	uint8 *pWork = (uint8*)pDst;
+	uint32 rest = size;
+	uint32 n;
+
+	// バッファに残っている分
+	n = (pReader->end - pReader->pos < rest) ? (pReader->end - pReader->pos) : rest;
+	memcpy(pWork, &pReader->pBuffer[pReader->pos], n);
+	pReader->pos += n;
+	pWork += n;
+	rest  -= n;
+
+	// 大きければ直接
+	while (rest >= TGA_STREAM_BUFFER_SIZE && !pReader->bEnd) {
+		if ((n = pReader->func(pWork, rest, pReader->pUser)) == 0) {
+			pReader->bEnd = true;
+			break;
+		}
+		pWork += n;
+		rest  -= n;
+	}
+
+	// 残りはバッファから
+	while (rest > 0) {
+		const uint32 len = (rest < TGA_STREAM_BUFFER_SIZE) ? rest : TGA_STREAM_BUFFER_SIZE;
+		const uint8 *pSrc = _tgaPeek(pReader, len);
+
+		if (pSrc == NULL) {
+			// 足りなければ読めた分だけ
+			n = (pReader->end - pReader->pos < rest) ? (pReader->end - pReader->pos) : rest;
+			memcpy(pWork, &pReader->pBuffer[pReader->pos], n);
+			pReader->pos += n;
+			rest -= n;
+			break;
+		}
+		memcpy(pWork, pSrc, len);
+		pReader->pos += len;
+		pWork += len;
+		rest  -= len;
+	}
+
+	return size - rest;
+}
+
+/*=======================================================================
+【機能】ストリームへ全部書く
+【引数】pWriter：書き込み先
+        pSrc   ：書き込むデータ
+        size   ：サイズ
+【戻値】true：成功
+【備考】非公開
+ =======================================================================*/
+bool _tgaWriteDirect(struct TGAWriter *pWriter, const uint8 *pSrc, uint32 size)
+{
+	while (size > 0) {
+		const uint32 n = pWriter->func(pSrc, size, pWriter->pUser);
+		if (n == 0) {
+			pWriter->bError = true;
+			return false;
+		}
+		pSrc += n;
+		size -= n;
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】ストリームのバッファに溜まっている分を書き出す
+【引数】pWriter：書き込み先
+【戻値】true：成功
+【備考】非公開
+ =======================================================================*/
+bool _tgaFlush(struct TGAWriter *pWriter)
+{
+	if (pWriter->bError) return false;
+
+	const uint32 size = pWriter->size;
+	pWriter->size = 0;
+
+	return _tgaWriteDirect(pWriter, pWriter->pBuffer, size);
+}
+
+/*=======================================================================
+【機能】ストリームへ書き込み
+【引数】pWriter：書き込み先
+        pSrc   ：書き込むデータ
+        size   ：サイズ
+【戻値】true：成功(一度失敗したら以降は全部false)
+【備考】非公開
+        バッファサイズ以上のデータはバッファを通さずに直接書き込む。
+ =======================================================================*/
+bool _tgaWrite(struct TGAWriter *pWriter, const void *pSrc, const uint32 size)
+{
+	if (pWriter->bError) return false;
+
+	// 入りきらなければ先に書き出す
+	if ((uint64)pWriter->size + size > TGA_STREAM_BUFFER_SIZE) {
+		if (!_tgaFlush(pWriter)) return false;
+	}
+
+	if (size >= TGA_STREAM_BUFFER_SIZE) {
+		return _tgaWriteDirect(pWriter, (const uint8*)pSrc, size);
+	}
+
+	memcpy(&pWriter->pBuffer[pWriter->size], pSrc, size);
+	pWriter->size += size;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】ストリームからRLE圧縮解凍
+【引数】pTga   ：TGA構造体のアドレス
+        pReader：読み込み元
+【戻値】true：成功
+【備考】非公開
+        1パケットずつバッファに先読みして展開する。
+        イメージの終わりを超えるパケットはエラーにする。
+ =======================================================================*/
+bool _tgaUnpackRLEStream(struct TGA *pTga, struct TGAReader *pReader)
+{
+	const uint32 byte = pTga->header.imageBit >> 3; // バイトサイズ
+	uint32 count = 0;
+
+	while (count < pTga->imageSize) {
+		const uint8 *pSrc = _tgaPeek(pReader, 1);
+		if (pSrc == NULL) return false;
+
+		const bool bFlg   = (pSrc[0] & 0x80) ? false : true; // 上位ビットが0ならリテラルグループ
+		const uint32 loop = (pSrc[0] & 0x7f) + 1;
+		const uint32 size = bFlg ? (loop * byte) : byte;
+
+		if (loop * byte > pTga->imageSize - count) return false;
+		if ((pSrc = _tgaPeek(pReader, 1 + size)) == NULL) return false;
+
+		if (bFlg) {
+			// リテラルグループ
+			memcpy(&pTga->pImage[count], &pSrc[1], size);
+			count += size;
+		} else {
+			// 反復
+			TgaKernelFill(&pTga->pImage[count], &pSrc[1], loop, byte);
+			count += loop * byte;
+		}
+
+		_tgaSkip(pReader, 1 + size);
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】TGAヘッダーを並べる
+【引数】pDst   ：格納先(TGA_HEADER_SIZEバイト)
+        pHeader：TGAヘッダー
+【備考】非公開
+        アライメントに沿っていないので、リトルエンディアンで1バイトずつ並べる。
+ =======================================================================*/
+void _tgaPackHeader(uint8 *pDst, const struct TGAHeader *pHeader)
+{
+	uint32 offset = 0;
+
+	pDst[offset++] = pHeader->IDField;
+	pDst[offset++] = pHeader->usePalette;
+	pDst[offset++] = pHeader->imageType;
+	pDst[offset++] = (uint8)pHeader->paletteIndex; pDst[offset++] = (uint8)(pHeader->paletteIndex >> 8);
+	pDst[offset++] = (uint8)pHeader->paletteColor; pDst[offset++] = (uint8)(pHeader->paletteColor >> 8);
+	pDst[offset++] = pHeader->paletteBit;
+	pDst[offset++] = (uint8)pHeader->imageX; pDst[offset++] = (uint8)(pHeader->imageX >> 8);
+	pDst[offset++] = (uint8)pHeader->imageY; pDst[offset++] = (uint8)(pHeader->imageY >> 8);
+	pDst[offset++] = (uint8)pHeader->imageW; pDst[offset++] = (uint8)(pHeader->imageW >> 8);
+	pDst[offset++] = (uint8)pHeader->imageH; pDst[offset++] = (uint8)(pHeader->imageH >> 8);
+	pDst[offset++] = pHeader->imageBit;
+	pDst[offset++] = pHeader->discripter;
+
+	_ASSERT(offset == TGA_HEADER_SIZE);
+}
+
+/*=======================================================================
+【機能】TGAフッターを並べる
+【引数】pDst   ：格納先(TGA_FOOTER_SIZEバイト)
+        pFooter：TGAフッター
+【備考】非公開
+ =======================================================================*/
+void _tgaPackFooter(uint8 *pDst, const struct TGAFooter *pFooter)
+{
+	pDst[0] = (uint8)pFooter->filePos;         pDst[1] = (uint8)(pFooter->filePos >> 8);
+	pDst[2] = (uint8)(pFooter->filePos >> 16); pDst[3] = (uint8)(pFooter->filePos >> 24);
+	pDst[4] = (uint8)pFooter->fileDev;         pDst[5] = (uint8)(pFooter->fileDev >> 8);
+	pDst[6] = (uint8)(pFooter->fileDev >> 16); pDst[7] = (uint8)(pFooter->fileDev >> 24);
+	memcpy(&pDst[8], pFooter->version, sizeof(pFooter->version));
+}
+
+/*=======================================================================
+【機能】出力用にヘッダーとフッターを整える
+【引数】pTga：TGA構造体のアドレス
+【備考】非公開
+ =======================================================================*/
+void _tgaPrepareOutput(struct TGA *pTga)
+{
+	// TODO:RLE圧縮出力対応
+	//      2008/04/01時点では非対応
+	if (TGA_IMAGE_TYPE_INDEX_RLE <= pTga->header.imageType && pTga->header.imageType < TGA_IMAGE_TYPE_RLE_MAX) {
+		pTga->header.imageType -= 8; // 非圧縮にする
+	}
+
+	// 元画像にフッターが付いていたかチェック
+	int ret = 0;
+	for (int i = 0; i < 18; i++) {
+		ret += pTga->footer.version[i];
+	}
+	if (ret == 0) {
+		strcpy((char*)pTga->footer.version, "TRUEVISION-TARGA");
+	}
+}
+
+
+/*=======================================================================
+【機能】ファイル読み込み
+【引数】pTga     ： TGA構造体のアドレス
+        pFileName：ファイル名
+ =======================================================================*/
+int tgaCreateFile(struct TGA *pTga, const char *pFileName)
+{
+	FILE *fp;
+	uint8 *mem;
+	uint32 size;
+
+#ifndef NDEBUG
+	_ASSERT(pTga != NULL);
+	_ASSERT(pFileName != NULL);
+#else
+	if (pTga == NULL || pFileName == NULL) return TGA_ERROR_OPEN;
+#endif
+
+	if ((fp = fopen(pFileName, "rb")) == NULL) {
+		DBG_PRINT("file not found!\n");
+		return TGA_ERROR_OPEN;
+	}
+
+	// get file size
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	// read file to memory
+	if ((mem = (uint8*)malloc(size)) == NULL) {
+		fclose(fp);
+		return TGA_ERROR_MEMORY;
+	}
+	fread(mem, size, 1, fp);
+	fclose(fp);
+
+	// 読み込み
+	int ret = tgaCreateMemory(pTga, mem, size);
+	SAFE_FREE(mem);
+
+	return ret;
+}
+
+/*=======================================================================
+【機能】メモリから作成
+【引数】pTga：TGA構造体のアドレス
+        pSrc：画像データアドレス
+        size：画像データサイズ
+ =======================================================================*/
+int tgaCreateMemory(struct TGA *pTga, const void *pSrc, const uint32 size)
+{
+	uint32 offset;
+
+#ifndef NDEBUG
+	_ASSERT(pTga != NULL);
+	_ASSERT(pSrc != NULL);
+	_ASSERT(size);
+#else
+	if (pTga == NULL || pSrc == NULL || size == 0) return TGA_ERROR_HEADER;
+#endif
+
+	// 既に作成しているなら削除
+	if (pTga->pImage != NULL) {
+		tgaRelease(pTga);
+	}
+
+	// ヘッダー読み込み
+	if (!_tgaReadHeader((const uint8*)pSrc, &pTga->header)) {
+		return TGA_ERROR_HEADER;
+	}
+
+	// ImageとPaletteのサイズを求める
+	if (!_tgaCalcSize(pTga, true)) {
+		tgaRelease(pTga);
+		return TGA_ERROR_MEMORY;
+	}
+
+	// パレット読み込み
+	if (!_tgaReadPalette(pTga, (const uint8*)pSrc)) {
+		tgaRelease(pTga);
+		return TGA_ERROR_PALETTE;
+	}
+
+	// イメージ読み込み
+	if (!_tgaReadImage(pTga, (const uint8*)pSrc, size, &offset)) {
+		tgaRelease(pTga);
+		return TGA_ERROR_IMAGE;
+	}
+
+	// フッター読み込み
+	offset += TGA_HEADER_SIZE + pTga->header.IDField + pTga->paletteSize;
+	if ((size - offset) >= TGA_FOOTER_SIZE) {
+		_tgaReadFooter((const uint8*)pSrc, offset, &pTga->footer);
+	}
+
+	return TGA_ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】ストリームから作成
+【引数】pTga ：TGA構造体のアドレス
+        func ：読み込み関数(tgaReadFd、tgaReadFILEなど)
+        pUser：funcに渡す値
+【備考】標準入力やパイプのようにシークできないものからも読み込めます。
+        バッファはTGA_STREAM_BUFFER_SIZEバイトだけ使います。
+        フッターはイメージの直後にTGA_FOOTER_SIZEバイト読めた場合だけ
+        読み込みます(tgaCreateMemoryと同じ位置)。それ以降は読みません。
+ =======================================================================*/
+int tgaCreateStream(struct TGA *pTga, TGAReadFunc func, void *pUser)
+{
+#ifndef NDEBUG
+	_ASSERT(pTga != NULL);
+	_ASSERT(func != NULL);
+#else
+	if (pTga == NULL || func == NULL) return TGA_ERROR_OPEN;
+#endif
+
+	// 既に作成しているなら削除
+	if (pTga->pImage != NULL) {
+		tgaRelease(pTga);
+	}
+
+	struct TGAReader reader;
+	reader.func    = func;
+	reader.pUser   = pUser;
+	reader.pos     = 0;
+	reader.end     = 0;
+	reader.bEnd    = false;
+	if ((reader.pBuffer = (uint8*)malloc(TGA_STREAM_BUFFER_SIZE)) == NULL) return TGA_ERROR_MEMORY;
+
+	int ret = TGA_ERROR_NONE;
+	uint8 head[TGA_HEADER_SIZE];
+	uint8 *pInfo = NULL;
+	uint32 infoSize = 0;
+
+	// ヘッダー読み込み
+	if (_tgaRead(&reader, head, TGA_HEADER_SIZE) != TGA_HEADER_SIZE || !_tgaReadHeader(head, &pTga->header)) {
+		ret = TGA_ERROR_HEADER;
+	} else if (!_tgaCalcSize(pTga, true)) {
+		// ImageとPaletteのサイズを求める
+		ret = TGA_ERROR_MEMORY;
+	} else if ((pInfo = (uint8*)malloc(infoSize = TGA_HEADER_SIZE + pTga->header.IDField + pTga->paletteSize)) == NULL) {
+		ret = TGA_ERROR_MEMORY;
+	} else {
+		// パレット読み込み(_tgaReadPaletteは先頭からのアドレスを受け取るので、ヘッダーも含める)
+		memcpy(pInfo, head, TGA_HEADER_SIZE);
+		if (_tgaRead(&reader, &pInfo[TGA_HEADER_SIZE], infoSize - TGA_HEADER_SIZE) != infoSize - TGA_HEADER_SIZE || !_tgaReadPalette(pTga, pInfo)) {
+			ret = TGA_ERROR_PALETTE;
+		} else if (TGA_IMAGE_TYPE_INDEX_RLE <= pTga->header.imageType && pTga->header.imageType < TGA_IMAGE_TYPE_RLE_MAX) {
+			// イメージ読み込み(RLE圧縮)
+			if (!_tgaUnpackRLEStream(pTga, &reader)) ret = TGA_ERROR_IMAGE;
+		} else if (_tgaRead(&reader, pTga->pImage, pTga->imageSize) != pTga->imageSize) {
+			// イメージ読み込み(非圧縮)
+			ret = TGA_ERROR_IMAGE;
+		}
+	}
+
+	// フッター読み込み
+	if (ret == TGA_ERROR_NONE) {
+		uint8 foot[TGA_FOOTER_SIZE];
+		if (_tgaRead(&reader, foot, TGA_FOOTER_SIZE) == TGA_FOOTER_SIZE) {
+			_tgaReadFooter(foot, 0, &pTga->footer);
+		}
+	}
+
+	SAFE_FREE(pInfo);
+	SAFE_FREE(reader.pBuffer);
+
+	if (ret != TGA_ERROR_NONE) {
+		tgaRelease(pTga);
+	}
+
+	return ret;
+}
+
+/*=======================================================================
+【機能】指定データから作成
+【引数】pTga       ：TGA構造体のアドレス
+        pHeader    ：TGAヘッダーのアドレス
+        pImage     ：イメージデータアドレス
+        imageSize  ：イメージデータサイズ
+        pPalette   ：パレットデータアドレス
+        paletteSize：パレットデータサイズ
+ =======================================================================*/
+int tgaCreateHeader(struct TGA *pTga, const struct TGAHeader *pHeader, uint8 *pImage, const uint32 imageSize, uint8 *pPalette, const uint32 paletteSize)
+{
+	// 引数チェック
+	if (pTga == NULL) return TGA_ERROR_IMAGE;
+	if (pImage == NULL || imageSize == 0) return TGA_ERROR_IMAGE;
+	if (pPalette != NULL && paletteSize == 0) return TGA_ERROR_PALETTE;
+	if (pPalette == NULL && paletteSize != 0) return TGA_ERROR_PALETTE;
+
+	// ヘッダーチェック
+	if (!_tgaCheckSupport(pHeader)) return TGA_ERROR_HEADER;
+
+	// 既に作成しているなら削除
+	if (pTga->pImage != NULL) {
+		tgaRelease(pTga);
+	}
+
+	memcpy(&pTga->header, pHeader, sizeof(pTga->header));
+	pTga->pImage      = pImage;
+	pTga->imageSize   = imageSize;
+	pTga->pPalette    = pPalette;
+	pTga->paletteSize = paletteSize;
+
+	return TGA_ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】ファイル出力
+【引数】pTga     ：TGA構造体のアドレス
+        pFileName：出力ファイル名
+ =======================================================================*/
+int tgaOutput(struct TGA *pTga, const char *pFileName)
+{
+#ifndef NDEBUG
+	_ASSERT(pTga != NULL);
+	_ASSERT(pFileName != NULL);
+#else
+	if (pTga == NULL || pFileName == NULL) return TGA_ERROR_OUTPUT;
+#endif
+
+	// 読み込まれていない？
+	if (pTga->pImage == NULL) return TGA_ERROR_NONE;
+
+	// 出力ファイルオープン
+	FILE *fp;
+	if ((fp = fopen(pFileName, "wb")) == NULL) {
+		DBG_PRINT("file can't open!\n");
+		return TGA_ERROR_OPEN;
+	}
+
+	int ret = tgaOutputStream(pTga, tgaWriteFILE, fp);
+	if (fclose(fp) != 0 && ret == TGA_ERROR_NONE) ret = TGA_ERROR_OUTPUT;
+
+	return ret;
+}
+
+/*=======================================================================
+【機能】ストリーム出力
+【引数】pTga ：TGA構造体のアドレス
+        func ：書き込み関数(tgaWriteFd、tgaWriteFILEなど)
+        pUser：funcに渡す値
+【備考】前から順に書くだけなので、標準出力やパイプにも出力できます。
+        バッファはTGA_STREAM_BUFFER_SIZEバイトだけ使います。
+ =======================================================================*/
+int tgaOutputStream(struct TGA *pTga, TGAWriteFunc func, void *pUser)
+{
+#ifndef NDEBUG
+	_ASSERT(pTga != NULL);
+	_ASSERT(func != NULL);
+#else
+	if (pTga == NULL || func == NULL) return TGA_ERROR_OUTPUT;
+#endif
+
+	// 読み込まれていない？
+	if (pTga->pImage == NULL) return TGA_ERROR_NONE;
+
+	struct TGAWriter writer;
+	writer.func   = func;
+	writer.pUser  = pUser;
+	writer.size   = 0;
+	writer.bError = false;
+	if ((writer.pBuffer = (uint8*)malloc(TGA_STREAM_BUFFER_SIZE)) == NULL) return TGA_ERROR_MEMORY;
+
+	uint8 head[TGA_HEADER_SIZE];
+	uint8 foot[TGA_FOOTER_SIZE];
+
+	_tgaPrepareOutput(pTga);
+
+	// ヘッダー出力
+	_tgaPackHeader(head, &pTga->header);
+	_tgaWrite(&writer, head, sizeof(head));
+
+	// パレット出力
+	if (pTga->pPalette != NULL) {
+		_tgaWrite(&writer, pTga->pPalette, pTga->paletteSize);
+	}
+
+	// イメージ出力
+	_tgaWrite(&writer, pTga->pImage, pTga->imageSize);
+
+	// フッター出力
+	_tgaPackFooter(foot, &pTga->footer);
+	_tgaWrite(&writer, foot, sizeof(foot));
+
+	const bool bResult = _tgaFlush(&writer);
+	SAFE_FREE(writer.pBuffer);
+
+	return bResult ? TGA_ERROR_NONE : TGA_ERROR_OUTPUT;
+}
+
+/*=======================================================================
+【機能】BMP出力
+【引数】pTga     ：TGA構造体のアドレス
+        pFileName：出力ファイル名
+ =======================================================================*/
+int tgaOutputBMP(struct TGA *pTga, const char *pFileName)
+{
+#ifndef NDEBUG
+	_ASSERT(pTga != NULL);
+	_ASSERT(pFileName != NULL);
+#else
+	if (pTga == NULL) return TGA_ERROR_IMAGE;
+	if (pFileName == NULL) return TGA_ERROR_OUTPUT;
+#endif
+
+	// 読み込まれていない？
+	if (pTga->pImage == NULL) return TGA_ERROR_NONE;
+
+	// 出力ファイルオープン
+	FILE *fp;
+	if ((fp = fopen(pFileName, "wb")) == NULL) {
+		DBG_PRINT("file can't open!\n");
+		return TGA_ERROR_OPEN;
+	}
+
+	// BMPヘッダー作成
+	uint32 hsize, isize, psize;
+	BITMAPFILEHEADER bmHead;
+	BITMAPINFOHEADER bmInfo;
+
+	memset(&bmHead, 0, sizeof(bmHead));
+	memset(&bmInfo, 0, sizeof(bmInfo));
+
+	hsize = sizeof(BITMAPFILEHEADER);
+	isize = sizeof(BITMAPINFOHEADER);
+	psize = sizeof(RGBQUAD) * pTga->header.paletteColor;
+
+	bmHead.bfType = 0x4D42; //BM
+	bmHead.bfSize = pTga->imageSize + hsize + isize + psize;
+	bmHead.bfReserved1 = 0;
+	bmHead.bfReserved2 = 0;
+	bmHead.bfOffBits   = hsize + isize + psize;
+
+	bmInfo.biSize   = isize;
+	bmInfo.biWidth  = pTga->header.imageW;
+	bmInfo.biHeight = pTga->header.imageH;
+	bmInfo.biPlanes = 1;
+	bmInfo.biBitCount = pTga->header.imageBit;
+
+
+	// ヘッダー出力
+	fwrite(&bmHead, hsize, 1, fp);
+	fwrite(&bmInfo, isize, 1, fp);
+
+	// パレット出力
+	if (pTga->pPalette != NULL) {
+		if (pTga->header.paletteBit == 24) {
+			uint8 *pPalette = pTga->pPalette;
+			uint8 alpha = 0x00;
+
+			for (int i = 0; i < pTga->header.paletteColor; i++) {
+				fwrite(pPalette++, sizeof(uint8), 1, fp);
+				fwrite(pPalette++, sizeof(uint8), 1, fp);
+				fwrite(pPalette++, sizeof(uint8), 1, fp);
+				fwrite(&alpha    , sizeof(uint8), 1, fp);
+			}
+		} else {
+			fwrite(pTga->pPalette, pTga->paletteSize, 1, fp);
+		}
+	}
+
+	// イメージ出力（幅が4で割れない画像への対応はしていません）
+	tgaConvertType(pTga, TGA_IMAGE_LINE_LRDU); // 左→右、下→上配列に変換
+	fwrite(pTga->pImage, pTga->imageSize, 1, fp);
+
+	fclose(fp);
+
+	return TGA_ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】BGRA配列をRGBA配列に変更
+【引数】pTga：TGA構造体のアドレス
+【備考】RGBAに変更したあと再度呼ぶとBGRA配列になります。
+ =======================================================================*/
+bool tgaConvertRGBA(struct TGA *pTga)
+{
+	if (pTga == NULL || pTga->pImage == NULL) return false;
+
+	// パレット
+	if (pTga->pPalette) {
+		if (pTga->header.paletteBit == 32) {
+			TgaKernelSwapRB32(pTga->pPalette, pTga->pPalette, pTga->paletteSize >> 2);
+		} else {
+			TgaKernelSwapRB24(pTga->pPalette, pTga->pPalette, pTga->paletteSize / 3);
+		}
+	}
+
+	// イメージ
+	switch (pTga->header.imageBit) {
+	case 16:
+		// RGBA:5551
+		TgaKernelSwapRB16(pTga->pImage, pTga->pImage, pTga->imageSize >> 1);
+		break;
+	case 24:
+		TgaKernelSwapRB24(pTga->pImage, pTga->pImage, pTga->imageSize / 3);
+		break;
+	case 32:
+		TgaKernelSwapRB32(pTga->pImage, pTga->pImage, pTga->imageSize >> 2);
+		break;
+	default:
+		// IndexColorなら処理しない
+		break;
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】指定のビット配列に変換
+【引数】pTga：TGA構造体のアドレス
+        type：ラインタイプ
+ =======================================================================*/
+bool tgaConvertType(struct TGA *pTga, const sint32 type)
+{
+	if (type >= TGA_IMAGE_LINE_MAX) return false;
+	if (pTga == NULL || pTga->pImage == NULL) return false;
+
+	// 一緒なら処理なし
+	if ((pTga->header.discripter & 0xf0) == type) return true;
+
+	uint8 *pImage;
+
+	// 変換用のメモリ確保
+	if ((pImage = (uint8*)malloc(pTga->imageSize)) == NULL) {
+		return false;
+	}
+
+	// 配列変換(1ラインずつ)
+	const uint32 h      = pTga->header.imageH;
+	const uint32 byte   = pTga->header.imageBit >> 3;
+	const uint32 line   = pTga->header.imageW * byte;
+	const bool   bFlipX = ((pTga->header.discripter & 0x10) != (type & 0x10));	// お互いのX方向が一致しないなら反転
+	const bool   bFlipY = ((pTga->header.discripter & 0x20) != (type & 0x20));	// お互いのY方向が一致しないなら反転
+
+	for (uint32 y = 0; y < h; y++) {
+		const uint32 ty = bFlipY ? (h - y - 1) : y;
+
+		if (bFlipX) {
+			TgaKernelReverse(&pImage[y * line], &pTga->pImage[ty * line], pTga->header.imageW, byte);
+		} else {
+			memcpy(&pImage[y * line], &pTga->pImage[ty * line], line);
+		}
+	}
+
+	// 元を破棄して変換後のデータを保持
+	SAFE_FREE(pTga->pImage);
+	pTga->pImage = pImage;
+
+	// イメージ記述子を変更
+	pTga->header.discripter = type;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】構造体情報の解放
+【引数】pTga：TGA構造体のアドレス
+ =======================================================================*/
+void tgaRelease(struct TGA *pTga)
+{
+	SAFE_FREE(pTga->pImage);
+	SAFE_FREE(pTga->pPalette);
+
+	memset(&pTga->header, 0, sizeof(pTga->header));
+	memset(&pTga->footer, 0, sizeof(pTga->footer));
+
+	pTga->imageSize   = 0;
+	pTga->paletteSize = 0;
+}
+
+/*=======================================================================
+【機能】TGAヘッダー出力
+【引数】fp     ：FILEポインタ
+        pHeader：出力するTGAヘッダー
+【備考】アライメントに沿っていないので個別出力。
+ =======================================================================*/
+bool tgaWriteHeader(FILE *fp, struct TGAHeader *pHeader)
+{
+#ifndef NDEBUG
+	_ASSERT(fp != NULL);
+	_ASSERT(pHeader != NULL);
+#else
+	if (fp == NULL || pHeader == NULL) return false;
+#endif
+
+	// TODO:RLE圧縮出力対応
+	//      2008/04/01時点では非対応
+	if (TGA_IMAGE_TYPE_INDEX_RLE <= pHeader->imageType && pHeader->imageType < TGA_IMAGE_TYPE_RLE_MAX) {
+		pHeader->imageType -= 8; // 非圧縮にする
+	}
+
+	uint8 head[TGA_HEADER_SIZE];
+	_tgaPackHeader(head, pHeader);
+
+	return (fwrite(head, sizeof(head), 1, fp) == 1);
+}
+
+/*=======================================================================
+【機能】TGAフッター出力
+【引数】fp     ：FILEポインタ
+        pHeader：出力するTGAフッター
+【備考】アライメントに沿っていないので個別出力。
+ =======================================================================*/
+bool tgaWriteFooter(FILE *fp, struct TGAFooter *pFooter)
+{
+#ifndef NDEBUG
+	_ASSERT(fp != NULL);
+	_ASSERT(pFooter != NULL);
+#else
+	if (fp == NULL || pFooter == NULL) return false;
+#endif
+
+	// 元画像にフッターが付いていたかチェック
+	int ret = 0;
+	for (int i = 0; i < 18; i++) {
+		ret += pFooter->version[i];
+	}
+
+	if (ret == 0) {
+		strcpy((char*)pFooter->version, "TRUEVISION-TARGA");
+	}
+
+	uint8 foot[TGA_FOOTER_SIZE];
+	_tgaPackFooter(foot, pFooter);
+
+	return (fwrite(foot, sizeof(foot), 1, fp) == 1);
+}
+
+/*=======================================================================
+【機能】ファイルディスクリプタから読み込み
+【引数】pDst ：格納先
+        size ：サイズ
+        pUser：ファイルディスクリプタ(int*)
+【戻値】読み込んだバイト数(0：終わりかエラー)
+【備考】シグナルで中断された場合は読み直します。
+ =======================================================================*/
+uint32 tgaReadFd(void *pDst, const uint32 size, void *pUser)
+{
+	const int fd = *(const int*)pUser;
+	const uint32 len = (size < 0x40000000) ? size : 0x40000000; // Windowsはintなので
+
+	for (;;) {
+#if defined(_WIN32)
+		const int n = _read(fd, pDst, len);
+#else
+		const ssize_t n = read(fd, pDst, len);
+#endif
+		if (n >= 0) return (uint32)n;
+		if (errno != EINTR) return 0;
+	}
+}
+
+/*=======================================================================
+【機能】ファイルディスクリプタへ書き込み
+【引数】pSrc ：書き込むデータ
+        size ：サイズ
+        pUser：ファイルディスクリプタ(int*)
+【戻値】書き込んだバイト数(0：エラー)
+ =======================================================================*/
+uint32 tgaWriteFd(const void *pSrc, const uint32 size, void *pUser)
+{
+	const int fd = *(const int*)pUser;
+	const uint32 len = (size < 0x40000000) ? size : 0x40000000; // Windowsはintなので
+
+	for (;;) {
+#if defined(_WIN32)
+		const int n = _write(fd, pSrc, len);
+#else
+		const ssize_t n = write(fd, pSrc, len);
+#endif
+		if (n >= 0) return (uint32)n;
+		if (errno != EINTR) return 0;
+	}
+}
+
+/*=======================================================================
+【機能】FILEポインタから読み込み
+【引数】pDst ：格納先
+        size ：サイズ
+        pUser：FILEポインタ
+【戻値】読み込んだバイト数(0：終わりかエラー)
+ =======================================================================*/
+uint32 tgaReadFILE(void *pDst, const uint32 size, void *pUser)
+{
+	return (uint32)fread(pDst, 1, size, (FILE*)pUser);
+}
+
+/*=======================================================================
+【機能】FILEポインタへ書き込み
+【引数】pSrc ：書き込むデータ
+        size ：サイズ
+        pUser：FILEポインタ
+【戻値】書き込んだバイト数(0：エラー)
+ =======================================================================*/
+uint32 tgaWriteFILE(const void *pSrc, const uint32 size, void *pUser)
+{
+	return (uint32)fwrite(pSrc, 1, size, (FILE*)pUser);
+}
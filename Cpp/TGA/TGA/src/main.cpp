@@ -1,77 +1,109 @@
-#include "mto_common.h"
-#include "tga.h"
-
-
-int main(int argc, char* argv[])
-{
-	SET_CRTDBG();
-
-	// `FbN
-	if (argc <= 1) return 1;
-
-	// gq`FbN
-	const char *pStr = strrchr(argv[1], '.');
-	if (pStr == NULL) return 1;
-
-	char ext[_MAX_EXT];
-	strcpy(ext, pStr);
-	if (strcmp(ext, ".tga") != 0 && strcmp(ext, ".TGA") != 0) return 1;
-
-	// TGA쐬
-	CTga tga;
-	int ret = tga.Create(argv[1]);
-
-	if (ret < 0) {
-		switch (ret) {
-			case CTga::ERROR_OPEN:
-				printf("File open error!!\n");
-				break;
-			case CTga::ERROR_MEMORY:
-				printf("Memory alloc error!!\n");
-				break;
-			case CTga::ERROR_HEADER:
-				printf("Not support error!!\n");
-				break;
-			case CTga::ERROR_PALETTE:
-				printf("Not support palette data\n");
-				break;
-			case CTga::ERROR_IMAGE:
-				printf("Not support image data\n");
-				break;
-			case CTga::ERROR_OUTPUT:
-				printf("Output error!!\n");
-				break;
-		}
-	}
-
-	// TGAo
-	tga.ConvertType(CTga::IMAGE_LINE_RLDU);
-	ret = tga.Output("output.tga");
-	if (ret < 0) {
-		switch (ret) {
-			case CTga::ERROR_OPEN:
-				printf("File open error!!\n");
-				break;
-			case CTga::ERROR_OUTPUT:
-				printf("Output error!!\n");
-				break;
-		}
-	}
-
-	// BMPo
-//	tga.ConvertRGBA(); // BGR->RGB
-	ret = tga.OutputBMP("output.bmp");
-	if (ret < 0) {
-		switch (ret) {
-			case CTga::ERROR_OPEN:
-				printf("File open error!!\n");
-				break;
-			case CTga::ERROR_OUTPUT:
-				printf("Output error!!\n");
-				break;
-		}
-	}
-
-	return 0;
-}
-
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_stream.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+
+int main(int argc, char* argv[])
+{
+	SET_CRTDBG();
+
+	// 引数チェック(TGA 入力 [出力]、"-"なら標準入出力)
+	if (argc <= 1) return 1;
+
+	const bool bStdin  = (strcmp(argv[1], "-") == 0);
+	const char *pOut   = (argc > 2) ? argv[2] : "output.tga";
+	const bool bStdout = (strcmp(pOut, "-") == 0);
+
+	// 拡張子チェック
+	if (!bStdin) {
+		const char *pStr = strrchr(argv[1], '.');
+		if (pStr == NULL) return 1;
+
+		char ext[_MAX_EXT];
+		if (strlen(pStr) >= sizeof(ext)) return 1;
+		strcpy(ext, pStr);
+		if (strcmp(ext, ".tga") != 0 && strcmp(ext, ".TGA") != 0) return 1;
+	}
+
+#if defined(_WIN32)
+	_setmode(_fileno(stdin),  _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+	// TGA作成
+	CTga tga;
+	int fdIn  = 0;
+	int fdOut = 1;
+	int ret;
+
+	if (bStdin) {
+		CTgaStreamReader reader(TgaStreamReadFd, &fdIn);
+		ret = tga.Create(&reader);
+	} else {
+		ret = tga.Create(argv[1]);
+	}
+
+	if (ret < 0) {
+		switch (ret) {
+			case CTga::ERROR_OPEN:
+				fprintf(stderr, "File open error!!\n");
+				break;
+			case CTga::ERROR_MEMORY:
+				fprintf(stderr, "Memory alloc error!!\n");
+				break;
+			case CTga::ERROR_HEADER:
+				fprintf(stderr, "Not support error!!\n");
+				break;
+			case CTga::ERROR_PALETTE:
+				fprintf(stderr, "Not support palette data\n");
+				break;
+			case CTga::ERROR_IMAGE:
+				fprintf(stderr, "Not support image data\n");
+				break;
+			case CTga::ERROR_OUTPUT:
+				fprintf(stderr, "Output error!!\n");
+				break;
+		}
+	}
+
+	// TGA出力
+	tga.ConvertType(CTga::IMAGE_LINE_RLDU);
+	if (bStdout) {
+		CTgaStreamWriter writer(TgaStreamWriteFd, &fdOut);
+		ret = tga.Output(&writer, CTga::OUTPUT_FLAG_NONE);
+	} else {
+		ret = tga.Output(pOut);
+	}
+	if (ret < 0) {
+		switch (ret) {
+			case CTga::ERROR_OPEN:
+				fprintf(stderr, "File open error!!\n");
+				break;
+			case CTga::ERROR_OUTPUT:
+				fprintf(stderr, "Output error!!\n");
+				break;
+		}
+	}
+
+	// BMP出力
+//	tga.ConvertRGBA(); // BGR->RGB
+	ret = bStdout ? CTga::ERROR_NONE : tga.OutputBMP("output.bmp");
+	if (ret < 0) {
+		switch (ret) {
+			case CTga::ERROR_OPEN:
+				fprintf(stderr, "File open error!!\n");
+				break;
+			case CTga::ERROR_OUTPUT:
+				fprintf(stderr, "Output error!!\n");
+				break;
+		}
+	}
+
+	return 0;
+}
+
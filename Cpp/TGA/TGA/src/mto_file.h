@@ -0,0 +1,364 @@
+/*=============================================================================
+ * ファイル関係の最低限のラッパー。
+ * Windows(Win32 API)とLinux(POSIX)に対応。
+ * Windowsではwindows.hをインクルードするので、mto_common.hより先に
+ * インクルードしてください。
+=============================================================================*/
+#ifndef _MTO_FILE_H_
+#define _MTO_FILE_H_
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+
+
+/*=======================================================================
+【機能】ファイルの状態
+ =======================================================================*/
+struct MtoFileStatus {
+	unsigned long long	size;		// ファイルサイズ
+	long long			time;		// 更新日時(1970/01/01からの秒)
+};
+
+/*=======================================================================
+【機能】ファイルの状態を取得
+【引数】pFileName：ファイル名
+        pStatus  ：格納先
+【戻値】true：成功
+ =======================================================================*/
+static inline bool MtoFileGetStatus(const char *pFileName, MtoFileStatus *pStatus)
+{
+#if defined(_WIN32)
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesExA(pFileName, GetFileExInfoStandard, &data)) return false;
+	if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) return false;
+
+	// 100ナノ秒単位(1601/01/01から)を秒(1970/01/01から)に
+	const unsigned long long t = (static_cast<unsigned long long>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+	pStatus->size = (static_cast<unsigned long long>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+	pStatus->time = static_cast<long long>(t / 10000000ULL) - 11644473600LL;
+#else
+	struct stat st;
+	if (stat(pFileName, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+
+	pStatus->size = static_cast<unsigned long long>(st.st_size);
+	pStatus->time = static_cast<long long>(st.st_mtime);
+#endif
+
+	return true;
+}
+
+/*=======================================================================
+【機能】ファイルの位置を移動(64bit)
+【引数】fp    ：ファイルポインタ
+        offset：位置
+        origin：基準(SEEK_SET、SEEK_CUR、SEEK_END)
+【戻値】true：成功
+【備考】32bitのLinuxでは_FILE_OFFSET_BITS=64を指定してビルドしてください。
+ =======================================================================*/
+static inline bool MtoFileSeek(FILE *fp, const long long offset, const int origin)
+{
+#if defined(_WIN32)
+	return (_fseeki64(fp, offset, origin) == 0);
+#else
+	return (fseeko(fp, static_cast<off_t>(offset), origin) == 0);
+#endif
+}
+
+/*=======================================================================
+【機能】ファイルの位置を取得(64bit)
+【引数】fp：ファイルポインタ
+【戻値】位置(-1：失敗)
+ =======================================================================*/
+static inline long long MtoFileTell(FILE *fp)
+{
+#if defined(_WIN32)
+	return _ftelli64(fp);
+#else
+	return static_cast<long long>(ftello(fp));
+#endif
+}
+
+/*=======================================================================
+【機能】ファイルの更新日時を現在時刻にする
+【引数】pFileName：ファイル名
+ =======================================================================*/
+static inline bool MtoFileTouch(const char *pFileName)
+{
+#if defined(_WIN32)
+	HANDLE hFile = CreateFileA(pFileName, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+
+	SYSTEMTIME st;
+	FILETIME ft;
+	GetSystemTime(&st);
+	SystemTimeToFileTime(&st, &ft);
+	const BOOL ret = SetFileTime(hFile, NULL, NULL, &ft);
+	CloseHandle(hFile);
+
+	return ret ? true : false;
+#else
+	return (utime(pFileName, NULL) == 0);
+#endif
+}
+
+/*=======================================================================
+【機能】ファイルを置き換える
+【引数】pSrc：置き換えるファイル名
+        pDst：置き換えられるファイル名
+【備考】同じディレクトリ内なら置き換えは不可分に行われます。
+ =======================================================================*/
+static inline bool MtoFileReplace(const char *pSrc, const char *pDst)
+{
+#if defined(_WIN32)
+	return MoveFileExA(pSrc, pDst, MOVEFILE_REPLACE_EXISTING) ? true : false;
+#else
+	return (rename(pSrc, pDst) == 0);
+#endif
+}
+
+/*=======================================================================
+【機能】ファイルを削除
+【引数】pFileName：ファイル名
+【備考】Windowsではマップ中のファイルは削除できません。
+ =======================================================================*/
+static inline bool MtoFileRemove(const char *pFileName)
+{
+	return (remove(pFileName) == 0);
+}
+
+/*=======================================================================
+【機能】プロセスID
+ =======================================================================*/
+static inline unsigned long MtoGetProcessId(void)
+{
+#if defined(_WIN32)
+	return static_cast<unsigned long>(GetCurrentProcessId());
+#else
+	return static_cast<unsigned long>(getpid());
+#endif
+}
+
+/*=======================================================================
+【機能】ディレクトリ内のファイルを列挙
+【引数】pDir ：ディレクトリ名
+        func ：ファイルごとに呼ぶ関数(ファイル名、状態、pUser)
+        pUser：funcに渡す値
+【備考】ディレクトリ("."、".."を含む)は列挙しません。
+ =======================================================================*/
+typedef void (*MtoDirFunc)(const char *pName, const MtoFileStatus &status, void *pUser);
+
+static inline bool MtoDirScan(const char *pDir, MtoDirFunc func, void *pUser)
+{
+	char path[1024];
+
+#if defined(_WIN32)
+	WIN32_FIND_DATAA data;
+	HANDLE hFind;
+
+	_snprintf(path, sizeof(path), "%s\\*", pDir);
+	path[sizeof(path) - 1] = '\0';
+	if ((hFind = FindFirstFileA(path, &data)) == INVALID_HANDLE_VALUE) return false;
+
+	do {
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+
+		const unsigned long long t = (static_cast<unsigned long long>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+		MtoFileStatus status;
+		status.size = (static_cast<unsigned long long>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+		status.time = static_cast<long long>(t / 10000000ULL) - 11644473600LL;
+
+		func(data.cFileName, status, pUser);
+	} while (FindNextFileA(hFind, &data));
+
+	FindClose(hFind);
+#else
+	DIR *pDirp;
+	struct dirent *pEnt;
+
+	if ((pDirp = opendir(pDir)) == NULL) return false;
+
+	while ((pEnt = readdir(pDirp)) != NULL) {
+		MtoFileStatus status;
+
+		snprintf(path, sizeof(path), "%s/%s", pDir, pEnt->d_name);
+		if (!MtoFileGetStatus(path, &status)) continue;
+
+		func(pEnt->d_name, status, pUser);
+	}
+
+	closedir(pDirp);
+#endif
+
+	return true;
+}
+
+/*=======================================================================
+【機能】ディレクトリ内のサブディレクトリを列挙
+【引数】pDir ：ディレクトリ名
+        func ：サブディレクトリごとに呼ぶ関数(ディレクトリ名、pUser)
+        pUser：funcに渡す値
+【備考】"."、".."とシンボリックリンク(ジャンクション)は列挙しません。
+ =======================================================================*/
+typedef void (*MtoSubDirFunc)(const char *pName, void *pUser);
+
+static inline bool MtoDirScanSub(const char *pDir, MtoSubDirFunc func, void *pUser)
+{
+	char path[1024];
+
+#if defined(_WIN32)
+	WIN32_FIND_DATAA data;
+	HANDLE hFind;
+
+	_snprintf(path, sizeof(path), "%s\\*", pDir);
+	path[sizeof(path) - 1] = '\0';
+	if ((hFind = FindFirstFileA(path, &data)) == INVALID_HANDLE_VALUE) return false;
+
+	do {
+		if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) continue;
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) continue;
+		if (strcmp(data.cFileName, ".") == 0 || strcmp(data.cFileName, "..") == 0) continue;
+
+		func(data.cFileName, pUser);
+	} while (FindNextFileA(hFind, &data));
+
+	FindClose(hFind);
+#else
+	DIR *pDirp;
+	struct dirent *pEnt;
+
+	if ((pDirp = opendir(pDir)) == NULL) return false;
+
+	while ((pEnt = readdir(pDirp)) != NULL) {
+		struct stat st;
+
+		if (strcmp(pEnt->d_name, ".") == 0 || strcmp(pEnt->d_name, "..") == 0) continue;
+
+		snprintf(path, sizeof(path), "%s/%s", pDir, pEnt->d_name);
+		if (lstat(path, &st) != 0 || !S_ISDIR(st.st_mode)) continue;
+
+		func(pEnt->d_name, pUser);
+	}
+
+	closedir(pDirp);
+#endif
+
+	return true;
+}
+
+/*=======================================================================
+【機能】ファイルのメモリマップ
+【備考】コピーオンライトでマップするので、書き換えてもファイルには
+        反映されません(書き換えたページだけメモリを使います)。
+ =======================================================================*/
+class CMtoFileMap {
+private:
+	unsigned char		*m_pData;	// マップしたアドレス
+	unsigned long long	m_Size;		// サイズ
+#if defined(_WIN32)
+	HANDLE				m_hMap;
+#endif
+
+	// コピー禁止
+	CMtoFileMap(const CMtoFileMap&);
+	CMtoFileMap &operator=(const CMtoFileMap&);
+
+public:
+	CMtoFileMap(void)
+	{
+		m_pData = NULL;
+		m_Size  = 0;
+#if defined(_WIN32)
+		m_hMap  = NULL;
+#endif
+	}
+	virtual ~CMtoFileMap(void) {this->Close();}
+
+	unsigned char *getData(void)     const {return m_pData;}
+	unsigned long long getSize(void) const {return m_Size;}
+
+	/*=======================================================================
+	【機能】マップ
+	【引数】pFileName：ファイル名
+	【戻値】true：成功(空のファイルは失敗)
+	 =======================================================================*/
+	bool Open(const char *pFileName)
+	{
+		this->Close();
+
+#if defined(_WIN32)
+		HANDLE hFile = CreateFileA(pFileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0 || static_cast<unsigned long long>(size.QuadPart) > static_cast<SIZE_T>(-1)) {
+			CloseHandle(hFile);
+			return false;
+		}
+
+		// ファイルのハンドルはマップ後に閉じてよい
+		m_hMap = CreateFileMappingA(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		CloseHandle(hFile);
+		if (m_hMap == NULL) return false;
+
+		if ((m_pData = static_cast<unsigned char*>(MapViewOfFile(m_hMap, FILE_MAP_COPY, 0, 0, 0))) == NULL) {
+			CloseHandle(m_hMap);
+			m_hMap = NULL;
+			return false;
+		}
+		m_Size = static_cast<unsigned long long>(size.QuadPart);
+#else
+		int fd;
+		struct stat st;
+
+		if ((fd = open(pFileName, O_RDONLY)) < 0) return false;
+
+		if (fstat(fd, &st) != 0 || st.st_size <= 0 || static_cast<unsigned long long>(st.st_size) > static_cast<size_t>(-1)) {
+			close(fd);
+			return false;
+		}
+
+		// ファイルディスクリプタはマップ後に閉じてよい
+		void *p = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (p == MAP_FAILED) return false;
+
+		m_pData = static_cast<unsigned char*>(p);
+		m_Size  = static_cast<unsigned long long>(st.st_size);
+#endif
+
+		return true;
+	}
+
+	/*=======================================================================
+	【機能】アンマップ
+	 =======================================================================*/
+	void Close(void)
+	{
+		if (m_pData == NULL) return;
+
+#if defined(_WIN32)
+		UnmapViewOfFile(m_pData);
+		CloseHandle(m_hMap);
+		m_hMap = NULL;
+#else
+		munmap(m_pData, static_cast<size_t>(m_Size));
+#endif
+
+		m_pData = NULL;
+		m_Size  = 0;
+	}
+};
+
+#endif
@@ -0,0 +1,195 @@
+/*=============================================================================
+ * スレッド関係の最低限のラッパー。
+ * Windows(Win32 API)とLinux(pthread)に対応。
+ * Windowsではwindows.hをインクルードするので、mto_common.hより先に
+ * インクルードしてください。
+=============================================================================*/
+#ifndef _MTO_THREAD_H_
+#define _MTO_THREAD_H_
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#include <errno.h>
+#endif
+
+
+/*=======================================================================
+【機能】ミューテックス
+【備考】同じスレッドから2重にロックしないこと。
+ =======================================================================*/
+class CMtoMutex {
+private:
+#if defined(_WIN32)
+	CRITICAL_SECTION	m_Cs;
+#else
+	pthread_mutex_t		m_Mutex;
+#endif
+
+	// コピー禁止
+	CMtoMutex(const CMtoMutex&);
+	CMtoMutex &operator=(const CMtoMutex&);
+
+public:
+#if defined(_WIN32)
+	CMtoMutex(void)          {InitializeCriticalSection(&m_Cs);}
+	virtual ~CMtoMutex(void) {DeleteCriticalSection(&m_Cs);}
+
+	void Lock(void)   {EnterCriticalSection(&m_Cs);}
+	void Unlock(void) {LeaveCriticalSection(&m_Cs);}
+#else
+	CMtoMutex(void)          {pthread_mutex_init(&m_Mutex, NULL);}
+	virtual ~CMtoMutex(void) {pthread_mutex_destroy(&m_Mutex);}
+
+	void Lock(void)   {pthread_mutex_lock(&m_Mutex);}
+	void Unlock(void) {pthread_mutex_unlock(&m_Mutex);}
+#endif
+};
+
+/*=======================================================================
+【機能】スコープロック
+【備考】作成時にロックして、破棄時にアンロックします。
+ =======================================================================*/
+class CMtoLock {
+private:
+	CMtoMutex	&m_Mutex;
+
+	// コピー禁止
+	CMtoLock(const CMtoLock&);
+	CMtoLock &operator=(const CMtoLock&);
+
+public:
+	CMtoLock(CMtoMutex &mutex) : m_Mutex(mutex) {m_Mutex.Lock();}
+	~CMtoLock(void) {m_Mutex.Unlock();}
+};
+
+/*=======================================================================
+【機能】スレッド間で共有するフラグ
+【備考】Setより前の書き込みは、Getでtrueを見たスレッドから見えることを
+        保証します(ロックせずに完了を確認する場合に使う)。
+        一度Setしたら戻せません。
+ =======================================================================*/
+class CMtoFlag {
+private:
+	volatile long		m_Value;
+
+	// コピー禁止
+	CMtoFlag(const CMtoFlag&);
+	CMtoFlag &operator=(const CMtoFlag&);
+
+public:
+	CMtoFlag(void) : m_Value(0) {}
+
+#if defined(_WIN32)
+	bool Get(void) const {const long value = m_Value; MemoryBarrier(); return (value != 0);}
+	void Set(void)       {MemoryBarrier(); m_Value = 1;}
+#else
+	bool Get(void) const {return (__atomic_load_n(&m_Value, __ATOMIC_ACQUIRE) != 0);}
+	void Set(void)       {__atomic_store_n(&m_Value, 1, __ATOMIC_RELEASE);}
+#endif
+};
+
+/*=======================================================================
+【機能】セマフォ
+ =======================================================================*/
+class CMtoSemaphore {
+private:
+#if defined(_WIN32)
+	HANDLE				m_hSem;
+#else
+	sem_t				m_Sem;
+#endif
+
+	// コピー禁止
+	CMtoSemaphore(const CMtoSemaphore&);
+	CMtoSemaphore &operator=(const CMtoSemaphore&);
+
+public:
+#if defined(_WIN32)
+	CMtoSemaphore(const unsigned int count = 0) {m_hSem = CreateSemaphore(NULL, count, 0x7fffffff, NULL);}
+	virtual ~CMtoSemaphore(void)                {CloseHandle(m_hSem);}
+
+	void Wait(void) {WaitForSingleObject(m_hSem, INFINITE);}
+	void Post(void) {ReleaseSemaphore(m_hSem, 1, NULL);}
+#else
+	CMtoSemaphore(const unsigned int count = 0) {sem_init(&m_Sem, 0, count);}
+	virtual ~CMtoSemaphore(void)                {sem_destroy(&m_Sem);}
+
+	void Wait(void) {while (sem_wait(&m_Sem) != 0 && errno == EINTR) {}}
+	void Post(void) {sem_post(&m_Sem);}
+#endif
+};
+
+/*=======================================================================
+【機能】スレッド
+【備考】Startで開始して、Joinで終了を待ちます。
+        破棄する前に必ずJoinしてください。
+ =======================================================================*/
+typedef void (*MtoThreadFunc)(void *pArg);
+
+class CMtoThread {
+private:
+	MtoThreadFunc		m_Func;
+	void				*m_pArg;
+	bool				m_bRun;
+#if defined(_WIN32)
+	HANDLE				m_hThread;
+
+	static unsigned int __stdcall Entry(void *p) {
+		CMtoThread *pThread = static_cast<CMtoThread*>(p);
+		pThread->m_Func(pThread->m_pArg);
+		return 0;
+	}
+#else
+	pthread_t			m_Thread;
+
+	static void *Entry(void *p) {
+		CMtoThread *pThread = static_cast<CMtoThread*>(p);
+		pThread->m_Func(pThread->m_pArg);
+		return NULL;
+	}
+#endif
+
+	// コピー禁止
+	CMtoThread(const CMtoThread&);
+	CMtoThread &operator=(const CMtoThread&);
+
+public:
+	CMtoThread(void) : m_Func(NULL), m_pArg(NULL), m_bRun(false) {}
+	virtual ~CMtoThread(void) {this->Join();}
+
+	bool isRunning(void) const {return m_bRun;}
+
+	bool Start(MtoThreadFunc func, void *pArg)
+	{
+		if (m_bRun) return false;
+
+		m_Func = func;
+		m_pArg = pArg;
+#if defined(_WIN32)
+		m_hThread = reinterpret_cast<HANDLE>(_beginthreadex(NULL, 0, Entry, this, 0, NULL));
+		m_bRun    = (m_hThread != NULL);
+#else
+		m_bRun = (pthread_create(&m_Thread, NULL, Entry, this) == 0);
+#endif
+		return m_bRun;
+	}
+
+	void Join(void)
+	{
+		if (!m_bRun) return;
+
+#if defined(_WIN32)
+		WaitForSingleObject(m_hThread, INFINITE);
+		CloseHandle(m_hThread);
+#else
+		pthread_join(m_Thread, NULL);
+#endif
+		m_bRun = false;
+	}
+};
+
+#endif
@@ -1,750 +1,1442 @@
-#include "mto_common.h"
-#include "tga.h"
-
-
-/*=======================================================================
-y@\z
- =======================================================================*/
-CTga::CTga(void)
-{
-	memset(&m_Header, 0, sizeof(m_Header));
-	memset(&m_Footer, 0, sizeof(m_Footer));
-	m_pImage   = NULL;
-	m_pPalette = NULL;
-
-	m_ImageSize   = 0;
-	m_PaletteSize = 0;
-}
-
-/*=======================================================================
-y@\z
- =======================================================================*/
-CTga::~CTga(void)
-{
-	SAFE_DELETES(m_pImage);
-	SAFE_DELETES(m_pPalette);
-}
-
-
-/*=======================================================================
-y@\zt@Cǂݍ
-yzpFileNameFt@C
- =======================================================================*/
-int CTga::Create(const char *pFileName)
-{
-	FILE *fp;
-	uint8 *mem;
-	uint32 size;
-
-#ifndef NDEBUG
-	_ASSERT(pFileName != NULL);
-#else
-	if (pFileName == NULL) return ERROR_OPEN;
-#endif
-
-	if ((fp = fopen(pFileName, "rb")) == NULL) {
-		DBG_PRINT("file not found!\n");
-		return ERROR_OPEN;
-	}
-
-	// get file size
-	fseek(fp, 0, SEEK_END);
-	size = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
-
-	// read file to memory
-	if ((mem = new uint8[size]) == NULL) {
-		fclose(fp);
-		return ERROR_MEMORY;
-	}
-	fread(mem, size, 1, fp);
-	fclose(fp);
-
-	// ǂݍ
-	int ret = this->Create(mem, size);
-	SAFE_DELETES(mem);
-
-	return ret;
-}
-
-/*=======================================================================
-y@\z쐬
-yzpSrcF摜f[^AhX
-        sizeF摜f[^TCY
- =======================================================================*/
-int CTga::Create(const void *pSrc, const uint32 size)
-{
-	uint32 offset;
-
-#ifndef NDEBUG
-	_ASSERT(pSrc != NULL);
-	_ASSERT(size);
-#else
-	if (pSrc == NULL || size == 0) return ERROR_HEADER;
-#endif
-
-	// ɍ쐬ĂȂ폜
-	if (m_pImage != NULL) {
-		this->Clear();
-	}
-
-	// wb_[ǂݍ
-	if (!this->ReadHeader(static_cast<const uint8*>(pSrc))) {
-		return ERROR_HEADER;
-	}
-
-	// ImagePalettẽTCY߂
-	if (!this->CalcSize(true)) {
-		this->Clear();
-		return ERROR_MEMORY;
-	}
-
-	// pbgǂݍ
-	if (!this->ReadPalette(static_cast<const uint8*>(pSrc))) {
-		this->Clear();
-		return ERROR_PALETTE;
-	}
-
-	// C[Wǂݍ
-	if (!this->ReadImage(static_cast<const uint8*>(pSrc), size, &offset)) {
-		this->Clear();
-		return ERROR_IMAGE;
-	}
-
-	// tb^[ǂݍ
-	offset += HEADER_SIZE + m_Header.IDField + m_PaletteSize;
-	if ((size - offset) >= FOOTER_SIZE) {
-		this->ReadFooter(static_cast<const uint8*>(pSrc), offset);
-	}
-
-	return ERROR_NONE;
-}
-
-/*=======================================================================
-y@\zwf[^쐬
-yzheader     FTGAwb_[
-        pImage     FC[Wf[^AhX
-        imageSize  FC[Wf[^TCY
-        pPalette   Fpbgf[^AhX
-        paletteSizeFpbgf[^TCY
- =======================================================================*/
-int CTga::Create(const TGAHeader &header, uint8 *pImage, const uint32 imageSize, uint8 *pPalette, const uint32 paletteSize)
-{
-	// `FbN
-	if (pImage == NULL || imageSize == 0) return ERROR_IMAGE;
-	if (pPalette != NULL && paletteSize == 0) return ERROR_PALETTE;
-	if (pPalette == NULL && paletteSize != 0) return ERROR_PALETTE;
-
-	// wb_[`FbN
-	if (!this->CheckSupport(header)) return ERROR_HEADER;
-
-	// ɍ쐬ĂȂ폜
-	if (m_pImage != NULL) {
-		this->Clear();
-	}
-
-	m_Header      = header;
-	m_pImage      = pImage;
-	m_ImageSize   = imageSize;
-	m_pPalette    = pPalette;
-	m_PaletteSize = paletteSize;
-
-	return ERROR_NONE;
-}
-
-/*=======================================================================
-y@\zt@Co
-yzpFileNameFo̓t@C
- =======================================================================*/
-int CTga::Output(const char *pFileName)
-{
-#ifndef NDEBUG
-	_ASSERT(pFileName != NULL);
-#else
-	if (pFileName == NULL) return ERROR_OUTPUT;
-#endif
-
-	// ǂݍ܂ĂȂH
-	if (m_pImage == NULL) return ERROR_NONE;
-
-	// o̓t@CI[v
-	FILE *fp;
-	if ((fp = fopen(pFileName, "wb")) == NULL) {
-		DBG_PRINT("file can't open!\n");
-		return ERROR_OPEN;
-	}
-
-	// wb_[o
-	this->WriteHeader(fp);
-
-	// pbgo
-	if (m_pPalette != NULL) {
-		fwrite(m_pPalette, m_PaletteSize, 1, fp);
-	}
-
-	// C[Wo
-	fwrite(m_pImage, m_ImageSize, 1, fp);
-
-	// tb^[o
-	this->WriteFooter(fp);
-
-	fclose(fp);
-
-	return ERROR_NONE;
-}
-
-/*=======================================================================
-y@\zBMPo
-yzpFileNameFo̓t@C
- =======================================================================*/
-int CTga::OutputBMP(const char *pFileName)
-{
-#ifndef NDEBUG
-	_ASSERT(pFileName != NULL);
-#else
-	if (pFileName == NULL) return ERROR_OUTPUT;
-#endif
-
-	// ǂݍ܂ĂȂH
-	if (m_pImage == NULL) return ERROR_NONE;
-
-	// o̓t@CI[v
-	FILE *fp;
-	if ((fp = fopen(pFileName, "wb")) == NULL) {
-		DBG_PRINT("file can't open!\n");
-		return ERROR_OPEN;
-	}
-
-	// BMPwb_[쐬
-	uint32 hsize, isize, psize;
-	BITMAPFILEHEADER bmHead;
-	BITMAPINFOHEADER bmInfo;
-
-	memset(&bmHead, 0, sizeof(bmHead));
-	memset(&bmInfo, 0, sizeof(bmInfo));
-
-	hsize = sizeof(BITMAPFILEHEADER);
-	isize = sizeof(BITMAPINFOHEADER);
-	psize = sizeof(RGBQUAD) * m_Header.paletteColor;
-
-	bmHead.bfType = 0x4D42; //BM
-	bmHead.bfSize = m_ImageSize + hsize + isize + psize;
-	bmHead.bfReserved1 = 0;
-	bmHead.bfReserved2 = 0;
-	bmHead.bfOffBits   = hsize + isize + psize;
-
-	bmInfo.biSize   = isize;
-	bmInfo.biWidth  = m_Header.imageW;
-	bmInfo.biHeight = m_Header.imageH;
-	bmInfo.biPlanes = 1;
-	bmInfo.biBitCount = m_Header.imageBit;
-
-
-	// wb_[o
-	fwrite(&bmHead, hsize, 1, fp);
-	fwrite(&bmInfo, isize, 1, fp);
-
-	// pbgo
-	if (m_pPalette != NULL) {
-		if (m_Header.paletteBit == 24) {
-			uint8 *pPalette = m_pPalette;
-			uint8 alpha = 0x00;
-
-			for (int i = 0; i < m_Header.paletteColor; i++) {
-				fwrite(pPalette++, sizeof(uint8), 1, fp);
-				fwrite(pPalette++, sizeof(uint8), 1, fp);
-				fwrite(pPalette++, sizeof(uint8), 1, fp);
-				fwrite(&alpha    , sizeof(uint8), 1, fp);
-			}
-		} else {
-			fwrite(m_pPalette, m_PaletteSize, 1, fp);
-		}
-	}
-
-	// C[Wói4ŊȂ摜ւ̑Ή͂Ă܂j
-	this->ConvertType(IMAGE_LINE_LRDU); // EAzɕϊ
-	fwrite(m_pImage, m_ImageSize, 1, fp);
-
-	fclose(fp);
-
-	return ERROR_NONE;
-}
-
-/*=======================================================================
-y@\zBGRAzRGBAzɕύX
-ylzRGBAɕύXƍēxĂԂBGRAzɂȂ܂B
- =======================================================================*/
-bool CTga::ConvertRGBA(void)
-{
-	if (m_pImage == NULL) return false;
-
-	uint8 r, b;
-	uint8 byte;
-	uint32 offset;
-
-	// pbg
-	if (m_pPalette) {
-		byte = m_Header.paletteBit >> 3;
-
-		for (offset = 0; offset < m_PaletteSize; offset += byte) {
-			r = m_pPalette[offset + 2];
-			b = m_pPalette[offset + 0];
-			m_pPalette[offset + 2] = b;
-			m_pPalette[offset + 0] = r;
-		}
-	}
-
-	// C[W
-	byte = m_Header.imageBit >> 3;
-
-	if (m_Header.imageBit <= 8) {
-		// IndexColorȂ珈Ȃ
-		return true;
-	} else if (m_Header.imageBit == 16) {
-		uint16 r, g, b, a;
-		uint16 *pImage = reinterpret_cast<uint16*>(m_pImage);
-
-		// RGBA:5551
-		for (offset = 0; offset < m_ImageSize; offset += byte) {
-			a = (*pImage & 0x8000);
-			r = (*pImage & 0x7c00) >> 10;
-			g = (*pImage & 0x03e0);
-			b = (*pImage & 0x001f) << 10;
-			*pImage++ = (a | r | g | b);
-		}
-	} else {
-		for (offset = 0; offset < m_ImageSize; offset += byte) {
-			r = m_pImage[offset + 2];
-			b = m_pImage[offset + 0];
-			m_pImage[offset + 2] = b;
-			m_pImage[offset + 0] = r;
-		}
-	}
-
-	return true;
-}
-
-/*=======================================================================
-y@\zw̃rbgzɕϊ
-yztypeFC^Cv
- =======================================================================*/
-bool CTga::ConvertType(const sint32 type)
-{
-	if (type >= IMAGE_LINE_MAX) return false;
-	if (m_pImage == NULL) return false;
-
-	// ꏏȂ珈Ȃ
-	if ((m_Header.discripter & 0xf0) == type) return true;
-
-	uint8 *pImage;
-
-	// ϊp̃m
-	if ((pImage = new uint8[m_ImageSize]) == NULL) {
-		return false;
-	}
-
-	// zϊ
-	uint16 tx, ty;
-	uint32 ofsSrc, ofsDst;
-
-	ofsDst = 0;
-	for (int y = 0; y < m_Header.imageH; y++) {
-		ty = y;
-		if ((m_Header.discripter & 0x20) != (type & 0x20)) {
-			// ݂YvȂȂ甽]
-			ty = m_Header.imageH - y - 1;
-		}
-
-		for (int x = 0; x < m_Header.imageW; x++) {
-			tx = x;
-			if ((m_Header.discripter & 0x10) != (type & 0x10)) {
-				// ݂XvȂȂ甽]
-				tx = m_Header.imageW - x - 1;
-			}
-			ofsSrc = (ty * m_Header.imageW) + tx;
-
-			if (m_Header.imageBit == 8) {
-				pImage[ofsDst++] = m_pImage[ofsSrc];
-
-			} else if (m_Header.imageBit == 16) {
-				uint16 *pSrc = reinterpret_cast<uint16*>(m_pImage);
-				uint16 *pDst = reinterpret_cast<uint16*>(pImage);
-				pDst[ofsDst++] = pSrc[ofsSrc];
-
-			} else if (m_Header.imageBit == 24) {
-				ofsSrc *= 3;
-				pImage[ofsDst++] = m_pImage[ofsSrc++];
-				pImage[ofsDst++] = m_pImage[ofsSrc++];
-				pImage[ofsDst++] = m_pImage[ofsSrc++];
-
-			} else if (m_Header.imageBit == 32) {
-				ofsSrc *= 4;
-				pImage[ofsDst++] = m_pImage[ofsSrc++];
-				pImage[ofsDst++] = m_pImage[ofsSrc++];
-				pImage[ofsDst++] = m_pImage[ofsSrc++];
-				pImage[ofsDst++] = m_pImage[ofsSrc++];
-			}
-		}
-	}
-
-	// jĕϊ̃f[^ێ
-	SAFE_DELETES(m_pImage);
-	m_pImage = pImage;
-
-	// C[WLqqύX
-	m_Header.discripter = type;
-
-	return true;
-}
-
-/*=======================================================================
-y@\zNA
-ylzJ
- =======================================================================*/
-void CTga::Clear(void)
-{
-	SAFE_DELETES(m_pImage);
-	SAFE_DELETES(m_pPalette);
-
-	memset(&m_Header, 0, sizeof(m_Header));
-	memset(&m_Footer, 0, sizeof(m_Footer));
-
-	m_ImageSize   = 0;
-	m_PaletteSize = 0;
-}
-
-/*=======================================================================
-y@\zΉ`FbN
-yzheaderFTGAwb_[
-ylzJ
- =======================================================================*/
-bool CTga::CheckSupport(const TGAHeader &header)
-{
-	// _0ł͂ȂH
-	if (header.imageX != 0 && header.imageY != 0) return false;
-
-	// ΉĂȂC[W^CvH
-	if (!((IMAGE_TYPE_NONE < header.imageType && header.imageType < IMAGE_TYPE_MAX) ||
-		  (IMAGE_TYPE_INDEX_RLE <= header.imageType && header.imageType < IMAGE_TYPE_RLE_MAX))) {
-		return false;
-	}
-
-	// ΉrbgH
-	if (header.imageBit !=  8 && header.imageBit != 16 &&
-		header.imageBit != 24 && header.imageBit != 32) {
-		return false;
-	}
-
-	// ΉpbgH
-	if (header.usePalette) {
-		if (header.paletteIndex != 0) return false;
-		if (header.paletteBit != 24 && header.paletteBit != 32) return false;
-	}
-
-	return true;
-}
-
-/*=======================================================================
-y@\zTGAwb_[ǂݍ
-yzpSrcF摜f[^AhX
-ylzJ
- =======================================================================*/
-bool CTga::ReadHeader(const uint8 *pSrc)
-{
-#ifndef NDEBUG
-	_ASSERT(pSrc != NULL);
-#else
-	if (pSrc == NULL) return false;
-#endif
-
-	uint32 offset = 0;
-
-	m_Header.IDField      = pSrc[offset++];
-	m_Header.usePalette   = pSrc[offset++];
-	m_Header.imageType    = pSrc[offset++];
-	m_Header.paletteIndex = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
-	m_Header.paletteColor = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
-	m_Header.paletteBit   = pSrc[offset++];
-	m_Header.imageX       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
-	m_Header.imageY       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
-	m_Header.imageW       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
-	m_Header.imageH       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
-	m_Header.imageBit     = pSrc[offset++];
-	m_Header.discripter   = pSrc[offset++];
-
-	_ASSERT(offset == HEADER_SIZE);
-
-	return this->CheckSupport(m_Header);
-}
-
-/*=======================================================================
-y@\zTGAtb^[ǂݍ
-yzpSrc@F摜f[^AhX
-        offsetFtb^[܂ł̃ItZbg
-ylzJ
- =======================================================================*/
-void CTga::ReadFooter(const uint8 *pSrc, const uint32 offset)
-{
-#ifndef NDEBUG
-	_ASSERT(pSrc != NULL);
-#else
-	if (pSrc == NULL) return;
-#endif
-
-	uint32 offs = offset;
-
-	memcpy(&m_Footer.filePos, &pSrc[offs], sizeof(m_Footer.filePos)); offs += sizeof(m_Footer.filePos);
-	memcpy(&m_Footer.fileDev, &pSrc[offs], sizeof(m_Footer.fileDev)); offs += sizeof(m_Footer.fileDev);
-	memcpy(m_Footer.version,  &pSrc[offs], sizeof(m_Footer.version)); offs += sizeof(m_Footer.version);
-
-	_ASSERT((offs - offset) == FOOTER_SIZE);
-}
-
-/*=======================================================================
-y@\zImage/PaletteTCY߂
-yzbFlgFmۂsH
-ylzJ
- =======================================================================*/
-bool CTga::CalcSize(const bool bFlg)
-{
-	m_ImageSize   = m_Header.imageW * m_Header.imageH * (m_Header.imageBit >> 3);
-	m_PaletteSize = m_Header.usePalette * m_Header.paletteColor * (m_Header.paletteBit >> 3);
-
-	if (bFlg) {
-		if ((m_pImage = new uint8[m_ImageSize]) == NULL) return false;
-
-		// pbgȂ烁m
-		if (m_Header.usePalette) {
-			if ((m_pPalette = new uint8[m_PaletteSize]) == NULL) return false;
-		}
-	}
-
-	return true;
-}
-
-/*=======================================================================
-y@\zImageǂݍ
-yzpSrc  F摜f[^AhX
-        size  F摜f[^TCY
-        offsetFۑ挳C[WTCYiRLȄꍇ͈k̃TCYj
-ylzJ
- =======================================================================*/
-bool CTga::ReadImage(const uint8 *pSrc, const uint32 size, uint32 *pOffset)
-{
-#ifndef NDEBUG
-	_ASSERT(pSrc != NULL);
-	_ASSERT(m_pImage != NULL);
-#else
-	if (pSrc == NULL || m_pImage == NULL) return false;
-#endif
-
-	uint8 *pWork  = const_cast<uint8*>(pSrc) + HEADER_SIZE + m_Header.IDField + m_PaletteSize;
-	uint8 *pImage = m_pImage;
-	uint32 offset = 0;
-
-	if (IMAGE_TYPE_INDEX_RLE <= m_Header.imageType && m_Header.imageType < IMAGE_TYPE_RLE_MAX) {
-		// RLEk
-		offset = this->UnpackRLE(m_pImage, pWork, size);
-		if (offset == static_cast<uint32>(-1)) return false;
-	} else {
-		// 񈳏k
-		memcpy(pImage, pWork, m_ImageSize);
-		offset = m_ImageSize;
-	}
-
-	if (pOffset != NULL) *pOffset = offset;
-
-	return true;
-}
-
-/*=======================================================================
-y@\zPaletteǂݍ
-yzpSrcF摜f[^AhX
-ylzJ
- =======================================================================*/
-bool CTga::ReadPalette(const uint8 *pSrc)
-{
-#ifndef NDEBUG
-	_ASSERT(pSrc != NULL);
-#else
-	if (pSrc == NULL) return false;
-#endif
-
-	// IndexColor?
-	if (m_Header.imageType != IMAGE_TYPE_INDEX && m_Header.imageType != IMAGE_TYPE_INDEX_RLE) {
-		return true;
-	}
-
-	// Palette OK?
-	if (m_pPalette == NULL) return false;
-
-	uint8 *pWork = const_cast<uint8*>(pSrc) + HEADER_SIZE + m_Header.IDField;
-	uint8 *pPalette = m_pPalette;
-	uint16 i; // VC6.0ł̓RpCʂȂ̂ŊOɏo
-
-	switch (m_Header.paletteBit) {
-	case 24:
-		for (i = 0; i < m_Header.paletteColor; i++) {
-			*pPalette++ = *pWork++;
-			*pPalette++ = *pWork++;
-			*pPalette++ = *pWork++;
-		}
-		break;
-	case 32:
-		for (i = 0; i < m_Header.paletteColor; i++) {
-			*pPalette++ = *pWork++;
-			*pPalette++ = *pWork++;
-			*pPalette++ = *pWork++;
-			*pPalette++ = *pWork++;
-		}
-		break;
-	default:
-		DBG_PRINT("not support palette data!!\n");
-		return false;
-	}
-
-	return true;
-}
-
-/*=======================================================================
-y@\zRLEk
-yzpDstFWJ
-        pSrcF摜f[^AhX
-        sizeF摜f[^TCY
-ylzJ
- =======================================================================*/
-uint32 CTga::UnpackRLE(uint8 *pDst, const uint8 *pSrc, const uint32 size)
-{
-#ifndef NDEBUG
-	_ASSERT(pSrc != NULL);
-	_ASSERT(pDst != NULL);
-#else
-	if (pSrc == NULL || pDst == NULL) return false;
-#endif
-
-	bool bFlg;
-	uint16 loop;
-	uint32 offset  = 0;
-//	uint32 endAddr = reinterpret_cast<uint32>(pDst) + m_ImageSize;
-	uint32 count   = 0;
-
-	uint8 byte = m_Header.imageBit >> 3; // oCgTCY
-
-//	while (reinterpret_cast<uint32>(pDst) < endAddr) {
-	while (count < m_ImageSize) {
-		bFlg = (pSrc[offset] & 0x80) ? false : true; // ʃrbg0Ȃ烊eO[v
-		loop = (pSrc[offset] & 0x7f) + 1;
-		offset++;
-
-		if (bFlg) {
-			// eO[v
-			// oCǧipSrc[offset] & 0x7f)+1̃f[^isNZoCgPʁjRs[
-			for (uint16 i = 0; i < loop; i++) {
-				for (uint32 j = 0; j < byte; j++) {
-//					*pDst++ = pSrc[offset++];
-					pDst[count++] = pSrc[offset++];
-				}
-			}
-		} else {
-			// 
-			// ɑf[^oCgisNZoCgPʁjipSrc[offset] & 0x7f)+1JԂ
-			for (uint16 i = 0; i < loop; i++) {
-				for (uint32 j = 0; j < byte; j++) {
-//					*pDst++ = pSrc[offset + j];
-					pDst[count++] = pSrc[offset + j];
-				}
-			}
-			offset += byte;
-		}
-
-		// 𓀂̂`FbN
-		if (offset > size) {
-			DBG_PRINT("UnpackRLE error!!\n");
-			_ASSERT(0);
-			return -1;
-		}
-	}
-
-	_ASSERT(count == m_ImageSize);
-
-	return offset;
-}
-
-/*=======================================================================
-y@\zTGAwb_[o
-yzfp     FFILE|C^
-        pHeaderFo͂TGAwb_[
-ylzACgɉĂȂ̂ŌʏóB
- =======================================================================*/
-bool CTga::WriteHeader(FILE *fp)
-{
-	return this->WriteHeader(fp, &m_Header);
-}
-
-bool CTga::WriteHeader(FILE *fp, TGAHeader *pHeader)
-{
-#ifndef NDEBUG
-	_ASSERT(fp != NULL);
-	_ASSERT(pHeader != NULL);
-#else
-	if (fp == NULL || pHeader == NULL) return false;
-#endif
-
-	// TODO:RLEko͑Ή
-	//      2008/04/01_ł͔Ή
-	if (IMAGE_TYPE_INDEX_RLE <= pHeader->imageType && pHeader->imageType < IMAGE_TYPE_RLE_MAX) {
-		pHeader->imageType -= 8; // 񈳏kɂ
-	}
-
-	fwrite(&pHeader->IDField     , sizeof(pHeader->IDField)     , 1, fp);
-	fwrite(&pHeader->usePalette  , sizeof(pHeader->usePalette)  , 1, fp);
-	fwrite(&pHeader->imageType   , sizeof(pHeader->imageType)   , 1, fp);
-	fwrite(&pHeader->paletteIndex, sizeof(pHeader->paletteIndex), 1, fp);
-	fwrite(&pHeader->paletteColor, sizeof(pHeader->paletteColor), 1, fp);
-	fwrite(&pHeader->paletteBit  , sizeof(pHeader->paletteBit)  , 1, fp);
-	fwrite(&pHeader->imageX      , sizeof(pHeader->imageX)      , 1, fp);
-	fwrite(&pHeader->imageY      , sizeof(pHeader->imageY)      , 1, fp);
-	fwrite(&pHeader->imageW      , sizeof(pHeader->imageW)      , 1, fp);
-	fwrite(&pHeader->imageH      , sizeof(pHeader->imageH)      , 1, fp);
-	fwrite(&pHeader->imageBit    , sizeof(pHeader->imageBit)    , 1, fp);
-	fwrite(&pHeader->discripter  , sizeof(pHeader->discripter)  , 1, fp);
-
-	return true;
-}
-
-/*=======================================================================
-y@\zTGAtb^[o
-yzfp     FFILE|C^
-        pHeaderFo͂TGAtb^[
-ylzACgɉĂȂ̂ŌʏóB
- =======================================================================*/
-bool CTga::WriteFooter(FILE *fp)
-{
-	return this->WriteFooter(fp, &m_Footer);
-}
-
-bool CTga::WriteFooter(FILE *fp, TGAFooter *pFooter)
-{
-#ifndef NDEBUG
-	_ASSERT(fp != NULL);
-	_ASSERT(pFooter != NULL);
-#else
-	if (fp == NULL || pFooter == NULL) return false;
-#endif
-
-	// 摜Ƀtb^[tĂ`FbN
-	int ret = 0;
-	for (int i = 0; i < 18; i++) {
-		ret += pFooter->version[i];
-	}
-
-	fwrite(&pFooter->filePos, sizeof(pFooter->filePos), 1, fp);
-	fwrite(&pFooter->fileDev, sizeof(pFooter->fileDev), 1, fp);
-
-	if (ret == 0) {
-		strcpy(reinterpret_cast<char*>(pFooter->version), "TRUEVISION-TARGA");
-	}
-	fwrite(pFooter->version, sizeof(pFooter->version), 1, fp);
-
-	return true;
-}
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+#include "tga_sidecar.h"
+#include "tga_stream.h"
+
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTga::CTga(void)
+{
+	memset(&m_Header, 0, sizeof(m_Header));
+	memset(&m_Footer, 0, sizeof(m_Footer));
+	m_pImage   = NULL;
+	m_pPalette = NULL;
+
+	m_ImageSize   = 0;
+	m_PaletteSize = 0;
+
+	m_CreateFlag     = CREATE_FLAG_NONE;
+	m_bPremultiplied = false;
+	m_bRGBA          = false;
+	m_Hash           = 0;
+
+	m_pMap      = NULL;
+	m_pShare    = NULL;
+	m_pSidecar  = NULL;
+	m_pLazy    = NULL;
+}
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTga::~CTga(void)
+{
+	// マップ中ならアンマップだけ
+	if (m_pMap != NULL) {
+		m_pImage   = NULL;
+		m_pPalette = NULL;
+		this->ReleaseMap();
+	}
+
+	SAFE_DELETES(m_pImage);
+	SAFE_DELETES(m_pPalette);
+	this->ClearLazy();
+}
+
+
+/*=======================================================================
+【機能】ファイル読み込み
+【引数】pFileName：ファイル名
+【備考】setSidecarでキャッシュを指定している場合、ファイルが更新されて
+        いなければデコード済みのデータをマップするだけで済ませます。
+        CREATE_FLAG_LAZYの場合はヘッダーとパレットだけ読み込み、イメージは
+        最初に使う時(getImageなど)に読み込みます。
+ =======================================================================*/
+int CTga::Create(const char *pFileName)
+{
+	FILE *fp;
+	uint8 *mem;
+	uint32 size;
+	sint64 fileSize;
+	MtoFileStatus status;
+
+#ifndef NDEBUG
+	_ASSERT(pFileName != NULL);
+#else
+	if (pFileName == NULL) return ERROR_OPEN;
+#endif
+
+	// キャッシュから読み込み
+	// 状態は読み込み前に取得しておき、読み込み中に更新されたら次回は読み直させる
+	if (m_pSidecar != NULL) {
+		if (m_pSidecar->Load(this, pFileName, &status) == ERROR_NONE) return ERROR_NONE;
+	}
+
+	// 遅延デコードならヘッダーとパレットだけ読む
+	if (m_CreateFlag & CREATE_FLAG_LAZY) {
+		return this->CreateLazy(pFileName, NULL, 0);
+	}
+
+	if ((fp = fopen(pFileName, "rb")) == NULL) {
+		DBG_PRINT("file not found!\n");
+		return ERROR_OPEN;
+	}
+
+	// get file size
+	MtoFileSeek(fp, 0, SEEK_END);
+	fileSize = MtoFileTell(fp);
+	MtoFileSeek(fp, 0, SEEK_SET);
+
+	// 4GB以上はメモリに読み込めないのでCTgaLargeで処理する
+	if (fileSize < 0 || fileSize > 0xffffffffLL) {
+		fclose(fp);
+		return ERROR_MEMORY;
+	}
+	size = static_cast<uint32>(fileSize);
+
+	// read file to memory
+	if ((mem = new uint8[size]) == NULL) {
+		fclose(fp);
+		return ERROR_MEMORY;
+	}
+	fread(mem, size, 1, fp);
+	fclose(fp);
+
+	// 読み込み
+	int ret = this->Create(mem, size);
+	SAFE_DELETES(mem);
+
+	// キャッシュに保存
+	if (ret == ERROR_NONE && m_pSidecar != NULL) {
+		m_pSidecar->Store(*this, pFileName, status);
+	}
+
+	return ret;
+}
+
+/*=======================================================================
+【機能】メモリから作成
+【引数】pSrc：画像データアドレス
+        size：画像データサイズ
+【備考】CREATE_FLAG_LAZYの場合は画像データをコピーしておき、
+        イメージは最初に使う時にデコードします。
+ =======================================================================*/
+int CTga::Create(const void *pSrc, const uint32 size)
+{
+	uint32 offset;
+
+#ifndef NDEBUG
+	_ASSERT(pSrc != NULL);
+	_ASSERT(size);
+#else
+	if (pSrc == NULL || size == 0) return ERROR_HEADER;
+#endif
+
+	// 遅延デコード
+	if (m_CreateFlag & CREATE_FLAG_LAZY) {
+		return this->CreateLazy(NULL, pSrc, size);
+	}
+
+	// 同じサイズなら前のイメージのメモリを使い回す(連番の読み込みなど)
+	uint8 *pReuse = NULL;
+	uint32 reuseSize = 0;
+	if (m_pImage != NULL && m_pMap == NULL && m_pLazy == NULL) {
+		pReuse    = m_pImage;
+		reuseSize = m_ImageSize;
+		m_pImage  = NULL;
+	}
+
+	// 既に作成しているなら削除
+	if (pReuse != NULL || m_pImage != NULL || m_pLazy != NULL) {
+		this->Clear();
+	}
+
+	// ヘッダー読み込み
+	if (!this->ReadHeader(static_cast<const uint8*>(pSrc))) {
+		SAFE_DELETES(pReuse);
+		return ERROR_HEADER;
+	}
+
+	// ImageとPaletteのサイズを求める
+	if (!this->CalcSize(false)) {
+		SAFE_DELETES(pReuse);
+		this->Clear();
+		return ERROR_MEMORY;
+	}
+	if (pReuse != NULL && reuseSize == m_ImageSize) {
+		m_pImage = pReuse;
+		pReuse   = NULL;
+	}
+	SAFE_DELETES(pReuse);
+
+	if (!this->CalcSize(true)) {
+		this->Clear();
+		return ERROR_MEMORY;
+	}
+
+	// パレット読み込み
+	if (!this->ReadPalette(static_cast<const uint8*>(pSrc))) {
+		this->Clear();
+		return ERROR_PALETTE;
+	}
+
+	m_bPremultiplied = (m_CreateFlag & CREATE_FLAG_PREMULTIPLY) ? true : false;
+
+	// イメージ読み込み
+	if (!this->ReadImage(static_cast<const uint8*>(pSrc), size, &offset)) {
+		this->Clear();
+		return ERROR_IMAGE;
+	}
+
+	// フッター読み込み
+	offset += HEADER_SIZE + m_Header.IDField + m_PaletteSize;
+	if ((size - offset) >= FOOTER_SIZE) {
+		this->ReadFooter(static_cast<const uint8*>(pSrc), offset);
+	}
+
+	return ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】指定データから作成
+【引数】header     ：TGAヘッダー
+        pImage     ：イメージデータアドレス
+        imageSize  ：イメージデータサイズ
+        pPalette   ：パレットデータアドレス
+        paletteSize：パレットデータサイズ
+ =======================================================================*/
+int CTga::Create(const TGAHeader &header, uint8 *pImage, const uint32 imageSize, uint8 *pPalette, const uint32 paletteSize)
+{
+	// 引数チェック
+	if (pImage == NULL || imageSize == 0) return ERROR_IMAGE;
+	if (pPalette != NULL && paletteSize == 0) return ERROR_PALETTE;
+	if (pPalette == NULL && paletteSize != 0) return ERROR_PALETTE;
+
+	// ヘッダーチェック
+	if (!this->CheckSupport(header)) return ERROR_HEADER;
+
+	// 既に作成しているなら削除
+	if (m_pImage != NULL || m_pLazy != NULL) {
+		this->Clear();
+	}
+
+	m_Header      = header;
+	m_pImage      = pImage;
+	m_ImageSize   = imageSize;
+	m_pPalette    = pPalette;
+	m_PaletteSize = paletteSize;
+
+	if (m_CreateFlag & CREATE_FLAG_HASH) {
+		this->CalcHash();
+	}
+
+	return ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】ファイル出力
+【引数】pFileName：出力ファイル名
+ =======================================================================*/
+int CTga::Output(const char *pFileName)
+{
+	return this->Output(pFileName, OUTPUT_FLAG_NONE);
+}
+
+/*=======================================================================
+【機能】ファイル出力
+【引数】pFileName：出力ファイル名
+        flag     ：出力フラグ(OUTPUT_FLAG_*)
+【備考】イメージタイプがRLE圧縮(setRLEで変更可)ならRLE圧縮して出力します。
+        パケットはラインをまたがないので、RLE_BAND_LINEラインずつの帯に分けて
+        並列で圧縮します(結果は1スレッドで圧縮した場合と同じ)。
+        IDフィールドは保持していないので出力しません。
+ =======================================================================*/
+int CTga::Output(const char *pFileName, const uint32 flag)
+{
+#ifndef NDEBUG
+	_ASSERT(pFileName != NULL);
+#else
+	if (pFileName == NULL) return ERROR_OUTPUT;
+#endif
+
+	// 遅延デコード
+	if (!this->Decode()) return ERROR_IMAGE;
+
+	// 読み込まれていない？
+	if (m_pImage == NULL) return ERROR_NONE;
+
+	// 出力ファイルオープン
+	FILE *fp;
+	if ((fp = fopen(pFileName, "wb")) == NULL) {
+		DBG_PRINT("file can't open!\n");
+		return ERROR_OPEN;
+	}
+
+	CTgaStreamWriter writer(TgaStreamWriteFILE, fp);
+	int ret = this->Output(&writer, flag);
+
+	if (fclose(fp) != 0 && ret == ERROR_NONE) ret = ERROR_OUTPUT;
+
+	return ret;
+}
+
+/*=======================================================================
+【機能】ストリーム出力
+【引数】pWriter：出力先
+        flag   ：出力フラグ(OUTPUT_FLAG_*)
+【備考】前から順に書くだけなので、パイプやソケットにも出力できます。
+        最後にpWriterのFlushまで行います。
+        OUTPUT_FLAG_OPTIMIZEならOptimizeで変換したものを出力します(自身は変わりません)。
+ =======================================================================*/
+int CTga::Output(CTgaStreamWriter *pWriter, const uint32 flag)
+{
+#ifndef NDEBUG
+	_ASSERT(pWriter != NULL);
+#else
+	if (pWriter == NULL) return ERROR_OUTPUT;
+#endif
+
+	// 遅延デコード
+	if (!this->Decode()) return ERROR_IMAGE;
+
+	// 読み込まれていない？
+	if (m_pImage == NULL) return ERROR_NONE;
+
+	// 保存形式の最適化
+	if (flag & OUTPUT_FLAG_OPTIMIZE) {
+		CTga tga;
+		if (!this->Optimize(&tga)) return ERROR_MEMORY;
+		return tga.Output(pWriter, flag & ~OUTPUT_FLAG_OPTIMIZE);
+	}
+
+	const sint32 h     = m_Header.imageH;
+	const uint32 line  = m_Header.imageW * (m_Header.imageBit >> 3);
+	const bool bRLE    = this->isRLE();
+	const bool bScan   = (flag & OUTPUT_FLAG_SCANLINE) ? true : false;
+	const sint32 bandNum = (h + RLE_BAND_LINE - 1) / RLE_BAND_LINE;
+
+	// RLE圧縮(帯ごとのバッファに圧縮して、後で順番に出力する)
+	uint8 **ppBand = NULL;
+	uint32 *pLineSize = NULL;
+
+	if (bRLE) {
+		const uint32 worst = line + m_Header.imageW;	// 1ラインの最大サイズ
+		bool bResult = true;
+
+		if ((ppBand = new uint8*[bandNum]) == NULL || (pLineSize = new uint32[h]) == NULL) {
+			SAFE_DELETES(ppBand);
+			return ERROR_MEMORY;
+		}
+		memset(ppBand, 0, sizeof(uint8*) * bandNum);
+
+#pragma omp parallel for schedule(dynamic)
+		for (sint32 band = 0; band < bandNum; band++) {
+			const sint32 y0 = band * RLE_BAND_LINE;
+			const sint32 y1 = (y0 + RLE_BAND_LINE < h) ? (y0 + RLE_BAND_LINE) : h;
+
+			uint8 *pDst = new uint8[worst * (y1 - y0)];
+			if (pDst == NULL) {
+#pragma omp critical
+				bResult = false;
+				continue;
+			}
+			ppBand[band] = pDst;
+
+			for (sint32 y = y0; y < y1; y++) {
+				pLineSize[y] = TgaKernelPackRLE(pDst, &m_pImage[y * line], m_Header.imageW, m_Header.imageBit >> 3);
+				pDst += pLineSize[y];
+			}
+		}
+
+		if (!bResult) {
+			for (sint32 band = 0; band < bandNum; band++) SAFE_DELETES(ppBand[band]);
+			SAFE_DELETES(ppBand);
+			SAFE_DELETES(pLineSize);
+			return ERROR_MEMORY;
+		}
+	}
+
+	int ret = ERROR_NONE;
+
+	// ヘッダー出力
+	TGAHeader header = m_Header;
+	header.IDField   = 0;
+	this->WriteHeader(pWriter, &header);
+
+	// パレット出力
+	if (m_pPalette != NULL) {
+		pWriter->Write(m_pPalette, m_PaletteSize);
+	}
+
+	// イメージ出力
+	uint32 imageSize = m_ImageSize;
+	if (bRLE) {
+		imageSize = 0;
+		for (sint32 band = 0; band < bandNum; band++) {
+			const sint32 y0 = band * RLE_BAND_LINE;
+			const sint32 y1 = (y0 + RLE_BAND_LINE < h) ? (y0 + RLE_BAND_LINE) : h;
+			uint32 size = 0;
+
+			for (sint32 y = y0; y < y1; y++) size += pLineSize[y];
+			pWriter->Write(ppBand[band], size);
+			imageSize += size;
+		}
+	} else {
+		pWriter->Write(m_pImage, m_ImageSize);
+	}
+
+	// エクステンションエリアとスキャンラインテーブル出力
+	TGAFooter footer = m_Footer;
+	if (bScan) {
+		const uint32 imageOffset = HEADER_SIZE + m_PaletteSize;
+		const uint32 extOffset   = imageOffset + imageSize;
+		const uint32 scanOffset  = extOffset + EXTENSION_SIZE;
+		uint8 ext[EXTENSION_SIZE];
+
+		memset(ext, 0, sizeof(ext));
+		ext[0]   = static_cast<uint8>(EXTENSION_SIZE);
+		ext[1]   = static_cast<uint8>(EXTENSION_SIZE >> 8);
+		ext[490] = static_cast<uint8>(scanOffset);
+		ext[491] = static_cast<uint8>(scanOffset >> 8);
+		ext[492] = static_cast<uint8>(scanOffset >> 16);
+		ext[493] = static_cast<uint8>(scanOffset >> 24);
+		ext[494] = (m_Header.discripter & 0x0f) ? (m_bPremultiplied ? 4 : 3) : 0;	// アルファの種類
+		pWriter->Write(ext, sizeof(ext));
+
+		// ラインの位置(上のラインから順に)
+		uint32 *pOffset = new uint32[h + 1];
+		if (pOffset == NULL) {
+			ret = ERROR_MEMORY;
+		} else {
+			pOffset[0] = imageOffset;
+			for (sint32 y = 0; y < h; y++) {
+				pOffset[y + 1] = pOffset[y] + (bRLE ? pLineSize[y] : line);
+			}
+			for (sint32 y = 0; y < h; y++) {
+				const uint32 offset = pOffset[(m_Header.discripter & 0x20) ? y : (h - y - 1)];
+				const uint8 data[4] = {
+					static_cast<uint8>(offset),       static_cast<uint8>(offset >> 8),
+					static_cast<uint8>(offset >> 16), static_cast<uint8>(offset >> 24)
+				};
+				pWriter->Write(data, sizeof(data));
+			}
+			SAFE_DELETES(pOffset);
+		}
+
+		footer.filePos = extOffset;
+	}
+
+	// フッター出力
+	this->WriteFooter(pWriter, &footer);
+
+	if (!pWriter->Flush() && ret == ERROR_NONE) ret = ERROR_OUTPUT;
+
+	if (ppBand != NULL) {
+		for (sint32 band = 0; band < bandNum; band++) SAFE_DELETES(ppBand[band]);
+		SAFE_DELETES(ppBand);
+	}
+	SAFE_DELETES(pLineSize);
+
+	return ret;
+}
+
+/*=======================================================================
+【機能】RLE圧縮して出力するか設定
+【引数】bRLE：RLE圧縮する？
+【備考】イメージタイプを切り替えるだけで、メモリ上のイメージは常に展開済みです。
+ =======================================================================*/
+void CTga::setRLE(const bool bRLE)
+{
+	if (m_Header.imageType == IMAGE_TYPE_NONE) return;
+
+	if (bRLE && m_Header.imageType < IMAGE_TYPE_MAX) {
+		m_Header.imageType += 8;
+	} else if (!bRLE && this->isRLE()) {
+		m_Header.imageType -= 8;
+	}
+}
+
+/*=======================================================================
+【機能】BMP出力
+【引数】pFileName：出力ファイル名
+ =======================================================================*/
+int CTga::OutputBMP(const char *pFileName)
+{
+#ifndef NDEBUG
+	_ASSERT(pFileName != NULL);
+#else
+	if (pFileName == NULL) return ERROR_OUTPUT;
+#endif
+
+	// 遅延デコード
+	if (!this->Decode()) return ERROR_IMAGE;
+
+	// 読み込まれていない？
+	if (m_pImage == NULL) return ERROR_NONE;
+
+	// 出力ファイルオープン
+	FILE *fp;
+	if ((fp = fopen(pFileName, "wb")) == NULL) {
+		DBG_PRINT("file can't open!\n");
+		return ERROR_OPEN;
+	}
+
+	// BMPヘッダー作成
+	uint32 hsize, isize, psize;
+	BITMAPFILEHEADER bmHead;
+	BITMAPINFOHEADER bmInfo;
+
+	memset(&bmHead, 0, sizeof(bmHead));
+	memset(&bmInfo, 0, sizeof(bmInfo));
+
+	hsize = sizeof(BITMAPFILEHEADER);
+	isize = sizeof(BITMAPINFOHEADER);
+	psize = sizeof(RGBQUAD) * m_Header.paletteColor;
+
+	bmHead.bfType = 0x4D42; //BM
+	bmHead.bfSize = ((m_Header.imageW * (m_Header.imageBit >> 3) + 3) & ~3) * m_Header.imageH + hsize + isize + psize;
+	bmHead.bfReserved1 = 0;
+	bmHead.bfReserved2 = 0;
+	bmHead.bfOffBits   = hsize + isize + psize;
+
+	bmInfo.biSize   = isize;
+	bmInfo.biWidth  = m_Header.imageW;
+	bmInfo.biHeight = m_Header.imageH;
+	bmInfo.biPlanes = 1;
+	bmInfo.biBitCount = m_Header.imageBit;
+
+
+	// ヘッダー出力
+	fwrite(&bmHead, hsize, 1, fp);
+	fwrite(&bmInfo, isize, 1, fp);
+
+	// パレット出力
+	if (m_pPalette != NULL) {
+		if (m_Header.paletteBit == 24) {
+			uint8 *pPalette = m_pPalette;
+			uint8 alpha = 0x00;
+
+			for (int i = 0; i < m_Header.paletteColor; i++) {
+				fwrite(pPalette++, sizeof(uint8), 1, fp);
+				fwrite(pPalette++, sizeof(uint8), 1, fp);
+				fwrite(pPalette++, sizeof(uint8), 1, fp);
+				fwrite(&alpha    , sizeof(uint8), 1, fp);
+			}
+		} else {
+			fwrite(m_pPalette, m_PaletteSize, 1, fp);
+		}
+	}
+
+	// イメージ出力(下のラインから、右→左なら反転、4バイト境界まで埋める)
+	const sint32 h    = m_Header.imageH;
+	const uint32 byte = m_Header.imageBit >> 3;
+	const uint32 line = m_Header.imageW * byte;
+	const uint8  pad[4] = {0, 0, 0, 0};
+	uint8 *pWork = NULL;
+
+	if ((m_Header.discripter & 0x10) && (pWork = new uint8[line]) == NULL) {
+		fclose(fp);
+		return ERROR_MEMORY;
+	}
+
+	for (sint32 y = h - 1; y >= 0; y--) {
+		const uint8 *pSrc = this->GetLinePtr(y);
+
+		if (pWork != NULL) {
+			TgaKernelReverse(pWork, pSrc, m_Header.imageW, byte);
+			pSrc = pWork;
+		}
+		fwrite(pSrc, line, 1, fp);
+		if (line & 3) fwrite(pad, 4 - (line & 3), 1, fp);
+	}
+
+	SAFE_DELETES(pWork);
+
+	fclose(fp);
+
+	return ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】BGRA配列をRGBA配列に変更
+【備考】RGBAに変更したあと再度呼ぶとBGRA配列になります。
+ =======================================================================*/
+bool CTga::ConvertRGBA(void)
+{
+	if (!this->Decode()) return false;
+	if (m_pImage == NULL) return false;
+
+	// 共有しているマップは他のCTgaからも見えるので、書き換える前にコピー
+	if (m_pShare != NULL && !this->Detach()) return false;
+
+	// パレット
+	if (m_pPalette) {
+		if (m_Header.paletteBit == 32) {
+			TgaKernelSwapRB32(m_pPalette, m_pPalette, m_PaletteSize >> 2);
+		} else {
+			TgaKernelSwapRB24(m_pPalette, m_pPalette, m_PaletteSize / 3);
+		}
+	}
+
+	// 並びが変わったことを記録
+	m_bRGBA = !m_bRGBA;
+
+	// イメージ
+	switch (m_Header.imageBit) {
+	case 16:
+		// RGBA:5551
+		TgaKernelSwapRB16(m_pImage, m_pImage, m_ImageSize >> 1);
+		break;
+	case 24:
+		TgaKernelSwapRB24(m_pImage, m_pImage, m_ImageSize / 3);
+		break;
+	case 32:
+		TgaKernelSwapRB32(m_pImage, m_pImage, m_ImageSize >> 2);
+		break;
+	default:
+		// IndexColorなら処理しない
+		break;
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】指定のビット配列に変換
+【引数】type：ラインタイプ
+【備考】イメージを並べ替えます。上から順に読み書きするだけなら、
+        getLine/getPitchで並べ替えずに扱えます。
+ =======================================================================*/
+bool CTga::ConvertType(const sint32 type)
+{
+	if (type >= IMAGE_LINE_MAX) return false;
+	if (!this->Decode()) return false;
+	if (m_pImage == NULL) return false;
+
+	// 一緒なら処理なし
+	if ((m_Header.discripter & 0xf0) == type) return true;
+
+	// マップ中のイメージは置き換えられないのでコピーしておく
+	if (!this->Detach()) return false;
+
+	uint8 *pImage;
+
+	// 変換用のメモリ確保
+	if ((pImage = new uint8[m_ImageSize]) == NULL) {
+		return false;
+	}
+
+	// 配列変換(1ラインずつ)
+	const sint32 h      = m_Header.imageH;
+	const uint32 byte   = m_Header.imageBit >> 3;
+	const uint32 line   = m_Header.imageW * byte;
+	const bool   bFlipX = ((m_Header.discripter & 0x10) != (type & 0x10));	// お互いのX方向が一致しないなら反転
+	const bool   bFlipY = ((m_Header.discripter & 0x20) != (type & 0x20));	// お互いのY方向が一致しないなら反転
+
+#pragma omp parallel for
+	for (sint32 y = 0; y < h; y++) {
+		const sint32 ty = bFlipY ? (h - y - 1) : y;
+
+		if (bFlipX) {
+			TgaKernelReverse(&pImage[y * line], &m_pImage[ty * line], m_Header.imageW, byte);
+		} else {
+			memcpy(&pImage[y * line], &m_pImage[ty * line], line);
+		}
+	}
+
+	// 元を破棄して変換後のデータを保持
+	SAFE_DELETES(m_pImage);
+	m_pImage = pImage;
+
+	// イメージ記述子を変更
+	m_Header.discripter = static_cast<uint8>((m_Header.discripter & 0x0f) | type);
+
+	return true;
+}
+
+/*=======================================================================
+【機能】乗算済みアルファに変換
+【備考】32bitと16bit(ARGB:1555)のイメージが対象です。
+        インデックスカラーの場合はパレット(32bit)のみ変換します。
+ =======================================================================*/
+bool CTga::Premultiply(void)
+{
+	if (!this->Decode()) return false;
+	if (m_pImage == NULL) return false;
+
+	// 変換済みなら処理なし
+	if (m_bPremultiplied) return true;
+
+	// 共有しているマップは他のCTgaからも見えるので、書き換える前にコピー
+	if (m_pShare != NULL && !this->Detach()) return false;
+
+	// パレット
+	if (m_pPalette != NULL && m_Header.paletteBit == 32) {
+		TgaKernelPremultiply32(m_pPalette, m_pPalette, m_Header.paletteColor);
+	}
+
+	// イメージ
+	if (this->IsAlphaImage()) {
+		if (m_Header.imageBit == 32) {
+			TgaKernelPremultiply32(m_pImage, m_pImage, m_ImageSize >> 2);
+		} else {
+			TgaKernelPremultiply16(m_pImage, m_pImage, m_ImageSize >> 1);
+		}
+	}
+
+	m_bPremultiplied = true;
+	m_Hash           = 0;	// 内容が変わったのでハッシュ値は無効
+
+	return true;
+}
+
+/*=======================================================================
+【機能】乗算済みアルファを元に戻す
+【備考】アルファが0のピクセルの色は元に戻りません。
+        16bit(ARGB:1555)はアルファ1のピクセルが変化しないので処理なし。
+ =======================================================================*/
+bool CTga::Unpremultiply(void)
+{
+	if (!this->Decode()) return false;
+	if (m_pImage == NULL) return false;
+
+	// 変換していないなら処理なし
+	if (!m_bPremultiplied) return true;
+
+	// 共有しているマップは他のCTgaからも見えるので、書き換える前にコピー
+	if (m_pShare != NULL && !this->Detach()) return false;
+
+	// パレット
+	if (m_pPalette != NULL && m_Header.paletteBit == 32) {
+		TgaKernelUnpremultiply32(m_pPalette, m_pPalette, m_Header.paletteColor);
+	}
+
+	// イメージ
+	if (this->IsAlphaImage() && m_Header.imageBit == 32) {
+		TgaKernelUnpremultiply32(m_pImage, m_pImage, m_ImageSize >> 2);
+	}
+
+	m_bPremultiplied = false;
+	m_Hash           = 0;	// 内容が変わったのでハッシュ値は無効
+
+	return true;
+}
+
+/*=======================================================================
+【機能】32bit(BGRA)に展開して取り出す
+【引数】pDst：展開先(幅×高さ×4バイト)
+【備考】並びは左→右、上→下(IMAGE_LINE_LRUD)になります。
+        アルファのない画像はアルファを255にします。
+ =======================================================================*/
+bool CTga::GetImage32(uint8 *pDst) const
+{
+	if (!this->Decode()) return false;
+	if (pDst == NULL || m_pImage == NULL) return false;
+
+	const bool bIndex = (m_Header.imageType == IMAGE_TYPE_INDEX || m_Header.imageType == IMAGE_TYPE_INDEX_RLE);
+	if (bIndex && m_pPalette == NULL) return false;
+
+	const sint32 w = m_Header.imageW;
+	const sint32 h = m_Header.imageH;
+
+#pragma omp parallel for
+	for (sint32 y = 0; y < h; y++) {
+		uint8 *pLine = &pDst[y * w * 4];
+		const uint8 *pSrc = this->GetLine32(pLine, y);
+
+		if (pSrc != pLine) memcpy(pLine, pSrc, w * 4);
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】情報クリア
+【備考】非公開
+ =======================================================================*/
+void CTga::Clear(void)
+{
+	// マップ中ならアンマップだけ
+	if (m_pMap != NULL) {
+		m_pImage   = NULL;
+		m_pPalette = NULL;
+		this->ReleaseMap();
+	}
+
+	SAFE_DELETES(m_pImage);
+	SAFE_DELETES(m_pPalette);
+	this->ClearLazy();
+
+	memset(&m_Header, 0, sizeof(m_Header));
+	memset(&m_Footer, 0, sizeof(m_Footer));
+
+	m_ImageSize   = 0;
+	m_PaletteSize = 0;
+
+	m_bPremultiplied = false;
+	m_bRGBA          = false;
+	m_Hash           = 0;
+}
+
+/*=======================================================================
+【機能】マップ中のイメージとパレットをコピーしてアンマップ
+【備考】非公開
+        イメージを置き換える処理の前に呼ぶ。
+ =======================================================================*/
+bool CTga::Detach(void)
+{
+	if (m_pMap == NULL) return true;
+
+	uint8 *pImage   = new uint8[m_ImageSize];
+	uint8 *pPalette = (m_pPalette != NULL) ? new uint8[m_PaletteSize] : NULL;
+
+	if (pImage == NULL || (m_pPalette != NULL && pPalette == NULL)) {
+		SAFE_DELETES(pImage);
+		SAFE_DELETES(pPalette);
+		return false;
+	}
+
+	memcpy(pImage, m_pImage, m_ImageSize);
+	if (pPalette != NULL) memcpy(pPalette, m_pPalette, m_PaletteSize);
+
+	this->ReleaseMap();
+	m_pImage   = pImage;
+	m_pPalette = pPalette;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】ライン取得
+【引数】y：ライン(上から数えた位置)
+【戻値】ラインの先頭アドレス(イメージなしならNULL)
+【備考】下→上の並びでもイメージは並べ替えずに、上から数えたラインを返します。
+        次のラインまではgetPitchバイト(下→上の並びなら負)です。
+        ライン内のピクセルは保存の並びのまま(右→左なら右端が先頭)です。
+ =======================================================================*/
+uint8 *CTga::getLine(const sint32 y) const
+{
+	if (!this->Decode() || m_pImage == NULL) return NULL;
+
+	return this->GetLinePtr(y);
+}
+
+/*=======================================================================
+【機能】マップを手放す
+【備考】非公開
+        共有しているマップ(CTgaPack)は参照をやめるだけで、
+        最後の参照がなくなった時に削除する。
+ =======================================================================*/
+void CTga::ReleaseMap(void)
+{
+	if (m_pShare != NULL) {
+		ReleaseShareMap(m_pShare);
+		m_pMap   = NULL;
+		m_pShare = NULL;
+	} else {
+		SAFE_DELETE(m_pMap);
+	}
+}
+
+/*=======================================================================
+【機能】共有しているマップの情報
+【備考】CTgaPackのマップは、パックファイルとLoadで作成したCTgaが参照する。
+        パックファイルを先に閉じても、CTgaが残っている間はマップしたまま。
+        別々のスレッドで作成・破棄してもよいように参照数はロックして数える。
+ =======================================================================*/
+struct CTga::TGAShareMap {
+	CMtoFileMap		map;
+	CMtoMutex		mutex;
+	uint32			ref;			// 参照数
+};
+
+/*=======================================================================
+【機能】共有するマップを作成
+【引数】pFileName：ファイル名
+【戻値】共有するマップ(参照数は1、NULL：マップできない)
+【備考】非公開
+ =======================================================================*/
+CTga::TGAShareMap *CTga::OpenShareMap(const char *pFileName)
+{
+	TGAShareMap *pShare = new TGAShareMap;
+	if (pShare == NULL) return NULL;
+
+	if (!pShare->map.Open(pFileName)) {
+		SAFE_DELETE(pShare);
+		return NULL;
+	}
+	pShare->ref = 1;
+
+	return pShare;
+}
+
+/*=======================================================================
+【機能】共有しているマップを取得
+【備考】非公開
+ =======================================================================*/
+CMtoFileMap *CTga::GetShareMap(TGAShareMap *pShare)
+{
+	return &pShare->map;
+}
+
+/*=======================================================================
+【機能】共有しているマップの参照をやめる
+【備考】非公開
+        最後の参照ならアンマップして削除する。
+ =======================================================================*/
+void CTga::ReleaseShareMap(TGAShareMap *pShare)
+{
+	bool bLast;
+	{
+		CMtoLock lock(pShare->mutex);
+		bLast = (--pShare->ref == 0);
+	}
+	if (bLast) SAFE_DELETE(pShare);
+}
+
+/*=======================================================================
+【機能】共有しているマップを参照する
+【引数】pShare：共有しているマップ
+【備考】非公開
+        イメージとパレットは呼び出し側でマップの中を指すようにする。
+ =======================================================================*/
+void CTga::AttachShareMap(TGAShareMap *pShare)
+{
+	{
+		CMtoLock lock(pShare->mutex);
+		pShare->ref++;
+	}
+	m_pShare = pShare;
+	m_pMap   = &pShare->map;
+}
+
+/*=======================================================================
+【機能】アルファ付きイメージ？
+【備考】非公開
+        16bitはイメージ記述子のアルファビット数が0ならアルファなしとして扱う。
+ =======================================================================*/
+bool CTga::IsAlphaImage(void) const
+{
+	if (m_Header.imageBit == 32) return true;
+	if (m_Header.imageBit == 16 && (m_Header.discripter & 0x0f) != 0) return true;
+
+	return false;
+}
+
+/*=======================================================================
+【機能】上から数えたラインのアドレス
+【引数】y：ライン(上から数えた位置)
+【戻値】ラインの先頭アドレス
+【備考】非公開
+        遅延デコード中にも使うので、デコードはしない。
+ =======================================================================*/
+uint8 *CTga::GetLinePtr(const sint32 y) const
+{
+	const sint32 sy = (m_Header.discripter & 0x20) ? y : (m_Header.imageH - y - 1);
+
+	return &m_pImage[sy * m_Header.imageW * (m_Header.imageBit >> 3)];
+}
+
+/*=======================================================================
+【機能】1ラインを32bit(BGRA)で取得
+【引数】pWork：展開用の作業領域(幅×4バイト)
+        y    ：ライン(上から数えた位置)
+【戻値】ラインのアドレス
+【備考】非公開
+        32bit(BGRA、左→右)ならイメージを直接返し、それ以外はpWorkに展開して返す。
+ =======================================================================*/
+const uint8 *CTga::GetLine32(uint8 *pWork, const sint32 y) const
+{
+	const sint32 w      = m_Header.imageW;
+	const uint32 byte   = m_Header.imageBit >> 3;
+	const uint32 palB   = m_Header.paletteBit >> 3;
+	const bool   bIndex = (m_Header.imageType == IMAGE_TYPE_INDEX || m_Header.imageType == IMAGE_TYPE_INDEX_RLE);
+	const bool   bAlpha = this->IsAlphaImage();
+
+	// 元の並びでのライン
+	const uint8 *pSrc = this->GetLinePtr(y);
+
+	if ((m_Header.discripter & 0x10) == 0 && !bIndex) {
+		// 左→右ならまとめて展開
+		switch (byte) {
+		case 1:
+			TgaKernelExpand8(pWork, pSrc, w);
+			break;
+		case 2:
+			TgaKernelExpand16(pWork, pSrc, w, bAlpha);
+			break;
+		case 3:
+			TgaKernelExpand24(pWork, pSrc, w);
+			break;
+		default:
+			if (!m_bRGBA) return pSrc;
+			memcpy(pWork, pSrc, w * 4);
+			break;
+		}
+
+		// RGBA配列ならBGRAに戻す(グレースケールは変わらない)
+		if (m_bRGBA && byte != 1) {
+			TgaKernelSwapRB32(pWork, pWork, w);
+		}
+
+		return pWork;
+	}
+
+	for (sint32 x = 0; x < w; x++) {
+		const sint32 sx = (m_Header.discripter & 0x10) ? (w - x - 1) : x;
+		const uint8 *s = &pSrc[sx * byte];
+		uint8 *d = &pWork[x * 4];
+
+		if (bIndex) {
+			const uint8 *p = &m_pPalette[((s[0] < m_Header.paletteColor) ? s[0] : 0) * palB];
+			d[0] = p[0];
+			d[1] = p[1];
+			d[2] = p[2];
+			d[3] = (palB == 4) ? p[3] : A_MAX;
+		} else if (byte == 1) {
+			d[0] = d[1] = d[2] = s[0];
+			d[3] = A_MAX;
+		} else if (byte == 2) {
+			uint32 pix = s[0] | (s[1] << 8);
+			d[0] = static_cast<uint8>(((pix      ) & 0x1f) * 255 / 31);
+			d[1] = static_cast<uint8>(((pix >>  5) & 0x1f) * 255 / 31);
+			d[2] = static_cast<uint8>(((pix >> 10) & 0x1f) * 255 / 31);
+			d[3] = (!bAlpha || (pix & 0x8000)) ? A_MAX : 0;
+		} else {
+			d[0] = s[0];
+			d[1] = s[1];
+			d[2] = s[2];
+			d[3] = (byte == 4) ? s[3] : A_MAX;
+		}
+
+		// RGBA配列ならBGRAに戻す
+		if (m_bRGBA) {
+			uint8 t = d[0];
+			d[0] = d[2];
+			d[2] = t;
+		}
+	}
+
+	return pWork;
+}
+
+/*=======================================================================
+【機能】対応チェック
+【引数】header：TGAヘッダー
+【備考】非公開
+ =======================================================================*/
+bool CTga::CheckSupport(const TGAHeader &header)
+{
+	// 原点が0ではない？
+	if (header.imageX != 0 && header.imageY != 0) return false;
+
+	// 対応していないイメージタイプ？
+	if (!((IMAGE_TYPE_NONE < header.imageType && header.imageType < IMAGE_TYPE_MAX) ||
+		  (IMAGE_TYPE_INDEX_RLE <= header.imageType && header.imageType < IMAGE_TYPE_RLE_MAX))) {
+		return false;
+	}
+
+	// 対応ビット？
+	if (header.imageBit !=  8 && header.imageBit != 16 &&
+		header.imageBit != 24 && header.imageBit != 32) {
+		return false;
+	}
+
+	// 対応パレット？
+	if (header.usePalette) {
+		if (header.paletteIndex != 0) return false;
+		if (header.paletteBit != 24 && header.paletteBit != 32) return false;
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】TGAヘッダー読み込み
+【引数】pSrc：画像データアドレス
+【備考】非公開
+ =======================================================================*/
+bool CTga::ReadHeader(const uint8 *pSrc)
+{
+#ifndef NDEBUG
+	_ASSERT(pSrc != NULL);
+#else
+	if (pSrc == NULL) return false;
+#endif
+
+	uint32 offset = 0;
+
+	m_Header.IDField      = pSrc[offset++];
+	m_Header.usePalette   = pSrc[offset++];
+	m_Header.imageType    = pSrc[offset++];
+	m_Header.paletteIndex = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
+	m_Header.paletteColor = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
+	m_Header.paletteBit   = pSrc[offset++];
+	m_Header.imageX       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
+	m_Header.imageY       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
+	m_Header.imageW       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
+	m_Header.imageH       = (pSrc[offset] | (pSrc[offset + 1] << 8)); offset += 2;
+	m_Header.imageBit     = pSrc[offset++];
+	m_Header.discripter   = pSrc[offset++];
+
+	_ASSERT(offset == HEADER_SIZE);
+
+	return this->CheckSupport(m_Header);
+}
+
+/*=======================================================================
+【機能】TGAフッター読み込み
+【引数】pSrc　：画像データアドレス
+        offset：フッターまでのオフセット
+【備考】非公開
+ =======================================================================*/
+void CTga::ReadFooter(const uint8 *pSrc, const uint32 offset)
+{
+#ifndef NDEBUG
+	_ASSERT(pSrc != NULL);
+#else
+	if (pSrc == NULL) return;
+#endif
+
+	uint32 offs = offset;
+
+	memcpy(&m_Footer.filePos, &pSrc[offs], sizeof(m_Footer.filePos)); offs += sizeof(m_Footer.filePos);
+	memcpy(&m_Footer.fileDev, &pSrc[offs], sizeof(m_Footer.fileDev)); offs += sizeof(m_Footer.fileDev);
+	memcpy(m_Footer.version,  &pSrc[offs], sizeof(m_Footer.version)); offs += sizeof(m_Footer.version);
+
+	_ASSERT((offs - offset) == FOOTER_SIZE);
+}
+
+/*=======================================================================
+【機能】Image/Paletteサイズを求める
+【引数】bFlg：メモリ確保を行う？
+【戻値】false：メモリ確保失敗か、メモリ上で扱えない大きさ
+【備考】非公開
+        IMAGE_PIXEL_MAXを超える画像はCTgaLargeで処理してください。
+ =======================================================================*/
+bool CTga::CalcSize(const bool bFlg)
+{
+	// 65535x65535x32bitは32bitに収まらないので64bitで求める
+	const uint64 pixel = static_cast<uint64>(m_Header.imageW) * m_Header.imageH;
+	if (pixel > IMAGE_PIXEL_MAX) return false;
+
+	m_ImageSize   = static_cast<uint32>(pixel * (m_Header.imageBit >> 3));
+	m_PaletteSize = m_Header.usePalette * m_Header.paletteColor * (m_Header.paletteBit >> 3);
+
+	if (bFlg) {
+		// 使い回すイメージがあればそのまま
+		if (m_pImage == NULL && (m_pImage = new uint8[m_ImageSize]) == NULL) return false;
+
+		// パレットありならメモリ確保
+		if (m_Header.usePalette) {
+			if ((m_pPalette = new uint8[m_PaletteSize]) == NULL) return false;
+		}
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】Image読み込み
+【引数】pSrc  ：画像データアドレス
+        size  ：画像データサイズ
+        offset：保存先元イメージサイズ（RLEの場合は圧縮時のサイズ）
+【備考】非公開
+ =======================================================================*/
+bool CTga::ReadImage(const uint8 *pSrc, const uint32 size, uint32 *pOffset)
+{
+#ifndef NDEBUG
+	_ASSERT(pSrc != NULL);
+	_ASSERT(m_pImage != NULL);
+#else
+	if (pSrc == NULL || m_pImage == NULL) return false;
+#endif
+
+	uint8 *pWork  = const_cast<uint8*>(pSrc) + HEADER_SIZE + m_Header.IDField + m_PaletteSize;
+	uint8 *pImage = m_pImage;
+	uint32 offset = 0;
+
+	const bool bPremultiply = ((m_CreateFlag & CREATE_FLAG_PREMULTIPLY) && this->IsAlphaImage());
+
+	if (IMAGE_TYPE_INDEX_RLE <= m_Header.imageType && m_Header.imageType < IMAGE_TYPE_RLE_MAX) {
+		// RLE圧縮
+		const uint32 head = HEADER_SIZE + m_Header.IDField + m_PaletteSize;
+		if (size < head) return false;
+
+		offset = this->UnpackRLE(m_pImage, pWork, size - head);
+		if (offset == static_cast<uint32>(-1)) return false;
+
+		// 展開は先頭から順にしかできないので、ハッシュ値は展開後に計算
+		if (m_CreateFlag & CREATE_FLAG_HASH) {
+			this->HashAll();
+		}
+	} else if (m_CreateFlag & CREATE_FLAG_HASH) {
+		// 非圧縮(ハッシュ値計算あり)
+		// 1ラインずつコピーして、キャッシュに載っているうちにハッシュ値を計算する
+		const sint32 h    = m_Header.imageH;
+		const uint32 line = m_Header.imageW * (m_Header.imageBit >> 3);
+		uint64 *pLineHash;
+		bool bResult = true;
+
+		if ((pLineHash = new uint64[h]) == NULL) return false;
+
+#pragma omp parallel
+		{
+			uint8 *pLine = new uint8[line];
+
+			if (pLine == NULL) {
+#pragma omp critical
+				bResult = false;
+			}
+
+#pragma omp for
+			for (sint32 sy = 0; sy < h; sy++) {
+				if (bPremultiply) {
+					if (m_Header.imageBit == 32) {
+						TgaKernelPremultiply32(&pImage[sy * line], &pWork[sy * line], line >> 2);
+					} else {
+						TgaKernelPremultiply16(&pImage[sy * line], &pWork[sy * line], line >> 1);
+					}
+				} else {
+					memcpy(&pImage[sy * line], &pWork[sy * line], line);
+				}
+
+				const sint32 y = (m_Header.discripter & 0x20) ? sy : (h - sy - 1);
+				if (pLine != NULL) pLineHash[y] = this->HashLine(pLine, y);
+			}
+
+			SAFE_DELETES(pLine);
+		}
+
+		if (!bResult) {
+			SAFE_DELETES(pLineHash);
+			return false;
+		}
+
+		m_Hash = this->HashImage(pLineHash);
+		SAFE_DELETES(pLineHash);
+		offset = m_ImageSize;
+	} else {
+		// 非圧縮
+		if (bPremultiply) {
+			// 乗算済みアルファに変換しながらコピー
+			if (m_Header.imageBit == 32) {
+				TgaKernelPremultiply32(pImage, pWork, m_ImageSize >> 2);
+			} else {
+				TgaKernelPremultiply16(pImage, pWork, m_ImageSize >> 1);
+			}
+		} else {
+			memcpy(pImage, pWork, m_ImageSize);
+		}
+		offset = m_ImageSize;
+	}
+
+	if (pOffset != NULL) *pOffset = offset;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】Palette読み込み
+【引数】pSrc：画像データアドレス
+【備考】非公開
+ =======================================================================*/
+bool CTga::ReadPalette(const uint8 *pSrc)
+{
+#ifndef NDEBUG
+	_ASSERT(pSrc != NULL);
+#else
+	if (pSrc == NULL) return false;
+#endif
+
+	// IndexColor?
+	if (m_Header.imageType != IMAGE_TYPE_INDEX && m_Header.imageType != IMAGE_TYPE_INDEX_RLE) {
+		return true;
+	}
+
+	// Palette OK?
+	if (m_pPalette == NULL) return false;
+
+	uint8 *pWork = const_cast<uint8*>(pSrc) + HEADER_SIZE + m_Header.IDField;
+	uint8 *pPalette = m_pPalette;
+	uint16 i; // VC6.0ではコンパイルが通らないので外に出す
+
+	switch (m_Header.paletteBit) {
+	case 24:
+		for (i = 0; i < m_Header.paletteColor; i++) {
+			*pPalette++ = *pWork++;
+			*pPalette++ = *pWork++;
+			*pPalette++ = *pWork++;
+		}
+		break;
+	case 32:
+		if (m_CreateFlag & CREATE_FLAG_PREMULTIPLY) {
+			// 乗算済みアルファに変換しながらコピー
+			TgaKernelPremultiply32(pPalette, pWork, m_Header.paletteColor);
+			break;
+		}
+		for (i = 0; i < m_Header.paletteColor; i++) {
+			*pPalette++ = *pWork++;
+			*pPalette++ = *pWork++;
+			*pPalette++ = *pWork++;
+			*pPalette++ = *pWork++;
+		}
+		break;
+	default:
+		DBG_PRINT("not support palette data!!\n");
+		return false;
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】RLE圧縮解凍
+【引数】pDst：展開先
+        pSrc：圧縮データアドレス
+        size：圧縮データサイズ
+【戻値】読み込んだ圧縮データのサイズ(失敗なら0xffffffff)
+【備考】非公開
+        展開はカーネル(C版と共通)で行い、乗算済みアルファへの変換は展開後にまとめて行う。
+ =======================================================================*/
+uint32 CTga::UnpackRLE(uint8 *pDst, const uint8 *pSrc, const uint32 size)
+{
+#ifndef NDEBUG
+	_ASSERT(pSrc != NULL);
+	_ASSERT(pDst != NULL);
+#else
+	if (pSrc == NULL || pDst == NULL) return static_cast<uint32>(-1);
+#endif
+
+	const uint32 byte   = m_Header.imageBit >> 3; // バイトサイズ
+	const uint32 offset = TgaKernelUnpackRLE(pDst, m_ImageSize, pSrc, size, byte);
+
+	// 解凍のしすぎチェック
+	if (offset == static_cast<uint32>(-1)) {
+		DBG_PRINT("UnpackRLE error!!\n");
+		return offset;
+	}
+
+	// 乗算済みアルファに変換
+	if ((m_CreateFlag & CREATE_FLAG_PREMULTIPLY) && this->IsAlphaImage()) {
+		if (byte == 4) {
+			TgaKernelPremultiply32(pDst, pDst, m_ImageSize >> 2);
+		} else {
+			TgaKernelPremultiply16(pDst, pDst, m_ImageSize >> 1);
+		}
+	}
+
+	return offset;
+}
+
+/*=======================================================================
+【機能】TGAヘッダー出力
+【引数】fp     ：FILEポインタ
+        pWriter：出力先(ストリームの場合)
+        pHeader：出力するTGAヘッダー
+【備考】アライメントに沿っていないので、リトルエンディアンに並べてから出力。
+ =======================================================================*/
+bool CTga::WriteHeader(FILE *fp)
+{
+	return this->WriteHeader(fp, &m_Header);
+}
+
+bool CTga::WriteHeader(FILE *fp, TGAHeader *pHeader)
+{
+#ifndef NDEBUG
+	_ASSERT(fp != NULL);
+#else
+	if (fp == NULL) return false;
+#endif
+
+	CTgaStreamWriter writer(TgaStreamWriteFILE, fp);
+	return (this->WriteHeader(&writer, pHeader) && writer.Flush());
+}
+
+bool CTga::WriteHeader(CTgaStreamWriter *pWriter, TGAHeader *pHeader)
+{
+#ifndef NDEBUG
+	_ASSERT(pWriter != NULL);
+	_ASSERT(pHeader != NULL);
+#else
+	if (pWriter == NULL || pHeader == NULL) return false;
+#endif
+
+	uint8 head[HEADER_SIZE];
+	uint32 offset = 0;
+
+	head[offset++] = pHeader->IDField;
+	head[offset++] = pHeader->usePalette;
+	head[offset++] = pHeader->imageType;
+	head[offset++] = static_cast<uint8>(pHeader->paletteIndex); head[offset++] = static_cast<uint8>(pHeader->paletteIndex >> 8);
+	head[offset++] = static_cast<uint8>(pHeader->paletteColor); head[offset++] = static_cast<uint8>(pHeader->paletteColor >> 8);
+	head[offset++] = pHeader->paletteBit;
+	head[offset++] = static_cast<uint8>(pHeader->imageX); head[offset++] = static_cast<uint8>(pHeader->imageX >> 8);
+	head[offset++] = static_cast<uint8>(pHeader->imageY); head[offset++] = static_cast<uint8>(pHeader->imageY >> 8);
+	head[offset++] = static_cast<uint8>(pHeader->imageW); head[offset++] = static_cast<uint8>(pHeader->imageW >> 8);
+	head[offset++] = static_cast<uint8>(pHeader->imageH); head[offset++] = static_cast<uint8>(pHeader->imageH >> 8);
+	head[offset++] = pHeader->imageBit;
+	head[offset++] = pHeader->discripter;
+
+	_ASSERT(offset == HEADER_SIZE);
+
+	return pWriter->Write(head, sizeof(head));
+}
+
+/*=======================================================================
+【機能】TGAフッター出力
+【引数】fp     ：FILEポインタ
+        pWriter：出力先(ストリームの場合)
+        pHeader：出力するTGAフッター
+【備考】アライメントに沿っていないので、リトルエンディアンに並べてから出力。
+ =======================================================================*/
+bool CTga::WriteFooter(FILE *fp)
+{
+	return this->WriteFooter(fp, &m_Footer);
+}
+
+bool CTga::WriteFooter(FILE *fp, TGAFooter *pFooter)
+{
+#ifndef NDEBUG
+	_ASSERT(fp != NULL);
+#else
+	if (fp == NULL) return false;
+#endif
+
+	CTgaStreamWriter writer(TgaStreamWriteFILE, fp);
+	return (this->WriteFooter(&writer, pFooter) && writer.Flush());
+}
+
+bool CTga::WriteFooter(CTgaStreamWriter *pWriter, TGAFooter *pFooter)
+{
+#ifndef NDEBUG
+	_ASSERT(pWriter != NULL);
+	_ASSERT(pFooter != NULL);
+#else
+	if (pWriter == NULL || pFooter == NULL) return false;
+#endif
+
+	// 元画像にフッターが付いていたかチェック
+	int ret = 0;
+	for (int i = 0; i < 18; i++) {
+		ret += pFooter->version[i];
+	}
+
+	if (ret == 0) {
+		strcpy(reinterpret_cast<char*>(pFooter->version), "TRUEVISION-TARGA");
+	}
+
+	uint8 foot[FOOTER_SIZE];
+	foot[0] = static_cast<uint8>(pFooter->filePos);       foot[1] = static_cast<uint8>(pFooter->filePos >> 8);
+	foot[2] = static_cast<uint8>(pFooter->filePos >> 16); foot[3] = static_cast<uint8>(pFooter->filePos >> 24);
+	foot[4] = static_cast<uint8>(pFooter->fileDev);       foot[5] = static_cast<uint8>(pFooter->fileDev >> 8);
+	foot[6] = static_cast<uint8>(pFooter->fileDev >> 16); foot[7] = static_cast<uint8>(pFooter->fileDev >> 24);
+	memcpy(&foot[8], pFooter->version, sizeof(pFooter->version));
+
+	return pWriter->Write(foot, sizeof(foot));
+}
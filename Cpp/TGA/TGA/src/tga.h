@@ -1,121 +1,353 @@
-#ifndef _TGA_H_
-#define _TGA_H_
-
-class CTga {
-public:
-	// C[W^Cv
-	enum {
-		IMAGE_TYPE_NONE = 0,		// C[WȂ
-		IMAGE_TYPE_INDEX,			// 256F
-		IMAGE_TYPE_FULL,			// tJ[
-		IMAGE_TYPE_GRAY,			// 
-		IMAGE_TYPE_MAX,
-		IMAGE_TYPE_INDEX_RLE = 9,	// 256F(RLEk)
-		IMAGE_TYPE_FULL_RLE,		// tJ[(RLEk)
-		IMAGE_TYPE_GRAY_RLE,		// (RLEk)
-		IMAGE_TYPE_RLE_MAX
-	};
-
-	// sNZ̕
-	enum {
-		IMAGE_LINE_LRDU = 0x00,		// EA
-		IMAGE_LINE_RLDU = 0x10,		// EA
-		IMAGE_LINE_LRUD = 0x20,		// EAと
-		IMAGE_LINE_RLUD = 0x30,		// EAと
-		IMAGE_LINE_MAX
-	};
-
-	enum {
-		HEADER_SIZE = 0x12,			// wb_[TCY
-		FOOTER_SIZE = 0x1a			// tb^[TCY
-	};
-
-	// G[^Cv
-	enum {
-		ERROR_OPEN    = -1,			// t@CI[vs
-		ERROR_MEMORY  = -2,			// mێs
-		ERROR_HEADER  = -3,			// T|[gĂȂ`
-		ERROR_PALETTE = -4,			// pbgf[^s
-		ERROR_IMAGE   = -5,			// C[Wf[^s
-		ERROR_OUTPUT  = -6,			// o̓G[
-		ERROR_NONE    =  1,			// G[Ȃ
-		ERROR_MAX
-	};
-
-	struct TGAHeader {
-		uint8	IDField;			// IDtB[h̃TCY
-		uint8	usePalette;			// pbggpH
-		uint8	imageType;			// C[W`
-		uint16	paletteIndex;		// pbgIndex
-		uint16	paletteColor;		// pbg̐F
-		uint8	paletteBit;			// 1pbg̃rbg
-		uint16	imageX;				// C[WX_
-		uint16	imageY;				// C[WY_
-		uint16	imageW;				// C[W
-		uint16	imageH;				// C[W
-		uint8	imageBit;			// C[Wrbg
-		uint8	discripter;			// C[WLqq
-	};
-
-	struct TGAFooter {
-		uint32	filePos;			// t@C̈ʒu(GNXeVGÄʒu?)
-		uint32	fileDev;			// developer directory t@Cʒu
-		uint8	version[18];		// hTRUEVISION-TARGAh̕iversion[17]==0x00j
-	};
-
-private:
-	TGAHeader	m_Header;
-	TGAFooter	m_Footer;
-
-	uint8		*m_pImage;			// sNZf[^
-	uint8		*m_pPalette;		// pbgf[^
-	uint32		m_ImageSize;		// sNZf[^TCY
-	uint32		m_PaletteSize;		// pbgf[^TCY
-
-private:
-	void   Clear(void);
-	bool   CheckSupport(const TGAHeader &header);
-	bool   ReadHeader(const uint8 *pSrc);
-	void   ReadFooter(const uint8 *pSrc, const uint32 offset);
-	bool   CalcSize(const bool bFlg);
-	bool   ReadImage(const uint8 *pSrc, const uint32 size, uint32 *pOffset);
-	bool   ReadPalette(const uint8 *pSrc);
-	uint32 UnpackRLE(uint8 *pDst, const uint8 *pSrc, const uint32 size);
-
-public:
-	CTga(void);
-	virtual ~CTga(void);
-
-	uint8 *getImage(void)        const {return m_pImage;}
-	uint32 getImageSize(void)    const {return m_ImageSize;}
-	uint8  getImageBit(void)     const {return m_Header.imageBit;}
-
-	uint8 *getPalette(void)      const {return m_pPalette;}
-	uint32 getPaletteSize(void)  const {return m_PaletteSize;}
-	uint16 getPaletteColor(void) const {return m_Header.paletteColor;}
-	uint8  getPaletteBit(void)   const {return m_Header.paletteBit;}
-
-	uint16 getWidth(void)        const {return m_Header.imageW;}
-	uint16 getHeight(void)       const {return m_Header.imageH;}
-
-	TGAHeader getHeader(void)   const {return m_Header;}
-	TGAFooter getFooter(void)   const {return m_Footer;}
-
-	void setFilePos(const uint32 filePos) {m_Footer.filePos = filePos;}
-	void setFileDev(const uint32 fileDev) {m_Footer.fileDev = fileDev;}
-
-	int  Create(const char *pFileName);
-	int  Create(const void *pSrc, const uint32 size);
-	int  Create(const TGAHeader &header, uint8 *pImage, const uint32 imageSize, uint8 *pPalette, const uint32 paletteSize);
-	int  Output(const char *pFileName);
-	int  OutputBMP(const char *pFileName);
-	bool ConvertRGBA(void);
-	bool ConvertType(const sint32 type);
-
-	bool WriteHeader(FILE *fp);
-	bool WriteHeader(FILE *fp, TGAHeader *pHeader);
-	bool WriteFooter(FILE *fp);
-	bool WriteFooter(FILE *fp, TGAFooter *pHeader);
-};
-
-#endif
+#ifndef _TGA_H_
+#define _TGA_H_
+
+class CMtoFileMap;
+class CTgaLarge;
+class CTgaPack;
+class CTgaSidecar;
+class CTgaStreamReader;
+class CTgaStreamWriter;
+
+class CTga {
+	friend class CTgaLarge;
+	friend class CTgaPack;
+	friend class CTgaSidecar;
+
+public:
+	// イメージタイプ
+	enum {
+		IMAGE_TYPE_NONE = 0,		// イメージなし
+		IMAGE_TYPE_INDEX,			// 256色
+		IMAGE_TYPE_FULL,			// フルカラー
+		IMAGE_TYPE_GRAY,			// 白黒
+		IMAGE_TYPE_MAX,
+		IMAGE_TYPE_INDEX_RLE = 9,	// 256色(RLE圧縮)
+		IMAGE_TYPE_FULL_RLE,		// フルカラー(RLE圧縮)
+		IMAGE_TYPE_GRAY_RLE,		// 白黒(RLE圧縮)
+		IMAGE_TYPE_RLE_MAX
+	};
+
+	// ピクセルの並び
+	enum {
+		IMAGE_LINE_LRDU = 0x00,		// 左→右、下→上
+		IMAGE_LINE_RLDU = 0x10,		// 右→左、下→上
+		IMAGE_LINE_LRUD = 0x20,		// 左→右、上→下
+		IMAGE_LINE_RLUD = 0x30,		// 右→左、上→下
+		IMAGE_LINE_MAX
+	};
+
+	enum {
+		HEADER_SIZE = 0x12,			// ヘッダーサイズ
+		FOOTER_SIZE = 0x1a,			// フッターサイズ
+		EXTENSION_SIZE = 0x1ef		// エクステンションエリアのサイズ
+	};
+
+	// 出力フラグ
+	enum {
+		OUTPUT_FLAG_NONE     = 0x00,	// 指定なし
+		OUTPUT_FLAG_SCANLINE = 0x01,	// エクステンションエリアとスキャンラインテーブルを出力する
+		OUTPUT_FLAG_OPTIMIZE = 0x02		// 劣化しない一番小さい形式に変換して出力する
+	};
+
+	enum {
+		RLE_BAND_LINE = 32			// RLE圧縮を並列で行う時の1つの帯のライン数
+	};
+
+	// 回転
+	enum {
+		ROTATE_90 = 0,				// 時計回りに90度
+		ROTATE_180,					// 180度
+		ROTATE_270,					// 時計回りに270度(反時計回りに90度)
+		ROTATE_TRANSPOSE,			// 転置(左上と右下を結ぶ線で反転)
+		ROTATE_MAX
+	};
+
+	enum {
+		ROTATE_TILE = 64			// 回転を並列で行う時の1つのタイルの辺のピクセル数
+	};
+
+	// 切り出しフラグ
+	enum {
+		SLICE_FLAG_NONE  = 0x00,	// 指定なし
+		SLICE_FLAG_RLE   = 0x01,	// RLE圧縮して出力する
+		SLICE_FLAG_SKIP  = 0x02		// 全部透明な範囲は出力しない
+	};
+
+	enum {
+		SLICE_PATH_MAX_LEN = 1024,	// 切り出したファイルのパスの最大長
+		PATTERN_WIDTH_MAX  = 16		// ファイル名のパターンで指定できる最大の幅
+	};
+
+	enum {
+		IMAGE_PIXEL_MAX = 0x1fffffff	// メモリ上で扱える最大ピクセル数(32bitに展開しても2GB未満)
+	};
+
+	// エラータイプ
+	enum {
+		ERROR_OPEN    = -1,			// ファイルオープン失敗
+		ERROR_MEMORY  = -2,			// メモリ確保失敗
+		ERROR_HEADER  = -3,			// サポートしていない形式
+		ERROR_PALETTE = -4,			// パレットデータが不正
+		ERROR_IMAGE   = -5,			// イメージデータが不正
+		ERROR_OUTPUT  = -6,			// 出力エラー
+		ERROR_NONE    =  1,			// エラーなし
+		ERROR_MAX
+	};
+
+	// 検証結果
+	enum {
+		VALIDATE_NONE = 0,			// 問題なし
+		VALIDATE_OPEN,				// ファイルを開けない
+		VALIDATE_TRUNCATED,			// データが途中で終わっている
+		VALIDATE_HEADER,			// サポートしていない形式
+		VALIDATE_SIZE,				// 大きさが0か、メモリ上で扱えない大きさ
+		VALIDATE_PALETTE,			// パレットがない
+		VALIDATE_RLE,				// RLEのパケットがイメージの終わりを超える
+		VALIDATE_INDEX,				// パレットの色数を超える番号
+		VALIDATE_EXTENSION,			// エクステンションエリアの位置かサイズが不正
+		VALIDATE_SCANLINE,			// スキャンラインテーブルが不正
+		VALIDATE_DEVELOPER,			// デベロッパーエリアが不正
+		VALIDATE_MAX
+	};
+
+	// 作成フラグ
+	enum {
+		CREATE_FLAG_NONE        = 0x00,	// 指定なし
+		CREATE_FLAG_PREMULTIPLY = 0x01,	// 乗算済みアルファで読み込む
+		CREATE_FLAG_HASH        = 0x02,	// 読み込み時にハッシュ値を計算する
+		CREATE_FLAG_LAZY        = 0x04	// ピクセルは最初に使う時にデコードする
+	};
+
+	// ミップマップのフィルタ
+	enum {
+		MIPMAP_FILTER_BOX = 0,		// 2x2の平均
+		MIPMAP_FILTER_GAMMA,		// sRGBをリニアに戻して平均
+		MIPMAP_FILTER_COVERAGE,		// アルファテストのカバレッジを維持
+		MIPMAP_FILTER_MAX
+	};
+
+	enum {
+		MIPMAP_LEVEL_MAX = 16		// ミップマップの最大段階数
+	};
+
+	// サイズ変更のフィルタ
+	enum {
+		RESIZE_FILTER_BILINEAR = 0,	// バイリニア
+		RESIZE_FILTER_BICUBIC,		// バイキュービック(Catmull-Rom)
+		RESIZE_FILTER_LANCZOS3,		// Lanczos(3)
+		RESIZE_FILTER_MAX
+	};
+
+	// ブロック圧縮の形式
+	enum {
+		BC_FORMAT_BC1 = 0,			// RGB(1bitアルファ)、8バイト/ブロック
+		BC_FORMAT_BC3,				// RGBA、16バイト/ブロック
+		BC_FORMAT_BC4,				// 1チャンネル(R、白黒)、8バイト/ブロック
+		BC_FORMAT_BC5,				// 2チャンネル(RG)、16バイト/ブロック
+		BC_FORMAT_MAX
+	};
+
+	// ブロック圧縮のフラグ
+	enum {
+		BC_FLAG_NONE    = 0x00,		// 範囲フィット(速い)
+		BC_FLAG_CLUSTER = 0x01,		// クラスタフィット(遅いが誤差が小さい)
+		BC_FLAG_RAW     = 0x02		// OutputBCでDDSヘッダーを付けない
+	};
+
+	struct TGAHeader {
+		uint8	IDField;			// IDフィールドのサイズ
+		uint8	usePalette;			// パレット使用？
+		uint8	imageType;			// イメージ形式
+		uint16	paletteIndex;		// パレットIndex
+		uint16	paletteColor;		// パレットの色数
+		uint8	paletteBit;			// 1パレットのビット数
+		uint16	imageX;				// イメージX原点
+		uint16	imageY;				// イメージY原点
+		uint16	imageW;				// イメージ幅
+		uint16	imageH;				// イメージ高さ
+		uint8	imageBit;			// イメージビット数
+		uint8	discripter;			// イメージ記述子
+	};
+
+	struct TGAFooter {
+		uint32	filePos;			// ファイルの位置(エクステンションエリアの位置?)
+		uint32	fileDev;			// developer directory ファイル位置
+		uint8	version[18];		// ”TRUEVISION-TARGA”の文字（version[17]==0x00）
+	};
+
+	struct TGACompare {
+		uint32	diffPixel;			// 一致しないピクセル数
+		uint32	maxDiff;			// 最大差(全チャンネル)
+		uint32	maxDiffCh[4];		// チャンネルごとの最大差(B,G,R,A)
+		double	mse[4];				// チャンネルごとの平均2乗誤差(B,G,R,A)
+		double	psnr[4];			// チャンネルごとのPSNR(dB、一致ならHUGE_VAL)
+		double	mseAll;				// 全チャンネルの平均2乗誤差
+		double	psnrAll;			// 全チャンネルのPSNR(dB、一致ならHUGE_VAL)
+	};
+
+	enum {
+		ANALYSIS_COLOR_MAX = 256	// 色数を数える上限(超えたらANALYSIS_COLOR_MAX + 1)
+	};
+
+	struct TGARect {
+		uint16	x;					// 左上のX座標
+		uint16	y;					// 左上のY座標(上から)
+		uint16	w;					// 幅
+		uint16	h;					// 高さ
+	};
+
+	struct TGAValidation {
+		sint32	error;				// 検証結果(VALIDATE_*)
+		uint64	errorOffset;		// エラーの位置(ファイルの先頭から)
+		uint64	imageOffset;		// イメージの位置
+		uint64	imageSize;			// イメージのファイル上のサイズ(RLEなら圧縮後)
+		uint32	packetNum;			// RLEのパケット数
+		bool	bFooter;			// フッターあり？
+		bool	bExtension;			// エクステンションエリアあり？
+	};
+
+	struct TGAAnalysis {
+		bool	bOpaque;			// 全ピクセルが不透明？
+		bool	bBinaryAlpha;		// アルファが0か255だけ？
+		bool	bGray;				// 白黒(B=G=R)？
+		bool	b5Bit;				// BGRを16bit(5bit/チャンネル)にしても変わらない？
+		uint32	colorNum;			// 色数(アルファ込み、上限を超えたらANALYSIS_COLOR_MAX + 1)
+	};
+
+private:
+	struct TGALazy;
+	struct TGAColorSet;
+	struct TGAShareMap;
+
+	TGAHeader	m_Header;
+	TGAFooter	m_Footer;
+
+	uint8		*m_pImage;			// ピクセルデータ
+	uint8		*m_pPalette;		// パレットデータ
+	uint32		m_ImageSize;		// ピクセルデータサイズ
+	uint32		m_PaletteSize;		// パレットデータサイズ
+
+	uint32		m_CreateFlag;		// 作成フラグ
+	bool		m_bPremultiplied;	// 乗算済みアルファ？
+	bool		m_bRGBA;			// RGBA配列？(ConvertRGBAで切り替わる)
+	uint64		m_Hash;				// ハッシュ値(未計算なら0)
+
+	CMtoFileMap			*m_pMap;		// マップ中のキャッシュ(NULL以外ならイメージとパレットはこの中)
+	TGAShareMap			*m_pShare;		// 共有しているマップ(CTgaPackのもの、NULLなら共有していない)
+	const CTgaSidecar	*m_pSidecar;	// 読み込みに使うキャッシュ
+	TGALazy				*m_pLazy;		// 遅延デコードの情報(NULLなら遅延デコードなし)
+
+private:
+	void   Clear(void);
+	bool   Detach(void);
+	void   ReleaseMap(void);
+	void   AttachShareMap(TGAShareMap *pShare);
+	bool   CheckSupport(const TGAHeader &header);
+	bool   ReadHeader(const uint8 *pSrc);
+	void   ReadFooter(const uint8 *pSrc, const uint32 offset);
+	bool   CalcSize(const bool bFlg);
+	bool   ReadImage(const uint8 *pSrc, const uint32 size, uint32 *pOffset);
+	bool   ReadPalette(const uint8 *pSrc);
+	uint32 UnpackRLE(uint8 *pDst, const uint8 *pSrc, const uint32 size);
+	bool   UnpackRLE(CTgaStreamReader *pReader);
+	bool   IsAlphaImage(void) const;
+	uint8 *GetLinePtr(const sint32 y) const;
+	const uint8 *GetLine32(uint8 *pWork, const sint32 y) const;
+	bool   IsClearRect(const TGARect &rect, const uint8 *pClearIndex) const;
+	uint64 HashLine(uint8 *pWork, const sint32 y) const;
+	uint64 HashImage(const uint64 *pLineHash) const;
+	uint64 HashAll(void);
+	int    CreateLazy(const char *pFileName, const void *pSrc, const uint32 size);
+	bool   DecodeLazy(void) const;
+	void   ClearLazy(void);
+	bool   CreateMipmap(CTga *pMip, const sint32 filter, const float coverage) const;
+	bool   Analyze(TGAAnalysis *pResult, TGAColorSet *pSet) const;
+
+	static TGAShareMap *OpenShareMap(const char *pFileName);
+	static CMtoFileMap *GetShareMap(TGAShareMap *pShare);
+	static void         ReleaseShareMap(TGAShareMap *pShare);
+
+public:
+	CTga(void);
+	virtual ~CTga(void);
+
+	uint8 *getImage(void)        const {this->Decode(); return m_pImage;}
+	uint32 getImageSize(void)    const {return m_ImageSize;}
+	uint8  getImageBit(void)     const {return m_Header.imageBit;}
+	uint8 *getLine(const sint32 y) const;
+	sint32 getPitch(void)        const {return ((m_Header.discripter & 0x20) ? 1 : -1) * static_cast<sint32>(m_Header.imageW * (m_Header.imageBit >> 3));}
+
+	uint8 *getPalette(void)      const {return m_pPalette;}
+	uint32 getPaletteSize(void)  const {return m_PaletteSize;}
+	uint16 getPaletteColor(void) const {return m_Header.paletteColor;}
+	uint8  getPaletteBit(void)   const {return m_Header.paletteBit;}
+
+	uint16 getWidth(void)        const {return m_Header.imageW;}
+	uint16 getHeight(void)       const {return m_Header.imageH;}
+
+	TGAHeader getHeader(void)   const {return m_Header;}
+	TGAFooter getFooter(void)   const {this->Decode(); return m_Footer;}
+
+	uint32 getCreateFlag(void)   const {return m_CreateFlag;}
+	bool   isPremultiplied(void) const {return m_bPremultiplied;}
+	bool   isRGBA(void)          const {return m_bRGBA;}
+	uint64 getHash(void)         const {return m_Hash;}
+	bool   isMapped(void)        const {return (m_pMap != NULL);}
+	bool   isRLE(void)           const {return (IMAGE_TYPE_INDEX_RLE <= m_Header.imageType && m_Header.imageType < IMAGE_TYPE_RLE_MAX);}
+
+	void setFilePos(const uint32 filePos) {this->Decode(); m_Footer.filePos = filePos;}
+	void setFileDev(const uint32 fileDev) {this->Decode(); m_Footer.fileDev = fileDev;}
+	void setCreateFlag(const uint32 flag) {m_CreateFlag = flag;}
+	void setSidecar(const CTgaSidecar *pSidecar) {m_pSidecar = pSidecar;}
+	void setRLE(const bool bRLE);
+
+	int  Create(const char *pFileName);
+	int  Create(const void *pSrc, const uint32 size);
+	int  Create(const TGAHeader &header, uint8 *pImage, const uint32 imageSize, uint8 *pPalette, const uint32 paletteSize);
+	int  Create(CTgaStreamReader *pReader);
+	bool Decode(void) const {return (m_pLazy == NULL) ? true : this->DecodeLazy();}
+	int  Output(const char *pFileName);
+	int  Output(const char *pFileName, const uint32 flag);
+	int  Output(CTgaStreamWriter *pWriter, const uint32 flag);
+	int  OutputBMP(const char *pFileName);
+	bool ConvertRGBA(void);
+	bool ConvertType(const sint32 type);
+	bool Rotate(const sint32 rotate);
+	int  Slice(const char *pPattern, const TGARect *pRect, const uint32 num, const uint32 flag, uint32 *pOutNum) const;
+	int  SliceGrid(const char *pPattern, const uint32 cellW, const uint32 cellH, const uint32 flag, uint32 *pOutNum) const;
+	static bool CheckPattern(const char *pPattern, const uint32 pathMax);
+	static bool ExpandPattern(char *pPath, const uint32 pathMax, const char *pPattern, const sint32 number);
+	bool Premultiply(void);
+	bool Unpremultiply(void);
+	bool Quantize(const uint32 colorMax, const uint32 refine);
+	bool GetImage32(uint8 *pDst) const;
+	uint64 CalcHash(void);
+
+	bool   CreateMipmap(CTga *pMip, const sint32 filter) const;
+	sint32 CreateMipmapChain(CTga *pLevel, const sint32 levelMax, const sint32 filter) const;
+	int    OutputMipmap(const char *pFileName, const sint32 filter);
+
+	bool Resize(CTga *pDst, const uint32 width, const uint32 height, const sint32 filter) const;
+	bool Compare(const CTga &tga, TGACompare *pResult, CTga *pHeatmap) const;
+
+	uint32 CalcBCSize(const sint32 format) const;
+	bool   EncodeBC(uint8 *pDst, const sint32 format, const uint32 flag) const;
+	int    OutputBC(const char *pFileName, const sint32 format, const uint32 flag);
+
+	bool Analyze(TGAAnalysis *pResult) const;
+	bool Optimize(CTga *pDst) const;
+
+	static sint32 Validate(const void *pSrc, const uint64 size, TGAValidation *pResult);
+	static sint32 Validate(const char *pFileName, TGAValidation *pResult);
+	static uint32 ValidateFiles(const char *const *ppFile, const uint32 num, TGAValidation *pResult);
+	static const char *GetValidateMessage(const sint32 error);
+
+	bool WriteHeader(FILE *fp);
+	bool WriteHeader(FILE *fp, TGAHeader *pHeader);
+	bool WriteFooter(FILE *fp);
+	bool WriteFooter(FILE *fp, TGAFooter *pHeader);
+	bool WriteHeader(CTgaStreamWriter *pWriter, TGAHeader *pHeader);
+	bool WriteFooter(CTgaStreamWriter *pWriter, TGAFooter *pFooter);
+};
+
+#endif
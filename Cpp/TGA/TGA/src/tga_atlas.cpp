@@ -0,0 +1,522 @@
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_atlas.h"
+#include "tga_kernel.h"
+
+#include <algorithm>
+
+namespace {
+
+/*=======================================================================
+【機能】スカイラインの1区間
+ =======================================================================*/
+struct Skyline {
+	uint32	x;								// 開始X座標
+	uint32	y;								// 高さ
+	uint32	w;								// 幅
+};
+
+/*=======================================================================
+【機能】詰め込む順番の比較(高さ→幅の大きい順)
+ =======================================================================*/
+struct SpriteGreater {
+	const CTgaAtlas::TGASprite *pSprite;
+
+	SpriteGreater(const CTgaAtlas::TGASprite *p) : pSprite(p) {}
+	bool operator()(const uint32 a, const uint32 b) const
+	{
+		if (pSprite[a].h != pSprite[b].h) return pSprite[a].h > pSprite[b].h;
+		if (pSprite[a].w != pSprite[b].w) return pSprite[a].w > pSprite[b].w;
+		return a < b;
+	}
+};
+
+/*=======================================================================
+【機能】2バイト/4バイト出力(リトルエンディアン)
+ =======================================================================*/
+void Write16(FILE *fp, const uint32 n)
+{
+	uint8 buf[2] = {static_cast<uint8>(n), static_cast<uint8>(n >> 8)};
+	fwrite(buf, sizeof(buf), 1, fp);
+}
+
+void Write32(FILE *fp, const uint32 n)
+{
+	uint8 buf[4] = {static_cast<uint8>(n), static_cast<uint8>(n >> 8), static_cast<uint8>(n >> 16), static_cast<uint8>(n >> 24)};
+	fwrite(buf, sizeof(buf), 1, fp);
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTgaAtlas::CTgaAtlas(void)
+{
+	m_pSprite   = NULL;
+	m_ppImage   = NULL;
+	m_SpriteNum = 0;
+	m_SpriteMax = 0;
+
+	m_pName    = NULL;
+	m_NameSize = 0;
+	m_NameMax  = 0;
+
+	m_pAtlas = NULL;
+}
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTgaAtlas::~CTgaAtlas(void)
+{
+	this->Clear();
+}
+
+/*=======================================================================
+【機能】情報クリア
+ =======================================================================*/
+void CTgaAtlas::Clear(void)
+{
+	for (uint32 i = 0; i < m_SpriteNum; i++) {
+		SAFE_DELETES(m_ppImage[i]);
+	}
+	SAFE_DELETES(m_ppImage);
+	SAFE_DELETES(m_pSprite);
+	SAFE_DELETES(m_pName);
+
+	m_SpriteNum = 0;
+	m_SpriteMax = 0;
+	m_NameSize  = 0;
+	m_NameMax   = 0;
+
+	SAFE_DELETE(m_pAtlas);
+}
+
+/*=======================================================================
+【機能】ファイルから追加
+【引数】pFileName：ファイル名(スプライトの名前になります)
+【戻値】エラータイプ(CTga::ERROR_*)
+ =======================================================================*/
+int CTgaAtlas::Add(const char *pFileName)
+{
+#ifndef NDEBUG
+	_ASSERT(pFileName != NULL);
+#else
+	if (pFileName == NULL) return CTga::ERROR_OPEN;
+#endif
+
+	CTga tga;
+	int ret = tga.Create(pFileName);
+	if (ret != CTga::ERROR_NONE) return ret;
+
+	return this->Add(tga, pFileName);
+}
+
+/*=======================================================================
+【機能】TGAから追加
+【引数】tga  ：追加するTGA
+        pName：スプライトの名前
+【戻値】エラータイプ(CTga::ERROR_*)
+【備考】アルファが0ではない範囲にトリミングして保持します。
+        全部アルファ0の画像は幅・高さ0のスプライトになります。
+ =======================================================================*/
+int CTgaAtlas::Add(const CTga &tga, const char *pName)
+{
+	if (tga.getImage() == NULL) return CTga::ERROR_IMAGE;
+	if (pName == NULL) pName = "";
+
+	const uint32 w = tga.getWidth();
+	const uint32 h = tga.getHeight();
+	const uint32 len = static_cast<uint32>(strlen(pName)) + 1;
+
+	if (!this->Reserve(m_SpriteNum + 1, m_NameSize + len)) return CTga::ERROR_MEMORY;
+
+	// 32bitに展開してトリミング
+	uint8 *pImage;
+	if ((pImage = new uint8[w * h * 4]) == NULL) return CTga::ERROR_MEMORY;
+	tga.GetImage32(pImage);
+
+	TGASprite *pSprite = &m_pSprite[m_SpriteNum];
+	uint8 *pTrim = NULL;
+	bool bResult = this->Trim(pImage, w, h, pSprite, &pTrim);
+	SAFE_DELETES(pImage);
+	if (!bResult) return CTga::ERROR_MEMORY;
+
+	pSprite->x          = 0;
+	pSprite->y          = 0;
+	pSprite->srcW       = static_cast<uint16>(w);
+	pSprite->srcH       = static_cast<uint16>(h);
+	pSprite->nameOffset = m_NameSize;
+
+	memcpy(&m_pName[m_NameSize], pName, len);
+	m_NameSize += len;
+
+	m_ppImage[m_SpriteNum] = pTrim;
+	m_SpriteNum++;
+
+	return CTga::ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】アトラスに詰め込む
+【引数】width  ：アトラスの幅
+        height ：アトラスの最大高さ(0なら65535まで)
+        padding：スプライト間の隙間
+【戻値】エラータイプ(CTga::ERROR_*、ERROR_PACK)
+【備考】アトラスの高さは使用した高さになります。
+        アトラスは32bit、左上原点で作成します。
+ =======================================================================*/
+int CTgaAtlas::Pack(const uint32 width, const uint32 height, const uint32 padding)
+{
+	if (width == 0 || width > 0xffff || height > 0xffff) return CTga::ERROR_HEADER;
+	if (m_SpriteNum == 0) return CTga::ERROR_IMAGE;
+
+	// 配置
+	uint32 usedH;
+	if (!this->Place(width, (height != 0) ? height : 0xffff, padding, &usedH)) return ERROR_PACK;
+	if (usedH == 0) usedH = 1;
+
+	// 転送
+	const uint32 size = width * usedH * 4;
+	uint8 *pAtlas;
+	if ((pAtlas = new uint8[size]) == NULL) return CTga::ERROR_MEMORY;
+	memset(pAtlas, 0, size);
+
+	const sint32 num = static_cast<sint32>(m_SpriteNum);
+
+#pragma omp parallel for schedule(dynamic, 16)
+	for (sint32 i = 0; i < num; i++) {
+		const TGASprite &sprite = m_pSprite[i];
+		const uint8 *pSrc = m_ppImage[i];
+
+		for (uint32 y = 0; y < sprite.h; y++) {
+			memcpy(&pAtlas[((sprite.y + y) * width + sprite.x) * 4], &pSrc[y * sprite.w * 4], sprite.w * 4);
+		}
+	}
+
+	CTga::TGAHeader header;
+	memset(&header, 0, sizeof(header));
+	header.imageType  = CTga::IMAGE_TYPE_FULL;
+	header.imageW     = static_cast<uint16>(width);
+	header.imageH     = static_cast<uint16>(usedH);
+	header.imageBit   = 32;
+	header.discripter = CTga::IMAGE_LINE_LRUD | 8;
+
+	SAFE_DELETE(m_pAtlas);
+	if ((m_pAtlas = new CTga) == NULL) {
+		SAFE_DELETES(pAtlas);
+		return CTga::ERROR_MEMORY;
+	}
+
+	int ret = m_pAtlas->Create(header, pAtlas, size, NULL, 0);
+	if (ret != CTga::ERROR_NONE) {
+		SAFE_DELETES(pAtlas);
+		SAFE_DELETE(m_pAtlas);
+	}
+
+	return ret;
+}
+
+/*=======================================================================
+【機能】ファイル出力
+【引数】pImageFile：アトラスのファイル名
+        pTableFile：スプライトテーブルのファイル名(NULLなら出力しない)
+【戻値】エラータイプ(CTga::ERROR_*)
+ =======================================================================*/
+int CTgaAtlas::Output(const char *pImageFile, const char *pTableFile)
+{
+	if (m_pAtlas == NULL) return CTga::ERROR_IMAGE;
+
+	int ret = m_pAtlas->Output(pImageFile);
+	if (ret != CTga::ERROR_NONE || pTableFile == NULL) return ret;
+
+	FILE *fp;
+	if ((fp = fopen(pTableFile, "wb")) == NULL) {
+		DBG_PRINT("file can't open!\n");
+		return CTga::ERROR_OPEN;
+	}
+
+	bool bResult = this->WriteTable(fp);
+	fclose(fp);
+
+	return bResult ? CTga::ERROR_NONE : CTga::ERROR_OUTPUT;
+}
+
+/*=======================================================================
+【機能】配列の確保
+【引数】spriteNum：必要なスプライト数
+        nameSize ：必要な名前テーブルのサイズ
+【備考】非公開
+ =======================================================================*/
+bool CTgaAtlas::Reserve(const uint32 spriteNum, const uint32 nameSize)
+{
+	if (spriteNum > m_SpriteMax) {
+		uint32 max = (m_SpriteMax != 0) ? (m_SpriteMax * 2) : 256;
+		while (max < spriteNum) max *= 2;
+
+		TGASprite *pSprite = new TGASprite[max];
+		uint8 **ppImage = new uint8*[max];
+		if (pSprite == NULL || ppImage == NULL) {
+			SAFE_DELETES(pSprite);
+			SAFE_DELETES(ppImage);
+			return false;
+		}
+
+		if (m_SpriteNum != 0) {
+			memcpy(pSprite, m_pSprite, sizeof(TGASprite) * m_SpriteNum);
+			memcpy(ppImage, m_ppImage, sizeof(uint8*) * m_SpriteNum);
+		}
+		SAFE_DELETES(m_pSprite);
+		SAFE_DELETES(m_ppImage);
+		m_pSprite   = pSprite;
+		m_ppImage   = ppImage;
+		m_SpriteMax = max;
+	}
+
+	if (nameSize > m_NameMax) {
+		uint32 max = (m_NameMax != 0) ? (m_NameMax * 2) : 4096;
+		while (max < nameSize) max *= 2;
+
+		char *pName;
+		if ((pName = new char[max]) == NULL) return false;
+
+		if (m_NameSize != 0) {
+			memcpy(pName, m_pName, m_NameSize);
+		}
+		SAFE_DELETES(m_pName);
+		m_pName   = pName;
+		m_NameMax = max;
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】アルファの範囲にトリミング
+【引数】pImage  ：32bitイメージ(左上原点)
+        w       ：幅
+        h       ：高さ
+        pSprite ：トリミング範囲の格納先
+        ppTrim  ：トリミング後のイメージの格納先
+【備考】非公開
+ =======================================================================*/
+bool CTgaAtlas::Trim(const uint8 *pImage, const uint32 w, const uint32 h, TGASprite *pSprite, uint8 **ppTrim)
+{
+	uint32 left = w, right = 0, top = h, bottom = 0;
+
+	for (uint32 y = 0; y < h; y++) {
+		const uint8 *pLine = &pImage[y * w * 4];
+		bool bFind = false;
+
+		// 左端はこれまでの左端より左、右端はこれまでの右端より右だけ調べる
+		uint32 l = TgaKernelFindAlpha32(pLine, left);
+		if (l < left) {
+			left  = l;
+			bFind = true;
+		}
+		uint32 r = TgaKernelFindAlphaLast32(&pLine[right * 4], w - right);
+		if (r != 0) {
+			right += r;
+			bFind  = true;
+		}
+
+		// 外側になければ内側を調べる
+		if (!bFind && left < right) {
+			bFind = (TgaKernelFindAlpha32(&pLine[left * 4], right - left) < right - left);
+		}
+		if (!bFind) continue;
+
+		if (top == h) top = y;
+		bottom = y + 1;
+	}
+
+	// 全部アルファ0
+	if (top == h) {
+		pSprite->w = pSprite->h = 0;
+		pSprite->trimX = pSprite->trimY = 0;
+		*ppTrim = NULL;
+		return true;
+	}
+
+	const uint32 tw = right - left;
+	const uint32 th = bottom - top;
+	uint8 *pTrim;
+
+	if ((pTrim = new uint8[tw * th * 4]) == NULL) return false;
+
+	for (uint32 y = 0; y < th; y++) {
+		memcpy(&pTrim[y * tw * 4], &pImage[((top + y) * w + left) * 4], tw * 4);
+	}
+
+	pSprite->w     = static_cast<uint16>(tw);
+	pSprite->h     = static_cast<uint16>(th);
+	pSprite->trimX = static_cast<uint16>(left);
+	pSprite->trimY = static_cast<uint16>(top);
+	*ppTrim = pTrim;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】スカイライン法で配置
+【引数】width  ：アトラスの幅
+        height ：アトラスの最大高さ
+        padding：スプライト間の隙間
+        pUsedH ：使用した高さの格納先
+【備考】非公開
+        大きいものから順に、一番低く置ける位置(同じなら左)に置く。
+ =======================================================================*/
+bool CTgaAtlas::Place(const uint32 width, const uint32 height, const uint32 padding, uint32 *pUsedH)
+{
+	uint32 *pOrder;
+	Skyline *pLine;
+	Skyline *pWork;
+
+	pOrder = new uint32[m_SpriteNum];
+	pLine  = new Skyline[width + 1];
+	pWork  = new Skyline[width + 1];
+	if (pOrder == NULL || pLine == NULL || pWork == NULL) {
+		SAFE_DELETES(pOrder);
+		SAFE_DELETES(pLine);
+		SAFE_DELETES(pWork);
+		return false;
+	}
+
+	for (uint32 i = 0; i < m_SpriteNum; i++) pOrder[i] = i;
+	std::sort(pOrder, pOrder + m_SpriteNum, SpriteGreater(m_pSprite));
+
+	uint32 lineNum = 1;
+	pLine[0].x = 0;
+	pLine[0].y = 0;
+	pLine[0].w = width;
+
+	uint32 usedH = 0;
+	bool bResult = true;
+
+	for (uint32 n = 0; n < m_SpriteNum && bResult; n++) {
+		TGASprite &sprite = m_pSprite[pOrder[n]];
+		if (sprite.w == 0 || sprite.h == 0) continue;
+
+		// 右端・下端の隙間は不要
+		const uint32 sw = sprite.w + padding;
+		const uint32 sh = sprite.h + padding;
+		uint32 bestY = 0xffffffff, bestI = 0, bestX = 0;
+
+		for (uint32 i = 0; i < lineNum; i++) {
+			const uint32 x = pLine[i].x;
+			if (x + sprite.w > width) break;
+
+			// 置いた時の高さ(幅の範囲で一番高い区間)
+			uint32 y = 0, j = i, end = (x + sw < width) ? (x + sw) : width;
+			for (; j < lineNum && pLine[j].x < end; j++) {
+				if (pLine[j].y > y) y = pLine[j].y;
+				if (y >= bestY) break;
+			}
+			if (y < bestY && y + sprite.h <= height) {
+				bestY = y;
+				bestI = i;
+				bestX = x;
+			}
+		}
+
+		if (bestY == 0xffffffff) {
+			bResult = false;
+			break;
+		}
+
+		sprite.x = static_cast<uint16>(bestX);
+		sprite.y = static_cast<uint16>(bestY);
+		if (bestY + sprite.h > usedH) usedH = bestY + sprite.h;
+
+		// スカイラインを更新(置いた範囲を1区間にまとめる)
+		const uint32 end = (bestX + sw < width) ? (bestX + sw) : width;
+		const uint32 top = (bestY + sh < height) ? (bestY + sh) : height;
+		uint32 num = 0;
+
+		for (uint32 i = 0; i < bestI; i++) pWork[num++] = pLine[i];
+
+		pWork[num].x = bestX;
+		pWork[num].y = top;
+		pWork[num].w = end - bestX;
+		num++;
+
+		for (uint32 i = bestI; i < lineNum; i++) {
+			const uint32 segEnd = pLine[i].x + pLine[i].w;
+			if (segEnd <= end) continue;
+
+			Skyline seg = pLine[i];
+			if (seg.x < end) {
+				seg.w = segEnd - end;
+				seg.x = end;
+			}
+			pWork[num++] = seg;
+		}
+
+		// 同じ高さの区間は結合
+		lineNum = 0;
+		for (uint32 i = 0; i < num; i++) {
+			if (lineNum != 0 && pLine[lineNum - 1].y == pWork[i].y) {
+				pLine[lineNum - 1].w += pWork[i].w;
+			} else {
+				pLine[lineNum++] = pWork[i];
+			}
+		}
+	}
+
+	SAFE_DELETES(pOrder);
+	SAFE_DELETES(pLine);
+	SAFE_DELETES(pWork);
+
+	*pUsedH = usedH;
+
+	return bResult;
+}
+
+/*=======================================================================
+【機能】スプライトテーブル出力
+【引数】fp：FILEポインタ
+【備考】非公開
+        "TGAA"、バージョン(2)、予約(2)、スプライト数(4)、アトラスの幅(2)・高さ(2)、
+        スプライト情報(TGASpriteの順に20バイト×スプライト数)、名前テーブルの順。
+        数値はすべてリトルエンディアンです。
+ =======================================================================*/
+bool CTgaAtlas::WriteTable(FILE *fp)
+{
+#ifndef NDEBUG
+	_ASSERT(fp != NULL);
+#else
+	if (fp == NULL) return false;
+#endif
+
+	// ヘッダー
+	fwrite("TGAA", 4, 1, fp);
+	Write16(fp, TABLE_VERSION);
+	Write16(fp, 0);
+	Write32(fp, m_SpriteNum);
+	Write16(fp, m_pAtlas->getWidth());
+	Write16(fp, m_pAtlas->getHeight());
+
+	// スプライト情報
+	for (uint32 i = 0; i < m_SpriteNum; i++) {
+		const TGASprite &sprite = m_pSprite[i];
+
+		Write16(fp, sprite.x);
+		Write16(fp, sprite.y);
+		Write16(fp, sprite.w);
+		Write16(fp, sprite.h);
+		Write16(fp, sprite.trimX);
+		Write16(fp, sprite.trimY);
+		Write16(fp, sprite.srcW);
+		Write16(fp, sprite.srcH);
+		Write32(fp, sprite.nameOffset);
+	}
+
+	// 名前テーブル
+	if (m_NameSize != 0) {
+		fwrite(m_pName, m_NameSize, 1, fp);
+	}
+
+	return (ferror(fp) == 0);
+}
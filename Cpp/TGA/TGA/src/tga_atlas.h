@@ -0,0 +1,69 @@
+/*=============================================================================
+ * テクスチャアトラス作成
+ * 複数のTGAをアルファの範囲でトリミングして1枚のTGAに詰め込み、
+ * 各スプライトの位置をバイナリのテーブルで出力します。
+ * tga.hをインクルードしてから使用してください。
+=============================================================================*/
+#ifndef _TGA_ATLAS_H_
+#define _TGA_ATLAS_H_
+
+class CTgaAtlas {
+public:
+	// エラータイプ(CTgaのエラータイプに追加)
+	enum {
+		ERROR_PACK = -7				// アトラスに収まらない
+	};
+
+	enum {
+		TABLE_VERSION = 1,			// テーブルのバージョン
+		TABLE_HEADER_SIZE = 0x10,	// テーブルのヘッダーサイズ
+		TABLE_SPRITE_SIZE = 0x14	// テーブルの1スプライトのサイズ
+	};
+
+	struct TGASprite {
+		uint16	x;					// アトラス上のX座標
+		uint16	y;					// アトラス上のY座標
+		uint16	w;					// トリミング後の幅
+		uint16	h;					// トリミング後の高さ
+		uint16	trimX;				// 元画像上のトリミング開始X座標
+		uint16	trimY;				// 元画像上のトリミング開始Y座標
+		uint16	srcW;				// 元画像の幅
+		uint16	srcH;				// 元画像の高さ
+		uint32	nameOffset;			// 名前テーブル内の位置
+	};
+
+private:
+	TGASprite	*m_pSprite;			// スプライト情報
+	uint8		**m_ppImage;		// トリミング後のイメージ(32bit、左上原点)
+	uint32		m_SpriteNum;		// スプライト数
+	uint32		m_SpriteMax;		// 確保済みのスプライト数
+
+	char		*m_pName;			// 名前テーブル(\0区切り)
+	uint32		m_NameSize;			// 名前テーブルの使用サイズ
+	uint32		m_NameMax;			// 名前テーブルの確保サイズ
+
+	CTga		*m_pAtlas;			// 作成したアトラス
+
+private:
+	bool Reserve(const uint32 spriteNum, const uint32 nameSize);
+	bool Trim(const uint8 *pImage, const uint32 w, const uint32 h, TGASprite *pSprite, uint8 **ppTrim);
+	bool Place(const uint32 width, const uint32 height, const uint32 padding, uint32 *pUsedH);
+	bool WriteTable(FILE *fp);
+
+public:
+	CTgaAtlas(void);
+	virtual ~CTgaAtlas(void);
+
+	uint32 getSpriteNum(void)             const {return m_SpriteNum;}
+	const TGASprite &getSprite(uint32 i)  const {return m_pSprite[i];}
+	const char *getName(uint32 i)         const {return &m_pName[m_pSprite[i].nameOffset];}
+	const CTga *getAtlas(void)            const {return m_pAtlas;}
+
+	void Clear(void);
+	int  Add(const char *pFileName);
+	int  Add(const CTga &tga, const char *pName);
+	int  Pack(const uint32 width, const uint32 height, const uint32 padding);
+	int  Output(const char *pImageFile, const char *pTableFile);
+};
+
+#endif
@@ -0,0 +1,725 @@
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+
+#ifdef _USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+enum {
+	BLOCK_PIXEL = 16,						// 1ブロックのピクセル数(4x4)
+	POWER_LOOP  = 8,						// 主軸を求める反復回数
+	DDS_HEADER_SIZE = 128					// DDSのヘッダーサイズ("DDS "を含む)
+};
+
+// ブロック内のチャンネル(GetLine32の並びに関係なくRGBAに揃える)
+enum {
+	CH_R = 0,
+	CH_G,
+	CH_B,
+	CH_A
+};
+
+MTOINLINE void Put16(uint8 *p, const uint32 n) {p[0] = static_cast<uint8>(n); p[1] = static_cast<uint8>(n >> 8);}
+MTOINLINE void Put32(uint8 *p, const uint32 n) {Put16(p, n); Put16(&p[2], n >> 16);}
+
+/*=======================================================================
+【機能】色を565に量子化
+【引数】pColor：色(RGB、0～255)
+ =======================================================================*/
+MTOINLINE uint32 Pack565(const float *pColor)
+{
+	sint32 r = static_cast<sint32>(pColor[0] * (31.0f / 255.0f) + 0.5f);
+	sint32 g = static_cast<sint32>(pColor[1] * (63.0f / 255.0f) + 0.5f);
+	sint32 b = static_cast<sint32>(pColor[2] * (31.0f / 255.0f) + 0.5f);
+
+	r = (r < 0) ? 0 : (r > 31) ? 31 : r;
+	g = (g < 0) ? 0 : (g > 63) ? 63 : g;
+	b = (b < 0) ? 0 : (b > 31) ? 31 : b;
+
+	return static_cast<uint32>((r << 11) | (g << 5) | b);
+}
+
+/*=======================================================================
+【機能】565を8bitに戻す
+ =======================================================================*/
+MTOINLINE void Unpack565(sint32 *pColor, const uint32 c)
+{
+	const sint32 r = (c >> 11) & 0x1f;
+	const sint32 g = (c >> 5) & 0x3f;
+	const sint32 b = c & 0x1f;
+
+	pColor[0] = (r << 3) | (r >> 2);
+	pColor[1] = (g << 2) | (g >> 4);
+	pColor[2] = (b << 3) | (b >> 2);
+}
+
+/*=======================================================================
+【機能】色を565の格子に合わせる(クラスタフィット用)
+ =======================================================================*/
+MTOINLINE void Snap565(float *pColor)
+{
+	sint32 c[3];
+
+	Unpack565(c, Pack565(pColor));
+	pColor[0] = static_cast<float>(c[0]);
+	pColor[1] = static_cast<float>(c[1]);
+	pColor[2] = static_cast<float>(c[2]);
+}
+
+/*=======================================================================
+【機能】パレットから一番近い色を選ぶ
+【引数】pIndex：番号の格納先(16個)
+        pPal  ：パレット(RGBA、palNum個)
+        palNum：パレット数
+        pBlock：ブロック(RGBA×16)
+        mask  ：対象のピクセル(ビットごと、対象外は番号3で誤差に含めない)
+【戻値】誤差(2乗和)
+ =======================================================================*/
+uint32 FitIndex(uint8 *pIndex, const sint32 *pPal, const sint32 palNum, const uint8 *pBlock, const uint32 mask)
+{
+#ifdef _USE_SSE2
+	if (TgaKernelGetLevel() >= TGA_KERNEL_LEVEL_SSE2) {
+		// 4ピクセルずつ、パレットごとの距離を16bitの積和で求める
+		const __m128i zero  = _mm_setzero_si128();
+		const __m128i rgb   = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+		__m128i pal[4];
+		uint32 dist[BLOCK_PIXEL];
+
+		for (sint32 k = 0; k < palNum; k++) {
+			const sint32 *p = &pPal[k * 4];
+			pal[k] = _mm_set_epi16(0, static_cast<short>(p[2]), static_cast<short>(p[1]), static_cast<short>(p[0]),
+								   0, static_cast<short>(p[2]), static_cast<short>(p[1]), static_cast<short>(p[0]));
+		}
+
+		for (sint32 i = 0; i < BLOCK_PIXEL; i += 4) {
+			const __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pBlock[i * 4]));
+			const __m128i lo  = _mm_and_si128(_mm_unpacklo_epi8(src, zero), rgb);
+			const __m128i hi  = _mm_and_si128(_mm_unpackhi_epi8(src, zero), rgb);
+			__m128i best = _mm_set1_epi32(0x7fffffff);
+			__m128i idx  = zero;
+
+			for (sint32 k = 0; k < palNum; k++) {
+				__m128i d0 = _mm_sub_epi16(lo, pal[k]);
+				__m128i d1 = _mm_sub_epi16(hi, pal[k]);
+				d0 = _mm_madd_epi16(d0, d0);
+				d1 = _mm_madd_epi16(d1, d1);
+				d0 = _mm_add_epi32(d0, _mm_shuffle_epi32(d0, 0xb1));
+				d1 = _mm_add_epi32(d1, _mm_shuffle_epi32(d1, 0xb1));
+
+				// (p0,p0,p1,p1)と(p2,p2,p3,p3)から(p0,p1,p2,p3)
+				const __m128i d = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(d0), _mm_castsi128_ps(d1), 0x88));
+				const __m128i m = _mm_cmplt_epi32(d, best);
+
+				best = _mm_or_si128(_mm_and_si128(m, d), _mm_andnot_si128(m, best));
+				idx  = _mm_or_si128(_mm_and_si128(m, _mm_set1_epi32(k)), _mm_andnot_si128(m, idx));
+			}
+
+			uint32 n[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(n), idx);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&dist[i]), best);
+			for (sint32 j = 0; j < 4; j++) pIndex[i + j] = static_cast<uint8>(n[j]);
+		}
+
+		uint32 error = 0;
+		for (sint32 i = 0; i < BLOCK_PIXEL; i++) {
+			if (mask & (1 << i)) {
+				error += dist[i];
+			} else {
+				pIndex[i] = 3;
+			}
+		}
+
+		return error;
+	}
+#endif
+
+	uint32 error = 0;
+
+	for (sint32 i = 0; i < BLOCK_PIXEL; i++) {
+		const uint8 *pPixel = &pBlock[i * 4];
+		uint32 best = 0xffffffff;
+
+		if ((mask & (1 << i)) == 0) {
+			pIndex[i] = 3;
+			continue;
+		}
+
+		for (sint32 k = 0; k < palNum; k++) {
+			const sint32 r = pPixel[CH_R] - pPal[k * 4 + 0];
+			const sint32 g = pPixel[CH_G] - pPal[k * 4 + 1];
+			const sint32 b = pPixel[CH_B] - pPal[k * 4 + 2];
+			const uint32 d = static_cast<uint32>(r * r + g * g + b * b);
+
+			if (d < best) {
+				best = d;
+				pIndex[i] = static_cast<uint8>(k);
+			}
+		}
+		error += best;
+	}
+
+	return error;
+}
+
+/*=======================================================================
+【機能】端点を決めて色ブロックを作る
+【引数】pDst  ：格納先(8バイト)
+        c0/c1 ：端点(565)
+        b3Color：3色+透明のモード？
+        pBlock：ブロック(RGBA×16)
+        mask  ：不透明のピクセル(ビットごと)
+【戻値】誤差(2乗和)
+【備考】4色のモードはc0>c1、3色のモードはc0<=c1にする必要があるので入れ替える。
+ =======================================================================*/
+uint32 WriteColorBlock(uint8 *pDst, uint32 c0, uint32 c1, const bool b3Color, const uint8 *pBlock, const uint32 mask)
+{
+	if (b3Color ? (c0 > c1) : (c0 < c1)) {
+		const uint32 t = c0;
+		c0 = c1;
+		c1 = t;
+	}
+
+	sint32 pal[4 * 4];
+	sint32 palNum;
+
+	Unpack565(&pal[0], c0);
+	Unpack565(&pal[4], c1);
+
+	if (b3Color) {
+		for (sint32 c = 0; c < 3; c++) pal[8 + c] = (pal[c] + pal[4 + c]) >> 1;
+		palNum = 3;
+	} else if (c0 == c1) {
+		// 1色(c0==c1は3色のモードになるので番号0だけ使う)
+		palNum = 1;
+	} else {
+		for (sint32 c = 0; c < 3; c++) {
+			pal[8 + c]  = (pal[c] * 2 + pal[4 + c]) / 3;
+			pal[12 + c] = (pal[c] + pal[4 + c] * 2) / 3;
+		}
+		palNum = 4;
+	}
+
+	uint8 index[BLOCK_PIXEL];
+	const uint32 error = FitIndex(index, pal, palNum, pBlock, mask);
+
+	uint32 bits = 0;
+	for (sint32 i = 0; i < BLOCK_PIXEL; i++) {
+		bits |= static_cast<uint32>(index[i]) << (i * 2);
+	}
+
+	Put16(&pDst[0], c0);
+	Put16(&pDst[2], c1);
+	Put32(&pDst[4], bits);
+
+	return error;
+}
+
+/*=======================================================================
+【機能】平均と主軸を求める
+【引数】pMean ：平均の格納先(RGB)
+        pAxis ：主軸の格納先(RGB、長さ1、全部同じ色なら0)
+        pBlock：ブロック(RGBA×16)
+        mask  ：対象のピクセル
+ =======================================================================*/
+void CalcAxis(float *pMean, float *pAxis, const uint8 *pBlock, const uint32 mask)
+{
+	float sum[3] = {0.0f, 0.0f, 0.0f};
+	float num = 0.0f;
+
+	for (sint32 i = 0; i < BLOCK_PIXEL; i++) {
+		if ((mask & (1 << i)) == 0) continue;
+		for (sint32 c = 0; c < 3; c++) sum[c] += pBlock[i * 4 + c];
+		num += 1.0f;
+	}
+	for (sint32 c = 0; c < 3; c++) pMean[c] = sum[c] / num;
+
+	// 共分散
+	float cov[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+	for (sint32 i = 0; i < BLOCK_PIXEL; i++) {
+		if ((mask & (1 << i)) == 0) continue;
+
+		const float r = pBlock[i * 4 + CH_R] - pMean[0];
+		const float g = pBlock[i * 4 + CH_G] - pMean[1];
+		const float b = pBlock[i * 4 + CH_B] - pMean[2];
+
+		cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+		cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+	}
+
+	// べき乗法(初期値は分散の一番大きい軸)
+	float v[3] = {1.0f, 1.0f, 1.0f};
+	if (cov[0] >= cov[3] && cov[0] >= cov[5]) {
+		v[0] = 1.0f; v[1] = cov[1]; v[2] = cov[2];
+	} else if (cov[3] >= cov[5]) {
+		v[0] = cov[1]; v[1] = 1.0f; v[2] = cov[4];
+	} else {
+		v[0] = cov[2]; v[1] = cov[4]; v[2] = 1.0f;
+	}
+
+	for (sint32 loop = 0; loop < POWER_LOOP; loop++) {
+		const float x = cov[0] * v[0] + cov[1] * v[1] + cov[2] * v[2];
+		const float y = cov[1] * v[0] + cov[3] * v[1] + cov[4] * v[2];
+		const float z = cov[2] * v[0] + cov[4] * v[1] + cov[5] * v[2];
+		float m = static_cast<float>(fabs(x));
+		if (fabs(y) > m) m = static_cast<float>(fabs(y));
+		if (fabs(z) > m) m = static_cast<float>(fabs(z));
+
+		if (m <= 0.0f) break;
+		v[0] = x / m; v[1] = y / m; v[2] = z / m;
+	}
+
+	const float len = static_cast<float>(sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]));
+	if (cov[0] + cov[3] + cov[5] <= 0.0f || len <= 0.0f) {
+		pAxis[0] = pAxis[1] = pAxis[2] = 0.0f;
+	} else {
+		pAxis[0] = v[0] / len; pAxis[1] = v[1] / len; pAxis[2] = v[2] / len;
+	}
+}
+
+/*=======================================================================
+【機能】色ブロックの作成(範囲フィット)
+【引数】pDst   ：格納先(8バイト)
+        pBlock ：ブロック(RGBA×16)
+        mask   ：不透明のピクセル(0ならすべて透明)
+        b3Color：3色+透明のモード？
+【戻値】誤差(2乗和)
+【備考】主軸に投影した範囲の両端を端点にします。
+ =======================================================================*/
+uint32 EncodeColorRange(uint8 *pDst, const uint8 *pBlock, const uint32 mask, const bool b3Color)
+{
+	if (mask == 0) {
+		// すべて透明
+		Put16(&pDst[0], 0);
+		Put16(&pDst[2], 0);
+		Put32(&pDst[4], 0xffffffff);
+		return 0;
+	}
+
+	float mean[3], axis[3];
+	CalcAxis(mean, axis, pBlock, mask);
+
+	float lo = 0.0f;
+	float hi = 0.0f;
+	for (sint32 i = 0; i < BLOCK_PIXEL; i++) {
+		if ((mask & (1 << i)) == 0) continue;
+
+		const float d = (pBlock[i * 4 + CH_R] - mean[0]) * axis[0] + (pBlock[i * 4 + CH_G] - mean[1]) * axis[1] + (pBlock[i * 4 + CH_B] - mean[2]) * axis[2];
+		if (d < lo) lo = d;
+		if (d > hi) hi = d;
+	}
+
+	float start[3], end[3];
+	for (sint32 c = 0; c < 3; c++) {
+		start[c] = mean[c] + axis[c] * lo;
+		end[c]   = mean[c] + axis[c] * hi;
+	}
+
+	return WriteColorBlock(pDst, Pack565(end), Pack565(start), b3Color, pBlock, mask);
+}
+
+/*=======================================================================
+【機能】色ブロックの作成(クラスタフィット)
+【引数】pDst  ：格納先(8バイト)
+        pBlock：ブロック(RGBA×16、すべて不透明として扱う)
+【戻値】誤差(2乗和)
+【備考】主軸に投影した順に並べて4つの組に分ける分け方をすべて試し、
+        組ごとの重みで最小2乗法により端点を求めます。
+        範囲フィットの結果より誤差が小さい場合だけ使います。
+ =======================================================================*/
+uint32 EncodeColorCluster(uint8 *pDst, const uint8 *pBlock)
+{
+	const uint32 mask = (1 << BLOCK_PIXEL) - 1;
+	uint32 error = EncodeColorRange(pDst, pBlock, mask, false);
+	if (error == 0) return 0;
+
+	float mean[3], axis[3];
+	CalcAxis(mean, axis, pBlock, mask);
+
+	// 主軸に投影した順に並べる
+	float dot[BLOCK_PIXEL];
+	sint32 order[BLOCK_PIXEL];
+	for (sint32 i = 0; i < BLOCK_PIXEL; i++) {
+		const uint8 *p = &pBlock[i * 4];
+		const float d = p[CH_R] * axis[0] + p[CH_G] * axis[1] + p[CH_B] * axis[2];
+		sint32 j = i;
+
+		for (; j > 0 && dot[j - 1] > d; j--) {
+			dot[j]   = dot[j - 1];
+			order[j] = order[j - 1];
+		}
+		dot[j]   = d;
+		order[j] = i;
+	}
+
+	// 並べた順の累積
+	float sum[BLOCK_PIXEL + 1][3];
+	sum[0][0] = sum[0][1] = sum[0][2] = 0.0f;
+	for (sint32 i = 0; i < BLOCK_PIXEL; i++) {
+		for (sint32 c = 0; c < 3; c++) sum[i + 1][c] = sum[i][c] + pBlock[order[i] * 4 + c];
+	}
+
+	float best = 0.0f;
+	float bestA[3], bestB[3];
+	bool bFound = false;
+
+	// [0,i0)が端点A、[i0,i1)が2/3、[i1,i2)が1/3、[i2,16)が端点B
+	for (sint32 i0 = 0; i0 <= BLOCK_PIXEL; i0++) {
+		for (sint32 i1 = i0; i1 <= BLOCK_PIXEL; i1++) {
+			for (sint32 i2 = i1; i2 <= BLOCK_PIXEL; i2++) {
+				const float n0 = static_cast<float>(i0);
+				const float n1 = static_cast<float>(i1 - i0);
+				const float n2 = static_cast<float>(i2 - i1);
+				const float n3 = static_cast<float>(BLOCK_PIXEL - i2);
+
+				const float aa  = n0 + n1 * (4.0f / 9.0f) + n2 * (1.0f / 9.0f);
+				const float bb  = n3 + n2 * (4.0f / 9.0f) + n1 * (1.0f / 9.0f);
+				const float ab  = (n1 + n2) * (2.0f / 9.0f);
+				const float det = aa * bb - ab * ab;
+				if (fabs(det) < 1e-6f) continue;
+
+				float a[3], b[3], ax[3], bx[3];
+				for (sint32 c = 0; c < 3; c++) {
+					const float s0 = sum[i0][c];
+					const float s1 = sum[i1][c] - sum[i0][c];
+					const float s2 = sum[i2][c] - sum[i1][c];
+					const float s3 = sum[BLOCK_PIXEL][c] - sum[i2][c];
+
+					ax[c] = s0 + s1 * (2.0f / 3.0f) + s2 * (1.0f / 3.0f);
+					bx[c] = s3 + s2 * (2.0f / 3.0f) + s1 * (1.0f / 3.0f);
+					a[c]  = (ax[c] * bb - bx[c] * ab) / det;
+					b[c]  = (bx[c] * aa - ax[c] * ab) / det;
+				}
+				Snap565(a);
+				Snap565(b);
+
+				// 定数項を除いた誤差
+				float e = 0.0f;
+				for (sint32 c = 0; c < 3; c++) {
+					e += a[c] * a[c] * aa + b[c] * b[c] * bb + 2.0f * (a[c] * b[c] * ab - a[c] * ax[c] - b[c] * bx[c]);
+				}
+
+				if (!bFound || e < best) {
+					best   = e;
+					bFound = true;
+					memcpy(bestA, a, sizeof(a));
+					memcpy(bestB, b, sizeof(b));
+				}
+			}
+		}
+	}
+
+	if (bFound) {
+		uint8 block[8];
+		const uint32 e = WriteColorBlock(block, Pack565(bestA), Pack565(bestB), false, pBlock, mask);
+
+		if (e < error) {
+			memcpy(pDst, block, sizeof(block));
+			error = e;
+		}
+	}
+
+	return error;
+}
+
+/*=======================================================================
+【機能】1チャンネルのブロックを作る
+【引数】pDst  ：格納先(8バイト)
+        pValue：値(16個)
+        a0/a1 ：端点
+【戻値】誤差(2乗和)
+【備考】a0>a1なら8段階、a0<=a1なら6段階と0、255のモードになります。
+ =======================================================================*/
+uint32 WriteAlphaBlock(uint8 *pDst, const uint32 a0, const uint32 a1, const uint8 *pValue)
+{
+	sint32 pal[8];
+
+	pal[0] = a0;
+	pal[1] = a1;
+	if (a0 > a1) {
+		for (sint32 k = 2; k < 8; k++) pal[k] = ((8 - k) * a0 + (k - 1) * a1) / 7;
+	} else {
+		for (sint32 k = 2; k < 6; k++) pal[k] = ((6 - k) * a0 + (k - 1) * a1) / 5;
+		pal[6] = 0;
+		pal[7] = 255;
+	}
+
+	uint64 bits = 0;
+	uint32 error = 0;
+
+	for (sint32 i = 0; i < BLOCK_PIXEL; i++) {
+		uint32 best = 0xffffffff;
+		uint32 index = 0;
+
+		for (sint32 k = 0; k < 8; k++) {
+			const sint32 d = pValue[i] - pal[k];
+			if (static_cast<uint32>(d * d) < best) {
+				best  = static_cast<uint32>(d * d);
+				index = k;
+			}
+		}
+		bits  |= static_cast<uint64>(index) << (i * 3);
+		error += best;
+	}
+
+	pDst[0] = static_cast<uint8>(a0);
+	pDst[1] = static_cast<uint8>(a1);
+	for (sint32 i = 0; i < 6; i++) {
+		pDst[2 + i] = static_cast<uint8>(bits >> (i * 8));
+	}
+
+	return error;
+}
+
+/*=======================================================================
+【機能】1チャンネルのブロックの作成(BC3のアルファ、BC4、BC5)
+【引数】pDst    ：格納先(8バイト)
+        pBlock  ：ブロック(RGBA×16)
+        channel ：チャンネル(CH_*)
+        bCluster：高画質？
+【備考】最小と最大を端点にした8段階で作ります。
+        高画質の場合は、0と255を除いた範囲の6段階も試して誤差の小さい方を使います。
+ =======================================================================*/
+void EncodeAlpha(uint8 *pDst, const uint8 *pBlock, const sint32 channel, const bool bCluster)
+{
+	uint8 value[BLOCK_PIXEL];
+	uint32 lo = 255, hi = 0;
+	uint32 lo6 = 255, hi6 = 0;
+
+	for (sint32 i = 0; i < BLOCK_PIXEL; i++) {
+		const uint32 v = pBlock[i * 4 + channel];
+
+		value[i] = static_cast<uint8>(v);
+		if (v < lo) lo = v;
+		if (v > hi) hi = v;
+		if (v != 0 && v != 255) {
+			if (v < lo6) lo6 = v;
+			if (v > hi6) hi6 = v;
+		}
+	}
+
+	const uint32 error = WriteAlphaBlock(pDst, hi, lo, value);
+
+	if (bCluster && error != 0) {
+		uint8 block[8];
+		if (lo6 > hi6) lo6 = hi6 = 0;
+		if (WriteAlphaBlock(block, lo6, hi6, value) < error) {
+			memcpy(pDst, block, sizeof(block));
+		}
+	}
+}
+
+/*=======================================================================
+【機能】1ブロック分のピクセルを集める
+【引数】pBlock：格納先(RGBA×16)
+        ppLine：4ライン分の32bitライン(画像の下端を超えた分は最後のライン)
+        x     ：左端
+        w     ：画像の幅(右端を超えた分は最後のピクセル)
+【備考】GetLine32のラインはRGBA配列に変更していてもBGRA配列。
+ =======================================================================*/
+MTOINLINE void GatherBlock(uint8 *pBlock, const uint8 *const *ppLine, const sint32 x, const sint32 w)
+{
+	for (sint32 y = 0; y < 4; y++) {
+		for (sint32 i = 0; i < 4; i++) {
+			const uint8 *pSrc = &ppLine[y][((x + i < w) ? (x + i) : (w - 1)) * 4];
+			uint8 *pDst = &pBlock[(y * 4 + i) * 4];
+
+			pDst[CH_R] = pSrc[2];
+			pDst[CH_G] = pSrc[1];
+			pDst[CH_B] = pSrc[0];
+			pDst[CH_A] = pSrc[3];
+		}
+	}
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】ブロック圧縮後のサイズ
+【引数】format：形式(BC_FORMAT_*)
+【戻値】バイト数(画像がないか形式が不正なら0)
+【備考】幅と高さは4の倍数に切り上げます。
+ =======================================================================*/
+uint32 CTga::CalcBCSize(const sint32 format) const
+{
+	if (m_Header.imageType == IMAGE_TYPE_NONE) return 0;
+	if (format < 0 || format >= BC_FORMAT_MAX) return 0;
+
+	const uint32 blockW = (m_Header.imageW + 3) >> 2;
+	const uint32 blockH = (m_Header.imageH + 3) >> 2;
+	const uint32 size   = (format == BC_FORMAT_BC1 || format == BC_FORMAT_BC4) ? 8 : 16;
+
+	return blockW * blockH * size;
+}
+
+/*=======================================================================
+【機能】ブロック圧縮
+【引数】pDst  ：格納先(CalcBCSizeのサイズ)
+        format：形式(BC_FORMAT_*)
+        flag  ：フラグ(BC_FLAG_*)
+【戻値】true：成功
+【備考】4x4のブロックを左上から並べます(DDSと同じ並び)。
+        右端と下端の足りないピクセルは端のピクセルで埋めます。
+        BC1はアルファ付きの画像なら、アルファが128未満のブロックを3色+透明で作ります。
+        BC4はR(白黒ならその値)、BC5はRとGを使います。
+        4ブロックのラインごとに並列で処理します。
+ =======================================================================*/
+bool CTga::EncodeBC(uint8 *pDst, const sint32 format, const uint32 flag) const
+{
+	if (!this->Decode()) return false;
+	if (pDst == NULL || m_pImage == NULL) return false;
+	if (format < 0 || format >= BC_FORMAT_MAX) return false;
+
+	const bool bIndex = (m_Header.imageType == IMAGE_TYPE_INDEX || m_Header.imageType == IMAGE_TYPE_INDEX_RLE);
+	if (bIndex && m_pPalette == NULL) return false;
+
+	const sint32 w        = m_Header.imageW;
+	const sint32 h        = m_Header.imageH;
+	const sint32 blockW   = (w + 3) >> 2;
+	const sint32 blockH   = (h + 3) >> 2;
+	const uint32 size     = (format == BC_FORMAT_BC1 || format == BC_FORMAT_BC4) ? 8 : 16;
+	const bool   bCluster = (flag & BC_FLAG_CLUSTER) ? true : false;
+	const bool   bAlpha   = (format == BC_FORMAT_BC1 && this->IsAlphaImage());
+	bool bResult = true;
+
+#pragma omp parallel
+	{
+		uint8 *pWork = new uint8[w * 4 * 4];
+
+		if (pWork == NULL) {
+#pragma omp critical
+			bResult = false;
+		}
+
+#pragma omp for schedule(dynamic)
+		for (sint32 by = 0; by < blockH; by++) {
+			if (!bResult) continue;
+
+			// 4ライン分(下端を超えたら最後のライン)
+			const uint8 *pLine[4];
+			for (sint32 i = 0; i < 4; i++) {
+				const sint32 y = (by * 4 + i < h) ? (by * 4 + i) : (h - 1);
+				pLine[i] = this->GetLine32(&pWork[w * 4 * i], y);
+			}
+
+			uint8 *pBlockDst = &pDst[by * blockW * size];
+			uint8 block[BLOCK_PIXEL * 4];
+
+			for (sint32 bx = 0; bx < blockW; bx++, pBlockDst += size) {
+				GatherBlock(block, pLine, bx * 4, w);
+
+				switch (format) {
+				case BC_FORMAT_BC1:
+					{
+						uint32 mask = (1 << BLOCK_PIXEL) - 1;
+						if (bAlpha) {
+							for (sint32 i = 0; i < BLOCK_PIXEL; i++) {
+								if (block[i * 4 + CH_A] < 128) mask &= ~(1 << i);
+							}
+						}
+
+						if (mask != (1 << BLOCK_PIXEL) - 1) {
+							EncodeColorRange(pBlockDst, block, mask, true);
+						} else if (bCluster) {
+							EncodeColorCluster(pBlockDst, block);
+						} else {
+							EncodeColorRange(pBlockDst, block, mask, false);
+						}
+					}
+					break;
+				case BC_FORMAT_BC3:
+					EncodeAlpha(pBlockDst, block, CH_A, bCluster);
+					if (bCluster) {
+						EncodeColorCluster(&pBlockDst[8], block);
+					} else {
+						EncodeColorRange(&pBlockDst[8], block, (1 << BLOCK_PIXEL) - 1, false);
+					}
+					break;
+				case BC_FORMAT_BC4:
+					EncodeAlpha(pBlockDst, block, CH_R, bCluster);
+					break;
+				case BC_FORMAT_BC5:
+					EncodeAlpha(pBlockDst,     block, CH_R, bCluster);
+					EncodeAlpha(&pBlockDst[8], block, CH_G, bCluster);
+					break;
+				}
+			}
+		}
+
+		SAFE_DELETES(pWork);
+	}
+
+	return bResult;
+}
+
+/*=======================================================================
+【機能】ブロック圧縮してファイル出力
+【引数】pFileName：出力ファイル名
+        format   ：形式(BC_FORMAT_*)
+        flag     ：フラグ(BC_FLAG_*、BC_FLAG_RAWならDDSヘッダーなし)
+【戻値】エラータイプ
+【備考】DDSはミップマップなし、FourCC(DXT1/DXT5/ATI1/ATI2)で出力します。
+ =======================================================================*/
+int CTga::OutputBC(const char *pFileName, const sint32 format, const uint32 flag)
+{
+#ifndef NDEBUG
+	_ASSERT(pFileName != NULL);
+#else
+	if (pFileName == NULL) return ERROR_OUTPUT;
+#endif
+
+	if (!this->Decode()) return ERROR_IMAGE;
+	if (m_pImage == NULL) return ERROR_NONE;
+
+	const uint32 size = this->CalcBCSize(format);
+	if (size == 0) return ERROR_OUTPUT;
+
+	uint8 *pBlock = new uint8[size];
+	if (pBlock == NULL) return ERROR_MEMORY;
+
+	if (!this->EncodeBC(pBlock, format, flag)) {
+		SAFE_DELETES(pBlock);
+		return ERROR_MEMORY;
+	}
+
+	FILE *fp;
+	if ((fp = fopen(pFileName, "wb")) == NULL) {
+		DBG_PRINT("file can't open!\n");
+		SAFE_DELETES(pBlock);
+		return ERROR_OPEN;
+	}
+
+	int ret = ERROR_NONE;
+
+	// DDSヘッダー
+	if ((flag & BC_FLAG_RAW) == 0) {
+		static const char fourCC[BC_FORMAT_MAX][4] = {
+			{'D', 'X', 'T', '1'}, {'D', 'X', 'T', '5'}, {'A', 'T', 'I', '1'}, {'A', 'T', 'I', '2'}
+		};
+		uint8 head[DDS_HEADER_SIZE];
+
+		memset(head, 0, sizeof(head));
+		memcpy(&head[0], "DDS ", 4);
+		Put32(&head[4],   124);				// ヘッダーサイズ
+		Put32(&head[8],   0x00081007);		// CAPS|HEIGHT|WIDTH|PIXELFORMAT|LINEARSIZE
+		Put32(&head[12],  m_Header.imageH);
+		Put32(&head[16],  m_Header.imageW);
+		Put32(&head[20],  size);
+		Put32(&head[76],  32);				// ピクセルフォーマットのサイズ
+		Put32(&head[80],  0x00000004);		// FOURCC
+		memcpy(&head[84], fourCC[format], 4);
+		Put32(&head[108], 0x00001000);		// TEXTURE
+
+		if (fwrite(head, sizeof(head), 1, fp) != 1) ret = ERROR_OUTPUT;
+	}
+
+	if (ret == ERROR_NONE && fwrite(pBlock, size, 1, fp) != 1) ret = ERROR_OUTPUT;
+	if (fclose(fp) != 0 && ret == ERROR_NONE) ret = ERROR_OUTPUT;
+
+	SAFE_DELETES(pBlock);
+
+	return ret;
+}
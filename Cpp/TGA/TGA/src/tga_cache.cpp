@@ -0,0 +1,467 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_cache.h"
+#include "tga_kernel.h"
+
+
+/*=======================================================================
+【機能】キャッシュの1エントリー
+【備考】ファイルが更新された場合、古いエントリーはパスのテーブルから外し、
+        参照がなくなった時点で破棄する。
+ =======================================================================*/
+struct CTgaCache::Entry {
+	char		*pPath;				// ファイルパス
+	uint64		pathHash;			// ファイルパスのハッシュ値
+	sint64		fileSize;			// ファイルサイズ
+	sint64		fileTime;			// 更新日時
+
+	CTga		*pTga;				// 読み込んだTGA(失敗時はNULL)
+	uint64		bytes;				// 使用メモリ
+	int			error;				// 読み込み結果
+	uint32		ref;				// 参照数
+	bool		bLoaded;			// 読み込み済み？
+	bool		bLinked;			// パスのテーブルに登録中？
+
+	CMtoMutex	mutex;				// 読み込み中はロックする
+
+	Entry		*pPathNext;			// パスのテーブルの次
+	Entry		*pTgaNext;			// CTgaのテーブルの次
+	Entry		*pPrev;				// LRUの前(最近使った方)
+	Entry		*pNext;				// LRUの次
+};
+
+
+namespace {
+
+/*=======================================================================
+【機能】アドレスのハッシュ値
+ =======================================================================*/
+MTOINLINE uint32 HashPointer(const void *p)
+{
+	uint64 n = static_cast<uint64>(reinterpret_cast<size_t>(p));
+	n ^= n >> 29;
+	n *= 0x9e3779b185ebca87ULL;
+	return static_cast<uint32>(n >> 32);
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】
+【引数】budget：使用メモリの上限(バイト)
+ =======================================================================*/
+CTgaCache::CTgaCache(const uint64 budget)
+{
+	m_ppPathTable = NULL;
+	m_ppTgaTable  = NULL;
+	m_TableSize   = 0;
+	m_EntryNum    = 0;
+
+	m_pHead = NULL;
+	m_pTail = NULL;
+
+	m_Budget     = budget;
+	m_Usage      = 0;
+	m_CreateFlag = CTga::CREATE_FLAG_NONE;
+	m_pSidecar   = NULL;
+	m_HitCount   = 0;
+	m_MissCount  = 0;
+
+	this->Rehash(TABLE_SIZE_MIN);
+}
+
+/*=======================================================================
+【機能】
+【備考】参照中のCTgaがあっても破棄します。
+ =======================================================================*/
+CTgaCache::~CTgaCache(void)
+{
+	for (uint32 i = 0; i < m_TableSize; i++) {
+		Entry *pEntry = m_ppTgaTable[i];
+		while (pEntry != NULL) {
+			Entry *pNext = pEntry->pTgaNext;
+			SAFE_DELETE(pEntry->pTga);
+			SAFE_DELETES(pEntry->pPath);
+			SAFE_DELETE(pEntry);
+			pEntry = pNext;
+		}
+	}
+
+	SAFE_DELETES(m_ppPathTable);
+	SAFE_DELETES(m_ppTgaTable);
+}
+
+/*=======================================================================
+【機能】使用メモリの上限を変更
+【引数】budget：使用メモリの上限(バイト)
+ =======================================================================*/
+void CTgaCache::setBudget(const uint64 budget)
+{
+	CMtoLock lock(m_Mutex);
+
+	m_Budget = budget;
+	this->Evict();
+}
+
+/*=======================================================================
+【機能】TGAを取得
+【引数】pFileName：ファイル名
+        pError   ：エラータイプの格納先(NULL可)
+【戻値】TGA(失敗時はNULL)
+【備考】キャッシュになければ読み込みます。同じファイルを複数のスレッドが
+        同時に要求した場合、読み込みは1回だけで他のスレッドは完了を待ちます。
+        取得したTGAは読み込み専用で、使い終わったらReleaseを呼んでください。
+ =======================================================================*/
+const CTga *CTgaCache::Acquire(const char *pFileName, int *pError)
+{
+#ifndef NDEBUG
+	_ASSERT(pFileName != NULL);
+#else
+	if (pFileName == NULL) return NULL;
+#endif
+
+	// ファイルのサイズと更新日時
+	MtoFileStatus status;
+	if (!MtoFileGetStatus(pFileName, &status)) {
+		if (pError != NULL) *pError = CTga::ERROR_OPEN;
+		return NULL;
+	}
+
+	const uint32 len  = static_cast<uint32>(strlen(pFileName));
+	const uint64 hash = TgaKernelHash64(pFileName, len, 0);
+	bool bLoad = false;
+	Entry *pEntry;
+
+	m_Mutex.Lock();
+
+	// 更新されていたら古いものはテーブルから外す
+	pEntry = this->FindPath(pFileName, hash);
+	if (pEntry != NULL && (pEntry->fileSize != static_cast<sint64>(status.size) || pEntry->fileTime != status.time)) {
+		this->UnlinkPath(pEntry);
+		if (pEntry->ref == 0) this->Destroy(pEntry);
+		pEntry = NULL;
+	}
+
+	if (pEntry == NULL) {
+		// 新規作成(読み込みが終わるまでロックしておく)
+		if ((pEntry = new Entry) == NULL || (pEntry->pPath = new char[len + 1]) == NULL) {
+			SAFE_DELETE(pEntry);
+			m_Mutex.Unlock();
+			if (pError != NULL) *pError = CTga::ERROR_MEMORY;
+			return NULL;
+		}
+		memcpy(pEntry->pPath, pFileName, len + 1);
+		pEntry->pathHash = hash;
+		pEntry->fileSize = static_cast<sint64>(status.size);
+		pEntry->fileTime = status.time;
+		pEntry->pTga     = NULL;
+		pEntry->bytes    = 0;
+		pEntry->error    = CTga::ERROR_NONE;
+		pEntry->ref      = 0;
+		pEntry->bLoaded  = false;
+		pEntry->bLinked  = false;
+		pEntry->pTgaNext = NULL;
+		pEntry->mutex.Lock();
+
+		this->LinkPath(pEntry);
+		bLoad = true;
+		m_MissCount++;
+	} else {
+		m_HitCount++;
+	}
+
+	pEntry->ref++;
+
+	// LRUの先頭に移動
+	if (pEntry->bLinked && pEntry != m_pHead) {
+		if (pEntry->pPrev != NULL) pEntry->pPrev->pNext = pEntry->pNext;
+		if (pEntry->pNext != NULL) pEntry->pNext->pPrev = pEntry->pPrev;
+		if (m_pTail == pEntry) m_pTail = pEntry->pPrev;
+		pEntry->pPrev = NULL;
+		pEntry->pNext = m_pHead;
+		if (m_pHead != NULL) m_pHead->pPrev = pEntry;
+		m_pHead = pEntry;
+		if (m_pTail == NULL) m_pTail = pEntry;
+	}
+
+	m_Mutex.Unlock();
+
+	if (bLoad) {
+		// 読み込み(キャッシュ全体はロックしない)
+		CTga *pTga = new CTga;
+		int ret = CTga::ERROR_MEMORY;
+
+		if (pTga != NULL) {
+			pTga->setCreateFlag(m_CreateFlag);
+			pTga->setSidecar(m_pSidecar);
+			ret = pTga->Create(pFileName);
+		}
+
+		m_Mutex.Lock();
+		if (ret == CTga::ERROR_NONE) {
+			pEntry->pTga  = pTga;
+			pEntry->bytes = sizeof(CTga) + pTga->getImageSize() + pTga->getPaletteSize();
+			m_Usage += pEntry->bytes;
+			this->LinkTga(pEntry);
+		} else {
+			SAFE_DELETE(pTga);
+			pEntry->error = ret;
+		}
+		pEntry->bLoaded = true;
+		m_Mutex.Unlock();
+
+		pEntry->mutex.Unlock();
+	} else {
+		// 他のスレッドが読み込み中なら終わるまで待つ
+		pEntry->mutex.Lock();
+		pEntry->mutex.Unlock();
+	}
+
+	CMtoLock lock(m_Mutex);
+
+	if (pEntry->error != CTga::ERROR_NONE) {
+		// 失敗したものは次回読み直せるように外す
+		if (pError != NULL) *pError = pEntry->error;
+		if (pEntry->bLinked) this->UnlinkPath(pEntry);
+		if (--pEntry->ref == 0) this->Destroy(pEntry);
+		return NULL;
+	}
+
+	this->Evict();
+
+	if (pError != NULL) *pError = CTga::ERROR_NONE;
+
+	return pEntry->pTga;
+}
+
+/*=======================================================================
+【機能】TGAの参照を終了
+【引数】pTga：Acquireで取得したTGA
+ =======================================================================*/
+void CTgaCache::Release(const CTga *pTga)
+{
+	if (pTga == NULL) return;
+
+	CMtoLock lock(m_Mutex);
+
+	Entry *pEntry = this->FindTga(pTga);
+	if (pEntry == NULL || pEntry->ref == 0) {
+		_ASSERT(0);
+		return;
+	}
+
+	if (--pEntry->ref == 0) {
+		if (!pEntry->bLinked) {
+			// 更新されて外れたもの
+			this->Destroy(pEntry);
+		} else {
+			this->Evict();
+		}
+	}
+}
+
+/*=======================================================================
+【機能】参照されていないTGAを全部破棄
+ =======================================================================*/
+void CTgaCache::Flush(void)
+{
+	CMtoLock lock(m_Mutex);
+
+	Entry *pEntry = m_pTail;
+	while (pEntry != NULL) {
+		Entry *pPrev = pEntry->pPrev;
+		if (pEntry->ref == 0 && pEntry->bLoaded) {
+			this->UnlinkPath(pEntry);
+			this->Destroy(pEntry);
+		}
+		pEntry = pPrev;
+	}
+}
+
+/*=======================================================================
+【機能】パスで検索
+【引数】pFileName：ファイル名
+        hash     ：ファイル名のハッシュ値
+【備考】非公開(ロック中に呼ぶこと)
+ =======================================================================*/
+CTgaCache::Entry *CTgaCache::FindPath(const char *pFileName, const uint64 hash) const
+{
+	Entry *pEntry = m_ppPathTable[static_cast<uint32>(hash) & (m_TableSize - 1)];
+
+	for (; pEntry != NULL; pEntry = pEntry->pPathNext) {
+		if (pEntry->pathHash == hash && strcmp(pEntry->pPath, pFileName) == 0) {
+			return pEntry;
+		}
+	}
+
+	return NULL;
+}
+
+/*=======================================================================
+【機能】CTgaのアドレスで検索
+【引数】pTga：TGA
+【備考】非公開(ロック中に呼ぶこと)
+ =======================================================================*/
+CTgaCache::Entry *CTgaCache::FindTga(const CTga *pTga) const
+{
+	Entry *pEntry = m_ppTgaTable[HashPointer(pTga) & (m_TableSize - 1)];
+
+	for (; pEntry != NULL; pEntry = pEntry->pTgaNext) {
+		if (pEntry->pTga == pTga) return pEntry;
+	}
+
+	return NULL;
+}
+
+/*=======================================================================
+【機能】ハッシュテーブルの作り直し
+【引数】size：テーブルのサイズ(2のべき乗)
+【備考】非公開(ロック中に呼ぶこと)
+ =======================================================================*/
+bool CTgaCache::Rehash(const uint32 size)
+{
+	Entry **ppPath = new Entry*[size];
+	Entry **ppTga  = new Entry*[size];
+
+	if (ppPath == NULL || ppTga == NULL) {
+		SAFE_DELETES(ppPath);
+		SAFE_DELETES(ppTga);
+		return false;
+	}
+	memset(ppPath, 0, sizeof(Entry*) * size);
+	memset(ppTga,  0, sizeof(Entry*) * size);
+
+	for (uint32 i = 0; i < m_TableSize; i++) {
+		Entry *pEntry = m_ppPathTable[i];
+		while (pEntry != NULL) {
+			Entry *pNext = pEntry->pPathNext;
+			Entry **ppHead = &ppPath[static_cast<uint32>(pEntry->pathHash) & (size - 1)];
+			pEntry->pPathNext = *ppHead;
+			*ppHead = pEntry;
+			pEntry = pNext;
+		}
+
+		pEntry = m_ppTgaTable[i];
+		while (pEntry != NULL) {
+			Entry *pNext = pEntry->pTgaNext;
+			Entry **ppHead = &ppTga[HashPointer(pEntry->pTga) & (size - 1)];
+			pEntry->pTgaNext = *ppHead;
+			*ppHead = pEntry;
+			pEntry = pNext;
+		}
+	}
+
+	SAFE_DELETES(m_ppPathTable);
+	SAFE_DELETES(m_ppTgaTable);
+	m_ppPathTable = ppPath;
+	m_ppTgaTable  = ppTga;
+	m_TableSize   = size;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】パスのテーブルとLRUに登録
+【引数】pEntry：エントリー
+【備考】非公開(ロック中に呼ぶこと)
+ =======================================================================*/
+void CTgaCache::LinkPath(Entry *pEntry)
+{
+	// エントリーが増えたらテーブルを広げる
+	if (m_EntryNum + 1 > m_TableSize * 2) {
+		this->Rehash(m_TableSize * 2);
+	}
+
+	Entry **ppHead = &m_ppPathTable[static_cast<uint32>(pEntry->pathHash) & (m_TableSize - 1)];
+	pEntry->pPathNext = *ppHead;
+	*ppHead = pEntry;
+
+	pEntry->pPrev = NULL;
+	pEntry->pNext = m_pHead;
+	if (m_pHead != NULL) m_pHead->pPrev = pEntry;
+	m_pHead = pEntry;
+	if (m_pTail == NULL) m_pTail = pEntry;
+
+	pEntry->bLinked = true;
+	m_EntryNum++;
+}
+
+/*=======================================================================
+【機能】パスのテーブルとLRUから外す
+【引数】pEntry：エントリー
+【備考】非公開(ロック中に呼ぶこと)
+        CTgaのテーブルには残るので、Releaseで見つけられます。
+ =======================================================================*/
+void CTgaCache::UnlinkPath(Entry *pEntry)
+{
+	if (!pEntry->bLinked) return;
+
+	Entry **ppEntry = &m_ppPathTable[static_cast<uint32>(pEntry->pathHash) & (m_TableSize - 1)];
+	while (*ppEntry != pEntry) ppEntry = &(*ppEntry)->pPathNext;
+	*ppEntry = pEntry->pPathNext;
+
+	if (pEntry->pPrev != NULL) pEntry->pPrev->pNext = pEntry->pNext;
+	if (pEntry->pNext != NULL) pEntry->pNext->pPrev = pEntry->pPrev;
+	if (m_pHead == pEntry) m_pHead = pEntry->pNext;
+	if (m_pTail == pEntry) m_pTail = pEntry->pPrev;
+	pEntry->pPrev = pEntry->pNext = NULL;
+
+	pEntry->bLinked = false;
+	m_EntryNum--;
+}
+
+/*=======================================================================
+【機能】CTgaのテーブルに登録
+【引数】pEntry：エントリー
+【備考】非公開(ロック中に呼ぶこと)
+ =======================================================================*/
+void CTgaCache::LinkTga(Entry *pEntry)
+{
+	Entry **ppHead = &m_ppTgaTable[HashPointer(pEntry->pTga) & (m_TableSize - 1)];
+	pEntry->pTgaNext = *ppHead;
+	*ppHead = pEntry;
+}
+
+/*=======================================================================
+【機能】エントリーの破棄
+【引数】pEntry：エントリー(パスのテーブルから外したもの)
+【備考】非公開(ロック中に呼ぶこと)
+ =======================================================================*/
+void CTgaCache::Destroy(Entry *pEntry)
+{
+	_ASSERT(!pEntry->bLinked);
+
+	if (pEntry->pTga != NULL) {
+		Entry **ppEntry = &m_ppTgaTable[HashPointer(pEntry->pTga) & (m_TableSize - 1)];
+		while (*ppEntry != pEntry) ppEntry = &(*ppEntry)->pTgaNext;
+		*ppEntry = pEntry->pTgaNext;
+
+		m_Usage -= pEntry->bytes;
+		SAFE_DELETE(pEntry->pTga);
+	}
+
+	SAFE_DELETES(pEntry->pPath);
+	SAFE_DELETE(pEntry);
+}
+
+/*=======================================================================
+【機能】上限を超えた分を古い順に破棄
+【備考】非公開(ロック中に呼ぶこと)
+        参照中のものは破棄しないので、一時的に上限を超えることがあります。
+ =======================================================================*/
+void CTgaCache::Evict(void)
+{
+	Entry *pEntry = m_pTail;
+
+	while (m_Usage > m_Budget && pEntry != NULL) {
+		Entry *pPrev = pEntry->pPrev;
+		if (pEntry->ref == 0 && pEntry->bLoaded) {
+			this->UnlinkPath(pEntry);
+			this->Destroy(pEntry);
+		}
+		pEntry = pPrev;
+	}
+}
@@ -0,0 +1,67 @@
+/*=============================================================================
+ * 読み込み済みTGAのキャッシュ
+ * ファイルパス、サイズ、更新日時をキーにしてデコード済みのCTgaを共有します。
+ * 使用メモリが上限を超えたら、使われていないものから古い順に破棄します。
+ * mto_thread.h、mto_common.h、tga.hの順にインクルードしてから使用してください。
+=============================================================================*/
+#ifndef _TGA_CACHE_H_
+#define _TGA_CACHE_H_
+
+class CTgaCache {
+private:
+	struct Entry;
+
+	enum {
+		TABLE_SIZE_MIN = 256		// ハッシュテーブルの最小サイズ
+	};
+
+	Entry		**m_ppPathTable;	// パスのハッシュテーブル
+	Entry		**m_ppTgaTable;		// CTgaのアドレスのハッシュテーブル
+	uint32		m_TableSize;		// ハッシュテーブルのサイズ(2のべき乗)
+	uint32		m_EntryNum;			// エントリー数
+
+	Entry		*m_pHead;			// 最近使ったエントリー
+	Entry		*m_pTail;			// 一番使われていないエントリー
+
+	uint64		m_Budget;			// 使用メモリの上限
+	uint64		m_Usage;			// 使用メモリ
+	uint32		m_CreateFlag;		// CTgaの作成フラグ
+	const CTgaSidecar *m_pSidecar;	// CTgaの読み込みに使うキャッシュ
+	uint32		m_HitCount;			// キャッシュにあった回数
+	uint32		m_MissCount;		// 読み込んだ回数
+
+	CMtoMutex	m_Mutex;
+
+	// コピー禁止
+	CTgaCache(const CTgaCache&);
+	CTgaCache &operator=(const CTgaCache&);
+
+private:
+	Entry *FindPath(const char *pFileName, const uint64 hash) const;
+	Entry *FindTga(const CTga *pTga) const;
+	bool   Rehash(const uint32 size);
+	void   LinkPath(Entry *pEntry);
+	void   UnlinkPath(Entry *pEntry);
+	void   LinkTga(Entry *pEntry);
+	void   Destroy(Entry *pEntry);
+	void   Evict(void);
+
+public:
+	CTgaCache(const uint64 budget);
+	virtual ~CTgaCache(void);
+
+	uint64 getBudget(void)    const {return m_Budget;}
+	uint64 getUsage(void)     const {return m_Usage;}
+	uint32 getHitCount(void)  const {return m_HitCount;}
+	uint32 getMissCount(void) const {return m_MissCount;}
+
+	void setBudget(const uint64 budget);
+	void setCreateFlag(const uint32 flag) {m_CreateFlag = flag;}
+	void setSidecar(const CTgaSidecar *pSidecar) {m_pSidecar = pSidecar;}
+
+	const CTga *Acquire(const char *pFileName, int *pError);
+	void Release(const CTga *pTga);
+	void Flush(void);
+};
+
+#endif
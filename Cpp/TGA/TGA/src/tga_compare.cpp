@@ -0,0 +1,165 @@
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+
+namespace {
+
+/*=======================================================================
+【機能】差の大きさを色に変換(24bit BGR)
+【引数】pColor：格納先
+        diff  ：差(0～255)
+【備考】0は黒、小さい差も見えるように平方根で青→緑→黄→赤にする。
+ =======================================================================*/
+void HeatColor(uint8 *pColor, const uint32 diff)
+{
+	if (diff == 0) {
+		pColor[0] = pColor[1] = pColor[2] = 0;
+		return;
+	}
+
+	double t = sqrt(diff / 255.0) * 3.0;
+	double b, g, r;
+
+	if (t < 1.0) {
+		b = 1.0;     g = t;       r = 0.0;
+	} else if (t < 2.0) {
+		b = 2.0 - t; g = 1.0;     r = t - 1.0;
+	} else {
+		b = 0.0;     g = 3.0 - t; r = 1.0;
+	}
+
+	pColor[0] = static_cast<uint8>(b * 255.0 + 0.5);
+	pColor[1] = static_cast<uint8>(g * 255.0 + 0.5);
+	pColor[2] = static_cast<uint8>(r * 255.0 + 0.5);
+}
+
+/*=======================================================================
+【機能】平均2乗誤差からPSNRを求める
+ =======================================================================*/
+double CalcPSNR(const double mse)
+{
+	if (mse <= 0.0) return HUGE_VAL;
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】画像の比較
+【引数】tga     ：比較先
+        pResult ：結果の格納先
+        pHeatmap：差を色にした画像の作成先(NULLなら作成しない)
+【備考】ピクセルの並び、RGBA配列、ビット数が違っても
+        32bit(BGRA、左上原点)に揃えて比較します。
+        差分画像は24bit、左上原点で作成します。
+ =======================================================================*/
+bool CTga::Compare(const CTga &tga, TGACompare *pResult, CTga *pHeatmap) const
+{
+	if (!this->Decode() || !tga.Decode()) return false;
+	if (pResult == NULL || m_pImage == NULL || tga.m_pImage == NULL) return false;
+	if (m_Header.imageW != tga.m_Header.imageW || m_Header.imageH != tga.m_Header.imageH) return false;
+	if (m_Header.usePalette && m_pPalette == NULL) return false;
+	if (tga.m_Header.usePalette && tga.m_pPalette == NULL) return false;
+
+	const sint32 w = m_Header.imageW;
+	const sint32 h = m_Header.imageH;
+
+	// 差分画像
+	uint8 *pHeatImage = NULL;
+	uint8 heatColor[256 * 3];
+	if (pHeatmap != NULL) {
+		if ((pHeatImage = new uint8[w * h * 3]) == NULL) return false;
+		for (uint32 i = 0; i < 256; i++) HeatColor(&heatColor[i * 3], i);
+	}
+
+	uint32 diffPixel = 0;
+	uint32 maxCh[4]  = {0, 0, 0, 0};
+	uint64 sumCh[4]  = {0, 0, 0, 0};
+	bool bResult = true;
+
+#pragma omp parallel
+	{
+		uint8 *pWork0 = new uint8[w * 4];
+		uint8 *pWork1 = new uint8[w * 4];
+		uint8 *pHeat  = (pHeatImage != NULL) ? new uint8[w] : NULL;
+		uint32 count  = 0;
+		uint32 max[4] = {0, 0, 0, 0};
+		uint64 sum[4] = {0, 0, 0, 0};
+
+		if (pWork0 == NULL || pWork1 == NULL || (pHeatImage != NULL && pHeat == NULL)) {
+#pragma omp critical
+			bResult = false;
+		}
+
+#pragma omp for
+		for (sint32 y = 0; y < h; y++) {
+			if (!bResult) continue;
+
+			const uint8 *pLine0 = this->GetLine32(pWork0, y);
+			const uint8 *pLine1 = tga.GetLine32(pWork1, y);
+
+			count += TgaKernelCompare32(pLine0, pLine1, w, max, sum, pHeat);
+
+			if (pHeat != NULL) {
+				uint8 *pDst = &pHeatImage[y * w * 3];
+				for (sint32 x = 0; x < w; x++) {
+					memcpy(&pDst[x * 3], &heatColor[pHeat[x] * 3], 3);
+				}
+			}
+		}
+
+		// スレッドごとの結果をまとめる
+#pragma omp critical
+		{
+			diffPixel += count;
+			for (sint32 c = 0; c < 4; c++) {
+				if (max[c] > maxCh[c]) maxCh[c] = max[c];
+				sumCh[c] += sum[c];
+			}
+		}
+
+		SAFE_DELETES(pWork0);
+		SAFE_DELETES(pWork1);
+		SAFE_DELETES(pHeat);
+	}
+
+	if (!bResult) {
+		SAFE_DELETES(pHeatImage);
+		return false;
+	}
+
+	// 結果
+	const double pixel = static_cast<double>(w) * h;
+	uint64 sumAll = 0;
+
+	pResult->diffPixel = diffPixel;
+	pResult->maxDiff   = 0;
+	for (sint32 c = 0; c < 4; c++) {
+		pResult->maxDiffCh[c] = maxCh[c];
+		pResult->mse[c]       = (pixel > 0.0) ? (static_cast<double>(sumCh[c]) / pixel) : 0.0;
+		pResult->psnr[c]      = CalcPSNR(pResult->mse[c]);
+		if (maxCh[c] > pResult->maxDiff) pResult->maxDiff = maxCh[c];
+		sumAll += sumCh[c];
+	}
+	pResult->mseAll  = (pixel > 0.0) ? (static_cast<double>(sumAll) / (pixel * 4.0)) : 0.0;
+	pResult->psnrAll = CalcPSNR(pResult->mseAll);
+
+	// 差分画像作成
+	if (pHeatmap != NULL) {
+		TGAHeader header;
+		memset(&header, 0, sizeof(header));
+		header.imageType  = IMAGE_TYPE_FULL;
+		header.imageW     = m_Header.imageW;
+		header.imageH     = m_Header.imageH;
+		header.imageBit   = 24;
+		header.discripter = IMAGE_LINE_LRUD;
+
+		if (pHeatmap->Create(header, pHeatImage, w * h * 3, NULL, 0) != ERROR_NONE) {
+			SAFE_DELETES(pHeatImage);
+			return false;
+		}
+	}
+
+	return true;
+}
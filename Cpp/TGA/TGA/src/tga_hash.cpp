@@ -0,0 +1,164 @@
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+
+
+/*=======================================================================
+【機能】ハッシュ値を計算
+【戻値】ハッシュ値
+【備考】デコード後のピクセルとパレットから計算するので、RLE圧縮の有無、
+        ピクセルの並び、RGBA配列が違っても同じ画像なら同じ値になります。
+        ビット数や乗算済みアルファかどうかが違う場合は別の値になります。
+ =======================================================================*/
+uint64 CTga::CalcHash(void)
+{
+	if (!this->Decode()) return 0;
+
+	return this->HashAll();
+}
+
+/*=======================================================================
+【機能】ハッシュ値を計算
+【戻値】ハッシュ値(0:メモリ不足)
+【備考】非公開
+        遅延デコード中にも呼ぶので、Decodeは呼ばない。
+ =======================================================================*/
+uint64 CTga::HashAll(void)
+{
+	if (m_pImage == NULL) return 0;
+
+	const sint32 h = m_Header.imageH;
+	uint64 *pLineHash;
+	bool bResult = true;
+
+	if ((pLineHash = new uint64[h]) == NULL) return 0;
+
+#pragma omp parallel
+	{
+		uint8 *pWork = new uint8[m_Header.imageW * (m_Header.imageBit >> 3)];
+
+		if (pWork == NULL) {
+#pragma omp critical
+			bResult = false;
+		}
+
+#pragma omp for
+		for (sint32 y = 0; y < h; y++) {
+			if (pWork == NULL) continue;
+			pLineHash[y] = this->HashLine(pWork, y);
+		}
+
+		SAFE_DELETES(pWork);
+	}
+
+	if (!bResult) {
+		SAFE_DELETES(pLineHash);
+		return 0;
+	}
+
+	m_Hash = this->HashImage(pLineHash);
+	SAFE_DELETES(pLineHash);
+
+	return m_Hash;
+}
+
+/*=======================================================================
+【機能】1ラインのハッシュ値を計算
+【引数】pWork：並び替え用の作業領域(1ライン分)
+        y    ：ライン(上から数えた位置)
+【戻値】ハッシュ値
+【備考】非公開
+        右→左の並びとRGBA配列は、左→右、BGRA配列に戻してから計算する。
+ =======================================================================*/
+uint64 CTga::HashLine(uint8 *pWork, const sint32 y) const
+{
+	const sint32 w    = m_Header.imageW;
+	const uint32 byte = m_Header.imageBit >> 3;
+	const uint32 size = w * byte;
+
+	const uint8 *pSrc = this->GetLinePtr(y);
+
+	const bool bFlip = (m_Header.discripter & 0x10) ? true : false;
+	const bool bSwap = (m_bRGBA && byte >= 2);
+
+	if (!bFlip && !bSwap) {
+		return TgaKernelHash64(pSrc, size, 0);
+	}
+
+	for (sint32 x = 0; x < w; x++) {
+		const uint8 *s = &pSrc[(bFlip ? (w - x - 1) : x) * byte];
+		uint8 *d = &pWork[x * byte];
+
+		memcpy(d, s, byte);
+
+		if (bSwap) {
+			if (byte == 2) {
+				uint16 pix = static_cast<uint16>(d[0] | (d[1] << 8));
+				pix = static_cast<uint16>((pix & 0x83e0) | ((pix & 0x7c00) >> 10) | ((pix & 0x001f) << 10));
+				d[0] = static_cast<uint8>(pix);
+				d[1] = static_cast<uint8>(pix >> 8);
+			} else {
+				uint8 t = d[0];
+				d[0] = d[2];
+				d[2] = t;
+			}
+		}
+	}
+
+	return TgaKernelHash64(pWork, size, 0);
+}
+
+/*=======================================================================
+【機能】ラインごとのハッシュ値から画像全体のハッシュ値を計算
+【引数】pLineHash：ラインごとのハッシュ値(上から順に高さ分)
+【戻値】ハッシュ値
+【備考】非公開
+        ヘッダーの内容(RLE圧縮とピクセルの並び以外)とパレットも含める。
+ =======================================================================*/
+uint64 CTga::HashImage(const uint64 *pLineHash) const
+{
+	// ヘッダー
+	uint8 info[12];
+	uint8 type = m_Header.imageType;
+	if (IMAGE_TYPE_INDEX_RLE <= type && type < IMAGE_TYPE_RLE_MAX) type -= 8;
+
+	info[0]  = static_cast<uint8>(m_Header.imageW);
+	info[1]  = static_cast<uint8>(m_Header.imageW >> 8);
+	info[2]  = static_cast<uint8>(m_Header.imageH);
+	info[3]  = static_cast<uint8>(m_Header.imageH >> 8);
+	info[4]  = m_Header.imageBit;
+	info[5]  = type;
+	info[6]  = static_cast<uint8>(m_Header.paletteColor);
+	info[7]  = static_cast<uint8>(m_Header.paletteColor >> 8);
+	info[8]  = m_Header.paletteBit;
+	info[9]  = static_cast<uint8>(m_Header.discripter & 0x0f);
+	info[10] = m_bPremultiplied ? 1 : 0;
+	info[11] = 0;
+
+	uint64 hash = TgaKernelHash64(info, sizeof(info), 0);
+
+	// イメージ
+	hash = TgaKernelHash64(pLineHash, m_Header.imageH * sizeof(uint64), hash);
+
+	// パレット(BGRA配列で計算)
+	if (m_pPalette != NULL && m_PaletteSize != 0) {
+		if (m_bRGBA) {
+			uint8 *pWork;
+			if ((pWork = new uint8[m_PaletteSize]) == NULL) return 0;
+
+			const uint32 byte = m_Header.paletteBit >> 3;
+			memcpy(pWork, m_pPalette, m_PaletteSize);
+			for (uint32 i = 0; i + byte <= m_PaletteSize; i += byte) {
+				uint8 t = pWork[i];
+				pWork[i] = pWork[i + 2];
+				pWork[i + 2] = t;
+			}
+			hash = TgaKernelHash64(pWork, m_PaletteSize, hash);
+			SAFE_DELETES(pWork);
+		} else {
+			hash = TgaKernelHash64(m_pPalette, m_PaletteSize, hash);
+		}
+	}
+
+	return hash;
+}
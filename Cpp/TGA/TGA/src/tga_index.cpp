@@ -0,0 +1,590 @@
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_index.h"
+
+#include <algorithm>
+
+
+/*
+ * 目録ファイルの形式(リトルエンディアン)
+ *
+ *  0 "TGAI"
+ *  4 バージョン(16bit)
+ *  6 予約(16bit)
+ *  8 ファイル数(32bit)
+ * 12 パスの領域のサイズ(32bit)
+ *    以降FILE_HEADER_SIZEまで0
+ *
+ * ヘッダーの後ろにファイルごとの情報(ENTRY_SIZEバイト)をパスの昇順に並べ、
+ * その後ろにパスの領域('\0'終端のパスを情報と同じ順に並べたもの)を置く。
+ *
+ * ファイルごとの情報
+ *  0 パスの位置(32bit、パスの領域の先頭から)
+ *  4 予約(32bit)
+ *  8 ファイルサイズ(64bit)
+ * 16 更新日時(64bit)
+ * 24 イメージの位置(32bit)
+ * 28 エクステンションエリアの位置(32bit)
+ * 32 デベロッパーエリアの位置(32bit)
+ * 36 幅(16bit)
+ * 38 高さ(16bit)
+ * 40 パレットの色数(16bit)
+ * 42 イメージ形式、ビット数、イメージ記述子、IDフィールドのサイズ、
+ *    1パレットのビット数、アルファの種類(各8bit)
+ *    以降ENTRY_SIZEまで0
+ */
+
+namespace {
+
+// ヘッダー内の位置
+enum {
+	OFS_MAGIC       = 0,
+	OFS_VERSION     = 4,
+	OFS_NUM         = 8,
+	OFS_STRING_SIZE = 12
+};
+
+// ファイルごとの情報内の位置
+enum {
+	ENT_PATH        = 0,
+	ENT_SIZE        = 8,
+	ENT_TIME        = 16,
+	ENT_IMAGE       = 24,
+	ENT_EXTENSION   = 28,
+	ENT_DEVELOPER   = 32,
+	ENT_WIDTH       = 36,
+	ENT_HEIGHT      = 38,
+	ENT_PAL_COLOR   = 40,
+	ENT_IMAGE_TYPE  = 42,
+	ENT_IMAGE_BIT   = 43,
+	ENT_DISCRIPTER  = 44,
+	ENT_ID_FIELD    = 45,
+	ENT_PAL_BIT     = 46,
+	ENT_ALPHA_TYPE  = 47
+};
+
+// TGAファイル内の位置
+enum {
+	TGA_FOOTER_SIGNATURE = 8,		// フッター内の署名
+	TGA_EXT_ALPHA        = 494		// エクステンションエリア内のアルファの種類
+};
+
+const char FILE_MAGIC[4] = {'T', 'G', 'A', 'I'};
+const char TEMP_EXT[]    = ".tmp";
+
+MTOINLINE void Put16(uint8 *p, const uint32 n) {p[0] = static_cast<uint8>(n); p[1] = static_cast<uint8>(n >> 8);}
+MTOINLINE void Put32(uint8 *p, const uint32 n) {Put16(p, n); Put16(&p[2], n >> 16);}
+MTOINLINE void Put64(uint8 *p, const uint64 n) {Put32(p, static_cast<uint32>(n)); Put32(&p[4], static_cast<uint32>(n >> 32));}
+
+MTOINLINE uint32 Get16(const uint8 *p) {return p[0] | (p[1] << 8);}
+MTOINLINE uint32 Get32(const uint8 *p) {return Get16(p) | (Get16(&p[2]) << 16);}
+MTOINLINE uint64 Get64(const uint8 *p) {return Get32(p) | (static_cast<uint64>(Get32(&p[4])) << 32);}
+
+/*=======================================================================
+【機能】TGAファイルの拡張子？
+ =======================================================================*/
+bool IsTgaName(const char *pName)
+{
+	const size_t len = strlen(pName);
+	if (len <= 4) return false;
+
+	const char *pExt = &pName[len - 4];
+	return (strcmp(pExt, ".tga") == 0 || strcmp(pExt, ".TGA") == 0);
+}
+
+/*=======================================================================
+【機能】Buildで集めるファイル
+ =======================================================================*/
+struct ScanFile {
+	char				*pPath;		// ルートディレクトリからのパス
+	CTgaIndex::Entry	entry;
+	bool				bValid;		// 情報を読み込めた？
+};
+
+struct ScanList {
+	const char	*pRoot;
+	char		dir[CTgaIndex::PATH_MAX_LEN];	// 列挙中のディレクトリ(ルートディレクトリからのパス)
+	ScanFile	*pFile;
+	uint32		num;
+	uint32		max;
+};
+
+void ScanDir(ScanList *pList);
+
+/*=======================================================================
+【機能】TGAファイルを集める(MtoDirScanから呼ばれる)
+ =======================================================================*/
+void ScanFileFunc(const char *pName, const MtoFileStatus &status, void *pUser)
+{
+	ScanList *pList = static_cast<ScanList*>(pUser);
+
+	NOTHING(status);
+	if (!IsTgaName(pName)) return;
+
+	const size_t dirLen = strlen(pList->dir);
+	const size_t len    = dirLen + strlen(pName);
+	if (strlen(pList->pRoot) + 1 + len >= CTgaIndex::PATH_MAX_LEN) return;
+
+	// 足りなくなったら広げる
+	if (pList->num == pList->max) {
+		const uint32 max = (pList->max != 0) ? pList->max * 2 : 256;
+		ScanFile *pFile = new ScanFile[max];
+		if (pFile == NULL) return;
+		if (pList->pFile != NULL) memcpy(pFile, pList->pFile, sizeof(ScanFile) * pList->num);
+		SAFE_DELETES(pList->pFile);
+		pList->pFile = pFile;
+		pList->max   = max;
+	}
+
+	ScanFile &file = pList->pFile[pList->num];
+	if ((file.pPath = new char[len + 1]) == NULL) return;
+	memcpy(file.pPath, pList->dir, dirLen);
+	strcpy(&file.pPath[dirLen], pName);
+	file.bValid = false;
+
+	pList->num++;
+}
+
+/*=======================================================================
+【機能】サブディレクトリを列挙(MtoDirScanSubから呼ばれる)
+ =======================================================================*/
+void ScanSubFunc(const char *pName, void *pUser)
+{
+	ScanList *pList = static_cast<ScanList*>(pUser);
+
+	const size_t dirLen = strlen(pList->dir);
+	if (dirLen + strlen(pName) + 2 >= sizeof(pList->dir)) return;
+
+	sprintf(&pList->dir[dirLen], "%s/", pName);
+	ScanDir(pList);
+	pList->dir[dirLen] = '\0';
+}
+
+/*=======================================================================
+【機能】ディレクトリ以下を列挙
+ =======================================================================*/
+void ScanDir(ScanList *pList)
+{
+	char path[CTgaIndex::PATH_MAX_LEN * 2];
+
+	if (strlen(pList->pRoot) + 1 + strlen(pList->dir) >= CTgaIndex::PATH_MAX_LEN) return;
+	sprintf(path, "%s/%s", pList->pRoot, pList->dir);
+
+	MtoDirScan(path, ScanFileFunc, pList);
+	MtoDirScanSub(path, ScanSubFunc, pList);
+}
+
+/*=======================================================================
+【機能】パスの順に並べる
+ =======================================================================*/
+bool ComparePath(const ScanFile *pFile0, const ScanFile *pFile1)
+{
+	return (strcmp(pFile0->pPath, pFile1->pPath) < 0);
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTgaIndex::CTgaIndex(void)
+{
+	m_pMap       = NULL;
+	m_pEntry     = NULL;
+	m_pString    = NULL;
+	m_Num        = 0;
+	m_StringSize = 0;
+}
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTgaIndex::~CTgaIndex(void)
+{
+	this->Close();
+}
+
+/*=======================================================================
+【機能】目録ファイルを開く
+【引数】pFileName：目録ファイル名
+【戻値】true：成功
+【備考】目録ファイルはマップしたままになります。
+ =======================================================================*/
+bool CTgaIndex::Open(const char *pFileName)
+{
+	this->Close();
+
+	if (pFileName == NULL) return false;
+
+	if ((m_pMap = new CMtoFileMap) == NULL) return false;
+	if (!m_pMap->Open(pFileName) || m_pMap->getSize() < FILE_HEADER_SIZE) {
+		this->Close();
+		return false;
+	}
+
+	const uint8 *pSrc = m_pMap->getData();
+	const uint64 size = m_pMap->getSize();
+	const uint32 num  = Get32(&pSrc[OFS_NUM]);
+	const uint32 str  = Get32(&pSrc[OFS_STRING_SIZE]);
+
+	// 形式と範囲の確認(パスの領域は'\0'で終わっていること)
+	if (memcmp(&pSrc[OFS_MAGIC], FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+		Get16(&pSrc[OFS_VERSION]) != FILE_VERSION ||
+		FILE_HEADER_SIZE + static_cast<uint64>(num) * ENTRY_SIZE + str != size ||
+		(str != 0 && pSrc[size - 1] != '\0') || (num != 0 && str == 0)) {
+		this->Close();
+		return false;
+	}
+
+	m_pEntry     = &pSrc[FILE_HEADER_SIZE];
+	m_pString    = reinterpret_cast<const char*>(&pSrc[FILE_HEADER_SIZE + num * ENTRY_SIZE]);
+	m_Num        = num;
+	m_StringSize = str;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】目録ファイルを閉じる
+ =======================================================================*/
+void CTgaIndex::Close(void)
+{
+	SAFE_DELETE(m_pMap);
+
+	m_pEntry     = NULL;
+	m_pString    = NULL;
+	m_Num        = 0;
+	m_StringSize = 0;
+}
+
+/*=======================================================================
+【機能】ファイルの情報を取得
+【引数】index ：番号(パスの昇順)
+        pEntry：格納先(pPathは目録ファイルを閉じるまで使えます)
+【戻値】true：成功
+ =======================================================================*/
+bool CTgaIndex::GetEntry(const uint32 index, Entry *pEntry) const
+{
+	if (index >= m_Num || pEntry == NULL) return false;
+
+	const uint8 *p = &m_pEntry[index * ENTRY_SIZE];
+	const uint32 path = Get32(&p[ENT_PATH]);
+	if (path >= m_StringSize) return false;
+
+	pEntry->pPath           = &m_pString[path];
+	pEntry->size            = Get64(&p[ENT_SIZE]);
+	pEntry->time            = static_cast<sint64>(Get64(&p[ENT_TIME]));
+	pEntry->imageOffset     = Get32(&p[ENT_IMAGE]);
+	pEntry->extensionOffset = Get32(&p[ENT_EXTENSION]);
+	pEntry->developerOffset = Get32(&p[ENT_DEVELOPER]);
+	pEntry->imageW          = static_cast<uint16>(Get16(&p[ENT_WIDTH]));
+	pEntry->imageH          = static_cast<uint16>(Get16(&p[ENT_HEIGHT]));
+	pEntry->paletteColor    = static_cast<uint16>(Get16(&p[ENT_PAL_COLOR]));
+	pEntry->imageType       = p[ENT_IMAGE_TYPE];
+	pEntry->imageBit        = p[ENT_IMAGE_BIT];
+	pEntry->discripter      = p[ENT_DISCRIPTER];
+	pEntry->IDField         = p[ENT_ID_FIELD];
+	pEntry->paletteBit      = p[ENT_PAL_BIT];
+	pEntry->alphaType       = p[ENT_ALPHA_TYPE];
+
+	return true;
+}
+
+/*=======================================================================
+【機能】パスで探す
+【引数】pPath：ルートディレクトリからのパス(区切りは'/')
+【戻値】番号(見つからなければ-1)
+【備考】パスの昇順に並んでいるので二分探索します。
+ =======================================================================*/
+sint32 CTgaIndex::Find(const char *pPath) const
+{
+	uint32 lo = 0;
+	uint32 hi = m_Num;
+
+	while (lo < hi) {
+		const uint32 mid  = (lo + hi) / 2;
+		const uint32 path = Get32(&m_pEntry[mid * ENTRY_SIZE + ENT_PATH]);
+		if (path >= m_StringSize) return -1;
+
+		const int cmp = strcmp(&m_pString[path], pPath);
+		if (cmp == 0) return static_cast<sint32>(mid);
+		if (cmp < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return -1;
+}
+
+/*=======================================================================
+【機能】条件に合うファイルを探す
+【引数】query ：検索条件
+        pIndex：見つかった番号の格納先(NULLなら数えるだけ)
+        max   ：pIndexに格納できる数
+【戻値】条件に合うファイルの数(maxより多くても全部数える)
+【備考】目録ファイルの中だけを見るので、TGAファイルは開きません。
+ =======================================================================*/
+uint32 CTgaIndex::Select(const Query &query, uint32 *pIndex, const uint32 max) const
+{
+	uint32 count = 0;
+
+	for (uint32 i = 0; i < m_Num; i++) {
+		const uint8 *p = &m_pEntry[i * ENTRY_SIZE];
+		const uint32 w = Get16(&p[ENT_WIDTH]);
+		const uint32 h = Get16(&p[ENT_HEIGHT]);
+
+		if (query.minW != 0 && w < query.minW) continue;
+		if (query.maxW != 0 && w > query.maxW) continue;
+		if (query.minH != 0 && h < query.minH) continue;
+		if (query.maxH != 0 && h > query.maxH) continue;
+		if (query.imageBit != 0 && p[ENT_IMAGE_BIT] != query.imageBit) continue;
+		if (query.imageType != 0 && (p[ENT_IMAGE_TYPE] & ~8) != (query.imageType & ~8)) continue;
+		if (query.line >= 0 && (p[ENT_DISCRIPTER] & 0x30) != query.line) continue;
+
+		if (pIndex != NULL && count < max) pIndex[count] = i;
+		count++;
+	}
+
+	return count;
+}
+
+/*=======================================================================
+【機能】TGAファイルの情報を読み込む
+【引数】pFileName：TGAファイル名
+        pEntry   ：格納先(pPathはNULLになります)
+【戻値】true：対応しているTGAファイル
+【備考】ヘッダーとフッター、エクステンションエリアのアルファの種類だけ読みます。
+ =======================================================================*/
+bool CTgaIndex::ReadEntry(const char *pFileName, Entry *pEntry)
+{
+	MtoFileStatus status;
+	FILE *fp;
+	uint8 head[CTga::HEADER_SIZE];
+
+	if (!MtoFileGetStatus(pFileName, &status) || status.size < CTga::HEADER_SIZE) return false;
+	if ((fp = fopen(pFileName, "rb")) == NULL) return false;
+
+	if (fread(head, CTga::HEADER_SIZE, 1, fp) != 1) {
+		fclose(fp);
+		return false;
+	}
+
+	// ヘッダー(CTga::ReadHeaderと同じ並び)
+	const uint32 usePalette = head[1];
+	const uint32 type       = head[2] & ~8;
+
+	pEntry->pPath        = NULL;
+	pEntry->size         = status.size;
+	pEntry->time         = status.time;
+	pEntry->IDField      = head[0];
+	pEntry->imageType    = head[2];
+	pEntry->paletteColor = static_cast<uint16>(Get16(&head[5]));
+	pEntry->paletteBit   = head[7];
+	pEntry->imageW       = static_cast<uint16>(Get16(&head[12]));
+	pEntry->imageH       = static_cast<uint16>(Get16(&head[14]));
+	pEntry->imageBit     = head[16];
+	pEntry->discripter   = head[17];
+
+	const uint64 paletteSize = usePalette * pEntry->paletteColor * ((pEntry->paletteBit + 7) >> 3);
+	const uint64 imageOffset = CTga::HEADER_SIZE + pEntry->IDField + paletteSize;
+
+	if (type == CTga::IMAGE_TYPE_NONE || type >= CTga::IMAGE_TYPE_MAX || pEntry->imageType > CTga::IMAGE_TYPE_RLE_MAX ||
+		pEntry->imageBit == 0 || pEntry->imageBit > 32 || imageOffset > status.size) {
+		fclose(fp);
+		return false;
+	}
+
+	pEntry->imageOffset     = static_cast<uint32>(imageOffset);
+	pEntry->extensionOffset = 0;
+	pEntry->developerOffset = 0;
+	pEntry->alphaType       = ALPHA_UNKNOWN;
+
+	// フッター(署名があるものだけ)
+	uint8 foot[CTga::FOOTER_SIZE];
+
+	if (status.size >= imageOffset + CTga::FOOTER_SIZE &&
+		MtoFileSeek(fp, static_cast<long long>(status.size - CTga::FOOTER_SIZE), SEEK_SET) &&
+		fread(foot, CTga::FOOTER_SIZE, 1, fp) == 1 &&
+		memcmp(&foot[TGA_FOOTER_SIGNATURE], "TRUEVISION-", 11) == 0) {
+		const uint64 end = status.size - CTga::FOOTER_SIZE;
+		const uint32 ext = Get32(&foot[0]);
+		const uint32 dev = Get32(&foot[4]);
+
+		if (ext != 0 && ext + static_cast<uint64>(CTga::EXTENSION_SIZE) <= end) {
+			uint8 area[2];
+
+			// エクステンションエリアのサイズ(2.0なら495)とアルファの種類
+			pEntry->extensionOffset = ext;
+			if (MtoFileSeek(fp, ext, SEEK_SET) && fread(area, 2, 1, fp) == 1 && Get16(area) >= CTga::EXTENSION_SIZE &&
+				MtoFileSeek(fp, ext + TGA_EXT_ALPHA, SEEK_SET) && fread(area, 1, 1, fp) == 1) {
+				pEntry->alphaType = area[0];
+			}
+		}
+		if (dev != 0 && dev < end) {
+			pEntry->developerOffset = dev;
+		}
+	}
+
+	fclose(fp);
+
+	return true;
+}
+
+/*=======================================================================
+【機能】目録ファイルを作る
+【引数】pFileName：目録ファイル名
+        pRootDir ：TGAファイルを探すディレクトリ(サブディレクトリも探す)
+        pUpdate  ：読み込んだファイル数の格納先(NULL可)
+【戻値】true：成功
+【備考】既に目録ファイルがあれば、サイズと更新日時が同じファイルは
+        読み込まずに前の情報を使います(TGAファイルでないものは目録に
+        入らないので毎回読みます)。読み込みは並列で行います。
+        作業ファイルに書き出してから置き換えるので、途中の状態の目録ファイルが
+        読まれることはありません。
+ =======================================================================*/
+bool CTgaIndex::Build(const char *pFileName, const char *pRootDir, uint32 *pUpdate)
+{
+	if (pFileName == NULL || pRootDir == NULL) return false;
+	if (pUpdate != NULL) *pUpdate = 0;
+	if (strlen(pFileName) >= PATH_MAX_LEN) return false; // 作業ファイル名が入らない
+
+	// 末尾の区切り文字は除く
+	char root[PATH_MAX_LEN];
+	size_t len = strlen(pRootDir);
+	while (len > 1 && (pRootDir[len - 1] == '/' || pRootDir[len - 1] == '\\')) len--;
+	if (len >= PATH_MAX_LEN) return false;
+	memcpy(root, pRootDir, len);
+	root[len] = '\0';
+
+	// ファイルを集める
+	ScanList list;
+	list.pRoot  = root;
+	list.dir[0] = '\0';
+	list.pFile  = NULL;
+	list.num    = 0;
+	list.max    = 0;
+
+	ScanDir(&list);
+
+	// 前の目録から変わっていないものを探す
+	CTgaIndex old;
+	uint32 update = 0;
+
+	if (old.Open(pFileName)) {
+		for (uint32 i = 0; i < list.num; i++) {
+			ScanFile &file = list.pFile[i];
+			const sint32 index = old.Find(file.pPath);
+			MtoFileStatus status;
+
+			if (index >= 0 && old.GetEntry(index, &file.entry)) {
+				sprintf(root + len, "/%s", file.pPath);
+				file.bValid = (MtoFileGetStatus(root, &status) && status.size == file.entry.size && status.time == file.entry.time);
+				root[len] = '\0';
+			}
+		}
+	}
+
+	// 変わったものだけ読み込む
+	const sint32 num = static_cast<sint32>(list.num);
+
+#pragma omp parallel for schedule(dynamic)
+	for (sint32 i = 0; i < num; i++) {
+		ScanFile &file = list.pFile[i];
+		char path[PATH_MAX_LEN];
+
+		if (file.bValid) continue;
+
+		sprintf(path, "%s/%s", root, file.pPath);
+		file.bValid = ReadEntry(path, &file.entry);
+
+#pragma omp atomic
+		update++;
+	}
+
+	// パスの順に並べる
+	ScanFile **ppSort = new ScanFile*[list.num + 1];
+	uint32 count = 0;
+	uint32 strSize = 0;
+	bool bResult = (ppSort != NULL);
+
+	if (bResult) {
+		for (uint32 i = 0; i < list.num; i++) {
+			if (!list.pFile[i].bValid) continue;
+			ppSort[count++] = &list.pFile[i];
+			strSize += static_cast<uint32>(strlen(list.pFile[i].pPath)) + 1;
+		}
+		std::sort(ppSort, ppSort + count, ComparePath);
+	}
+
+	// 作業ファイルに書き出し(前の目録はマップしたままだと置き換えられないので閉じる)
+	char temp[PATH_MAX_LEN + 64];
+	FILE *fp = NULL;
+
+	old.Close();
+	sprintf(temp, "%s.%lu%s", pFileName, MtoGetProcessId(), TEMP_EXT);
+
+	if (bResult && (fp = fopen(temp, "wb")) == NULL) bResult = false;
+
+	if (bResult) {
+		uint8 head[FILE_HEADER_SIZE];
+
+		memset(head, 0, sizeof(head));
+		memcpy(&head[OFS_MAGIC], FILE_MAGIC, sizeof(FILE_MAGIC));
+		Put16(&head[OFS_VERSION],     FILE_VERSION);
+		Put32(&head[OFS_NUM],         count);
+		Put32(&head[OFS_STRING_SIZE], strSize);
+		bResult = (fwrite(head, sizeof(head), 1, fp) == 1);
+
+		uint32 path = 0;
+		for (uint32 i = 0; bResult && i < count; i++) {
+			const Entry &entry = ppSort[i]->entry;
+			uint8 p[ENTRY_SIZE];
+
+			memset(p, 0, sizeof(p));
+			Put32(&p[ENT_PATH],      path);
+			Put64(&p[ENT_SIZE],      entry.size);
+			Put64(&p[ENT_TIME],      static_cast<uint64>(entry.time));
+			Put32(&p[ENT_IMAGE],     entry.imageOffset);
+			Put32(&p[ENT_EXTENSION], entry.extensionOffset);
+			Put32(&p[ENT_DEVELOPER], entry.developerOffset);
+			Put16(&p[ENT_WIDTH],     entry.imageW);
+			Put16(&p[ENT_HEIGHT],    entry.imageH);
+			Put16(&p[ENT_PAL_COLOR], entry.paletteColor);
+			p[ENT_IMAGE_TYPE] = entry.imageType;
+			p[ENT_IMAGE_BIT]  = entry.imageBit;
+			p[ENT_DISCRIPTER] = entry.discripter;
+			p[ENT_ID_FIELD]   = entry.IDField;
+			p[ENT_PAL_BIT]    = entry.paletteBit;
+			p[ENT_ALPHA_TYPE] = entry.alphaType;
+
+			bResult = (fwrite(p, sizeof(p), 1, fp) == 1);
+			path += static_cast<uint32>(strlen(ppSort[i]->pPath)) + 1;
+		}
+
+		for (uint32 i = 0; bResult && i < count; i++) {
+			bResult = (fwrite(ppSort[i]->pPath, strlen(ppSort[i]->pPath) + 1, 1, fp) == 1);
+		}
+
+		if (fclose(fp) != 0) bResult = false;
+
+		// 置き換え
+		if (!bResult || !MtoFileReplace(temp, pFileName)) {
+			MtoFileRemove(temp);
+			bResult = false;
+		}
+	}
+
+	for (uint32 i = 0; i < list.num; i++) {
+		SAFE_DELETES(list.pFile[i].pPath);
+	}
+	SAFE_DELETES(list.pFile);
+	SAFE_DELETES(ppSort);
+
+	if (pUpdate != NULL) *pUpdate = update;
+
+	return bResult;
+}
@@ -0,0 +1,84 @@
+/*=============================================================================
+ * TGAファイルの目録
+ * ディレクトリ以下のTGAファイルのヘッダーとフッターだけを読み込んで、
+ * パスの順に並べた目録ファイルを作ります。目録ファイルはマップして使うので、
+ * 「幅が2048より大きい32bitの画像」のような検索がファイルを開かずにできます。
+ * 作り直す時は、サイズと更新日時が変わっていないファイルは読み込みません。
+ * mto_file.h、mto_common.h、tga.hの順にインクルードしてから使用してください。
+=============================================================================*/
+#ifndef _TGA_INDEX_H_
+#define _TGA_INDEX_H_
+
+class CTgaIndex {
+public:
+	enum {
+		FILE_VERSION = 1,			// 目録ファイルのバージョン
+		FILE_HEADER_SIZE = 32,		// 目録ファイルのヘッダーサイズ
+		ENTRY_SIZE = 64,			// 1ファイル分の情報のサイズ
+		PATH_MAX_LEN = 1024			// パスの最大長
+	};
+
+	enum {
+		ALPHA_UNKNOWN = 0xff		// エクステンションエリアがない(アルファの種類が不明)
+	};
+
+	// 1ファイル分の情報
+	struct Entry {
+		const char	*pPath;			// ルートディレクトリからのパス(区切りは'/')
+		uint64		size;			// ファイルサイズ
+		sint64		time;			// 更新日時(1970/01/01からの秒)
+		uint16		imageW;			// イメージ幅
+		uint16		imageH;			// イメージ高さ
+		uint8		imageType;		// イメージ形式
+		uint8		imageBit;		// イメージビット数
+		uint8		discripter;		// イメージ記述子(並びとアルファビット数)
+		uint8		IDField;		// IDフィールドのサイズ
+		uint16		paletteColor;	// パレットの色数
+		uint8		paletteBit;		// 1パレットのビット数
+		uint8		alphaType;		// エクステンションエリアのアルファの種類
+		uint32		imageOffset;	// イメージの位置
+		uint32		extensionOffset;// エクステンションエリアの位置(0ならなし)
+		uint32		developerOffset;// デベロッパーエリアの位置(0ならなし)
+	};
+
+	// 検索条件(0なら条件なし)
+	struct Query {
+		uint16		minW;			// 最小の幅
+		uint16		maxW;			// 最大の幅
+		uint16		minH;			// 最小の高さ
+		uint16		maxH;			// 最大の高さ
+		uint8		imageBit;		// イメージビット数
+		uint8		imageType;		// イメージ形式(RLE圧縮の有無は問わない)
+		sint32		line;			// ピクセルの並び(IMAGE_LINE_xxx、-1なら条件なし)
+
+		Query(void) {minW = maxW = minH = maxH = 0; imageBit = imageType = 0; line = -1;}
+	};
+
+private:
+	CMtoFileMap		*m_pMap;		// マップ中の目録ファイル
+	const uint8		*m_pEntry;		// 情報の先頭
+	const char		*m_pString;		// パスの先頭
+	uint32			m_Num;			// ファイル数
+	uint32			m_StringSize;	// パスの領域のサイズ
+
+	// コピー禁止
+	CTgaIndex(const CTgaIndex&);
+	CTgaIndex &operator=(const CTgaIndex&);
+
+public:
+	CTgaIndex(void);
+	virtual ~CTgaIndex(void);
+
+	uint32 getNum(void) const {return m_Num;}
+
+	bool   Open(const char *pFileName);
+	void   Close(void);
+	bool   GetEntry(const uint32 index, Entry *pEntry) const;
+	sint32 Find(const char *pPath) const;
+	uint32 Select(const Query &query, uint32 *pIndex, const uint32 max) const;
+
+	static bool Build(const char *pFileName, const char *pRootDir, uint32 *pUpdate);
+	static bool ReadEntry(const char *pFileName, Entry *pEntry);
+};
+
+#endif
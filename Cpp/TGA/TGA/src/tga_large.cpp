@@ -0,0 +1,528 @@
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+#include "tga_large.h"
+
+
+namespace {
+
+enum {
+	FOOTER_SIGNATURE = 8			// フッター内の署名
+};
+
+/*=======================================================================
+【機能】赤と青を入れ替える
+【引数】pImage：イメージ
+        num   ：ピクセル数
+        byte  ：1ピクセルのバイト数
+ =======================================================================*/
+void SwapRB(uint8 *pImage, const uint32 num, const uint32 byte)
+{
+	switch (byte) {
+	case 2:
+		TgaKernelSwapRB16(pImage, pImage, num);
+		break;
+	case 3:
+		TgaKernelSwapRB24(pImage, pImage, num);
+		break;
+	case 4:
+		TgaKernelSwapRB32(pImage, pImage, num);
+		break;
+	default:
+		// IndexColor、白黒なら処理しない
+		break;
+	}
+}
+
+/*=======================================================================
+【機能】RLE圧縮されたイメージを先頭から順に展開する
+【備考】パケットが帯やラインをまたいでも続きから展開できるように、
+        読みかけのパケットを覚えておく。
+ =======================================================================*/
+class CRleReader {
+private:
+	FILE	*m_fp;
+	uint8	*m_pBuf;				// 読み込みバッファ
+	uint32	m_Size;					// バッファ内のデータサイズ
+	uint32	m_Pos;					// バッファ内の読み込み位置
+	uint32	m_Byte;					// 1ピクセルのバイト数
+	uint32	m_Remain;				// 読みかけのパケットの残りピクセル数
+	bool	m_bRepeat;				// 読みかけのパケットは反復？
+	uint8	m_Pixel[4];				// 反復するピクセル
+
+	bool ReadByte(uint8 *pDst, uint32 size);
+
+public:
+	CRleReader(void);
+	~CRleReader(void);
+
+	bool Open(FILE *fp, const uint64 offset, const uint32 byte);
+	bool Read(uint8 *pDst, const uint32 num);
+};
+
+CRleReader::CRleReader(void)
+{
+	m_fp      = NULL;
+	m_pBuf    = NULL;
+	m_Size    = 0;
+	m_Pos     = 0;
+	m_Byte    = 0;
+	m_Remain  = 0;
+	m_bRepeat = false;
+}
+
+CRleReader::~CRleReader(void)
+{
+	SAFE_DELETES(m_pBuf);
+}
+
+/*=======================================================================
+【機能】展開開始
+【引数】fp    ：ファイルポインタ
+        offset：イメージの位置
+        byte  ：1ピクセルのバイト数
+ =======================================================================*/
+bool CRleReader::Open(FILE *fp, const uint64 offset, const uint32 byte)
+{
+	if (m_pBuf == NULL && (m_pBuf = new uint8[CTgaLarge::READ_BUFFER_SIZE]) == NULL) return false;
+	if (!MtoFileSeek(fp, static_cast<long long>(offset), SEEK_SET)) return false;
+
+	m_fp     = fp;
+	m_Size   = 0;
+	m_Pos    = 0;
+	m_Byte   = byte;
+	m_Remain = 0;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】バッファを通して読み込む
+【引数】pDst：格納先
+        size：バイト数
+ =======================================================================*/
+bool CRleReader::ReadByte(uint8 *pDst, uint32 size)
+{
+	while (size > 0) {
+		if (m_Pos == m_Size) {
+			m_Size = static_cast<uint32>(fread(m_pBuf, 1, CTgaLarge::READ_BUFFER_SIZE, m_fp));
+			m_Pos  = 0;
+			if (m_Size == 0) return false;
+		}
+
+		uint32 n = m_Size - m_Pos;
+		if (n > size) n = size;
+
+		memcpy(pDst, &m_pBuf[m_Pos], n);
+		m_Pos += n;
+		pDst  += n;
+		size  -= n;
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】続きを展開
+【引数】pDst：展開先
+        num ：ピクセル数
+【戻値】false：データが足りない
+ =======================================================================*/
+bool CRleReader::Read(uint8 *pDst, const uint32 num)
+{
+	uint32 i = 0;
+
+	while (i < num) {
+		// 次のパケット
+		if (m_Remain == 0) {
+			uint8 c;
+			if (!this->ReadByte(&c, 1)) return false;
+
+			m_bRepeat = (c & 0x80) ? true : false;
+			m_Remain  = (c & 0x7f) + 1;
+			if (m_bRepeat && !this->ReadByte(m_Pixel, m_Byte)) return false;
+		}
+
+		uint32 n = num - i;
+		if (n > m_Remain) n = m_Remain;
+
+		if (m_bRepeat) {
+			TgaKernelFill(&pDst[i * m_Byte], m_Pixel, n, m_Byte);
+		} else if (!this->ReadByte(&pDst[i * m_Byte], n * m_Byte)) {
+			return false;
+		}
+
+		i += n;
+		m_Remain -= n;
+	}
+
+	return true;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTgaLarge::CTgaLarge(void)
+{
+	m_pFileName   = NULL;
+	m_pPalette    = NULL;
+	m_PaletteSize = 0;
+	m_ImageOffset = 0;
+	m_ImageSize   = 0;
+
+	m_Type        = CTga::IMAGE_LINE_LRDU;
+	m_bRGBA       = false;
+	m_bRLE        = false;
+	m_MemoryLimit = MEMORY_LIMIT_DEFAULT;
+
+	memset(&m_Header, 0, sizeof(m_Header));
+	memset(&m_Footer, 0, sizeof(m_Footer));
+}
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTgaLarge::~CTgaLarge(void)
+{
+	this->Close();
+}
+
+/*=======================================================================
+【機能】ファイルを開く
+【引数】pFileName：ファイル名
+【戻値】エラータイプ(CTgaと同じ)
+【備考】ヘッダーとパレットだけ読み込み、イメージはOutputで読み込みます。
+        出力の設定は元ファイルと同じ(並び、RLE圧縮の有無)に戻ります。
+ =======================================================================*/
+int CTgaLarge::Open(const char *pFileName)
+{
+	this->Close();
+
+	if (pFileName == NULL) return CTga::ERROR_OPEN;
+
+	MtoFileStatus status;
+	FILE *fp;
+
+	if (!MtoFileGetStatus(pFileName, &status) || (fp = fopen(pFileName, "rb")) == NULL) {
+		return CTga::ERROR_OPEN;
+	}
+
+	uint8 head[CTga::HEADER_SIZE];
+	int ret = CTga::ERROR_NONE;
+	CTga tga;
+
+	// ヘッダーの読み込みと対応チェックはCTgaと共通
+	if (fread(head, CTga::HEADER_SIZE, 1, fp) != 1 || !tga.ReadHeader(head)) {
+		ret = CTga::ERROR_HEADER;
+	} else {
+		m_Header = tga.m_Header;
+
+		const uint32 byte   = m_Header.imageBit >> 3;
+		const uint32 type   = m_Header.imageType & ~8;
+		const bool   bIndex = (type == CTga::IMAGE_TYPE_INDEX);
+
+		m_PaletteSize = m_Header.usePalette * m_Header.paletteColor * (m_Header.paletteBit >> 3);
+		m_ImageOffset = CTga::HEADER_SIZE + m_Header.IDField + m_PaletteSize;
+
+		// 65535x65535x32bitは32bitに収まらないので64bitで求める
+		m_ImageSize = static_cast<uint64>(m_Header.imageW) * m_Header.imageH * byte;
+
+		if (bIndex && (m_PaletteSize == 0 || (m_Header.paletteBit != 24 && m_Header.paletteBit != 32))) {
+			ret = CTga::ERROR_PALETTE;
+		} else if (m_PaletteSize != 0) {
+			if ((m_pPalette = new uint8[m_PaletteSize]) == NULL) {
+				ret = CTga::ERROR_MEMORY;
+			} else if (!MtoFileSeek(fp, CTga::HEADER_SIZE + m_Header.IDField, SEEK_SET) || fread(m_pPalette, m_PaletteSize, 1, fp) != 1) {
+				ret = CTga::ERROR_PALETTE;
+			}
+		}
+
+		// 非圧縮ならイメージのサイズも確認しておく
+		if (ret == CTga::ERROR_NONE && !this->IsRLE() && status.size < m_ImageOffset + m_ImageSize) {
+			ret = CTga::ERROR_IMAGE;
+		}
+
+		// フッター(署名があるものだけ)
+		uint8 foot[CTga::FOOTER_SIZE];
+
+		if (ret == CTga::ERROR_NONE && status.size >= m_ImageOffset + CTga::FOOTER_SIZE &&
+			MtoFileSeek(fp, static_cast<long long>(status.size - CTga::FOOTER_SIZE), SEEK_SET) &&
+			fread(foot, CTga::FOOTER_SIZE, 1, fp) == 1 &&
+			memcmp(&foot[FOOTER_SIGNATURE], "TRUEVISION-", 11) == 0) {
+			tga.ReadFooter(foot, 0);
+			m_Footer = tga.m_Footer;
+		}
+	}
+	fclose(fp);
+
+	if (ret == CTga::ERROR_NONE) {
+		const size_t len = strlen(pFileName);
+		if ((m_pFileName = new char[len + 1]) == NULL) {
+			ret = CTga::ERROR_MEMORY;
+		} else {
+			memcpy(m_pFileName, pFileName, len + 1);
+		}
+	}
+
+	if (ret != CTga::ERROR_NONE) {
+		this->Close();
+		return ret;
+	}
+
+	m_Type  = m_Header.discripter & 0x30;
+	m_bRGBA = false;
+	m_bRLE  = this->IsRLE();
+
+	return CTga::ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】ファイルを閉じる
+ =======================================================================*/
+void CTgaLarge::Close(void)
+{
+	SAFE_DELETES(m_pFileName);
+	SAFE_DELETES(m_pPalette);
+
+	m_PaletteSize = 0;
+	m_ImageOffset = 0;
+	m_ImageSize   = 0;
+
+	memset(&m_Header, 0, sizeof(m_Header));
+	memset(&m_Footer, 0, sizeof(m_Footer));
+}
+
+/*=======================================================================
+【機能】BGRA配列をRGBA配列に変更して出力する
+【備考】再度呼ぶとBGRA配列に戻ります。
+ =======================================================================*/
+bool CTgaLarge::ConvertRGBA(void)
+{
+	if (m_pFileName == NULL) return false;
+
+	m_bRGBA = !m_bRGBA;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】指定のビット配列に変換して出力する
+【引数】type：ラインタイプ
+ =======================================================================*/
+bool CTgaLarge::ConvertType(const sint32 type)
+{
+	if (m_pFileName == NULL) return false;
+	if (type < 0 || type >= CTga::IMAGE_LINE_MAX || (type & 0x0f) != 0) return false;
+
+	m_Type = type;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】変換してファイル出力
+【引数】pFileName：ファイル名(元ファイルとは別のファイル)
+【戻値】エラータイプ(CTgaと同じ)
+【備考】作業メモリの上限に収まるライン数ずつ、読み込み→変換→書き込みを繰り返す。
+        上下反転する時は元ファイルの後ろの帯から読む。
+        RLE圧縮された元ファイルは後ろから読めないので、上下反転する時だけ
+        一時ファイルに展開してから読む(作業メモリは増えない)。
+        IDフィールドとエクステンションエリアは出力しません。
+ =======================================================================*/
+int CTgaLarge::Output(const char *pFileName)
+{
+	if (m_pFileName == NULL || pFileName == NULL) return CTga::ERROR_OUTPUT;
+
+	const uint32 w       = m_Header.imageW;
+	const uint32 h       = m_Header.imageH;
+	const uint32 byte    = m_Header.imageBit >> 3;
+	const uint32 line    = w * byte;
+	const uint32 worst   = line + w;			// RLE圧縮した1ラインの最大サイズ
+	const bool   bFlipX  = ((m_Header.discripter & 0x10) != (m_Type & 0x10));
+	const bool   bFlipY  = ((m_Header.discripter & 0x20) != (m_Type & 0x20));
+	const bool   bSrcRLE = this->IsRLE();
+
+	// 1つの帯のライン数(読み込み、並び替え、RLE圧縮の3つ分が上限に収まるように)
+	uint32 bandLine = (line != 0) ? m_MemoryLimit / (line * 2 + (m_bRLE ? worst : 0)) : h;
+	if (bandLine == 0) bandLine = 1;
+	if (bandLine > h) bandLine = h;
+
+	FILE *fpSrc, *fpDst;
+
+	if ((fpSrc = fopen(m_pFileName, "rb")) == NULL) {
+		return CTga::ERROR_OPEN;
+	}
+	if ((fpDst = fopen(pFileName, "wb")) == NULL) {
+		fclose(fpSrc);
+		return CTga::ERROR_OPEN;
+	}
+
+	uint8 *pBand     = NULL;
+	uint8 *pWork     = NULL;
+	uint8 *pPack     = NULL;
+	uint32 *pPackSize = NULL;
+	int ret = CTga::ERROR_NONE;
+
+	if (bandLine != 0) {
+		pBand     = new uint8[bandLine * line];
+		pWork     = new uint8[bandLine * line];
+		pPack     = m_bRLE ? new uint8[bandLine * worst] : NULL;
+		pPackSize = new uint32[bandLine];
+		if (pBand == NULL || pWork == NULL || (m_bRLE && pPack == NULL) || pPackSize == NULL) {
+			ret = CTga::ERROR_MEMORY;
+		}
+	}
+
+	// 元のイメージの読み込み方
+	FILE *fpRead = fpSrc;
+	FILE *fpTmp  = NULL;
+	uint64 offset = m_ImageOffset;
+	CRleReader reader;
+
+	if (ret == CTga::ERROR_NONE && bandLine != 0 && bSrcRLE) {
+		if (bFlipY) {
+			// 上下反転するなら一時ファイルに展開しておく
+			if ((fpTmp = tmpfile()) == NULL) {
+				ret = CTga::ERROR_OUTPUT;
+			} else {
+				ret = this->Unpack(fpSrc, fpTmp, pBand, bandLine);
+			}
+			fpRead = fpTmp;
+			offset = 0;
+		} else if (!reader.Open(fpSrc, m_ImageOffset, byte)) {
+			ret = CTga::ERROR_MEMORY;
+		}
+	}
+
+	// ヘッダー、パレット
+	if (ret == CTga::ERROR_NONE) {
+		CTga tga;
+		CTga::TGAHeader header = m_Header;
+
+		header.IDField    = 0;
+		header.discripter = static_cast<uint8>((m_Header.discripter & 0x0f) | m_Type);
+		if (m_bRLE != bSrcRLE) {
+			header.imageType = static_cast<uint8>(m_bRLE ? (header.imageType + 8) : (header.imageType - 8));
+		}
+		tga.WriteHeader(fpDst, &header);
+
+		if (m_PaletteSize != 0) {
+			uint8 *pPalette = new uint8[m_PaletteSize];
+
+			if (pPalette == NULL) {
+				ret = CTga::ERROR_MEMORY;
+			} else {
+				memcpy(pPalette, m_pPalette, m_PaletteSize);
+				if (m_bRGBA) SwapRB(pPalette, m_PaletteSize / (m_Header.paletteBit >> 3), m_Header.paletteBit >> 3);
+				fwrite(pPalette, m_PaletteSize, 1, fpDst);
+				SAFE_DELETES(pPalette);
+			}
+		}
+	}
+
+	// イメージ(帯ごと)
+	for (uint32 y = 0; ret == CTga::ERROR_NONE && y < h; y += bandLine) {
+		const uint32 num = (h - y < bandLine) ? (h - y) : bandLine;
+
+		if (bSrcRLE && !bFlipY) {
+			if (!reader.Read(pBand, num * w)) ret = CTga::ERROR_IMAGE;
+		} else {
+			// 上下反転なら後ろの帯から
+			const uint64 sy = bFlipY ? (h - y - num) : y;
+			if (!MtoFileSeek(fpRead, static_cast<long long>(offset + sy * line), SEEK_SET) || fread(pBand, num * line, 1, fpRead) != 1) {
+				ret = CTga::ERROR_IMAGE;
+			}
+		}
+		if (ret != CTga::ERROR_NONE) break;
+
+		// 並び替え、RGBA変換、RLE圧縮
+#pragma omp parallel for
+		for (sint32 i = 0; i < static_cast<sint32>(num); i++) {
+			const uint8 *pSrc = &pBand[(bFlipY ? (num - i - 1) : i) * line];
+			uint8 *pDst = &pWork[i * line];
+
+			if (bFlipX) {
+				TgaKernelReverse(pDst, pSrc, w, byte);
+			} else {
+				memcpy(pDst, pSrc, line);
+			}
+			if (m_bRGBA && m_Header.imageType != CTga::IMAGE_TYPE_INDEX && m_Header.imageType != CTga::IMAGE_TYPE_INDEX_RLE) {
+				SwapRB(pDst, w, byte);
+			}
+			if (m_bRLE) {
+				pPackSize[i] = TgaKernelPackRLE(&pPack[i * worst], pDst, w, byte);
+			}
+		}
+
+		// 書き込み
+		if (m_bRLE) {
+			for (uint32 i = 0; i < num; i++) {
+				fwrite(&pPack[i * worst], pPackSize[i], 1, fpDst);
+			}
+		} else {
+			fwrite(pWork, num * line, 1, fpDst);
+		}
+		if (ferror(fpDst)) ret = CTga::ERROR_OUTPUT;
+	}
+
+	// フッター(元ファイルのものをそのまま、CTgaのOutputと同じ)
+	if (ret == CTga::ERROR_NONE) {
+		CTga tga;
+		CTga::TGAFooter footer = m_Footer;
+
+		tga.WriteFooter(fpDst, &footer);
+		if (ferror(fpDst)) ret = CTga::ERROR_OUTPUT;
+	}
+
+	if (fpTmp != NULL) fclose(fpTmp);
+	fclose(fpSrc);
+	if (fclose(fpDst) != 0 && ret == CTga::ERROR_NONE) ret = CTga::ERROR_OUTPUT;
+
+	SAFE_DELETES(pBand);
+	SAFE_DELETES(pWork);
+	SAFE_DELETES(pPack);
+	SAFE_DELETES(pPackSize);
+
+	return ret;
+}
+
+/*=======================================================================
+【機能】RLE圧縮されたイメージをすべて展開してファイルに書き込む
+【引数】fpSrc   ：元ファイル
+        fpDst   ：書き込み先
+        pWork   ：作業領域(bandLineライン分)
+        bandLine：1回に展開するライン数
+【戻値】エラータイプ
+【備考】非公開
+ =======================================================================*/
+int CTgaLarge::Unpack(FILE *fpSrc, FILE *fpDst, uint8 *pWork, const uint32 bandLine) const
+{
+	const uint32 w    = m_Header.imageW;
+	const uint32 h    = m_Header.imageH;
+	const uint32 byte = m_Header.imageBit >> 3;
+	CRleReader reader;
+
+	if (!reader.Open(fpSrc, m_ImageOffset, byte)) return CTga::ERROR_MEMORY;
+
+	for (uint32 y = 0; y < h; y += bandLine) {
+		const uint32 num = (h - y < bandLine) ? (h - y) : bandLine;
+
+		if (!reader.Read(pWork, num * w)) return CTga::ERROR_IMAGE;
+		if (fwrite(pWork, num * w * byte, 1, fpDst) != 1) return CTga::ERROR_OUTPUT;
+	}
+
+	return CTga::ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】元ファイルはRLE圧縮？
+【備考】非公開
+ =======================================================================*/
+bool CTgaLarge::IsRLE(void) const
+{
+	return (CTga::IMAGE_TYPE_INDEX_RLE <= m_Header.imageType && m_Header.imageType < CTga::IMAGE_TYPE_RLE_MAX);
+}
@@ -0,0 +1,62 @@
+/*=============================================================================
+ * 大きなTGAのファイル間変換
+ * メモリに載せきれない画像(65535x65535x32bitなど)を、ラインの帯ごとに
+ * 読み込んで、並びの変換、RGBA変換、RLE圧縮/展開をしながら出力します。
+ * 作業メモリはsetMemoryLimitで指定した大きさまでしか使いません。
+ * mto_file.h、mto_common.h、tga.hの順にインクルードしてから使用してください。
+=============================================================================*/
+#ifndef _TGA_LARGE_H_
+#define _TGA_LARGE_H_
+
+class CTgaLarge {
+public:
+	enum {
+		MEMORY_LIMIT_DEFAULT = 64 * 1024 * 1024,	// 作業メモリの上限の初期値
+		READ_BUFFER_SIZE = 64 * 1024				// RLE展開の読み込みバッファ
+	};
+
+private:
+	char				*m_pFileName;	// 元ファイル名
+	CTga::TGAHeader		m_Header;		// 元ファイルのヘッダー
+	CTga::TGAFooter		m_Footer;		// 元ファイルのフッター(なければ0)
+	uint8				*m_pPalette;	// パレットデータ
+	uint32				m_PaletteSize;	// パレットデータサイズ
+	uint64				m_ImageOffset;	// 元ファイル内のイメージの位置
+	uint64				m_ImageSize;	// ピクセルデータサイズ(展開後)
+
+	sint32				m_Type;			// 出力するピクセルの並び
+	bool				m_bRGBA;		// RGBA配列で出力する？
+	bool				m_bRLE;			// RLE圧縮して出力する？
+	uint32				m_MemoryLimit;	// 作業メモリの上限
+
+	// コピー禁止
+	CTgaLarge(const CTgaLarge&);
+	CTgaLarge &operator=(const CTgaLarge&);
+
+private:
+	bool IsRLE(void) const;
+	int  Unpack(FILE *fpSrc, FILE *fpDst, uint8 *pWork, const uint32 bandLine) const;
+
+public:
+	CTgaLarge(void);
+	virtual ~CTgaLarge(void);
+
+	uint16 getWidth(void)       const {return m_Header.imageW;}
+	uint16 getHeight(void)      const {return m_Header.imageH;}
+	uint8  getImageBit(void)    const {return m_Header.imageBit;}
+	uint64 getImageSize(void)   const {return m_ImageSize;}
+	uint32 getMemoryLimit(void) const {return m_MemoryLimit;}
+	CTga::TGAHeader getHeader(void) const {return m_Header;}
+	CTga::TGAFooter getFooter(void) const {return m_Footer;}
+
+	void setMemoryLimit(const uint32 size) {m_MemoryLimit = size;}
+	void setRLE(const bool bRLE) {m_bRLE = bRLE;}
+
+	int  Open(const char *pFileName);
+	void Close(void);
+	bool ConvertRGBA(void);
+	bool ConvertType(const sint32 type);
+	int  Output(const char *pFileName);
+};
+
+#endif
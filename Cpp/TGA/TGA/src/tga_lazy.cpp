@@ -0,0 +1,206 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+
+
+/*=======================================================================
+【機能】遅延デコードの情報
+【備考】他のスレッドがロックを待っているかもしれないので、デコード後も
+        破棄しない。デコード後はフラグだけ見てロックしない。
+ =======================================================================*/
+struct CTga::TGALazy {
+	CMtoMutex		mutex;			// デコード中はロックする
+	CMtoFlag		decoded;		// デコード済み？(errorを書いてからSetする)
+	char			*pFileName;		// 読み込むファイル名(ファイルから作成した場合)
+	MtoFileStatus	status;			// 作成時のファイルの状態
+	uint8			*pSource;		// 画像データのコピー(メモリから作成した場合)
+	uint32			size;			// 画像データサイズ
+	int				error;			// デコード結果
+};
+
+
+/*=======================================================================
+【機能】遅延デコードで作成
+【引数】pFileName：ファイル名(メモリから作成する場合はNULL)
+        pSrc     ：画像データアドレス
+        size     ：画像データサイズ
+【戻値】エラータイプ
+【備考】非公開
+        ヘッダーとパレットだけ読み込んで、イメージはDecodeで読み込む。
+        ファイルの場合はイメージ部分を読まず、メモリの場合はコピーしておく。
+ =======================================================================*/
+int CTga::CreateLazy(const char *pFileName, const void *pSrc, const uint32 size)
+{
+	// 既に作成しているなら削除
+	if (m_pImage != NULL || m_pLazy != NULL) {
+		this->Clear();
+	}
+
+	if ((m_pLazy = new TGALazy) == NULL) return ERROR_MEMORY;
+	m_pLazy->pFileName = NULL;
+	m_pLazy->pSource   = NULL;
+	m_pLazy->size      = size;
+	m_pLazy->error     = ERROR_NONE;
+
+	uint8 head[HEADER_SIZE];
+	uint8 *pInfo = NULL;			// ヘッダーからパレットまで
+	uint32 infoSize;
+	int ret = ERROR_NONE;
+
+	if (pFileName != NULL) {
+		// ファイルから(ヘッダーからパレットまでだけ読む)
+		FILE *fp = NULL;
+
+		if (!MtoFileGetStatus(pFileName, &m_pLazy->status) || m_pLazy->status.size > 0xffffffffULL || (fp = fopen(pFileName, "rb")) == NULL) {
+			this->Clear();
+			return ERROR_OPEN;
+		}
+		m_pLazy->size = static_cast<uint32>(m_pLazy->status.size);
+
+		if (fread(head, HEADER_SIZE, 1, fp) != 1 || !this->ReadHeader(head)) {
+			ret = ERROR_HEADER;
+		} else if (!this->CalcSize(false)) {
+			ret = ERROR_MEMORY;
+		} else {
+			infoSize = HEADER_SIZE + m_Header.IDField + m_PaletteSize;
+			if ((pInfo = new uint8[infoSize]) == NULL) {
+				ret = ERROR_MEMORY;
+			} else {
+				memcpy(pInfo, head, HEADER_SIZE);
+				if (infoSize > HEADER_SIZE && fread(&pInfo[HEADER_SIZE], infoSize - HEADER_SIZE, 1, fp) != 1) {
+					ret = ERROR_PALETTE;
+				}
+			}
+		}
+		fclose(fp);
+
+		if (ret == ERROR_NONE) {
+			const size_t len = strlen(pFileName);
+			if ((m_pLazy->pFileName = new char[len + 1]) == NULL) {
+				ret = ERROR_MEMORY;
+			} else {
+				memcpy(m_pLazy->pFileName, pFileName, len + 1);
+			}
+		}
+	} else {
+		// メモリから(全体をコピーしておく)
+		if (size < HEADER_SIZE || !this->ReadHeader(static_cast<const uint8*>(pSrc))) {
+			ret = ERROR_HEADER;
+		} else if (!this->CalcSize(false)) {
+			ret = ERROR_MEMORY;
+		} else if ((infoSize = HEADER_SIZE + m_Header.IDField + m_PaletteSize) > size) {
+			ret = ERROR_PALETTE;
+		} else if ((m_pLazy->pSource = new uint8[size]) == NULL) {
+			ret = ERROR_MEMORY;
+		} else {
+			memcpy(m_pLazy->pSource, pSrc, size);
+		}
+	}
+
+	if (ret == ERROR_NONE) {
+		// 非圧縮ならイメージのサイズも確認しておく
+		if (!this->isRLE() && m_pLazy->size - infoSize < m_ImageSize) {
+			ret = ERROR_IMAGE;
+		} else if (m_Header.usePalette && (m_pPalette = new uint8[m_PaletteSize]) == NULL) {
+			ret = ERROR_MEMORY;
+		} else if (!this->ReadPalette((pInfo != NULL) ? pInfo : m_pLazy->pSource)) {
+			ret = ERROR_PALETTE;
+		}
+	}
+
+	SAFE_DELETES(pInfo);
+
+	if (ret != ERROR_NONE) {
+		this->Clear();
+		return ret;
+	}
+
+	m_bPremultiplied = (m_CreateFlag & CREATE_FLAG_PREMULTIPLY) ? true : false;
+
+	return ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】遅延デコード
+【戻値】true：デコード済み
+【備考】非公開(Decodeから呼ばれる)
+        複数のスレッドから呼ばれても、デコードは1回だけ行う。
+        ファイルが作成時から更新されていたら失敗します。
+ =======================================================================*/
+bool CTga::DecodeLazy(void) const
+{
+	CTga *pThis = const_cast<CTga*>(this);
+	TGALazy *pLazy = m_pLazy;
+
+	// デコード済みならロックしない
+	if (pLazy->decoded.Get()) return (pLazy->error == ERROR_NONE);
+
+	CMtoLock lock(pLazy->mutex);
+
+	if (pLazy->decoded.Get()) return (pLazy->error == ERROR_NONE);
+
+	uint8 *pSrc = pLazy->pSource;
+	uint8 *pFile = NULL;
+
+	// ファイルから読み込み
+	if (pSrc == NULL) {
+		MtoFileStatus status;
+		FILE *fp;
+
+		if (!MtoFileGetStatus(pLazy->pFileName, &status) || status.size != pLazy->status.size || status.time != pLazy->status.time) {
+			pLazy->error = ERROR_OPEN;
+		} else if (MtoFileOpen(&fp, pLazy->pFileName, "rb") != pLazy->size) {
+			if (fp != NULL) fclose(fp);
+			pLazy->error = ERROR_OPEN;
+		} else {
+			if ((pFile = new uint8[pLazy->size]) == NULL) {
+				pLazy->error = ERROR_MEMORY;
+			} else if (fread(pFile, pLazy->size, 1, fp) != 1) {
+				pLazy->error = ERROR_OPEN;
+			}
+			fclose(fp);
+		}
+		pSrc = pFile;
+	}
+
+	// イメージ読み込み
+	if (pLazy->error == ERROR_NONE) {
+		uint32 offset;
+
+		if ((pThis->m_pImage = new uint8[m_ImageSize]) == NULL) {
+			pLazy->error = ERROR_MEMORY;
+		} else if (!pThis->ReadImage(pSrc, pLazy->size, &offset)) {
+			SAFE_DELETES(pThis->m_pImage);
+			pLazy->error = ERROR_IMAGE;
+		} else {
+			// フッター読み込み
+			offset += HEADER_SIZE + m_Header.IDField + m_PaletteSize;
+			if ((pLazy->size - offset) >= FOOTER_SIZE) {
+				pThis->ReadFooter(pSrc, offset);
+			}
+		}
+	}
+
+	// 元データはもう不要
+	SAFE_DELETES(pFile);
+	SAFE_DELETES(pLazy->pSource);
+	SAFE_DELETES(pLazy->pFileName);
+
+	pLazy->decoded.Set();
+
+	return (pLazy->error == ERROR_NONE);
+}
+
+/*=======================================================================
+【機能】遅延デコードの情報を破棄
+【備考】非公開
+ =======================================================================*/
+void CTga::ClearLazy(void)
+{
+	if (m_pLazy == NULL) return;
+
+	SAFE_DELETES(m_pLazy->pSource);
+	SAFE_DELETES(m_pLazy->pFileName);
+	SAFE_DELETE(m_pLazy);
+}
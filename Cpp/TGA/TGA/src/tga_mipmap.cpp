@@ -0,0 +1,466 @@
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+
+#ifdef _USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+enum {
+	LINEAR_BIT   = 16,						// リニア値のビット数
+	SRGB_LUT_BIT = 12,						// リニア→sRGBテーブルのビット数
+	COVERAGE_REF = 128,						// カバレッジを求めるアルファの閾値
+	COVERAGE_LOOP = 10						// カバレッジの倍率を求める回数
+};
+
+/*=======================================================================
+【機能】sRGB変換テーブル
+【備考】ガンマ補正フィルタ用。最初に使う時に作成。
+        関数内のstaticの初期化はVS2008ではスレッドセーフではないので、
+        並列処理に入る前に取得すること。
+ =======================================================================*/
+struct GammaTable {
+	uint16	toLinear[256];						// sRGB→リニア(16bit)
+	uint8	toSRGB[1 << SRGB_LUT_BIT];			// リニア(12bit)→sRGB
+
+	GammaTable(void)
+	{
+		for (sint32 i = 0; i < 256; i++) {
+			double c = i / 255.0;
+			c = (c <= 0.04045) ? (c / 12.92) : pow((c + 0.055) / 1.055, 2.4);
+			toLinear[i] = static_cast<uint16>(c * 65535.0 + 0.5);
+		}
+		for (sint32 i = 0; i < (1 << SRGB_LUT_BIT); i++) {
+			double c = (i + 0.5) / (1 << SRGB_LUT_BIT);
+			c = (c <= 0.0031308) ? (c * 12.92) : (1.055 * pow(c, 1.0 / 2.4) - 0.055);
+			toSRGB[i] = static_cast<uint8>(c * 255.0 + 0.5);
+		}
+	}
+};
+
+const GammaTable &GetGammaTable(void)
+{
+	static const GammaTable table;
+	return table;
+}
+
+/*=======================================================================
+【機能】1ライン縮小(8bit)
+【引数】pDst ：縮小先
+        pSrc0：上のライン
+        pSrc1：下のライン
+        w    ：縮小後の幅
+ =======================================================================*/
+void ReduceLine8(uint8 *pDst, const uint8 *pSrc0, const uint8 *pSrc1, const uint32 w)
+{
+	uint32 x = 0;
+
+#ifdef _USE_SSE2
+	if (TgaKernelGetLevel() >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one  = _mm_set1_epi16(1);
+		const __m128i two  = _mm_set1_epi32(2);
+
+		// 16ピクセル→8ピクセル
+		for (; x + 8 <= w; x += 8) {
+			__m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSrc0[x * 2]));
+			__m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSrc1[x * 2]));
+			__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(s0, zero), _mm_unpacklo_epi8(s1, zero));
+			__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(s0, zero), _mm_unpackhi_epi8(s1, zero));
+
+			// 横2ピクセルの合計
+			lo = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(lo, one), two), 2);
+			hi = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(hi, one), two), 2);
+
+			__m128i v = _mm_packs_epi32(lo, hi);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(&pDst[x]), _mm_packus_epi16(v, v));
+		}
+	}
+#endif
+
+	for (; x < w; x++) {
+		pDst[x] = static_cast<uint8>((pSrc0[x * 2] + pSrc0[x * 2 + 1] + pSrc1[x * 2] + pSrc1[x * 2 + 1] + 2) >> 2);
+	}
+}
+
+/*=======================================================================
+【機能】1ライン縮小(16bit ARGB:1555)
+【引数】pDst ：縮小先
+        pSrc0：上のライン
+        pSrc1：下のライン
+        w    ：縮小後の幅
+【備考】アルファは4ピクセル中2ピクセル以上が1なら1にする。
+ =======================================================================*/
+void ReduceLine16(uint16 *pDst, const uint16 *pSrc0, const uint16 *pSrc1, const uint32 w)
+{
+	uint32 x = 0;
+
+#ifdef _USE_SSE2
+	if (TgaKernelGetLevel() >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i one  = _mm_set1_epi16(1);
+		const __m128i two  = _mm_set1_epi32(2);
+		const __m128i mask = _mm_set1_epi16(0x1f);
+
+		// 8ピクセル→4ピクセル
+		for (; x + 4 <= w; x += 4) {
+			__m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSrc0[x * 2]));
+			__m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSrc1[x * 2]));
+			__m128i c[4];
+
+			c[0] = _mm_add_epi16(_mm_and_si128(s0, mask), _mm_and_si128(s1, mask));
+			c[1] = _mm_add_epi16(_mm_and_si128(_mm_srli_epi16(s0, 5), mask), _mm_and_si128(_mm_srli_epi16(s1, 5), mask));
+			c[2] = _mm_add_epi16(_mm_and_si128(_mm_srli_epi16(s0, 10), mask), _mm_and_si128(_mm_srli_epi16(s1, 10), mask));
+			c[3] = _mm_add_epi16(_mm_srli_epi16(s0, 15), _mm_srli_epi16(s1, 15));
+
+			// 横2ピクセルの合計
+			__m128i b = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(c[0], one), two), 2);
+			__m128i g = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(c[1], one), two), 2);
+			__m128i r = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(c[2], one), two), 2);
+			__m128i a = _mm_srli_epi32(_mm_madd_epi16(c[3], one), 1);
+			a = _mm_min_epi16(a, _mm_set1_epi32(1));
+
+			__m128i v = _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 5)), _mm_or_si128(_mm_slli_epi32(r, 10), _mm_slli_epi32(a, 15)));
+
+			// 32bit→16bit(符号付きで詰めると0x8000以上が飽和するので、ずらしてから詰める)
+			v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+			v = _mm_packs_epi32(v, v);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(&pDst[x]), v);
+		}
+	}
+#endif
+
+	for (; x < w; x++) {
+		uint16 p[4] = {pSrc0[x * 2], pSrc0[x * 2 + 1], pSrc1[x * 2], pSrc1[x * 2 + 1]};
+		uint32 b = 0, g = 0, r = 0, a = 0;
+
+		for (sint32 i = 0; i < 4; i++) {
+			b += p[i] & 0x1f;
+			g += (p[i] >> 5) & 0x1f;
+			r += (p[i] >> 10) & 0x1f;
+			a += p[i] >> 15;
+		}
+		pDst[x] = static_cast<uint16>(((b + 2) >> 2) | (((g + 2) >> 2) << 5) | (((r + 2) >> 2) << 10) | ((a >= 2) ? 0x8000 : 0));
+	}
+}
+
+/*=======================================================================
+【機能】1ライン縮小(24bit)
+【引数】pDst ：縮小先
+        pSrc0：上のライン
+        pSrc1：下のライン
+        w    ：縮小後の幅
+ =======================================================================*/
+void ReduceLine24(uint8 *pDst, const uint8 *pSrc0, const uint8 *pSrc1, const uint32 w)
+{
+	for (uint32 x = 0; x < w; x++) {
+		const uint8 *s0 = &pSrc0[x * 6];
+		const uint8 *s1 = &pSrc1[x * 6];
+
+		pDst[x * 3 + 0] = static_cast<uint8>((s0[0] + s0[3] + s1[0] + s1[3] + 2) >> 2);
+		pDst[x * 3 + 1] = static_cast<uint8>((s0[1] + s0[4] + s1[1] + s1[4] + 2) >> 2);
+		pDst[x * 3 + 2] = static_cast<uint8>((s0[2] + s0[5] + s1[2] + s1[5] + 2) >> 2);
+	}
+}
+
+/*=======================================================================
+【機能】1ライン縮小(32bit)
+【引数】pDst ：縮小先
+        pSrc0：上のライン
+        pSrc1：下のライン
+        w    ：縮小後の幅
+ =======================================================================*/
+void ReduceLine32(uint8 *pDst, const uint8 *pSrc0, const uint8 *pSrc1, const uint32 w)
+{
+	uint32 x = 0;
+
+#ifdef _USE_SSE2
+	if (TgaKernelGetLevel() >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i two  = _mm_set1_epi16(2);
+
+		// 8ピクセル→4ピクセル
+		for (; x + 4 <= w; x += 4) {
+			__m128i v[2];
+
+			for (sint32 i = 0; i < 2; i++) {
+				__m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSrc0[(x + i * 2) * 8]));
+				__m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSrc1[(x + i * 2) * 8]));
+				__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(s0, zero), _mm_unpacklo_epi8(s1, zero));
+				__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(s0, zero), _mm_unpackhi_epi8(s1, zero));
+
+				// 横2ピクセルの合計(下位64bitに入る)
+				lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+				hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+				v[i] = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), two), 2);
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&pDst[x * 4]), _mm_packus_epi16(v[0], v[1]));
+		}
+	}
+#endif
+
+	for (; x < w; x++) {
+		const uint8 *s0 = &pSrc0[x * 8];
+		const uint8 *s1 = &pSrc1[x * 8];
+
+		for (sint32 c = 0; c < 4; c++) {
+			pDst[x * 4 + c] = static_cast<uint8>((s0[c] + s0[c + 4] + s1[c] + s1[c + 4] + 2) >> 2);
+		}
+	}
+}
+
+/*=======================================================================
+【機能】1ライン縮小(ガンマ補正 24bit/32bit)
+【引数】pDst ：縮小先
+        pSrc0：上のライン
+        pSrc1：下のライン
+        w    ：縮小後の幅
+        byte ：1ピクセルのバイト数
+        table：sRGB変換テーブル
+【備考】色はリニアに戻してから平均する。アルファはそのまま平均。
+ =======================================================================*/
+void ReduceLineGamma(uint8 *pDst, const uint8 *pSrc0, const uint8 *pSrc1, const uint32 w, const uint32 byte, const GammaTable &table)
+{
+	for (uint32 x = 0; x < w; x++) {
+		const uint8 *s0 = &pSrc0[x * byte * 2];
+		const uint8 *s1 = &pSrc1[x * byte * 2];
+
+		for (uint32 c = 0; c < 3; c++) {
+			uint32 sum = table.toLinear[s0[c]] + table.toLinear[s0[c + byte]] +
+						 table.toLinear[s1[c]] + table.toLinear[s1[c + byte]];
+			pDst[x * byte + c] = table.toSRGB[(sum + 2) >> (2 + LINEAR_BIT - SRGB_LUT_BIT)];
+		}
+		if (byte == 4) {
+			pDst[x * 4 + 3] = static_cast<uint8>((s0[3] + s0[7] + s1[3] + s1[7] + 2) >> 2);
+		}
+	}
+}
+
+/*=======================================================================
+【機能】アルファテストのカバレッジを求める
+【引数】pImage：32bitイメージ
+        pixel ：ピクセル数
+        scale ：アルファの倍率
+【戻値】閾値以上になるピクセルの割合
+ =======================================================================*/
+float CalcCoverage(const uint8 *pImage, const uint32 pixel, const float scale)
+{
+	const sint32 num = static_cast<sint32>(pixel);
+	sint32 count = 0;
+
+#pragma omp parallel for reduction(+:count)
+	for (sint32 i = 0; i < num; i++) {
+		if (pImage[i * 4 + 3] * scale >= COVERAGE_REF) count++;
+	}
+
+	return static_cast<float>(count) / pixel;
+}
+
+/*=======================================================================
+【機能】カバレッジが元画像と同じになるようにアルファを調整
+【引数】pImage  ：32bitイメージ
+        pixel   ：ピクセル数
+        coverage：元画像のカバレッジ
+ =======================================================================*/
+void FitCoverage(uint8 *pImage, const uint32 pixel, const float coverage)
+{
+	// 二分探索で倍率を求める
+	float lo = 0.0f, hi = 4.0f, scale = 1.0f;
+
+	for (sint32 loop = 0; loop < COVERAGE_LOOP; loop++) {
+		float cov = CalcCoverage(pImage, pixel, scale);
+		if (cov < coverage) {
+			lo = scale;
+		} else if (cov > coverage) {
+			hi = scale;
+		} else {
+			break;
+		}
+		scale = (lo + hi) * 0.5f;
+	}
+
+	const sint32 num = static_cast<sint32>(pixel);
+
+#pragma omp parallel for
+	for (sint32 i = 0; i < num; i++) {
+		float a = pImage[i * 4 + 3] * scale + 0.5f;
+		pImage[i * 4 + 3] = static_cast<uint8>((a > 255.0f) ? 255.0f : a);
+	}
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】1段階小さいミップマップを作成
+【引数】pMip  ：作成先
+        filter：フィルタ(MIPMAP_FILTER_*)
+【備考】8/16/24/32bitが対象です(インデックスカラーは非対応)。
+        幅・高さは半分(切り捨て、最小1)になります。
+        ガンマ補正/カバレッジ維持は24bit/32bit以外ではBOXと同じです。
+ =======================================================================*/
+bool CTga::CreateMipmap(CTga *pMip, const sint32 filter) const
+{
+	if (!this->Decode()) return false;
+
+	return this->CreateMipmap(pMip, filter, -1.0f);
+}
+
+bool CTga::CreateMipmap(CTga *pMip, const sint32 filter, const float coverage) const
+{
+	if (pMip == NULL || m_pImage == NULL) return false;
+	if (filter < 0 || filter >= MIPMAP_FILTER_MAX) return false;
+	if (m_Header.imageType == IMAGE_TYPE_INDEX || m_Header.imageType == IMAGE_TYPE_INDEX_RLE) return false;
+	if (m_Header.imageW <= 1 && m_Header.imageH <= 1) return false;
+
+	const uint32 srcW  = m_Header.imageW;
+	const uint32 srcH  = m_Header.imageH;
+	const uint32 dstW  = (srcW > 1) ? (srcW >> 1) : 1;
+	const uint32 dstH  = (srcH > 1) ? (srcH >> 1) : 1;
+	const uint32 byte  = m_Header.imageBit >> 3;
+	const uint32 size  = dstW * dstH * byte;
+	const sint32 lines = static_cast<sint32>(dstH);
+	uint8 *pImage;
+
+	if ((pImage = new uint8[size]) == NULL) return false;
+
+	// テーブルは並列処理の前に作成しておく
+	const GammaTable *pTable = (filter == MIPMAP_FILTER_GAMMA && byte >= 3) ? &GetGammaTable() : NULL;
+
+#pragma omp parallel
+	{
+		// 幅1の画像は横に2ピクセル並べた作業ラインで処理する
+		uint8 *pWork = (srcW == 1) ? new uint8[byte * 4] : NULL;
+
+#pragma omp for
+		for (sint32 y = 0; y < lines; y++) {
+			const uint8 *pSrc0 = &m_pImage[(y * 2) * srcW * byte];
+			const uint8 *pSrc1 = (srcH > 1) ? (pSrc0 + srcW * byte) : pSrc0;
+			uint8 *pDst = &pImage[y * dstW * byte];
+
+			if (pWork != NULL) {
+				memcpy(&pWork[0],        pSrc0, byte);
+				memcpy(&pWork[byte],     pSrc0, byte);
+				memcpy(&pWork[byte * 2], pSrc1, byte);
+				memcpy(&pWork[byte * 3], pSrc1, byte);
+				pSrc0 = &pWork[0];
+				pSrc1 = &pWork[byte * 2];
+			}
+
+			if (pTable != NULL) {
+				ReduceLineGamma(pDst, pSrc0, pSrc1, dstW, byte, *pTable);
+			} else {
+				switch (byte) {
+				case 1:
+					ReduceLine8(pDst, pSrc0, pSrc1, dstW);
+					break;
+				case 2:
+					ReduceLine16(reinterpret_cast<uint16*>(pDst), reinterpret_cast<const uint16*>(pSrc0), reinterpret_cast<const uint16*>(pSrc1), dstW);
+					break;
+				case 3:
+					ReduceLine24(pDst, pSrc0, pSrc1, dstW);
+					break;
+				case 4:
+					ReduceLine32(pDst, pSrc0, pSrc1, dstW);
+					break;
+				}
+			}
+		}
+
+		SAFE_DELETES(pWork);
+	}
+
+	// カバレッジ維持
+	if (filter == MIPMAP_FILTER_COVERAGE && byte == 4) {
+		float ref = (coverage < 0.0f) ? CalcCoverage(m_pImage, srcW * srcH, 1.0f) : coverage;
+		FitCoverage(pImage, dstW * dstH, ref);
+	}
+
+	TGAHeader header = m_Header;
+	header.imageW = static_cast<uint16>(dstW);
+	header.imageH = static_cast<uint16>(dstH);
+
+	if (pMip->Create(header, pImage, size, NULL, 0) != ERROR_NONE) {
+		SAFE_DELETES(pImage);
+		return false;
+	}
+	pMip->m_bPremultiplied = m_bPremultiplied;
+	pMip->m_bRGBA          = m_bRGBA;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】ミップマップを全段階作成
+【引数】pLevel  ：作成先の配列(pLevel[0]が1段階小さい画像)
+        levelMax：配列の数
+        filter  ：フィルタ(MIPMAP_FILTER_*)
+【戻値】作成した段階数(-1:失敗)
+【備考】1x1になるか、配列がいっぱいになるまで作成します。
+        カバレッジ維持は常にこの画像のカバレッジに合わせます。
+ =======================================================================*/
+sint32 CTga::CreateMipmapChain(CTga *pLevel, const sint32 levelMax, const sint32 filter) const
+{
+	if (!this->Decode()) return -1;
+	if (pLevel == NULL || m_pImage == NULL) return -1;
+
+	float coverage = -1.0f;
+	if (filter == MIPMAP_FILTER_COVERAGE && m_Header.imageBit == 32) {
+		coverage = CalcCoverage(m_pImage, m_Header.imageW * m_Header.imageH, 1.0f);
+	}
+
+	const CTga *pSrc = this;
+	sint32 level;
+
+	for (level = 0; level < levelMax; level++) {
+		if (pSrc->getWidth() <= 1 && pSrc->getHeight() <= 1) break;
+		if (!pSrc->CreateMipmap(&pLevel[level], filter, coverage)) return -1;
+		pSrc = &pLevel[level];
+	}
+
+	return level;
+}
+
+/*=======================================================================
+【機能】ミップマップをファイル出力
+【引数】pFileName：出力ファイル名(各段階は"名前_00.tga"のように番号を付けて出力)
+        filter   ：フィルタ(MIPMAP_FILTER_*)
+【戻値】エラータイプ
+【備考】_00がこの画像で、1x1まで出力します。
+ =======================================================================*/
+int CTga::OutputMipmap(const char *pFileName, const sint32 filter)
+{
+#ifndef NDEBUG
+	_ASSERT(pFileName != NULL);
+#else
+	if (pFileName == NULL) return ERROR_OUTPUT;
+#endif
+
+	if (!this->Decode()) return ERROR_IMAGE;
+	if (m_pImage == NULL) return ERROR_NONE;
+
+	// 拡張子を除いた名前
+	char base[_MAX_PATH];
+	const char *pExt = strrchr(pFileName, '.');
+	size_t len = (pExt != NULL) ? static_cast<size_t>(pExt - pFileName) : strlen(pFileName);
+	if (len + 8 >= sizeof(base)) return ERROR_OUTPUT;
+	memcpy(base, pFileName, len);
+	base[len] = '\0';
+
+	CTga level[MIPMAP_LEVEL_MAX];
+	sint32 num = this->CreateMipmapChain(level, MIPMAP_LEVEL_MAX, filter);
+	if (num < 0) return ERROR_MEMORY;
+
+	char name[_MAX_PATH + 16];
+	sprintf(name, "%s_%02d.tga", base, 0);
+	int ret = this->Output(name);
+
+	for (sint32 i = 0; i < num && ret == ERROR_NONE; i++) {
+		sprintf(name, "%s_%02d.tga", base, i + 1);
+		ret = level[i].Output(name);
+	}
+
+	return ret;
+}
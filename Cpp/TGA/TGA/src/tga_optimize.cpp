@@ -0,0 +1,336 @@
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+
+
+/*=======================================================================
+【機能】色の集合
+【備考】ANALYSIS_COLOR_MAX色までを登録順に持ち、ハッシュ表で引く。
+        インデックスカラーに変換する時はそのままパレットになる。
+ =======================================================================*/
+struct CTga::TGAColorSet {
+	enum {
+		SLOT_BIT = 10,
+		SLOT_NUM = 1 << SLOT_BIT		// ハッシュ表の大きさ(色数の4倍)
+	};
+
+	uint16	slot[SLOT_NUM];				// 色の番号+1(0なら空き)
+	uint32	color[ANALYSIS_COLOR_MAX];	// 登録した色(BGRA)
+	uint32	num;						// 登録した色数
+
+	void Clear(void)
+	{
+		memset(slot, 0, sizeof(slot));
+		num = 0;
+	}
+
+	static uint32 Hash(const uint32 c)
+	{
+		return (c * 0x9e3779b1U) >> (32 - SLOT_BIT);
+	}
+
+	// 色の番号(なければ-1)
+	sint32 Find(const uint32 c) const
+	{
+		for (uint32 i = Hash(c); slot[i] != 0; i = (i + 1) & (SLOT_NUM - 1)) {
+			if (color[slot[i] - 1] == c) return slot[i] - 1;
+		}
+		return -1;
+	}
+
+	// 登録(上限を超えたらfalse)
+	bool Insert(const uint32 c)
+	{
+		uint32 i = Hash(c);
+		for (; slot[i] != 0; i = (i + 1) & (SLOT_NUM - 1)) {
+			if (color[slot[i] - 1] == c) return true;
+		}
+		if (num >= ANALYSIS_COLOR_MAX) return false;
+
+		color[num] = c;
+		slot[i] = static_cast<uint16>(++num);
+		return true;
+	}
+};
+
+namespace {
+
+// 保存形式の候補
+enum {
+	FORMAT_32 = 0,		// 32bit
+	FORMAT_24,			// 24bit
+	FORMAT_16,			// 16bit(ARGB:1555)
+	FORMAT_INDEX,		// 256色
+	FORMAT_GRAY,		// 白黒
+	FORMAT_MAX
+};
+
+/*=======================================================================
+【機能】8bitを5bitに戻す
+【備考】c * 255 / 31 で展開した値は元の5bitに戻る。
+ =======================================================================*/
+MTOINLINE uint32 To5Bit(const uint32 c)
+{
+	return (c * 31 + 127) / 255;
+}
+
+/*=======================================================================
+【機能】32bit(BGRA)のピクセルをuint32で読む
+ =======================================================================*/
+MTOINLINE uint32 ReadPixel(const uint8 *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32>(p[3]) << 24);
+}
+
+}
+
+
+/*=======================================================================
+【機能】保存形式を決めるための解析
+【引数】pResult：結果
+【戻値】true:成功 / false:失敗(イメージなし)
+【備考】全ピクセルを1回読むだけで、アルファの種類、白黒か、
+        16bitで表せるか、色数(ANALYSIS_COLOR_MAXまで)を調べます。
+ =======================================================================*/
+bool CTga::Analyze(TGAAnalysis *pResult) const
+{
+	TGAColorSet set;
+
+	return this->Analyze(pResult, &set);
+}
+
+/*=======================================================================
+【機能】保存形式を決めるための解析
+【引数】pResult：結果
+        pSet   ：色の集合(色数が上限以下なら全部の色が入る)
+【戻値】true:成功 / false:失敗
+【備考】非公開
+        性質はカーネルでまとめて調べ、色数は前のピクセルと同じ色を飛ばしながら数える。
+        上限を超えたら色数は数えない。
+ =======================================================================*/
+bool CTga::Analyze(TGAAnalysis *pResult, TGAColorSet *pSet) const
+{
+#ifndef NDEBUG
+	_ASSERT(pResult != NULL && pSet != NULL);
+#else
+	if (pResult == NULL || pSet == NULL) return false;
+#endif
+
+	if (!this->Decode()) return false;
+	if (m_pImage == NULL) return false;
+
+	const sint32 w = m_Header.imageW;
+	const sint32 h = m_Header.imageH;
+
+	uint8 *pWork = new uint8[w * 4];
+	if (pWork == NULL) return false;
+
+	uint32 flag   = TGA_KERNEL_ANALYZE_ALL;
+	bool   bCount = true;
+	uint32 prev   = 0;
+
+	pSet->Clear();
+	if (w > 0 && h > 0) pSet->Insert(prev = ReadPixel(this->GetLine32(pWork, 0)));
+
+	for (sint32 y = 0; y < h; y++) {
+		const uint8 *pLine = this->GetLine32(pWork, y);
+
+		flag &= TgaKernelAnalyze32(pLine, w);
+
+		for (sint32 x = 0; x < w && bCount; x++) {
+			const uint32 c = ReadPixel(&pLine[x * 4]);
+			if (c == prev) continue;
+
+			bCount = pSet->Insert(c);
+			prev   = c;
+		}
+	}
+
+	SAFE_DELETES(pWork);
+
+	pResult->bOpaque      = (flag & TGA_KERNEL_ANALYZE_OPAQUE) ? true : false;
+	pResult->bBinaryAlpha = (flag & TGA_KERNEL_ANALYZE_BINARY) ? true : false;
+	pResult->bGray        = (flag & TGA_KERNEL_ANALYZE_GRAY)   ? true : false;
+	pResult->b5Bit        = (flag & TGA_KERNEL_ANALYZE_5BIT)   ? true : false;
+	pResult->colorNum     = bCount ? pSet->num : (ANALYSIS_COLOR_MAX + 1);
+
+	return true;
+}
+
+/*=======================================================================
+【機能】劣化しない一番小さい保存形式に変換
+【引数】pDst：変換先
+【戻値】true:成功 / false:失敗
+【備考】Analyzeの結果から、白黒、256色、16bit、24bit、32bitのうち
+        ピクセルが変わらずに一番小さくなるものを選びます。
+        選んだ形式でRLE圧縮した方が小さければRLE圧縮にします。
+        ピクセルの並びは元のまま、配列はBGRAになります。
+        アルファがなければイメージ記述子のアルファビット数は0にします。
+ =======================================================================*/
+bool CTga::Optimize(CTga *pDst) const
+{
+#ifndef NDEBUG
+	_ASSERT(pDst != NULL && pDst != this);
+#else
+	if (pDst == NULL || pDst == this) return false;
+#endif
+
+	TGAAnalysis info;
+	TGAColorSet set;
+
+	if (!this->Analyze(&info, &set)) return false;
+
+	const sint32 w     = m_Header.imageW;
+	const sint32 h     = m_Header.imageH;
+	const uint32 pixel = static_cast<uint32>(w) * h;
+
+	// 一番小さい形式を選ぶ
+	const uint32 palB = info.bOpaque ? 3 : 4;
+	sint32 format = FORMAT_32;
+	uint32 size   = pixel * 4;
+
+	if (info.bOpaque && pixel * 3 < size) {
+		format = FORMAT_24;
+		size   = pixel * 3;
+	}
+	if (info.b5Bit && (info.bOpaque || info.bBinaryAlpha) && pixel * 2 < size) {
+		format = FORMAT_16;
+		size   = pixel * 2;
+	}
+	if (info.colorNum <= ANALYSIS_COLOR_MAX && pixel + set.num * palB < size) {
+		format = FORMAT_INDEX;
+		size   = pixel + set.num * palB;
+	}
+	if (info.bGray && info.bOpaque && pixel <= size) {
+		format = FORMAT_GRAY;
+		size   = pixel;
+	}
+
+	static const uint8 s_Bit[FORMAT_MAX] = {32, 24, 16, 8, 8};
+	const uint32 byte  = s_Bit[format] >> 3;
+	const uint32 line  = w * byte;
+	const bool   bFlipX = (m_Header.discripter & 0x10) ? true : false;
+	const bool   bFlipY = (m_Header.discripter & 0x20) ? false : true;
+
+	// ヘッダー
+	TGAHeader header;
+	memset(&header, 0, sizeof(header));
+	header.imageW     = m_Header.imageW;
+	header.imageH     = m_Header.imageH;
+	header.imageBit   = s_Bit[format];
+	header.discripter = static_cast<uint8>(m_Header.discripter & 0x30);
+
+	switch (format) {
+	case FORMAT_INDEX:
+		header.usePalette   = 1;
+		header.imageType    = IMAGE_TYPE_INDEX;
+		header.paletteColor = static_cast<uint16>(set.num);
+		header.paletteBit   = static_cast<uint8>(palB << 3);
+		if (!info.bOpaque) header.discripter |= 8;
+		break;
+	case FORMAT_GRAY:
+		header.imageType = IMAGE_TYPE_GRAY;
+		break;
+	case FORMAT_16:
+		header.imageType = IMAGE_TYPE_FULL;
+		if (!info.bOpaque) header.discripter |= 1;
+		break;
+	default:
+		header.imageType = IMAGE_TYPE_FULL;
+		if (format == FORMAT_32) header.discripter |= 8;
+		break;
+	}
+
+	// メモリ確保
+	uint8 *pImage   = new uint8[line * h];
+	uint8 *pPalette = NULL;
+
+	if (pImage == NULL) return false;
+
+	if (format == FORMAT_INDEX) {
+		if ((pPalette = new uint8[set.num * palB]) == NULL) {
+			SAFE_DELETES(pImage);
+			return false;
+		}
+		for (uint32 i = 0; i < set.num; i++) {
+			const uint32 c = set.color[i];
+			for (uint32 j = 0; j < palB; j++) pPalette[i * palB + j] = static_cast<uint8>(c >> (j * 8));
+		}
+	}
+
+	// 1ラインずつ変換して、RLE圧縮したサイズも数える
+	uint64 rleSize = 0;
+	bool bResult = true;
+
+#pragma omp parallel
+	{
+		uint8 *pWork = new uint8[w * 4];
+		uint8 *pPack = new uint8[line + w];
+		uint64 packSize = 0;
+
+		if (pWork == NULL || pPack == NULL) {
+#pragma omp critical
+			bResult = false;
+		}
+
+#pragma omp for
+		for (sint32 y = 0; y < h; y++) {
+			if (!bResult) continue;
+
+			const uint8 *pSrc = this->GetLine32(pWork, bFlipY ? (h - y - 1) : y);
+			uint8 *pDst = &pImage[y * line];
+
+			for (sint32 x = 0; x < w; x++) {
+				const uint8 *s = &pSrc[(bFlipX ? (w - x - 1) : x) * 4];
+
+				switch (format) {
+				case FORMAT_INDEX:
+					pDst[x] = static_cast<uint8>(set.Find(ReadPixel(s)));
+					break;
+				case FORMAT_GRAY:
+					pDst[x] = s[0];
+					break;
+				case FORMAT_16:
+					{
+						const uint32 pix = ((s[3] != 0) ? 0x8000 : 0) | (To5Bit(s[2]) << 10) | (To5Bit(s[1]) << 5) | To5Bit(s[0]);
+						pDst[x * 2 + 0] = static_cast<uint8>(pix);
+						pDst[x * 2 + 1] = static_cast<uint8>(pix >> 8);
+					}
+					break;
+				default:
+					memcpy(&pDst[x * byte], s, byte);
+					break;
+				}
+			}
+
+			packSize += TgaKernelPackRLE(pPack, pDst, w, byte);
+		}
+
+#pragma omp critical
+		rleSize += packSize;
+
+		SAFE_DELETES(pWork);
+		SAFE_DELETES(pPack);
+	}
+
+	if (!bResult) {
+		SAFE_DELETES(pImage);
+		SAFE_DELETES(pPalette);
+		return false;
+	}
+
+	// RLE圧縮の方が小さい？
+	if (rleSize < line * h) header.imageType += 8;
+
+	if (pDst->Create(header, pImage, line * h, pPalette, (pPalette != NULL) ? set.num * palB : 0) != ERROR_NONE) {
+		SAFE_DELETES(pImage);
+		SAFE_DELETES(pPalette);
+		return false;
+	}
+
+	pDst->m_Footer         = m_Footer;
+	pDst->m_bPremultiplied = m_bPremultiplied;
+	pDst->m_bRGBA          = false;
+
+	return true;
+}
@@ -0,0 +1,523 @@
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+#include "tga_stream.h"
+#include "tga_pack.h"
+
+
+/*
+ * パックファイルの形式(リトルエンディアン)
+ *
+ *  0 "TGAP"
+ *  4 バージョン(16bit)
+ *  6 予約(16bit)
+ *  8 画像数(32bit)
+ * 12 ハッシュ表の大きさ(32bit、2のべき乗)
+ * 16 名前の領域のサイズ(32bit)
+ *    以降FILE_HEADER_SIZEまで0
+ *
+ * ヘッダーの後ろにハッシュ表(32bit×大きさ)、画像ごとの目次(ENTRY_SIZEバイト)、
+ * 名前の領域('\0'終端の名前を目次と同じ順に並べたもの)を置き、
+ * その後ろのPAGE_SIZEの境界から画像ごとのデータを置く。
+ * ハッシュ表は名前のハッシュ値の下位ビットから始めて順に探し、
+ * 目次の番号+1が入っている(0なら空き)。
+ *
+ * 画像ごとの目次
+ *  0 名前のハッシュ値(64bit)
+ *  8 データの位置(64bit、PAGE_SIZEの境界)
+ * 16 イメージのハッシュ値(64bit、未計算なら0)
+ * 24 データのサイズ(32bit)
+ * 28 パレットのサイズ(32bit)
+ * 32 名前の位置(32bit、名前の領域の先頭から)
+ * 36 格納方法(32bit、ENTRY_FLAG_*)
+ * 40 TGAヘッダー(18バイト、ファイルと同じ形式)
+ * 58 TGAフッター(26バイト、ファイルと同じ形式)
+ *    以降ENTRY_SIZEまで0
+ *
+ * 展開済みのデータはイメージ、パレットの順で、ピクセルの並びはデコード前と同じ。
+ * RLE圧縮のデータはCTga::Outputで出力したTGAファイルそのもの。
+ */
+
+namespace {
+
+// ヘッダー内の位置
+enum {
+	OFS_MAGIC       = 0,
+	OFS_VERSION     = 4,
+	OFS_NUM         = 8,
+	OFS_SLOT_NUM    = 12,
+	OFS_STRING_SIZE = 16
+};
+
+// 画像ごとの目次内の位置
+enum {
+	ENT_NAME_HASH   = 0,
+	ENT_DATA        = 8,
+	ENT_IMAGE_HASH  = 16,
+	ENT_DATA_SIZE   = 24,
+	ENT_PAL_SIZE    = 28,
+	ENT_NAME        = 32,
+	ENT_FLAG        = 36,
+	ENT_TGA_HEADER  = 40,
+	ENT_TGA_FOOTER  = 58
+};
+
+const char FILE_MAGIC[4] = {'T', 'G', 'A', 'P'};
+const char TEMP_EXT[]    = ".tmp";
+
+MTOINLINE void Put16(uint8 *p, const uint32 n) {p[0] = static_cast<uint8>(n); p[1] = static_cast<uint8>(n >> 8);}
+MTOINLINE void Put32(uint8 *p, const uint32 n) {Put16(p, n); Put16(&p[2], n >> 16);}
+MTOINLINE void Put64(uint8 *p, const uint64 n) {Put32(p, static_cast<uint32>(n)); Put32(&p[4], static_cast<uint32>(n >> 32));}
+
+MTOINLINE uint32 Get16(const uint8 *p) {return p[0] | (p[1] << 8);}
+MTOINLINE uint32 Get32(const uint8 *p) {return Get16(p) | (Get16(&p[2]) << 16);}
+MTOINLINE uint64 Get64(const uint8 *p) {return Get32(p) | (static_cast<uint64>(Get32(&p[4])) << 32);}
+
+MTOINLINE uint64 AlignPage(const uint64 n) {return (n + CTgaPack::PAGE_SIZE - 1) & ~static_cast<uint64>(CTgaPack::PAGE_SIZE - 1);}
+
+MTOINLINE uint64 HashName(const char *pName) {return TgaKernelHash64(pName, static_cast<uint32>(strlen(pName)), 0);}
+
+/*=======================================================================
+【機能】ファイルの位置までを0で埋める
+ =======================================================================*/
+bool PadFile(FILE *fp, uint64 pos, const uint64 end)
+{
+	static const uint8 pad[CTgaPack::PAGE_SIZE] = {0};
+
+	while (pos < end) {
+		const uint32 size = (end - pos < sizeof(pad)) ? static_cast<uint32>(end - pos) : sizeof(pad);
+		if (fwrite(pad, size, 1, fp) != 1) return false;
+		pos += size;
+	}
+
+	return true;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTgaPack::CTgaPack(void)
+{
+	m_pShare     = NULL;
+	m_pMap       = NULL;
+	m_pSlot      = NULL;
+	m_pEntry     = NULL;
+	m_pString    = NULL;
+	m_Num        = 0;
+	m_SlotNum    = 0;
+	m_StringSize = 0;
+}
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTgaPack::~CTgaPack(void)
+{
+	this->Close();
+}
+
+/*=======================================================================
+【機能】パックファイルを開く
+【引数】pFileName：パックファイル名
+【戻値】true：成功
+【備考】パックファイルはマップしたままになります。
+        マップはLoadで作成したCTgaと共有します。
+ =======================================================================*/
+bool CTgaPack::Open(const char *pFileName)
+{
+	this->Close();
+
+	if (pFileName == NULL) return false;
+
+	if ((m_pShare = CTga::OpenShareMap(pFileName)) == NULL) return false;
+
+	m_pMap = CTga::GetShareMap(m_pShare);
+	if (m_pMap->getSize() < FILE_HEADER_SIZE) {
+		this->Close();
+		return false;
+	}
+
+	const uint8 *pSrc = m_pMap->getData();
+	const uint64 size = m_pMap->getSize();
+	const uint32 num  = Get32(&pSrc[OFS_NUM]);
+	const uint32 slot = Get32(&pSrc[OFS_SLOT_NUM]);
+	const uint32 str  = Get32(&pSrc[OFS_STRING_SIZE]);
+	const uint64 end  = FILE_HEADER_SIZE + static_cast<uint64>(slot) * 4 + static_cast<uint64>(num) * ENTRY_SIZE + str;
+
+	// 形式と範囲の確認(ハッシュ表には空きがあり、名前の領域は'\0'で終わっていること)
+	if (memcmp(&pSrc[OFS_MAGIC], FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+		Get16(&pSrc[OFS_VERSION]) != FILE_VERSION ||
+		slot == 0 || (slot & (slot - 1)) != 0 || num >= slot || end > size ||
+		(str != 0 && pSrc[end - 1] != '\0') || (num != 0 && str == 0)) {
+		this->Close();
+		return false;
+	}
+
+	m_pSlot      = &pSrc[FILE_HEADER_SIZE];
+	m_pEntry     = &m_pSlot[slot * 4];
+	m_pString    = reinterpret_cast<const char*>(&m_pEntry[num * ENTRY_SIZE]);
+	m_Num        = num;
+	m_SlotNum    = slot;
+	m_StringSize = str;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】パックファイルを閉じる
+【備考】Loadで作成したCTgaのうち、展開済みで格納したものはマップの中を
+        指しているので、マップはそれらが全部破棄されるまで残ります。
+ =======================================================================*/
+void CTgaPack::Close(void)
+{
+	if (m_pShare != NULL) {
+		CTga::ReleaseShareMap(m_pShare);
+		m_pShare = NULL;
+	}
+	m_pMap = NULL;
+
+	m_pSlot      = NULL;
+	m_pEntry     = NULL;
+	m_pString    = NULL;
+	m_Num        = 0;
+	m_SlotNum    = 0;
+	m_StringSize = 0;
+}
+
+/*=======================================================================
+【機能】画像の情報を取得
+【引数】index ：番号(Buildに渡した順)
+        pEntry：格納先(pNameはパックファイルを閉じるまで使えます)
+【戻値】true：成功
+ =======================================================================*/
+bool CTgaPack::GetEntry(const uint32 index, Entry *pEntry) const
+{
+	if (index >= m_Num || pEntry == NULL) return false;
+
+	const uint8 *p = &m_pEntry[index * ENTRY_SIZE];
+	const uint32 name = Get32(&p[ENT_NAME]);
+	if (name >= m_StringSize) return false;
+
+	pEntry->pName       = &m_pString[name];
+	pEntry->offset      = Get64(&p[ENT_DATA]);
+	pEntry->size        = Get32(&p[ENT_DATA_SIZE]);
+	pEntry->paletteSize = Get32(&p[ENT_PAL_SIZE]);
+	pEntry->flag        = Get32(&p[ENT_FLAG]);
+	pEntry->hash        = Get64(&p[ENT_IMAGE_HASH]);
+
+	// TGAヘッダー(CTga::ReadHeaderと同じ並び)
+	const uint8 *pHead = &p[ENT_TGA_HEADER];
+	CTga::TGAHeader &header = pEntry->header;
+
+	header.IDField      = pHead[0];
+	header.usePalette   = pHead[1];
+	header.imageType    = pHead[2];
+	header.paletteIndex = static_cast<uint16>(Get16(&pHead[3]));
+	header.paletteColor = static_cast<uint16>(Get16(&pHead[5]));
+	header.paletteBit   = pHead[7];
+	header.imageX       = static_cast<uint16>(Get16(&pHead[8]));
+	header.imageY       = static_cast<uint16>(Get16(&pHead[10]));
+	header.imageW       = static_cast<uint16>(Get16(&pHead[12]));
+	header.imageH       = static_cast<uint16>(Get16(&pHead[14]));
+	header.imageBit     = pHead[16];
+	header.discripter   = pHead[17];
+
+	return true;
+}
+
+/*=======================================================================
+【機能】名前で探す
+【引数】pName：名前
+【戻値】番号(見つからなければ-1)
+【備考】ハッシュ表を引くので、画像数によらずほぼ一定の時間で見つかります。
+ =======================================================================*/
+sint32 CTgaPack::Find(const char *pName) const
+{
+	if (pName == NULL || m_SlotNum == 0) return -1;
+
+	const uint64 hash = HashName(pName);
+	const uint32 mask = m_SlotNum - 1;
+
+	for (uint32 i = 0, slot = static_cast<uint32>(hash) & mask; i < m_SlotNum; i++, slot = (slot + 1) & mask) {
+		const uint32 index = Get32(&m_pSlot[slot * 4]);
+		if (index == 0 || index > m_Num) return -1;
+
+		const uint8 *p = &m_pEntry[(index - 1) * ENTRY_SIZE];
+		const uint32 name = Get32(&p[ENT_NAME]);
+
+		if (Get64(&p[ENT_NAME_HASH]) == hash && name < m_StringSize && strcmp(&m_pString[name], pName) == 0) {
+			return static_cast<sint32>(index - 1);
+		}
+	}
+
+	return -1;
+}
+
+/*=======================================================================
+【機能】画像を読み込む
+【引数】pTga ：作成先(setCreateFlagの作成フラグを使います)
+        index：番号
+【戻値】エラータイプ
+【備考】展開済みで格納したものはコピーせず、pTgaのイメージとパレットは
+        マップの中を指します(マップを共有するので、パックファイルを閉じた後も使えます)。
+        同じ画像を読み込んだCTgaどうしはイメージを共有しているので、
+        getImageで得たイメージを書き換えると他からも見えます
+        (ConvertRGBAなどはコピーしてから書き換えます)。
+        CREATE_FLAG_PREMULTIPLYを指定した場合と、RLE圧縮で格納したものは
+        メモリを確保して展開します。
+ =======================================================================*/
+int CTgaPack::Load(CTga *pTga, const uint32 index) const
+{
+	if (pTga == NULL || index >= m_Num) return CTga::ERROR_OPEN;
+
+	const uint8 *p = &m_pEntry[index * ENTRY_SIZE];
+	const uint64 offset      = Get64(&p[ENT_DATA]);
+	const uint32 size        = Get32(&p[ENT_DATA_SIZE]);
+	const uint32 paletteSize = Get32(&p[ENT_PAL_SIZE]);
+
+	// 範囲の確認
+	if (offset > m_pMap->getSize() || static_cast<uint64>(size) + paletteSize > m_pMap->getSize() - offset) {
+		return CTga::ERROR_IMAGE;
+	}
+
+	uint8 *pData = m_pMap->getData() + offset;
+
+	// RLE圧縮ならTGAファイルとして展開
+	if (Get32(&p[ENT_FLAG]) & ENTRY_FLAG_RLE) {
+		return pTga->Create(pData, size);
+	}
+
+	// 既に作成しているなら削除
+	if (pTga->m_pImage != NULL || pTga->m_pLazy != NULL) {
+		pTga->Clear();
+	}
+
+	// ヘッダーとサイズの確認
+	if (!pTga->ReadHeader(&p[ENT_TGA_HEADER]) || !pTga->CalcSize(false) ||
+		pTga->m_ImageSize != size || pTga->m_PaletteSize != paletteSize || size == 0) {
+		pTga->Clear();
+		return CTga::ERROR_HEADER;
+	}
+	pTga->ReadFooter(p, ENT_TGA_FOOTER);
+
+	pTga->AttachShareMap(m_pShare);
+	pTga->m_pImage         = pData;
+	pTga->m_pPalette       = (paletteSize != 0) ? &pData[size] : NULL;
+	pTga->m_bPremultiplied = false;
+	pTga->m_Hash           = Get64(&p[ENT_IMAGE_HASH]);
+
+	if ((pTga->m_CreateFlag & CTga::CREATE_FLAG_PREMULTIPLY) && !pTga->Premultiply()) {
+		pTga->Clear();
+		return CTga::ERROR_MEMORY;
+	}
+	if ((pTga->m_CreateFlag & CTga::CREATE_FLAG_HASH) && pTga->m_Hash == 0) {
+		pTga->CalcHash();
+	}
+
+	return CTga::ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】名前で画像を読み込む
+【引数】pTga ：作成先
+        pName：名前
+【戻値】エラータイプ(見つからなければERROR_OPEN)
+ =======================================================================*/
+int CTgaPack::Load(CTga *pTga, const char *pName) const
+{
+	const sint32 index = this->Find(pName);
+	if (index < 0) return CTga::ERROR_OPEN;
+
+	return this->Load(pTga, static_cast<uint32>(index));
+}
+
+/*=======================================================================
+【機能】パックファイルを作る
+【引数】pFileName：パックファイル名
+        ppFile   ：TGAファイル名の配列
+        ppName   ：名前の配列(NULLならファイル名を名前にする)
+        num      ：画像数
+        bRLE     ：RLE圧縮して格納する？
+【戻値】true：成功
+【備考】読み込めないファイルや同じ名前があれば失敗します。
+        RLE圧縮すると小さくなりますが、読み込む時に展開が必要です。
+        作業ファイルに書き出してから置き換えるので、途中の状態のパックファイルが
+        読まれることはありません(開いているパックファイルは置き換えられません)。
+ =======================================================================*/
+bool CTgaPack::Build(const char *pFileName, const char *const *ppFile, const char *const *ppName, const uint32 num, const bool bRLE)
+{
+	if (pFileName == NULL || (ppFile == NULL && num != 0)) return false;
+	if (num > 0x7fffffff / ENTRY_SIZE) return false;
+
+	if (ppName == NULL) ppName = ppFile;
+
+	// ハッシュ表の大きさ(半分以上は空ける)
+	uint32 slotNum = 1;
+	while (slotNum <= num * 2) slotNum <<= 1;
+
+	// 名前の領域のサイズ
+	uint64 strSize = 0;
+	for (uint32 i = 0; i < num; i++) {
+		if (ppFile[i] == NULL || ppName[i] == NULL) return false;
+
+		const size_t len = strlen(ppName[i]);
+		if (len == 0 || len >= NAME_MAX_LEN) return false;
+		strSize += len + 1;
+	}
+	if (strSize > 0x7fffffff) return false;
+
+	// 目次はメモリ上で作って最後に書き出す
+	const uint64 tocSize  = FILE_HEADER_SIZE + static_cast<uint64>(slotNum) * 4 + static_cast<uint64>(num) * ENTRY_SIZE + strSize;
+	const uint64 dataBase = AlignPage(tocSize);
+	if (tocSize > 0x7fffffff) return false;
+
+	uint8 *pToc = new uint8[static_cast<uint32>(tocSize)];
+	if (pToc == NULL) return false;
+	memset(pToc, 0, static_cast<uint32>(tocSize));
+
+	uint8 *pSlot   = &pToc[FILE_HEADER_SIZE];
+	uint8 *pEntry  = &pSlot[slotNum * 4];
+	char  *pString = reinterpret_cast<char*>(&pEntry[num * ENTRY_SIZE]);
+	bool bResult = true;
+
+	memcpy(&pToc[OFS_MAGIC], FILE_MAGIC, sizeof(FILE_MAGIC));
+	Put16(&pToc[OFS_VERSION],     FILE_VERSION);
+	Put32(&pToc[OFS_NUM],         num);
+	Put32(&pToc[OFS_SLOT_NUM],    slotNum);
+	Put32(&pToc[OFS_STRING_SIZE], static_cast<uint32>(strSize));
+
+	// 名前とハッシュ表を作る
+	const uint32 mask = slotNum - 1;
+	uint32 name = 0;
+
+	for (uint32 i = 0; bResult && i < num; i++) {
+		uint8 *p = &pEntry[i * ENTRY_SIZE];
+		const uint64 hash = HashName(ppName[i]);
+		const size_t len  = strlen(ppName[i]);
+		uint32 slot = static_cast<uint32>(hash) & mask;
+
+		memcpy(&pString[name], ppName[i], len + 1);
+		Put64(&p[ENT_NAME_HASH], hash);
+		Put32(&p[ENT_NAME],      name);
+		name += static_cast<uint32>(len) + 1;
+
+		while (Get32(&pSlot[slot * 4]) != 0) {
+			// 同じ名前
+			const uint8 *pOther = &pEntry[(Get32(&pSlot[slot * 4]) - 1) * ENTRY_SIZE];
+			if (Get64(&pOther[ENT_NAME_HASH]) == hash && strcmp(&pString[Get32(&pOther[ENT_NAME])], ppName[i]) == 0) {
+				bResult = false;
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+		if (bResult) Put32(&pSlot[slot * 4], i + 1);
+	}
+
+	// 作業ファイルに書き出し(目次の分は空けておく)
+	char temp[NAME_MAX_LEN + 64];
+	FILE *fp = NULL;
+
+	if (strlen(pFileName) >= NAME_MAX_LEN) bResult = false;
+	if (bResult) {
+		sprintf(temp, "%s.%lu%s", pFileName, MtoGetProcessId(), TEMP_EXT);
+		if ((fp = fopen(temp, "wb")) == NULL) bResult = false;
+	}
+
+	if (bResult) {
+		uint64 pos = 0;
+		bResult = PadFile(fp, pos, dataBase);
+		pos = dataBase;
+
+		for (uint32 i = 0; bResult && i < num; i++) {
+			uint8 *p = &pEntry[i * ENTRY_SIZE];
+			CTga tga;
+
+			if (tga.Create(ppFile[i]) != CTga::ERROR_NONE || tga.m_pImage == NULL) {
+				bResult = false;
+				break;
+			}
+
+			// データはページ境界から
+			const uint64 offset = AlignPage(pos);
+			if (!PadFile(fp, pos, offset)) {
+				bResult = false;
+				break;
+			}
+			pos = offset;
+
+			if (bRLE) {
+				CTgaStreamWriter writer(TgaStreamWriteFILE, fp);
+
+				tga.setRLE(true);
+				if (tga.Output(&writer, CTga::OUTPUT_FLAG_NONE) != CTga::ERROR_NONE) {
+					bResult = false;
+					break;
+				}
+
+				const long long end = MtoFileTell(fp);
+				if (end < 0 || static_cast<uint64>(end) < pos || static_cast<uint64>(end) - pos > 0xffffffffULL) {
+					bResult = false;
+					break;
+				}
+				Put32(&p[ENT_DATA_SIZE], static_cast<uint32>(static_cast<uint64>(end) - pos));
+				Put32(&p[ENT_FLAG],      ENTRY_FLAG_RLE);
+				pos = static_cast<uint64>(end);
+			} else {
+				tga.CalcHash();
+				if (fwrite(tga.m_pImage, tga.m_ImageSize, 1, fp) != 1 ||
+					(tga.m_PaletteSize != 0 && fwrite(tga.m_pPalette, tga.m_PaletteSize, 1, fp) != 1)) {
+					bResult = false;
+					break;
+				}
+				Put64(&p[ENT_IMAGE_HASH], tga.m_Hash);
+				Put32(&p[ENT_DATA_SIZE],  tga.m_ImageSize);
+				Put32(&p[ENT_PAL_SIZE],   tga.m_PaletteSize);
+				Put32(&p[ENT_FLAG],       ENTRY_FLAG_NONE);
+				pos += static_cast<uint64>(tga.m_ImageSize) + tga.m_PaletteSize;
+			}
+			Put64(&p[ENT_DATA], offset);
+
+			// TGAヘッダーとフッター
+			const CTga::TGAHeader &header = tga.m_Header;
+			uint8 *pHead = &p[ENT_TGA_HEADER];
+
+			*pHead++ = header.IDField;
+			*pHead++ = header.usePalette;
+			*pHead++ = header.imageType;
+			Put16(pHead, header.paletteIndex); pHead += 2;
+			Put16(pHead, header.paletteColor); pHead += 2;
+			*pHead++ = header.paletteBit;
+			Put16(pHead, header.imageX); pHead += 2;
+			Put16(pHead, header.imageY); pHead += 2;
+			Put16(pHead, header.imageW); pHead += 2;
+			Put16(pHead, header.imageH); pHead += 2;
+			*pHead++ = header.imageBit;
+			*pHead++ = header.discripter;
+
+			_ASSERT(pHead == &p[ENT_TGA_FOOTER]);
+			memcpy(pHead, &tga.m_Footer.filePos, sizeof(tga.m_Footer.filePos)); pHead += sizeof(tga.m_Footer.filePos);
+			memcpy(pHead, &tga.m_Footer.fileDev, sizeof(tga.m_Footer.fileDev)); pHead += sizeof(tga.m_Footer.fileDev);
+			memcpy(pHead, tga.m_Footer.version,  sizeof(tga.m_Footer.version));
+		}
+
+		// 目次を先頭に書き出し
+		if (bResult) {
+			bResult = (MtoFileSeek(fp, 0, SEEK_SET) && fwrite(pToc, static_cast<uint32>(tocSize), 1, fp) == 1);
+		}
+		if (fclose(fp) != 0) bResult = false;
+
+		// 置き換え
+		if (!bResult || !MtoFileReplace(temp, pFileName)) {
+			MtoFileRemove(temp);
+			bResult = false;
+		}
+	}
+
+	SAFE_DELETES(pToc);
+
+	return bResult;
+}
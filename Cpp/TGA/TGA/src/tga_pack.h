@@ -0,0 +1,69 @@
+/*=============================================================================
+ * TGAのパックファイル
+ * 大量のTGAを1つのファイルにまとめ、名前のハッシュ表とTGAヘッダーを
+ * 先頭の目次に置きます。イメージはページ境界に置くので、パックファイルを
+ * 1回マップするだけで、CTgaはコピーせずにその中を指して作成できます。
+ * RLE圧縮で格納したものは、読み込む時にマップの中から展開します。
+ * mto_file.h、mto_common.h、tga.hの順にインクルードしてから使用してください。
+=============================================================================*/
+#ifndef _TGA_PACK_H_
+#define _TGA_PACK_H_
+
+class CTgaPack {
+public:
+	enum {
+		FILE_VERSION = 1,			// パックファイルのバージョン
+		FILE_HEADER_SIZE = 32,		// パックファイルのヘッダーサイズ
+		ENTRY_SIZE = 96,			// 1画像分の目次のサイズ
+		PAGE_SIZE = 4096,			// イメージの配置境界
+		NAME_MAX_LEN = 1024			// 名前の最大長
+	};
+
+	// 格納方法
+	enum {
+		ENTRY_FLAG_NONE = 0x00,		// 展開済みのイメージとパレット
+		ENTRY_FLAG_RLE  = 0x01		// RLE圧縮したTGAファイル
+	};
+
+	// 1画像分の情報
+	struct Entry {
+		const char		*pName;		// 名前
+		uint64			offset;		// データの位置(PAGE_SIZEの境界)
+		uint32			size;		// データのサイズ(展開済みならイメージのサイズ)
+		uint32			paletteSize;// パレットのサイズ(展開済みの場合だけ、イメージの直後)
+		uint32			flag;		// 格納方法(ENTRY_FLAG_*)
+		uint64			hash;		// イメージのハッシュ値(未計算なら0)
+		CTga::TGAHeader	header;		// TGAヘッダー
+	};
+
+private:
+	CTga::TGAShareMap	*m_pShare;	// マップ中のパックファイル(Loadで作成したCTgaと共有)
+	CMtoFileMap		*m_pMap;		// m_pShareのマップ
+	const uint8		*m_pSlot;		// ハッシュ表の先頭
+	const uint8		*m_pEntry;		// 目次の先頭
+	const char		*m_pString;		// 名前の先頭
+	uint32			m_Num;			// 画像数
+	uint32			m_SlotNum;		// ハッシュ表の大きさ(2のべき乗)
+	uint32			m_StringSize;	// 名前の領域のサイズ
+
+	// コピー禁止
+	CTgaPack(const CTgaPack&);
+	CTgaPack &operator=(const CTgaPack&);
+
+public:
+	CTgaPack(void);
+	virtual ~CTgaPack(void);
+
+	uint32 getNum(void) const {return m_Num;}
+
+	bool   Open(const char *pFileName);
+	void   Close(void);
+	bool   GetEntry(const uint32 index, Entry *pEntry) const;
+	sint32 Find(const char *pName) const;
+	int    Load(CTga *pTga, const uint32 index) const;
+	int    Load(CTga *pTga, const char *pName) const;
+
+	static bool Build(const char *pFileName, const char *const *ppFile, const char *const *ppName, const uint32 num, const bool bRLE);
+};
+
+#endif
@@ -0,0 +1,578 @@
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+
+#include <algorithm>
+
+#ifdef _USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+enum {
+	HIST_BIT_RGB   = 5,						// ヒストグラムのRGBのビット数
+	HIST_BIT_ALPHA = 3,						// ヒストグラムのアルファのビット数
+	CAND_MAX       = 32,					// 1区画の候補色の最大数
+	EXACT_BIT      = 10,					// 色数カウント用テーブルのビット数
+	PALETTE_MAX    = 256					// 最大パレット数
+};
+
+// ヒストグラムの1色(1区画)
+struct QuantizeColor {
+	uint32	key;							// 区画のキー
+	uint32	count;							// ピクセル数
+	uint64	sum[4];							// BGRAの合計
+	float	mean[4];						// BGRAの平均
+};
+
+// メディアンカットの箱
+struct QuantizeBox {
+	uint32	start;							// 開始位置
+	uint32	end;							// 終了位置
+	uint32	count;							// ピクセル数
+	sint32	axis;							// 分割する軸
+	float	range;							// 軸の幅
+};
+
+// 比較用(指定の軸で並べる)
+struct QuantizeLess {
+	sint32 axis;
+	explicit QuantizeLess(const sint32 a) : axis(a) {}
+	bool operator()(const QuantizeColor &c0, const QuantizeColor &c1) const {return c0.mean[axis] < c1.mean[axis];}
+};
+
+// 分割用(指定の軸で閾値未満か)
+struct QuantizeBelow {
+	sint32 axis;
+	float  value;
+	QuantizeBelow(const sint32 a, const float v) : axis(a), value(v) {}
+	bool operator()(const QuantizeColor &c) const {return c.mean[axis] < value;}
+};
+
+/*=======================================================================
+【機能】パレット検索用テーブル
+【備考】SSE2のpmaddwdで距離を求めるため、BG/RAを16bitずつ詰めて保持する。
+        SSE2版と通常版は同じ結果になる(同じ距離なら若い番号)。
+ =======================================================================*/
+struct QuantizePalette {
+	uint32	bg[PALETTE_MAX];				// B | G << 16
+	uint32	ra[PALETTE_MAX];				// R | A << 16
+	uint32	num;							// 色数(4の倍数に切り上げ)
+	uint32	color;							// 実際の色数
+	bool	bSse2;							// SSE2版を使う？
+
+	void Setup(const uint8 *pPalette, const uint32 color)
+	{
+		this->color = color;
+		bSse2 = (TgaKernelGetLevel() >= TGA_KERNEL_LEVEL_SSE2);
+		num = (color + 3) & ~3;
+		for (uint32 i = 0; i < num; i++) {
+			// 余りは先頭の色で埋める(同じ距離なら若い番号が優先されるので選ばれない)
+			const uint8 *p = &pPalette[((i < color) ? i : 0) * 4];
+			bg[i] = p[0] | (p[1] << 16);
+			ra[i] = p[2] | (p[3] << 16);
+		}
+	}
+
+	uint8 Nearest(const uint8 *pPixel) const
+	{
+		uint32 best = 0;
+
+#ifdef _USE_SSE2
+		if (bSse2) {
+			const __m128i pixBG = _mm_set1_epi32(pPixel[0] | (pPixel[1] << 16));
+			const __m128i pixRA = _mm_set1_epi32(pPixel[2] | (pPixel[3] << 16));
+			const __m128i four  = _mm_set1_epi32(4);
+			__m128i minDist = _mm_set1_epi32(0x7fffffff);
+			__m128i minIdx  = _mm_setzero_si128();
+			__m128i idx     = _mm_set_epi32(3, 2, 1, 0);
+
+			for (uint32 i = 0; i < num; i += 4) {
+				__m128i dBG = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&bg[i])), pixBG);
+				__m128i dRA = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&ra[i])), pixRA);
+				__m128i d   = _mm_add_epi32(_mm_madd_epi16(dBG, dBG), _mm_madd_epi16(dRA, dRA));
+				__m128i lt  = _mm_cmplt_epi32(d, minDist);
+
+				minDist = _mm_or_si128(_mm_and_si128(lt, d), _mm_andnot_si128(lt, minDist));
+				minIdx  = _mm_or_si128(_mm_and_si128(lt, idx), _mm_andnot_si128(lt, minIdx));
+				idx     = _mm_add_epi32(idx, four);
+			}
+
+			// 4レーンから最小を選ぶ(同じ距離なら若い番号)
+			uint32 dist[4], index[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dist), minDist);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(index), minIdx);
+
+			uint32 lane = 0;
+			for (uint32 i = 1; i < 4; i++) {
+				if (dist[i] < dist[lane] || (dist[i] == dist[lane] && index[i] < index[lane])) {
+					lane = i;
+				}
+			}
+			return static_cast<uint8>(index[lane]);
+		}
+#endif
+
+		uint32 minDist = 0xffffffff;
+
+		for (uint32 i = 0; i < num; i++) {
+			sint32 db = static_cast<sint32>(bg[i] & 0xffff) - pPixel[0];
+			sint32 dg = static_cast<sint32>(bg[i] >> 16)    - pPixel[1];
+			sint32 dr = static_cast<sint32>(ra[i] & 0xffff) - pPixel[2];
+			sint32 da = static_cast<sint32>(ra[i] >> 16)    - pPixel[3];
+			uint32 d  = db * db + dg * dg + dr * dr + da * da;
+
+			if (d < minDist) {
+				minDist = d;
+				best    = i;
+			}
+		}
+
+		return static_cast<uint8>(best);
+	}
+
+	/*-------------------------------------------------------------------
+	【機能】区画内の色の候補になるパレットを求める
+	【引数】pLo  ：区画の最小値(BGRA)
+	        pHi  ：区画の最大値(BGRA)
+	        pList：候補の保存先(CAND_MAX個)
+	【戻値】候補数(0:候補が多すぎる)
+	【備考】区画内のどの色に対しても最も近くなり得るパレットだけを残す。
+	        (区画までの最短距離が、全パレット中の最遠距離の最小値以下のもの)
+	-------------------------------------------------------------------*/
+	uint32 Candidate(const uint8 *pLo, const uint8 *pHi, uint8 *pList) const
+	{
+		uint32 minDist[PALETTE_MAX];
+		uint32 limit = 0xffffffff;
+		uint32 i = 0;
+
+#ifdef _USE_SSE2
+		if (bSse2) {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i loBG = _mm_set1_epi32(pLo[0] | (pLo[1] << 16));
+			const __m128i loRA = _mm_set1_epi32(pLo[2] | (pLo[3] << 16));
+			const __m128i hiBG = _mm_set1_epi32(pHi[0] | (pHi[1] << 16));
+			const __m128i hiRA = _mm_set1_epi32(pHi[2] | (pHi[3] << 16));
+			__m128i maxMin = _mm_set1_epi32(0x7fffffff);
+
+			for (i = 0; i < num; i += 4) {
+				__m128i eBG = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&bg[i]));
+				__m128i eRA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&ra[i]));
+
+				// 区画までの最短距離
+				__m128i nBG = _mm_max_epi16(_mm_max_epi16(_mm_sub_epi16(loBG, eBG), _mm_sub_epi16(eBG, hiBG)), zero);
+				__m128i nRA = _mm_max_epi16(_mm_max_epi16(_mm_sub_epi16(loRA, eRA), _mm_sub_epi16(eRA, hiRA)), zero);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(&minDist[i]),
+								 _mm_add_epi32(_mm_madd_epi16(nBG, nBG), _mm_madd_epi16(nRA, nRA)));
+
+				// 区画までの最遠距離
+				__m128i fBG = _mm_max_epi16(_mm_sub_epi16(eBG, loBG), _mm_sub_epi16(hiBG, eBG));
+				__m128i fRA = _mm_max_epi16(_mm_sub_epi16(eRA, loRA), _mm_sub_epi16(hiRA, eRA));
+				__m128i f   = _mm_add_epi32(_mm_madd_epi16(fBG, fBG), _mm_madd_epi16(fRA, fRA));
+				__m128i lt  = _mm_cmplt_epi32(f, maxMin);
+				maxMin = _mm_or_si128(_mm_and_si128(lt, f), _mm_andnot_si128(lt, maxMin));
+			}
+
+			uint32 lane[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(lane), maxMin);
+			for (i = 0; i < 4; i++) {
+				if (lane[i] < limit) limit = lane[i];
+			}
+			i = num;
+		}
+#endif
+
+		for (; i < num; i++) {
+			const sint32 e[4] = {static_cast<sint32>(bg[i] & 0xffff), static_cast<sint32>(bg[i] >> 16),
+								 static_cast<sint32>(ra[i] & 0xffff), static_cast<sint32>(ra[i] >> 16)};
+			uint32 dn = 0, df = 0;
+
+			for (sint32 c = 0; c < 4; c++) {
+				sint32 n = (e[c] < pLo[c]) ? (pLo[c] - e[c]) : ((e[c] > pHi[c]) ? (e[c] - pHi[c]) : 0);
+				sint32 f = ((e[c] - pLo[c]) > (pHi[c] - e[c])) ? (e[c] - pLo[c]) : (pHi[c] - e[c]);
+				dn += n * n;
+				df += f * f;
+			}
+			minDist[i] = dn;
+			if (df < limit) limit = df;
+		}
+
+		// 余りは先頭の色と同じ距離になるので候補に入れない
+		uint32 count = 0;
+		for (i = 0; i < color; i++) {
+			if (minDist[i] > limit) continue;
+			if (count >= CAND_MAX) return 0;
+			pList[count++] = static_cast<uint8>(i);
+		}
+
+		return count;
+	}
+};
+
+/*=======================================================================
+【機能】箱の分割軸を求める
+【引数】pColor：ヒストグラム
+        box   ：箱
+ =======================================================================*/
+void CalcBoxAxis(const QuantizeColor *pColor, QuantizeBox &box)
+{
+	float minV[4] = { 255.0f,  255.0f,  255.0f,  255.0f};
+	float maxV[4] = {   0.0f,    0.0f,    0.0f,    0.0f};
+
+	box.count = 0;
+	for (uint32 i = box.start; i < box.end; i++) {
+		for (sint32 c = 0; c < 4; c++) {
+			if (pColor[i].mean[c] < minV[c]) minV[c] = pColor[i].mean[c];
+			if (pColor[i].mean[c] > maxV[c]) maxV[c] = pColor[i].mean[c];
+		}
+		box.count += pColor[i].count;
+	}
+
+	box.axis  = 0;
+	box.range = maxV[0] - minV[0];
+	for (sint32 c = 1; c < 4; c++) {
+		if ((maxV[c] - minV[c]) > box.range) {
+			box.axis  = c;
+			box.range = maxV[c] - minV[c];
+		}
+	}
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】減色してインデックスカラーに変換
+【引数】colorMax：最大色数(2～256)
+        refine  ：k-meansでパレットを補正する回数(0:補正なし)
+【備考】24bit/32bitのフルカラーが対象です。
+        メディアンカットでパレットを作成し、各ピクセルを最も近い色に割り当てます。
+        32bitで透明なピクセルがある場合はパレットを32bitにします。
+ =======================================================================*/
+bool CTga::Quantize(const uint32 colorMax, const uint32 refine)
+{
+	if (!this->Decode()) return false;
+	if (m_pImage == NULL) return false;
+	if (colorMax < 2 || colorMax > PALETTE_MAX) return false;
+
+	// フルカラーのみ対応
+	if (m_Header.imageType != IMAGE_TYPE_FULL && m_Header.imageType != IMAGE_TYPE_FULL_RLE) return false;
+	if (m_Header.imageBit != 24 && m_Header.imageBit != 32) return false;
+
+	// マップ中のイメージは置き換えられないのでコピーしておく
+	if (!this->Detach()) return false;
+
+	const uint32 byte  = m_Header.imageBit >> 3;
+	const uint32 pixel = static_cast<uint32>(m_Header.imageW) * m_Header.imageH;
+	uint32 i;
+
+	// 透明なピクセルがある？
+	bool bAlpha = false;
+	if (byte == 4) {
+		for (i = 0; i < pixel; i++) {
+			if (m_pImage[i * 4 + 3] != A_MAX) {
+				bAlpha = true;
+				break;
+			}
+		}
+	}
+
+	// ヒストグラム作成
+	const uint32 bitA    = bAlpha ? HIST_BIT_ALPHA : 0;
+	const uint32 histNum = 1 << (HIST_BIT_RGB * 3 + bitA);
+	uint32 *pHistIdx;
+	QuantizeColor *pColor;
+
+	if ((pHistIdx = new uint32[histNum]) == NULL) return false;
+	memset(pHistIdx, 0xff, sizeof(uint32) * histNum);
+
+	if ((pColor = new QuantizeColor[(pixel < histNum) ? pixel : histNum]) == NULL) {
+		SAFE_DELETES(pHistIdx);
+		return false;
+	}
+
+	// 実際の色数も数える(最大色数以下ならそのままパレットにする)
+	uint32 exactKey[1 << EXACT_BIT];
+	uint8  exactUse[1 << EXACT_BIT];
+	uint32 exactNum  = 0;
+	uint32 exactLast = 0;
+	memset(exactUse, 0, sizeof(exactUse));
+
+	uint32 colorNum = 0;
+	for (i = 0; i < pixel; i++) {
+		const uint8 *p = &m_pImage[i * byte];
+		uint8 a = (byte == 4) ? p[3] : A_MAX;
+		uint32 key = (p[0] >> 3) | ((p[1] >> 3) << 5) | ((p[2] >> 3) << 10);
+		if (bAlpha) key |= (a >> (8 - HIST_BIT_ALPHA)) << 15;
+
+		if (exactNum <= colorMax) {
+			uint32 color = p[0] | (p[1] << 8) | (p[2] << 16) | (a << 24);
+			if (exactNum == 0 || color != exactLast) {
+				uint32 hash = (color * 2654435761U) >> (32 - EXACT_BIT);
+				while (exactUse[hash] && exactKey[hash] != color) {
+					hash = (hash + 1) & ((1 << EXACT_BIT) - 1);
+				}
+				if (!exactUse[hash]) {
+					exactUse[hash] = 1;
+					exactKey[hash] = color;
+					exactNum++;
+				}
+				exactLast = color;
+			}
+		}
+
+		uint32 n = pHistIdx[key];
+		if (n == 0xffffffff) {
+			n = pHistIdx[key] = colorNum++;
+			memset(&pColor[n], 0, sizeof(pColor[n]));
+			pColor[n].key = key;
+		}
+		pColor[n].count++;
+		pColor[n].sum[0] += p[0];
+		pColor[n].sum[1] += p[1];
+		pColor[n].sum[2] += p[2];
+		pColor[n].sum[3] += a;
+	}
+
+	for (i = 0; i < colorNum; i++) {
+		for (sint32 c = 0; c < 4; c++) {
+			pColor[i].mean[c] = static_cast<float>(pColor[i].sum[c]) / pColor[i].count;
+		}
+	}
+
+	uint8 palette[PALETTE_MAX * 4];
+	uint32 boxNum = 1;
+
+	if (exactNum <= colorMax) {
+		// 色数が少ないので減色しない
+		boxNum = 0;
+		for (i = 0; i < (1 << EXACT_BIT); i++) {
+			if (!exactUse[i]) continue;
+			for (sint32 c = 0; c < 4; c++) {
+				palette[boxNum * 4 + c] = static_cast<uint8>(exactKey[i] >> (c * 8));
+			}
+			boxNum++;
+		}
+	}
+
+	// メディアンカット
+	QuantizeBox box[PALETTE_MAX];
+
+	box[0].start = 0;
+	box[0].end   = colorNum;
+	CalcBoxAxis(pColor, box[0]);
+
+	while (exactNum > colorMax && boxNum < colorMax) {
+		// 分割する箱を選ぶ(ピクセル数×幅が最大の箱)
+		sint32 sel = -1;
+		float score = 0.0f;
+		for (i = 0; i < boxNum; i++) {
+			if ((box[i].end - box[i].start) < 2) continue;
+			float s = box[i].range * box[i].count;
+			if (s > score) {
+				score = s;
+				sel   = i;
+			}
+		}
+		if (sel < 0) break; // これ以上分割できない
+
+		// 軸のピクセル数の中央で分割
+		// (ソートすると色数が多いときに遅いので、256段階の度数分布から閾値を決めて振り分ける)
+		QuantizeBox &b = box[sel];
+		uint32 bin[256];
+		memset(bin, 0, sizeof(bin));
+		for (i = b.start; i < b.end; i++) {
+			bin[static_cast<uint32>(pColor[i].mean[b.axis])] += pColor[i].count;
+		}
+
+		uint32 half = b.count >> 1;
+		uint32 sum  = 0;
+		uint32 th   = 0;
+		while (th < 255) {
+			sum += bin[th];
+			if (sum >= half) break;
+			th++;
+		}
+
+		QuantizeColor *pStart = &pColor[b.start];
+		QuantizeColor *pEnd   = &pColor[b.end];
+		QuantizeColor *pMid   = std::partition(pStart, pEnd, QuantizeBelow(b.axis, static_cast<float>(th + 1)));
+		if (pMid == pEnd) {
+			pMid = std::partition(pStart, pEnd, QuantizeBelow(b.axis, static_cast<float>(th)));
+		}
+		if (pMid == pStart || pMid == pEnd) {
+			// 同じ段階に集まっている場合は並べて中央で分割
+			std::sort(pStart, pEnd, QuantizeLess(b.axis));
+			pMid = pStart + ((pEnd - pStart) >> 1);
+		}
+		uint32 mid = static_cast<uint32>(pMid - pColor);
+
+		box[boxNum].start = mid;
+		box[boxNum].end   = b.end;
+		b.end = mid;
+		CalcBoxAxis(pColor, b);
+		CalcBoxAxis(pColor, box[boxNum]);
+		boxNum++;
+	}
+
+	// パレット作成(BGRA)
+	for (i = 0; exactNum > colorMax && i < boxNum; i++) {
+		uint64 sum[4] = {0, 0, 0, 0};
+		for (uint32 j = box[i].start; j < box[i].end; j++) {
+			for (sint32 c = 0; c < 4; c++) sum[c] += pColor[j].sum[c];
+		}
+		for (sint32 c = 0; c < 4; c++) {
+			palette[i * 4 + c] = static_cast<uint8>((sum[c] + (box[i].count >> 1)) / box[i].count);
+		}
+	}
+
+	QuantizePalette table;
+	table.Setup(palette, boxNum);
+
+	// k-meansで補正
+	for (uint32 loop = 0; exactNum > colorMax && loop < refine; loop++) {
+		uint64 sum[PALETTE_MAX][4];
+		uint32 count[PALETTE_MAX];
+		memset(sum, 0, sizeof(sum));
+		memset(count, 0, sizeof(count));
+
+		for (i = 0; i < colorNum; i++) {
+			uint8 mean[4];
+			for (sint32 c = 0; c < 4; c++) mean[c] = static_cast<uint8>(pColor[i].mean[c] + 0.5f);
+
+			uint8 n = table.Nearest(mean);
+			for (sint32 c = 0; c < 4; c++) sum[n][c] += pColor[i].sum[c];
+			count[n] += pColor[i].count;
+		}
+
+		bool bMove = false;
+		for (i = 0; i < boxNum; i++) {
+			if (count[i] == 0) continue; // 空になった色はそのまま
+			for (sint32 c = 0; c < 4; c++) {
+				uint8 v = static_cast<uint8>((sum[i][c] + (count[i] >> 1)) / count[i]);
+				if (palette[i * 4 + c] != v) bMove = true;
+				palette[i * 4 + c] = v;
+			}
+		}
+		table.Setup(palette, boxNum);
+
+		if (!bMove) break; // 収束
+	}
+
+	// 区画ごとに候補のパレットを求める
+	// (全パレットとの比較はピクセル数分行うと重いので、区画内で最も近くなり得る色だけに絞る)
+	uint8 *pCand    = new uint8[colorNum * CAND_MAX];
+	uint8 *pCandNum = new uint8[colorNum];
+	uint8 *pImage   = new uint8[pixel];
+
+	if (pCand == NULL || pCandNum == NULL || pImage == NULL) {
+		SAFE_DELETES(pHistIdx);
+		SAFE_DELETES(pColor);
+		SAFE_DELETES(pCand);
+		SAFE_DELETES(pCandNum);
+		SAFE_DELETES(pImage);
+		return false;
+	}
+
+	const sint32 candLoop = colorNum;
+
+#pragma omp parallel for schedule(dynamic, 256)
+	for (sint32 n = 0; n < candLoop; n++) {
+		const uint32 key = pColor[n].key;
+		uint8 lo[4], hi[4];
+
+		lo[0] = static_cast<uint8>((key & 0x1f) << 3);
+		lo[1] = static_cast<uint8>(((key >> 5) & 0x1f) << 3);
+		lo[2] = static_cast<uint8>(((key >> 10) & 0x1f) << 3);
+		lo[3] = bAlpha ? static_cast<uint8>((key >> 15) << (8 - HIST_BIT_ALPHA)) : static_cast<uint8>(A_MAX);
+		hi[0] = lo[0] | 0x07;
+		hi[1] = lo[1] | 0x07;
+		hi[2] = lo[2] | 0x07;
+		hi[3] = bAlpha ? (lo[3] | ((1 << (8 - HIST_BIT_ALPHA)) - 1)) : static_cast<uint8>(A_MAX);
+
+		pCandNum[n] = static_cast<uint8>(table.Candidate(lo, hi, &pCand[n * CAND_MAX]));
+		pHistIdx[key] = n; // 並べ替えで位置が変わっているので付け直す
+	}
+	SAFE_DELETES(pColor);
+
+	// 最も近い色に割り当て
+	const sint32 height = m_Header.imageH;
+	const uint32 width  = m_Header.imageW;
+
+#pragma omp parallel for schedule(dynamic, 16)
+	for (sint32 y = 0; y < height; y++) {
+		const uint8 *pSrc = &m_pImage[y * width * byte];
+		uint8 *pDst = &pImage[y * width];
+
+		for (uint32 x = 0; x < width; x++, pSrc += byte) {
+			uint8 pix[4] = {pSrc[0], pSrc[1], pSrc[2], (byte == 4) ? pSrc[3] : static_cast<uint8>(A_MAX)};
+			if (!bAlpha) pix[3] = A_MAX;
+
+			uint32 key = (pix[0] >> 3) | ((pix[1] >> 3) << 5) | ((pix[2] >> 3) << 10);
+			if (bAlpha) key |= (pix[3] >> (8 - HIST_BIT_ALPHA)) << 15;
+
+			const uint32 n    = pHistIdx[key];
+			const uint32 num  = pCandNum[n];
+			const uint8 *pIdx = &pCand[n * CAND_MAX];
+
+			if (num == 0) {
+				// 候補が多い区画は全パレットから探す
+				pDst[x] = table.Nearest(pix);
+				continue;
+			}
+
+			uint32 minDist = 0xffffffff;
+			for (uint32 j = 0; j < num; j++) {
+				const uint8 *pPal = &palette[pIdx[j] * 4];
+				sint32 db = pPal[0] - pix[0];
+				sint32 dg = pPal[1] - pix[1];
+				sint32 dr = pPal[2] - pix[2];
+				sint32 da = pPal[3] - pix[3];
+				uint32 d  = db * db + dg * dg + dr * dr + da * da;
+
+				if (d < minDist) {
+					minDist = d;
+					pDst[x] = pIdx[j];
+				}
+			}
+		}
+	}
+
+	SAFE_DELETES(pHistIdx);
+	SAFE_DELETES(pCand);
+	SAFE_DELETES(pCandNum);
+
+	// パレット作成
+	const uint32 palByte = bAlpha ? 4 : 3;
+	uint8 *pPalette;
+	if ((pPalette = new uint8[boxNum * palByte]) == NULL) {
+		SAFE_DELETES(pImage);
+		return false;
+	}
+	for (i = 0; i < boxNum; i++) {
+		memcpy(&pPalette[i * palByte], &palette[i * 4], palByte);
+	}
+
+	// 元を破棄して変換後のデータを保持
+	SAFE_DELETES(m_pImage);
+	SAFE_DELETES(m_pPalette);
+	m_pImage      = pImage;
+	m_pPalette    = pPalette;
+	m_ImageSize   = pixel;
+	m_PaletteSize = boxNum * palByte;
+
+	// ヘッダーを変更
+	m_Header.imageType    = (m_Header.imageType == IMAGE_TYPE_FULL_RLE) ? IMAGE_TYPE_INDEX_RLE : IMAGE_TYPE_INDEX;
+	m_Header.usePalette   = 1;
+	m_Header.paletteIndex = 0;
+	m_Header.paletteColor = static_cast<uint16>(boxNum);
+	m_Header.paletteBit   = static_cast<uint8>(palByte << 3);
+	m_Header.imageBit     = 8;
+	m_Header.discripter   = (m_Header.discripter & 0xf0) | (bAlpha ? 8 : 0);
+
+	// 内容が変わったのでハッシュ値は無効
+	m_Hash = 0;
+
+	return true;
+}
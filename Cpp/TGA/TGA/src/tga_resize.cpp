@@ -0,0 +1,580 @@
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+
+#ifdef _USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+enum {
+	BAND_LINE = 64								// 1スレッドがまとめて処理する出力ライン数
+};
+
+/*=======================================================================
+【機能】フィルタ関数
+【引数】filter：フィルタ(RESIZE_FILTER_*)
+        x     ：中心からの距離
+ =======================================================================*/
+double FilterWeight(const sint32 filter, const double x)
+{
+	double t = (x < 0.0) ? -x : x;
+
+	switch (filter) {
+	case CTga::RESIZE_FILTER_BILINEAR:
+		return (t < 1.0) ? (1.0 - t) : 0.0;
+
+	case CTga::RESIZE_FILTER_BICUBIC:
+		// Catmull-Rom(a = -0.5)
+		if (t < 1.0) return (1.5 * t - 2.5) * t * t + 1.0;
+		if (t < 2.0) return ((-0.5 * t + 2.5) * t - 4.0) * t + 2.0;
+		return 0.0;
+
+	case CTga::RESIZE_FILTER_LANCZOS3:
+		if (t < 1e-8) return 1.0;
+		if (t < 3.0) {
+			double px = PI * t;
+			return 3.0 * sin(px) * sin(px / 3.0) / (px * px);
+		}
+		return 0.0;
+	}
+
+	return 0.0;
+}
+
+/*=======================================================================
+【機能】フィルタの半径
+【引数】filter：フィルタ(RESIZE_FILTER_*)
+ =======================================================================*/
+double FilterRadius(const sint32 filter)
+{
+	switch (filter) {
+	case CTga::RESIZE_FILTER_BILINEAR: return 1.0;
+	case CTga::RESIZE_FILTER_BICUBIC:  return 2.0;
+	case CTga::RESIZE_FILTER_LANCZOS3: return 3.0;
+	}
+	return 1.0;
+}
+
+/*=======================================================================
+【機能】1方向分のフィルタ係数
+【備考】出力1ピクセルごとに、参照する元ピクセルの先頭と数、係数を持つ。
+        画像外を参照する係数は端のピクセルに足し込んでおくので、
+        参照範囲は必ず画像内に収まる。
+ =======================================================================*/
+struct ResizeWeight {
+	sint32	*pStart;							// 参照する先頭ピクセル
+	sint32	*pCount;							// 参照するピクセル数
+	float	*pWeight;							// 係数(出力1ピクセルにつきtap個)
+	sint32	tap;								// 最大参照数
+
+	ResizeWeight(void) : pStart(NULL), pCount(NULL), pWeight(NULL), tap(0) {}
+	~ResizeWeight(void)
+	{
+		SAFE_DELETES(pStart);
+		SAFE_DELETES(pCount);
+		SAFE_DELETES(pWeight);
+	}
+
+	bool Create(const uint32 src, const uint32 dst, const sint32 filter)
+	{
+		const double scale   = static_cast<double>(src) / dst;
+		const double stretch = (scale > 1.0) ? scale : 1.0;	// 縮小時はフィルタを広げる
+		const double support = FilterRadius(filter) * stretch;
+
+		tap = static_cast<sint32>(ceil(support)) * 2 + 1;
+
+		if ((pStart  = new sint32[dst]) == NULL) return false;
+		if ((pCount  = new sint32[dst]) == NULL) return false;
+		if ((pWeight = new float[dst * tap]) == NULL) return false;
+
+		double *pWork;
+		if ((pWork = new double[tap]) == NULL) return false;
+
+		for (uint32 i = 0; i < dst; i++) {
+			const double center = (i + 0.5) * scale;
+			sint32 lo = static_cast<sint32>(floor(center - support));
+			sint32 hi = static_cast<sint32>(ceil(center + support));
+			if (hi - lo > tap) hi = lo + tap;
+
+			// 画像内に収める
+			sint32 first = (lo < 0) ? 0 : lo;
+			sint32 last  = (hi > static_cast<sint32>(src)) ? static_cast<sint32>(src) : hi;
+			if (last <= first) last = first + 1;
+
+			double sum = 0.0;
+			for (sint32 j = 0; j < last - first; j++) pWork[j] = 0.0;
+
+			for (sint32 k = lo; k < hi; k++) {
+				double w = FilterWeight(filter, (k + 0.5 - center) / stretch);
+				sint32 idx = k;
+				if (idx < first) idx = first;
+				if (idx >= last) idx = last - 1;
+				pWork[idx - first] += w;
+				sum += w;
+			}
+
+			// 係数0の端は詰める
+			while (last - first > 1 && pWork[0] == 0.0) {
+				for (sint32 j = 1; j < last - first; j++) pWork[j - 1] = pWork[j];
+				first++;
+			}
+			while (last - first > 1 && pWork[last - first - 1] == 0.0) last--;
+
+			pStart[i] = first;
+			pCount[i] = last - first;
+
+			float *pW = &pWeight[i * tap];
+			for (sint32 j = 0; j < tap; j++) {
+				pW[j] = (j < last - first && sum != 0.0) ? static_cast<float>(pWork[j] / sum) : 0.0f;
+			}
+			if (sum == 0.0) pW[0] = 1.0f;
+		}
+
+		SAFE_DELETES(pWork);
+
+		return true;
+	}
+};
+
+/*=======================================================================
+【機能】1ラインをfloatに展開する情報
+ =======================================================================*/
+struct ResizeSource {
+	const uint8	*pImage;						// 元イメージ
+	const uint8	*pPalette;						// パレット(インデックスカラーのみ)
+	uint32		width;							// 幅
+	uint32		byte;							// 1ピクセルのバイト数
+	uint32		paletteByte;					// 1パレットのバイト数
+	uint32		paletteColor;					// パレットの色数
+	uint32		ch;								// 展開後のチャンネル数(1 or 4)
+	bool		bAlpha;							// アルファを使う？
+	bool		bPremultiply;					// 展開時に乗算済みアルファに変換する？
+
+	/*=======================================================================
+	【機能】1ライン展開
+	【引数】pDst：展開先(幅×ch個)
+	        y   ：ライン
+	【備考】アルファなしの場合はアルファを255にする。
+	 =======================================================================*/
+	void Expand(float *pDst, const uint32 y) const
+	{
+		const uint8 *pSrc = &pImage[y * width * byte];
+		uint32 x = 0;
+
+		if (ch == 1) {
+			for (x = 0; x < width; x++) pDst[x] = pSrc[x];
+			return;
+		}
+
+		switch (byte) {
+		case 1:
+			// インデックスカラー
+			for (x = 0; x < width; x++) {
+				const uint8 *p = &pPalette[((pSrc[x] < paletteColor) ? pSrc[x] : 0) * paletteByte];
+				pDst[x * 4 + 0] = p[0];
+				pDst[x * 4 + 1] = p[1];
+				pDst[x * 4 + 2] = p[2];
+				pDst[x * 4 + 3] = (paletteByte == 4) ? p[3] : 255.0f;
+			}
+			break;
+
+		case 2:
+			// ARGB:1555
+			for (x = 0; x < width; x++) {
+				uint32 pix = pSrc[x * 2] | (pSrc[x * 2 + 1] << 8);
+				pDst[x * 4 + 0] = static_cast<float>(((pix      ) & 0x1f) * 255 / 31);
+				pDst[x * 4 + 1] = static_cast<float>(((pix >>  5) & 0x1f) * 255 / 31);
+				pDst[x * 4 + 2] = static_cast<float>(((pix >> 10) & 0x1f) * 255 / 31);
+				pDst[x * 4 + 3] = (!bAlpha || (pix & 0x8000)) ? 255.0f : 0.0f;
+			}
+			break;
+
+		case 3:
+			for (x = 0; x < width; x++) {
+				pDst[x * 4 + 0] = pSrc[x * 3 + 0];
+				pDst[x * 4 + 1] = pSrc[x * 3 + 1];
+				pDst[x * 4 + 2] = pSrc[x * 3 + 2];
+				pDst[x * 4 + 3] = 255.0f;
+			}
+			break;
+
+		case 4:
+#ifdef _USE_SSE2
+			if (TgaKernelGetLevel() >= TGA_KERNEL_LEVEL_SSE2) {
+				const __m128i zero = _mm_setzero_si128();
+
+				for (; x + 4 <= width; x += 4) {
+					__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSrc[x * 4]));
+					__m128i lo  = _mm_unpacklo_epi8(src, zero);
+					__m128i hi  = _mm_unpackhi_epi8(src, zero);
+
+					_mm_storeu_ps(&pDst[x * 4 +  0], _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)));
+					_mm_storeu_ps(&pDst[x * 4 +  4], _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)));
+					_mm_storeu_ps(&pDst[x * 4 +  8], _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)));
+					_mm_storeu_ps(&pDst[x * 4 + 12], _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)));
+				}
+			}
+#endif
+			for (; x < width; x++) {
+				pDst[x * 4 + 0] = pSrc[x * 4 + 0];
+				pDst[x * 4 + 1] = pSrc[x * 4 + 1];
+				pDst[x * 4 + 2] = pSrc[x * 4 + 2];
+				pDst[x * 4 + 3] = pSrc[x * 4 + 3];
+			}
+			break;
+		}
+
+		// 乗算済みアルファに変換
+		if (bPremultiply) {
+			for (x = 0; x < width; x++) {
+				float a = pDst[x * 4 + 3] * (1.0f / 255.0f);
+				pDst[x * 4 + 0] *= a;
+				pDst[x * 4 + 1] *= a;
+				pDst[x * 4 + 2] *= a;
+			}
+		}
+	}
+};
+
+/*=======================================================================
+【機能】横方向の縮小・拡大
+【引数】pDst   ：出力先(出力幅×ch個)
+        pSrc   ：展開済みの元ライン
+        weight ：横方向のフィルタ係数
+        dstW   ：出力幅
+        ch     ：チャンネル数(1 or 4)
+ =======================================================================*/
+void ResampleH(float *pDst, const float *pSrc, const ResizeWeight &weight, const uint32 dstW, const uint32 ch)
+{
+#ifdef _USE_SSE2
+	const bool bSse2 = (TgaKernelGetLevel() >= TGA_KERNEL_LEVEL_SSE2);
+#endif
+
+	if (ch == 4) {
+		for (uint32 x = 0; x < dstW; x++) {
+			const float *pW = &weight.pWeight[x * weight.tap];
+			const float *pS = &pSrc[weight.pStart[x] * 4];
+			const sint32 num = weight.pCount[x];
+
+#ifdef _USE_SSE2
+			if (bSse2) {
+				__m128 sum = _mm_setzero_ps();
+				for (sint32 k = 0; k < num; k++) {
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&pS[k * 4]), _mm_set1_ps(pW[k])));
+				}
+				_mm_storeu_ps(&pDst[x * 4], sum);
+				continue;
+			}
+#endif
+
+			float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			for (sint32 k = 0; k < num; k++) {
+				sum[0] += pS[k * 4 + 0] * pW[k];
+				sum[1] += pS[k * 4 + 1] * pW[k];
+				sum[2] += pS[k * 4 + 2] * pW[k];
+				sum[3] += pS[k * 4 + 3] * pW[k];
+			}
+			pDst[x * 4 + 0] = sum[0];
+			pDst[x * 4 + 1] = sum[1];
+			pDst[x * 4 + 2] = sum[2];
+			pDst[x * 4 + 3] = sum[3];
+		}
+	} else {
+		for (uint32 x = 0; x < dstW; x++) {
+			const float *pW = &weight.pWeight[x * weight.tap];
+			const float *pS = &pSrc[weight.pStart[x]];
+			const sint32 num = weight.pCount[x];
+			float sum = 0.0f;
+
+			for (sint32 k = 0; k < num; k++) sum += pS[k] * pW[k];
+			pDst[x] = sum;
+		}
+	}
+}
+
+/*=======================================================================
+【機能】縦方向の縮小・拡大
+【引数】pDst ：出力先
+        ppSrc：横方向処理済みのライン(num本)
+        pW   ：係数(num個)
+        num  ：参照ライン数
+        len  ：1ラインのfloat数
+ =======================================================================*/
+void ResampleV(float *pDst, const float * const *ppSrc, const float *pW, const sint32 num, const uint32 len)
+{
+	uint32 i = 0;
+
+#ifdef _USE_SSE2
+	if (TgaKernelGetLevel() >= TGA_KERNEL_LEVEL_SSE2) {
+		for (; i + 8 <= len; i += 8) {
+			__m128 s0 = _mm_setzero_ps();
+			__m128 s1 = _mm_setzero_ps();
+
+			for (sint32 k = 0; k < num; k++) {
+				__m128 w = _mm_set1_ps(pW[k]);
+				s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(&ppSrc[k][i + 0]), w));
+				s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(&ppSrc[k][i + 4]), w));
+			}
+			_mm_storeu_ps(&pDst[i + 0], s0);
+			_mm_storeu_ps(&pDst[i + 4], s1);
+		}
+	}
+#endif
+
+	for (; i < len; i++) {
+		float sum = 0.0f;
+		for (sint32 k = 0; k < num; k++) sum += ppSrc[k][i] * pW[k];
+		pDst[i] = sum;
+	}
+}
+
+/*=======================================================================
+【機能】floatを0～255に丸める
+ =======================================================================*/
+MTOINLINE uint8 ClampByte(const float f)
+{
+	if (f <= 0.0f) return 0;
+	if (f >= 255.0f) return 255;
+	return static_cast<uint8>(f + 0.5f);
+}
+
+#ifdef _USE_SSE2
+/*=======================================================================
+【機能】4つのfloatを整数に丸める(SSE2版)
+【備考】ClampByteと同じく0.5を足して切り捨てる(cvtps2dqの偶数丸めでは
+        0.5ちょうどの値が通常版と変わる)。0～255への飽和はパックで行う。
+ =======================================================================*/
+MTOINLINE __m128i RoundSse2(const __m128 v)
+{
+	return _mm_cvttps_epi32(_mm_add_ps(v, _mm_set1_ps(0.5f)));
+}
+#endif
+
+/*=======================================================================
+【機能】1ラインを出力形式に変換
+【引数】pDst         ：出力先
+        pSrc         ：縦方向処理済みのライン
+        width        ：幅
+        byte         ：出力の1ピクセルのバイト数(1/3/4)
+        bUnpremultiply：乗算済みアルファを元に戻す？
+ =======================================================================*/
+void StoreLine(uint8 *pDst, float *pSrc, const uint32 width, const uint32 byte, const bool bUnpremultiply)
+{
+	uint32 x = 0;
+
+	if (byte == 1) {
+#ifdef _USE_SSE2
+		if (TgaKernelGetLevel() >= TGA_KERNEL_LEVEL_SSE2) {
+			for (; x + 8 <= width; x += 8) {
+				__m128i lo = RoundSse2(_mm_loadu_ps(&pSrc[x + 0]));
+				__m128i hi = RoundSse2(_mm_loadu_ps(&pSrc[x + 4]));
+				__m128i v  = _mm_packs_epi32(lo, hi);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(&pDst[x]), _mm_packus_epi16(v, v));
+			}
+		}
+#endif
+		for (; x < width; x++) pDst[x] = ClampByte(pSrc[x]);
+		return;
+	}
+
+	// 乗算済みアルファを元に戻す
+	if (bUnpremultiply) {
+		for (x = 0; x < width; x++) {
+			float *p = &pSrc[x * 4];
+			float a = (p[3] < 0.0f) ? 0.0f : ((p[3] > 255.0f) ? 255.0f : p[3]);
+			if (a < 0.5f) {
+				p[0] = p[1] = p[2] = 0.0f;
+			} else {
+				float r = 255.0f / a;
+				p[0] *= r;
+				p[1] *= r;
+				p[2] *= r;
+			}
+		}
+		x = 0;
+	}
+
+	if (byte == 4) {
+#ifdef _USE_SSE2
+		if (TgaKernelGetLevel() >= TGA_KERNEL_LEVEL_SSE2) {
+			for (; x + 4 <= width; x += 4) {
+				__m128i v0 = RoundSse2(_mm_loadu_ps(&pSrc[x * 4 +  0]));
+				__m128i v1 = RoundSse2(_mm_loadu_ps(&pSrc[x * 4 +  4]));
+				__m128i v2 = RoundSse2(_mm_loadu_ps(&pSrc[x * 4 +  8]));
+				__m128i v3 = RoundSse2(_mm_loadu_ps(&pSrc[x * 4 + 12]));
+				__m128i lo = _mm_packs_epi32(v0, v1);
+				__m128i hi = _mm_packs_epi32(v2, v3);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(&pDst[x * 4]), _mm_packus_epi16(lo, hi));
+			}
+		}
+#endif
+		for (; x < width; x++) {
+			pDst[x * 4 + 0] = ClampByte(pSrc[x * 4 + 0]);
+			pDst[x * 4 + 1] = ClampByte(pSrc[x * 4 + 1]);
+			pDst[x * 4 + 2] = ClampByte(pSrc[x * 4 + 2]);
+			pDst[x * 4 + 3] = ClampByte(pSrc[x * 4 + 3]);
+		}
+	} else {
+		for (; x < width; x++) {
+			pDst[x * 3 + 0] = ClampByte(pSrc[x * 4 + 0]);
+			pDst[x * 3 + 1] = ClampByte(pSrc[x * 4 + 1]);
+			pDst[x * 3 + 2] = ClampByte(pSrc[x * 4 + 2]);
+		}
+	}
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】サイズ変更
+【引数】pDst  ：作成先
+        width ：変更後の幅
+        height：変更後の高さ
+        filter：フィルタ(RESIZE_FILTER_*)
+【備考】8bit(白黒)/24bit/32bitはそのままのビット数で出力します。
+        インデックスカラーはパレットのビット数、16bitはアルファの有無で
+        24bitか32bitのフルカラーに展開して出力します。
+        アルファ付きの画像は乗算済みアルファで処理し、元の状態に戻して出力します。
+ =======================================================================*/
+bool CTga::Resize(CTga *pDst, const uint32 width, const uint32 height, const sint32 filter) const
+{
+	if (!this->Decode()) return false;
+	if (pDst == NULL || pDst == this || m_pImage == NULL) return false;
+	if (filter < 0 || filter >= RESIZE_FILTER_MAX) return false;
+	if (width == 0 || height == 0 || width > 0xffff || height > 0xffff) return false;
+
+	const bool bIndex = (m_Header.imageType == IMAGE_TYPE_INDEX || m_Header.imageType == IMAGE_TYPE_INDEX_RLE);
+	if (bIndex && m_pPalette == NULL) return false;
+
+	// 元ラインの展開方法
+	ResizeSource src;
+	src.pImage       = m_pImage;
+	src.pPalette     = m_pPalette;
+	src.width        = m_Header.imageW;
+	src.byte         = m_Header.imageBit >> 3;
+	src.paletteByte  = m_Header.paletteBit >> 3;
+	src.paletteColor = m_Header.paletteColor;
+	src.ch           = (src.byte == 1 && !bIndex) ? 1 : 4;
+
+	// 出力のビット数
+	uint32 dstBit;
+	if (src.ch == 1) {
+		dstBit = 8;
+	} else if (bIndex) {
+		dstBit = m_Header.paletteBit;
+	} else if (src.byte == 2) {
+		dstBit = this->IsAlphaImage() ? 32 : 24;
+	} else {
+		dstBit = m_Header.imageBit;
+	}
+	src.bAlpha       = (dstBit == 32);
+	src.bPremultiply = (src.bAlpha && !m_bPremultiplied);
+
+	// フィルタ係数
+	const uint32 srcW = m_Header.imageW;
+	const uint32 srcH = m_Header.imageH;
+	ResizeWeight weightH, weightV;
+	if (!weightH.Create(srcW, width, filter))  return false;
+	if (!weightV.Create(srcH, height, filter)) return false;
+
+	const uint32 dstByte = dstBit >> 3;
+	const uint32 size    = width * height * dstByte;
+	const uint32 len     = width * src.ch;
+	uint8 *pImage;
+
+	if ((pImage = new uint8[size]) == NULL) return false;
+
+	// 出力ラインを帯に分けて並列処理
+	// 横方向の結果はtap本のリングバッファに持ち、帯の中では1度だけ計算する
+	const sint32 band = static_cast<sint32>((height + BAND_LINE - 1) / BAND_LINE);
+	const sint32 tap  = weightV.tap;
+	bool bResult = true;
+
+#pragma omp parallel
+	{
+		float *pLine = new float[srcW * src.ch];
+		float *pRing = new float[len * tap];
+		float *pOut  = new float[len];
+		sint32 *pRow = new sint32[tap];
+		const float **ppSrc = new const float*[tap];
+
+		if (pLine == NULL || pRing == NULL || pOut == NULL || pRow == NULL || ppSrc == NULL) {
+#pragma omp critical
+			bResult = false;
+		}
+
+#pragma omp for schedule(dynamic)
+		for (sint32 b = 0; b < band; b++) {
+			if (!bResult) continue;
+
+			for (sint32 i = 0; i < tap; i++) pRow[i] = -1;
+
+			const uint32 y0 = b * BAND_LINE;
+			const uint32 y1 = (y0 + BAND_LINE < height) ? (y0 + BAND_LINE) : height;
+
+			for (uint32 y = y0; y < y1; y++) {
+				const sint32 start = weightV.pStart[y];
+				const sint32 num   = weightV.pCount[y];
+
+				// 必要な元ラインを横方向に処理
+				for (sint32 k = 0; k < num; k++) {
+					const sint32 row  = start + k;
+					const sint32 slot = row % tap;
+
+					if (pRow[slot] != row) {
+						src.Expand(pLine, row);
+						ResampleH(&pRing[slot * len], pLine, weightH, width, src.ch);
+						pRow[slot] = row;
+					}
+					ppSrc[k] = &pRing[slot * len];
+				}
+
+				// 縦方向に処理して出力形式に変換
+				ResampleV(pOut, ppSrc, &weightV.pWeight[y * tap], num, len);
+				StoreLine(&pImage[y * width * dstByte], pOut, width, dstByte, src.bPremultiply);
+			}
+		}
+
+		SAFE_DELETES(pLine);
+		SAFE_DELETES(pRing);
+		SAFE_DELETES(pOut);
+		SAFE_DELETES(pRow);
+		SAFE_DELETES(ppSrc);
+	}
+
+	if (!bResult) {
+		SAFE_DELETES(pImage);
+		return false;
+	}
+
+	// ヘッダー作成(並びは元画像のまま)
+	TGAHeader header = m_Header;
+	header.imageW   = static_cast<uint16>(width);
+	header.imageH   = static_cast<uint16>(height);
+	header.imageBit = static_cast<uint8>(dstBit);
+
+	if (src.ch == 1) {
+		header.imageType = IMAGE_TYPE_GRAY;
+	} else {
+		header.imageType = IMAGE_TYPE_FULL;
+	}
+	if (bIndex) {
+		header.usePalette   = 0;
+		header.paletteIndex = 0;
+		header.paletteColor = 0;
+		header.paletteBit   = 0;
+	}
+	header.discripter = static_cast<uint8>((m_Header.discripter & 0xf0) | ((dstBit == 32) ? 8 : 0));
+
+	if (pDst->Create(header, pImage, size, NULL, 0) != ERROR_NONE) {
+		SAFE_DELETES(pImage);
+		return false;
+	}
+	pDst->m_bPremultiplied = m_bPremultiplied && (dstBit == 32);
+	pDst->m_bRGBA          = m_bRGBA;
+
+	return true;
+}
@@ -0,0 +1,78 @@
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+
+
+/*=======================================================================
+【機能】回転
+【引数】rotate：回転の種類(ROTATE_*)
+【戻値】true:成功 / false:失敗
+【備考】イメージ記述子のピクセルの並びは元のままで、見た目を回転します。
+        90度、270度、転置はROTATE_TILE四方のタイルに分けて、
+        タイルごとに並列で転置します(反転は転置の読み書きの向きで行う)。
+        ハッシュ値は無効になります。
+ =======================================================================*/
+bool CTga::Rotate(const sint32 rotate)
+{
+	if (rotate < 0 || rotate >= ROTATE_MAX) return false;
+	if (!this->Decode()) return false;
+	if (m_pImage == NULL) return false;
+
+	// マップ中のイメージは置き換えられないのでコピーしておく
+	if (!this->Detach()) return false;
+
+	uint8 *pImage;
+
+	// 変換用のメモリ確保
+	if ((pImage = new uint8[m_ImageSize]) == NULL) {
+		return false;
+	}
+
+	const sint32 w       = m_Header.imageW;
+	const sint32 h       = m_Header.imageH;
+	const uint32 byte    = m_Header.imageBit >> 3;
+	const sint32 srcLine = w * byte;
+
+	if (rotate == ROTATE_180) {
+		// 保存の並びのまま上下左右を入れ替える
+#pragma omp parallel for
+		for (sint32 y = 0; y < h; y++) {
+			TgaKernelReverse(&pImage[y * srcLine], &m_pImage[(h - y - 1) * srcLine], w, byte);
+		}
+	} else {
+		// 保存の並びで転置すると、変換先のラインは変換元の列、列は変換元のラインになる
+		// 元の並びが左右か上下の一方だけ反転していれば、回転の向きが逆になる
+		const bool   bFlip   = ((m_Header.discripter & 0x10) != 0) != ((m_Header.discripter & 0x20) == 0);
+		const bool   bRevCol = (bFlip != (rotate == ROTATE_270));	// 変換先のラインは変換元の右の列から
+		const bool   bRevRow = (bFlip != (rotate == ROTATE_90));	// 変換先の列は変換元の下のラインから
+		const sint32 dstLine = h * byte;
+
+		uint8       *pDst     = bRevCol ? &pImage[(w - 1) * dstLine] : pImage;
+		const sint32 dstPitch = bRevCol ? -dstLine : dstLine;
+		const uint8 *pSrc     = bRevRow ? &m_pImage[(h - 1) * srcLine] : m_pImage;
+		const sint32 srcPitch = bRevRow ? -srcLine : srcLine;
+
+		const sint32 tileW   = (w + ROTATE_TILE - 1) / ROTATE_TILE;
+		const sint32 tileNum = tileW * ((h + ROTATE_TILE - 1) / ROTATE_TILE);
+
+#pragma omp parallel for schedule(dynamic)
+		for (sint32 tile = 0; tile < tileNum; tile++) {
+			const sint32 x0 = (tile % tileW) * ROTATE_TILE;
+			const sint32 y0 = (tile / tileW) * ROTATE_TILE;
+			const sint32 tw = (x0 + ROTATE_TILE < w) ? ROTATE_TILE : (w - x0);
+			const sint32 th = (y0 + ROTATE_TILE < h) ? ROTATE_TILE : (h - y0);
+
+			TgaKernelTranspose(pDst + x0 * dstPitch + y0 * byte, dstPitch, pSrc + y0 * srcPitch + x0 * byte, srcPitch, tw, th, byte);
+		}
+
+		m_Header.imageW = static_cast<uint16>(h);
+		m_Header.imageH = static_cast<uint16>(w);
+	}
+
+	// 元を破棄して変換後のデータを保持
+	SAFE_DELETES(m_pImage);
+	m_pImage = pImage;
+	m_Hash   = 0;	// 内容が変わったのでハッシュ値は無効
+
+	return true;
+}
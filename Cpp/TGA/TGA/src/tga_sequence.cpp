@@ -0,0 +1,250 @@
+#include "mto_thread.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_sequence.h"
+
+
+/*=======================================================================
+【機能】先読みのスロット
+ =======================================================================*/
+struct CTgaSequence::Slot {
+	CTga			tga;			// 読み込み先(使い回す)
+	CMtoSemaphore	ready;			// 読み込みが終わったらPostする
+	sint32			frame;			// フレーム番号
+	int				error;			// 読み込み結果
+};
+
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTgaSequence::CTgaSequence(void)
+{
+	m_pPattern = NULL;
+	m_First    = 0;
+	m_Step     = 1;
+	m_FrameNum = 0;
+
+	m_pSlot     = NULL;
+	m_SlotNum   = 0;
+	m_pThread   = NULL;
+	m_ThreadNum = 0;
+	m_pFreeSem  = NULL;
+
+	m_NextLoad = 0;
+	m_NextOut  = 0;
+	m_bHold    = false;
+	m_bStop    = false;
+
+	m_CreateFlag = CTga::CREATE_FLAG_NONE;
+}
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTgaSequence::~CTgaSequence(void)
+{
+	this->Close();
+}
+
+/*=======================================================================
+【機能】先読み開始
+【引数】pPattern ：ファイル名のパターン(整数の変換指定を1つ含むprintf形式)
+        first    ：最初のフレーム番号
+        last     ：最後のフレーム番号(firstより小さければ逆順)
+        lookAhead：先読みするフレーム数
+        threadNum：読み込みスレッド数
+【備考】既に開始していれば停止してからやり直します。
+        フレーム数がFRAME_NUM_MAXを超える範囲は失敗します。
+ =======================================================================*/
+bool CTgaSequence::Open(const char *pPattern, const sint32 first, const sint32 last, const uint32 lookAhead, const uint32 threadNum)
+{
+	this->Close();
+
+	if (pPattern == NULL || !CTga::CheckPattern(pPattern, PATH_MAX_LEN)) return false;
+
+	// sint32の差は32bitに収まらないことがあるので64bitで求める
+	const sint64 frameNum = ((first <= last) ? (static_cast<sint64>(last) - first) : (static_cast<sint64>(first) - last)) + 1;
+	if (frameNum > FRAME_NUM_MAX) return false;
+
+	const size_t len = strlen(pPattern);
+
+	if ((m_pPattern = new char[len + 1]) == NULL) return false;
+	memcpy(m_pPattern, pPattern, len + 1);
+
+	m_First    = first;
+	m_Step     = (first <= last) ? 1 : -1;
+	m_FrameNum = static_cast<uint32>(frameNum);
+
+	// 取り出したフレームを使っている間も先読みできるように1つ多く確保
+	m_SlotNum   = ((lookAhead != 0) ? lookAhead : 1) + 1;
+	m_ThreadNum = (threadNum != 0) ? threadNum : 1;
+	if (m_ThreadNum > m_SlotNum) m_ThreadNum = m_SlotNum;
+
+	m_pSlot    = new Slot[m_SlotNum];
+	m_pThread  = new CMtoThread[m_ThreadNum];
+	m_pFreeSem = new CMtoSemaphore(m_SlotNum);
+	if (m_pSlot == NULL || m_pThread == NULL || m_pFreeSem == NULL) {
+		this->Close();
+		return false;
+	}
+
+	for (uint32 i = 0; i < m_SlotNum; i++) {
+		m_pSlot[i].tga.setCreateFlag(m_CreateFlag);
+	}
+
+	m_NextLoad = 0;
+	m_NextOut  = 0;
+	m_bHold    = false;
+	m_bStop    = false;
+
+	for (uint32 i = 0; i < m_ThreadNum; i++) {
+		if (!m_pThread[i].Start(ThreadFunc, this)) {
+			this->Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】次のフレームを取り出す
+【引数】pFrame：フレーム番号の格納先(NULL可)
+        pError：エラータイプの格納先(NULL可、最後まで取り出したらERROR_END)
+【戻値】TGA(失敗時はNULL)
+【備考】読み込みが終わっていなければ待ちます。
+        取り出したTGAは次にNextかCloseを呼ぶまで使えます。
+        読み込みに失敗したフレームはNULLを返すので、続けて呼べば次のフレームを
+        取り出せます。Nextは1つのスレッドから呼んでください。
+ =======================================================================*/
+const CTga *CTgaSequence::Next(sint32 *pFrame, int *pError)
+{
+	// 前回取り出したスロットを空ける
+	if (m_bHold) {
+		m_bHold = false;
+		m_pFreeSem->Post();
+	}
+
+	if (m_pSlot == NULL || m_NextOut >= m_FrameNum) {
+		if (pError != NULL) *pError = ERROR_END;
+		return NULL;
+	}
+
+	Slot &slot = m_pSlot[m_NextOut % m_SlotNum];
+	slot.ready.Wait();
+
+	m_NextOut++;
+	m_bHold = true;
+
+	if (pFrame != NULL) *pFrame = slot.frame;
+	if (pError != NULL) *pError = slot.error;
+
+	return (slot.error == CTga::ERROR_NONE) ? &slot.tga : NULL;
+}
+
+/*=======================================================================
+【機能】先読み終了
+【備考】読み込み中のフレームの完了を待ってから終了します。
+ =======================================================================*/
+void CTgaSequence::Close(void)
+{
+	if (m_pThread != NULL) {
+		m_Mutex.Lock();
+		m_bStop = true;
+		m_Mutex.Unlock();
+
+		// 空きを待っているスレッドを起こす
+		for (uint32 i = 0; i < m_ThreadNum; i++) {
+			m_pFreeSem->Post();
+		}
+		for (uint32 i = 0; i < m_ThreadNum; i++) {
+			m_pThread[i].Join();
+		}
+	}
+
+	SAFE_DELETES(m_pThread);
+	SAFE_DELETES(m_pSlot);
+	SAFE_DELETE(m_pFreeSem);
+	SAFE_DELETES(m_pPattern);
+
+	m_FrameNum  = 0;
+	m_SlotNum   = 0;
+	m_ThreadNum = 0;
+	m_NextLoad  = 0;
+	m_NextOut   = 0;
+	m_bHold     = false;
+}
+
+/*=======================================================================
+【機能】読み込みスレッド
+【備考】非公開
+ =======================================================================*/
+void CTgaSequence::ThreadFunc(void *pArg)
+{
+	static_cast<CTgaSequence*>(pArg)->Load();
+}
+
+/*=======================================================================
+【機能】空いたスロットに次のフレームを読み込む
+【備考】非公開
+        フレームnはスロット(n % スロット数)に読み込む。空きスロットの数だけ
+        先に進めるので、n - スロット数のフレームは取り出されて空いている。
+        ファイルの読み込み用のバッファはスレッドごとに使い回す。
+ =======================================================================*/
+void CTgaSequence::Load(void)
+{
+	char path[PATH_MAX_LEN];
+	uint8 *pBuf = NULL;
+	uint32 bufSize = 0;
+
+	for (;;) {
+		m_pFreeSem->Wait();
+
+		m_Mutex.Lock();
+		if (m_bStop || m_NextLoad >= m_FrameNum) {
+			m_Mutex.Unlock();
+			m_pFreeSem->Post();		// 待っている他のスレッドも終了させる
+			break;
+		}
+		const uint32 index = m_NextLoad++;
+		m_Mutex.Unlock();
+
+		Slot &slot = m_pSlot[index % m_SlotNum];
+		slot.frame = m_First + m_Step * static_cast<sint32>(index);
+
+		// 読み込み(パスに収まらなければ開けなかったものとする)
+		FILE *fp = NULL;
+		uint32 size = 0;
+		if (CTga::ExpandPattern(path, sizeof(path), m_pPattern, slot.frame)) size = MtoFileOpen(&fp, path, "rb");
+
+		if (fp == NULL) {
+			slot.error = CTga::ERROR_OPEN;
+		} else {
+			if (size == 0) {
+				slot.error = CTga::ERROR_HEADER;
+			} else {
+				// 足りなければバッファを広げる
+				if (size > bufSize) {
+					SAFE_DELETES(pBuf);
+					bufSize = 0;
+					if ((pBuf = new uint8[size]) != NULL) bufSize = size;
+				}
+
+				if (pBuf == NULL) {
+					slot.error = CTga::ERROR_MEMORY;
+				} else if (fread(pBuf, size, 1, fp) != 1) {
+					slot.error = CTga::ERROR_OPEN;
+				} else {
+					// 同じサイズならスロットのイメージのメモリに読み込む
+					slot.error = slot.tga.Create(pBuf, size);
+				}
+			}
+			fclose(fp);
+		}
+
+		slot.ready.Post();
+	}
+
+	SAFE_DELETES(pBuf);
+}
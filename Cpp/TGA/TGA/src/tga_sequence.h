@@ -0,0 +1,66 @@
+/*=============================================================================
+ * 連番TGAの先読み
+ * "shot_%04d.tga"のような連番のファイルを、バックグラウンドのスレッドで
+ * 先読みしながら順番に取り出します。逆順の再生にも対応。
+ * mto_thread.h、mto_common.h、tga.hの順にインクルードしてから使用してください。
+=============================================================================*/
+#ifndef _TGA_SEQUENCE_H_
+#define _TGA_SEQUENCE_H_
+
+class CTgaSequence {
+public:
+	// エラータイプ(CTgaのエラータイプに追加)
+	enum {
+		ERROR_END = -8				// 最後のフレームまで取り出した
+	};
+
+	enum {
+		PATH_MAX_LEN  = 1024,		// パスの最大長
+		FRAME_NUM_MAX = 0x7fffffff	// フレーム数の最大(インデックスをsint32で扱うため)
+	};
+
+private:
+	struct Slot;
+
+	char			*m_pPattern;	// ファイル名のパターン
+	sint32			m_First;		// 最初のフレーム番号
+	sint32			m_Step;			// フレーム番号の増分(1か-1)
+	uint32			m_FrameNum;		// フレーム数
+
+	Slot			*m_pSlot;		// 先読みのリングバッファ
+	uint32			m_SlotNum;		// 先読みするフレーム数
+	CMtoThread		*m_pThread;		// 読み込みスレッド
+	uint32			m_ThreadNum;	// 読み込みスレッド数
+	CMtoSemaphore	*m_pFreeSem;	// 空いているスロット数
+
+	CMtoMutex		m_Mutex;
+	uint32			m_NextLoad;		// 次に読み込むフレーム(先頭から何番目か)
+	uint32			m_NextOut;		// 次に取り出すフレーム(先頭から何番目か)
+	bool			m_bHold;		// 取り出したスロットを使用中？
+	bool			m_bStop;		// 読み込みスレッドの停止要求
+
+	uint32			m_CreateFlag;	// CTgaの作成フラグ
+
+	// コピー禁止
+	CTgaSequence(const CTgaSequence&);
+	CTgaSequence &operator=(const CTgaSequence&);
+
+private:
+	static void ThreadFunc(void *pArg);
+	void Load(void);
+
+public:
+	CTgaSequence(void);
+	virtual ~CTgaSequence(void);
+
+	uint32 getFrameNum(void)  const {return m_FrameNum;}
+	uint32 getLookAhead(void) const {return m_SlotNum;}
+
+	void setCreateFlag(const uint32 flag) {m_CreateFlag = flag;}
+
+	bool Open(const char *pPattern, const sint32 first, const sint32 last, const uint32 lookAhead, const uint32 threadNum);
+	const CTga *Next(sint32 *pFrame, int *pError);
+	void Close(void);
+};
+
+#endif
@@ -0,0 +1,438 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+#include "tga_sidecar.h"
+
+#include <algorithm>
+#include <time.h>
+
+
+/*
+ * キャッシュファイルの形式(リトルエンディアン)
+ *
+ *  0 "TGAC"
+ *  4 バージョン(16bit)
+ *  6 予約(16bit)
+ *  8 元ファイルのパスのハッシュ値(64bit)
+ * 16 元ファイルのサイズ(64bit)
+ * 24 元ファイルの更新日時(64bit)
+ * 32 イメージのハッシュ値(64bit、未計算なら0)
+ * 40 作成フラグ(32bit、CREATE_FLAG_PREMULTIPLYのみ)
+ * 44 イメージのオフセット(32bit)
+ * 48 イメージのサイズ(32bit)
+ * 52 パレットのオフセット(32bit)
+ * 56 パレットのサイズ(32bit)
+ * 60 TGAヘッダー(18バイト、ファイルと同じ形式)
+ * 78 TGAフッター(26バイト、ファイルと同じ形式)
+ *    以降FILE_HEADER_SIZEまで0
+ *
+ * パレットはヘッダーの直後、イメージはFILE_ALIGNの境界に置く。
+ * ピクセルの並びはデコード前と同じで、TGAヘッダーのイメージ記述子で示す。
+ */
+
+namespace {
+
+// ヘッダー内の位置
+enum {
+	OFS_MAGIC       = 0,
+	OFS_VERSION     = 4,
+	OFS_PATH_HASH   = 8,
+	OFS_SOURCE_SIZE = 16,
+	OFS_SOURCE_TIME = 24,
+	OFS_IMAGE_HASH  = 32,
+	OFS_CREATE_FLAG = 40,
+	OFS_IMAGE       = 44,
+	OFS_IMAGE_SIZE  = 48,
+	OFS_PALETTE     = 52,
+	OFS_PALETTE_SIZE= 56,
+	OFS_TGA_HEADER  = 60,
+	OFS_TGA_FOOTER  = 78
+};
+
+const char FILE_MAGIC[4] = {'T', 'G', 'A', 'C'};
+const char FILE_EXT[]    = ".tgac";
+const char TEMP_EXT[]    = ".tmp";
+
+// 作業ファイルをこれより古ければ削除(異常終了の残骸)
+const sint64 TEMP_EXPIRE = 60 * 60;
+
+MTOINLINE void Put16(uint8 *p, const uint32 n) {p[0] = static_cast<uint8>(n); p[1] = static_cast<uint8>(n >> 8);}
+MTOINLINE void Put32(uint8 *p, const uint32 n) {Put16(p, n); Put16(&p[2], n >> 16);}
+MTOINLINE void Put64(uint8 *p, const uint64 n) {Put32(p, static_cast<uint32>(n)); Put32(&p[4], static_cast<uint32>(n >> 32));}
+
+MTOINLINE uint32 Get16(const uint8 *p) {return p[0] | (p[1] << 8);}
+MTOINLINE uint32 Get32(const uint8 *p) {return Get16(p) | (Get16(&p[2]) << 16);}
+MTOINLINE uint64 Get64(const uint8 *p) {return Get32(p) | (static_cast<uint64>(Get32(&p[4])) << 32);}
+
+/*=======================================================================
+【機能】拡張子の確認
+ =======================================================================*/
+bool HasExt(const char *pName, const char *pExt)
+{
+	const size_t len = strlen(pName);
+	const size_t ext = strlen(pExt);
+
+	return (len > ext && strcmp(&pName[len - ext], pExt) == 0);
+}
+
+/*=======================================================================
+【機能】ディレクトリ内のファイルのパス
+【引数】pPath：格納先(CTgaSidecar::PATH_MAX_LEN)
+        pDir ：ディレクトリ
+        pName：ファイル名
+【戻値】true：成功(長すぎる場合はfalse)
+ =======================================================================*/
+bool GetFilePath(char *pPath, const char *pDir, const char *pName)
+{
+	const size_t dirLen  = strlen(pDir);
+	const size_t nameLen = strlen(pName);
+
+	if (dirLen + 1 + nameLen >= CTgaSidecar::PATH_MAX_LEN) return false;
+
+	memcpy(pPath, pDir, dirLen);
+	pPath[dirLen] = '/';
+	memcpy(&pPath[dirLen + 1], pName, nameLen + 1);
+
+	return true;
+}
+
+/*=======================================================================
+【機能】Trimで集めるキャッシュファイル
+ =======================================================================*/
+struct TrimFile {
+	char	name[64];
+	uint64	size;
+	sint64	time;
+
+	bool operator<(const TrimFile &file) const {return (time < file.time);}
+};
+
+struct TrimList {
+	const char	*pDir;
+	TrimFile	*pFile;
+	uint32		num;
+	uint32		max;
+	uint64		total;
+	sint64		now;
+};
+
+/*=======================================================================
+【機能】キャッシュファイルを集める(MtoDirScanから呼ばれる)
+ =======================================================================*/
+void TrimScan(const char *pName, const MtoFileStatus &status, void *pUser)
+{
+	TrimList *pList = static_cast<TrimList*>(pUser);
+
+	if (strlen(pName) >= sizeof(pList->pFile->name)) return;
+
+	// 古い作業ファイルは削除
+	if (HasExt(pName, TEMP_EXT)) {
+		if (status.time + TEMP_EXPIRE < pList->now) {
+			char path[CTgaSidecar::PATH_MAX_LEN];
+			if (GetFilePath(path, pList->pDir, pName)) MtoFileRemove(path);
+		}
+		return;
+	}
+
+	if (!HasExt(pName, FILE_EXT)) return;
+
+	// 足りなくなったら広げる
+	if (pList->num == pList->max) {
+		const uint32 max = (pList->max != 0) ? pList->max * 2 : 256;
+		TrimFile *pFile = new TrimFile[max];
+		if (pFile == NULL) return;
+		if (pList->pFile != NULL) memcpy(pFile, pList->pFile, sizeof(TrimFile) * pList->num);
+		SAFE_DELETES(pList->pFile);
+		pList->pFile = pFile;
+		pList->max   = max;
+	}
+
+	TrimFile &file = pList->pFile[pList->num++];
+	strcpy(file.name, pName);
+	file.size = status.size;
+	file.time = status.time;
+
+	pList->total += status.size;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】
+【引数】pDir ：キャッシュディレクトリ(作成済みのもの)
+        limit：キャッシュディレクトリの上限(バイト、0なら無制限)
+ =======================================================================*/
+CTgaSidecar::CTgaSidecar(const char *pDir, const uint64 limit)
+{
+	m_pDir     = NULL;
+	m_Limit    = limit;
+	m_Usage    = 0;
+	m_bScanned = false;
+
+	if (pDir == NULL) return;
+
+	// 末尾の区切り文字は除く
+	size_t len = strlen(pDir);
+	while (len > 1 && (pDir[len - 1] == '/' || pDir[len - 1] == '\\')) len--;
+
+	if ((m_pDir = new char[len + 1]) != NULL) {
+		memcpy(m_pDir, pDir, len);
+		m_pDir[len] = '\0';
+	}
+}
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTgaSidecar::~CTgaSidecar(void)
+{
+	SAFE_DELETES(m_pDir);
+}
+
+/*=======================================================================
+【機能】キャッシュから読み込み
+【引数】pTga     ：作成先
+        pFileName：元ファイル名
+        pStatus  ：元ファイルの状態の格納先(Storeに渡す)
+【戻値】エラータイプ(ERROR_NONE以外ならキャッシュなし)
+【備考】元ファイルのサイズと更新日時、作成フラグが同じ場合だけ使います。
+        キャッシュファイルはマップしたままになり、pTgaのイメージと
+        パレットはその中を指します。
+ =======================================================================*/
+int CTgaSidecar::Load(CTga *pTga, const char *pFileName, MtoFileStatus *pStatus) const
+{
+	char path[PATH_MAX_LEN];
+
+	if (!MtoFileGetStatus(pFileName, pStatus)) return CTga::ERROR_OPEN;
+
+	const uint64 hash = TgaKernelHash64(pFileName, static_cast<uint32>(strlen(pFileName)), 0);
+	if (!this->GetPath(path, hash, FILE_EXT)) return CTga::ERROR_OPEN;
+
+	CMtoFileMap *pMap = new CMtoFileMap;
+	if (pMap == NULL) return CTga::ERROR_MEMORY;
+	if (!pMap->Open(path) || pMap->getSize() < FILE_HEADER_SIZE) {
+		SAFE_DELETE(pMap);
+		return CTga::ERROR_OPEN;
+	}
+
+	uint8 *pSrc = pMap->getData();
+	const uint64 size = pMap->getSize();
+	const uint32 flag = pTga->m_CreateFlag & CTga::CREATE_FLAG_PREMULTIPLY;
+
+	// 元ファイルが更新されていないか
+	if (memcmp(&pSrc[OFS_MAGIC], FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+		Get16(&pSrc[OFS_VERSION]) != FILE_VERSION ||
+		Get64(&pSrc[OFS_PATH_HASH]) != hash ||
+		Get64(&pSrc[OFS_SOURCE_SIZE]) != pStatus->size ||
+		static_cast<sint64>(Get64(&pSrc[OFS_SOURCE_TIME])) != pStatus->time ||
+		Get32(&pSrc[OFS_CREATE_FLAG]) != flag) {
+		SAFE_DELETE(pMap);
+		return CTga::ERROR_HEADER;
+	}
+
+	// 範囲の確認
+	const uint32 imageOffset   = Get32(&pSrc[OFS_IMAGE]);
+	const uint32 imageSize     = Get32(&pSrc[OFS_IMAGE_SIZE]);
+	const uint32 paletteOffset = Get32(&pSrc[OFS_PALETTE]);
+	const uint32 paletteSize   = Get32(&pSrc[OFS_PALETTE_SIZE]);
+
+	if (static_cast<uint64>(imageOffset) + imageSize > size || static_cast<uint64>(paletteOffset) + paletteSize > size) {
+		SAFE_DELETE(pMap);
+		return CTga::ERROR_IMAGE;
+	}
+
+	// 既に作成しているなら削除
+	if (pTga->m_pImage != NULL || pTga->m_pLazy != NULL) {
+		pTga->Clear();
+	}
+
+	// ヘッダーとサイズの確認
+	if (!pTga->ReadHeader(&pSrc[OFS_TGA_HEADER]) || !pTga->CalcSize(false) ||
+		pTga->m_ImageSize != imageSize || pTga->m_PaletteSize != paletteSize || imageSize == 0) {
+		pTga->Clear();
+		SAFE_DELETE(pMap);
+		return CTga::ERROR_HEADER;
+	}
+	pTga->ReadFooter(pSrc, OFS_TGA_FOOTER);
+
+	pTga->m_pMap           = pMap;
+	pTga->m_pImage         = &pSrc[imageOffset];
+	pTga->m_pPalette       = (paletteSize != 0) ? &pSrc[paletteOffset] : NULL;
+	pTga->m_bPremultiplied = (flag != 0);
+	pTga->m_Hash           = Get64(&pSrc[OFS_IMAGE_HASH]);
+
+	if ((pTga->m_CreateFlag & CTga::CREATE_FLAG_HASH) && pTga->m_Hash == 0) {
+		pTga->CalcHash();
+	}
+
+	// 使われたことを記録(Trimで古い順に削除するため)
+	MtoFileTouch(path);
+
+	return CTga::ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】キャッシュに保存
+【引数】tga      ：読み込んだTGA
+        pFileName：元ファイル名
+        status   ：読み込み前に取得した元ファイルの状態
+【戻値】true：保存した
+【備考】作業ファイルに書き出してから置き換えるので、途中の状態のファイルが
+        読まれることはありません。
+        ディレクトリの使用量は最初のTrimで数え、以降は保存した分を足して
+        上限を超えた時だけTrimします(ディレクトリを毎回調べないため)。
+ =======================================================================*/
+bool CTgaSidecar::Store(const CTga &tga, const char *pFileName, const MtoFileStatus &status) const
+{
+	char path[PATH_MAX_LEN];
+	char temp[PATH_MAX_LEN];
+	char ext[64];
+
+	// 読み込んだ直後のものだけ
+	if (tga.m_pImage == NULL || tga.m_pMap != NULL || tga.m_bRGBA) return false;
+
+	const uint32 paletteOffset = FILE_HEADER_SIZE;
+	const uint32 imageOffset   = BOUND(paletteOffset + tga.m_PaletteSize, FILE_ALIGN);
+	const uint64 size          = static_cast<uint64>(imageOffset) + tga.m_ImageSize;
+
+	if (m_Limit != 0 && size > m_Limit) return false;
+
+	const uint64 hash = TgaKernelHash64(pFileName, static_cast<uint32>(strlen(pFileName)), 0);
+	sprintf(ext, ".%lu.%p%s", MtoGetProcessId(), static_cast<const void*>(&tga), TEMP_EXT);
+	if (!this->GetPath(path, hash, FILE_EXT) || !this->GetPath(temp, hash, ext)) return false;
+
+	// ヘッダー作成
+	const CTga::TGAHeader &header = tga.m_Header;
+	uint8 head[FILE_HEADER_SIZE];
+	memset(head, 0, sizeof(head));
+
+	memcpy(&head[OFS_MAGIC], FILE_MAGIC, sizeof(FILE_MAGIC));
+	Put16(&head[OFS_VERSION],      FILE_VERSION);
+	Put64(&head[OFS_PATH_HASH],    hash);
+	Put64(&head[OFS_SOURCE_SIZE],  status.size);
+	Put64(&head[OFS_SOURCE_TIME],  static_cast<uint64>(status.time));
+	Put64(&head[OFS_IMAGE_HASH],   tga.m_Hash);
+	Put32(&head[OFS_CREATE_FLAG],  tga.m_bPremultiplied ? CTga::CREATE_FLAG_PREMULTIPLY : 0);
+	Put32(&head[OFS_IMAGE],        imageOffset);
+	Put32(&head[OFS_IMAGE_SIZE],   tga.m_ImageSize);
+	Put32(&head[OFS_PALETTE],      paletteOffset);
+	Put32(&head[OFS_PALETTE_SIZE], tga.m_PaletteSize);
+
+	uint8 *p = &head[OFS_TGA_HEADER];
+	*p++ = header.IDField;
+	*p++ = header.usePalette;
+	*p++ = header.imageType;
+	Put16(p, header.paletteIndex); p += 2;
+	Put16(p, header.paletteColor); p += 2;
+	*p++ = header.paletteBit;
+	Put16(p, header.imageX); p += 2;
+	Put16(p, header.imageY); p += 2;
+	Put16(p, header.imageW); p += 2;
+	Put16(p, header.imageH); p += 2;
+	*p++ = header.imageBit;
+	*p++ = header.discripter;
+
+	_ASSERT(p == &head[OFS_TGA_FOOTER]);
+	memcpy(p, &tga.m_Footer.filePos, sizeof(tga.m_Footer.filePos)); p += sizeof(tga.m_Footer.filePos);
+	memcpy(p, &tga.m_Footer.fileDev, sizeof(tga.m_Footer.fileDev)); p += sizeof(tga.m_Footer.fileDev);
+	memcpy(p, tga.m_Footer.version,  sizeof(tga.m_Footer.version));
+
+	// 作業ファイルに書き出し
+	FILE *fp;
+	if ((fp = fopen(temp, "wb")) == NULL) return false;
+
+	static const uint8 pad[FILE_ALIGN] = {0};
+	bool bResult = (fwrite(head, sizeof(head), 1, fp) == 1);
+	if (bResult && tga.m_PaletteSize != 0) {
+		bResult = (fwrite(tga.m_pPalette, tga.m_PaletteSize, 1, fp) == 1);
+	}
+	if (bResult && imageOffset > paletteOffset + tga.m_PaletteSize) {
+		bResult = (fwrite(pad, imageOffset - paletteOffset - tga.m_PaletteSize, 1, fp) == 1);
+	}
+	if (bResult) {
+		bResult = (fwrite(tga.m_pImage, tga.m_ImageSize, 1, fp) == 1);
+	}
+	if (fclose(fp) != 0) bResult = false;
+
+	// 置き換え
+	if (!bResult || !MtoFileReplace(temp, path)) {
+		MtoFileRemove(temp);
+		return false;
+	}
+
+	if (m_Limit != 0) {
+		bool bTrim;
+		{
+			CMtoLock lock(m_Mutex);
+			m_Usage += size;
+			bTrim = (!m_bScanned || m_Usage > m_Limit);
+		}
+		if (bTrim) this->Trim();
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】上限を超えた分を古い順に削除
+【備考】更新日時(最後に使われた日時)の古い順に、上限の1/TRIM_MARGINだけ
+        余裕ができるまで削除します。
+        他のプロセスが使用中のファイルはWindowsでは削除できないので、
+        一時的に上限を超えることがあります。
+ =======================================================================*/
+void CTgaSidecar::Trim(void) const
+{
+	if (m_pDir == NULL) return;
+
+	TrimList list;
+	list.pDir  = m_pDir;
+	list.pFile = NULL;
+	list.num   = 0;
+	list.max   = 0;
+	list.total = 0;
+	list.now   = static_cast<sint64>(time(NULL));
+
+	if (!MtoDirScan(m_pDir, TrimScan, &list)) return;
+
+	if (m_Limit != 0 && list.total > m_Limit) {
+		const uint64 target = m_Limit - m_Limit / TRIM_MARGIN;
+		std::sort(list.pFile, list.pFile + list.num);
+
+		for (uint32 i = 0; i < list.num && list.total > target; i++) {
+			char path[PATH_MAX_LEN];
+			if (!GetFilePath(path, m_pDir, list.pFile[i].name)) continue;
+			if (MtoFileRemove(path)) list.total -= list.pFile[i].size;
+		}
+	}
+
+	SAFE_DELETES(list.pFile);
+
+	CMtoLock lock(m_Mutex);
+	m_Usage    = list.total;
+	m_bScanned = true;
+}
+
+/*=======================================================================
+【機能】キャッシュファイルのパス
+【引数】pPath：格納先(PATH_MAX_LEN)
+        hash ：元ファイルのパスのハッシュ値
+        pExt ：拡張子
+【備考】非公開
+ =======================================================================*/
+bool CTgaSidecar::GetPath(char *pPath, const uint64 hash, const char *pExt) const
+{
+	if (m_pDir == NULL) return false;
+
+	const size_t dirLen = strlen(m_pDir);
+	const size_t extLen = strlen(pExt);
+	if (dirLen + 1 + 16 + extLen >= PATH_MAX_LEN) return false;
+
+	memcpy(pPath, m_pDir, dirLen);
+	sprintf(&pPath[dirLen], "/%08x%08x", static_cast<uint32>(hash >> 32), static_cast<uint32>(hash));
+	memcpy(&pPath[dirLen + 1 + 16], pExt, extLen + 1);
+
+	return true;
+}
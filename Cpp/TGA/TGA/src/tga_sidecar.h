@@ -0,0 +1,48 @@
+/*=============================================================================
+ * デコード済みTGAのファイルキャッシュ
+ * 元ファイルのパスごとにデコード済みのイメージをキャッシュディレクトリに
+ * 保存しておき、元ファイルのサイズと更新日時が同じならマップして使います。
+ * CTga::setSidecarで指定すると、CTga::Create(ファイル名)で使われます。
+ * mto_thread.h、mto_file.h、mto_common.h、tga.hの順にインクルードしてから使用してください。
+=============================================================================*/
+#ifndef _TGA_SIDECAR_H_
+#define _TGA_SIDECAR_H_
+
+class CTgaSidecar {
+public:
+	enum {
+		FILE_VERSION = 1,			// キャッシュファイルのバージョン
+		FILE_HEADER_SIZE = 128,		// キャッシュファイルのヘッダーサイズ
+		FILE_ALIGN = 64,			// イメージの配置境界
+		PATH_MAX_LEN = 1024,		// パスの最大長
+		TRIM_MARGIN = 8				// 上限を超えたら上限の1/TRIM_MARGINだけ余分に削除する
+	};
+
+private:
+	char		*m_pDir;			// キャッシュディレクトリ
+	uint64		m_Limit;			// キャッシュディレクトリの上限(0なら無制限)
+
+	mutable uint64	m_Usage;		// キャッシュディレクトリの使用量(Trimで数えた値に保存した分を足したもの)
+	mutable bool	m_bScanned;		// 使用量を数えた？
+	mutable CMtoMutex m_Mutex;
+
+	// コピー禁止
+	CTgaSidecar(const CTgaSidecar&);
+	CTgaSidecar &operator=(const CTgaSidecar&);
+
+private:
+	bool GetPath(char *pPath, const uint64 hash, const char *pExt) const;
+
+public:
+	CTgaSidecar(const char *pDir, const uint64 limit);
+	virtual ~CTgaSidecar(void);
+
+	const char *getDir(void) const {return m_pDir;}
+	uint64 getLimit(void)    const {return m_Limit;}
+
+	int  Load(CTga *pTga, const char *pFileName, MtoFileStatus *pStatus) const;
+	bool Store(const CTga &tga, const char *pFileName, const MtoFileStatus &status) const;
+	void Trim(void) const;
+};
+
+#endif
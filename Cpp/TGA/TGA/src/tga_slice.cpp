@@ -0,0 +1,263 @@
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+
+/*=======================================================================
+【機能】ファイル名のパターンの確認
+【引数】pPattern：パターン
+        pathMax ：展開先のバッファのサイズ
+【戻値】true：整数の変換指定(%d、%04dなど)が1つだけあり、展開してもpathMaxに収まる
+【備考】Slice、CTgaSequenceで共通の形式です。
+        幅はPATTERN_WIDTH_MAXまでなので、展開後の長さは元の長さ+PATTERN_WIDTH_MAX未満です。
+ =======================================================================*/
+bool CTga::CheckPattern(const char *pPattern, const uint32 pathMax)
+{
+	uint32 count = 0;
+
+	for (const char *p = pPattern; *p != '\0'; p++) {
+		if (*p != '%') continue;
+		if (*++p == '%') continue;
+
+		// フラグと幅
+		while (*p == '0' || *p == '-' || *p == '+' || *p == ' ') p++;
+
+		uint32 width = 0;
+		while (MtoIsNumber(*p)) {
+			width = width * 10 + (*p++ - '0');
+			if (width > PATTERN_WIDTH_MAX) return false;
+		}
+
+		if (*p != 'd' && *p != 'i') return false;
+		count++;
+	}
+
+	if (count != 1) return false;
+	return (strlen(pPattern) + PATTERN_WIDTH_MAX < pathMax);
+}
+
+/*=======================================================================
+【機能】ファイル名のパターンに番号を入れる
+【引数】pPath   ：展開先
+        pathMax ：展開先のバッファのサイズ
+        pPattern：パターン(CheckPatternで確認したもの)
+        number  ：番号
+【戻値】false：展開先に収まらなかった(pPathは空文字列)
+【備考】Slice、CTgaSequenceで共通の形式です。
+ =======================================================================*/
+bool CTga::ExpandPattern(char *pPath, const uint32 pathMax, const char *pPattern, const sint32 number)
+{
+#if defined(_WIN32)
+	const int len = _snprintf(pPath, pathMax, pPattern, number);
+#else
+	const int len = snprintf(pPath, pathMax, pPattern, number);
+#endif
+
+	// 切り詰められたら(_snprintfは-1か、終端なしでpathMax)使わない
+	if (len < 0 || static_cast<uint32>(len) >= pathMax) {
+		pPath[0] = '\0';
+		return false;
+	}
+	return true;
+}
+
+
+/*=======================================================================
+【機能】範囲が全部透明か
+【引数】rect       ：範囲
+        pClearIndex：パレットの色ごとの透明フラグ(インデックスカラーの場合)
+【戻値】true:全部透明
+【備考】非公開
+        範囲のラインだけを保存の並びのまま調べる(32bitはカーネルでまとめて調べる)。
+ =======================================================================*/
+bool CTga::IsClearRect(const TGARect &rect, const uint8 *pClearIndex) const
+{
+	const uint32 w    = m_Header.imageW;
+	const uint32 byte = m_Header.imageBit >> 3;
+	const uint32 sx   = (m_Header.discripter & 0x10) ? (w - rect.x - rect.w) : rect.x;
+
+	for (uint32 y = 0; y < rect.h; y++) {
+		const uint8 *pSrc = &this->GetLinePtr(rect.y + y)[sx * byte];
+
+		if (pClearIndex != NULL) {
+			for (uint32 x = 0; x < rect.w; x++) {
+				if (!pClearIndex[pSrc[x]]) return false;
+			}
+		} else if (byte == 4) {
+			if (TgaKernelFindAlpha32(pSrc, rect.w) < rect.w) return false;
+		} else {
+			// 16bit(ARGB:1555)
+			for (uint32 x = 0; x < rect.w; x++) {
+				if (pSrc[x * 2 + 1] & 0x80) return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】範囲ごとに切り出してファイル出力
+【引数】pPattern：ファイル名のパターン(整数の変換指定を1つ含むprintf形式、範囲の番号が入る)
+        pRect   ：切り出す範囲
+        num     ：範囲の数
+        flag    ：切り出しフラグ(SLICE_FLAG_*)
+        pOutNum ：出力したファイル数の格納先(NULLなら格納しない)
+【戻値】エラータイプ
+【備考】範囲ごとに並列で、元のイメージから範囲のラインだけをコピーして出力します。
+        ピクセルの並び、ビット数、パレットは元のままです。
+        SLICE_FLAG_SKIPならアルファが全部0の範囲は出力しません(番号は飛ばす)。
+        アルファがないイメージは透明な範囲がないものとして扱います。
+        範囲が1つでもイメージからはみ出していれば何も出力しません。
+ =======================================================================*/
+int CTga::Slice(const char *pPattern, const TGARect *pRect, const uint32 num, const uint32 flag, uint32 *pOutNum) const
+{
+#ifndef NDEBUG
+	_ASSERT(pPattern != NULL);
+	_ASSERT(pRect != NULL || num == 0);
+#else
+	if (pPattern == NULL || (pRect == NULL && num != 0)) return ERROR_OUTPUT;
+#endif
+
+	if (pOutNum != NULL) *pOutNum = 0;
+
+	if (!CTga::CheckPattern(pPattern, SLICE_PATH_MAX_LEN)) return ERROR_OUTPUT;
+	if (!this->Decode()) return ERROR_IMAGE;
+	if (m_pImage == NULL) return ERROR_IMAGE;
+
+	// 範囲の確認
+	for (uint32 i = 0; i < num; i++) {
+		const TGARect &rect = pRect[i];
+		if (rect.w == 0 || rect.h == 0) return ERROR_IMAGE;
+		if (rect.x + rect.w > m_Header.imageW || rect.y + rect.h > m_Header.imageH) return ERROR_IMAGE;
+	}
+
+	// 透明な範囲を調べるか
+	const bool bIndex = (m_Header.imageType == IMAGE_TYPE_INDEX || m_Header.imageType == IMAGE_TYPE_INDEX_RLE);
+	uint8 clearIndex[256];
+	bool bSkip = false;
+
+	if (flag & SLICE_FLAG_SKIP) {
+		if (bIndex) {
+			if (m_Header.paletteBit == 32) {
+				// パレットの番号ごとに透明か(範囲外の番号は0番の色)
+				const uint32 color = (m_Header.paletteColor < 256) ? m_Header.paletteColor : 256;
+				memset(clearIndex, 0, sizeof(clearIndex));
+				for (uint32 i = 0; i < color; i++) clearIndex[i] = (m_pPalette[i * 4 + 3] == 0);
+				for (uint32 i = color; i < 256; i++) clearIndex[i] = clearIndex[0];
+				bSkip = true;
+			}
+		} else {
+			bSkip = this->IsAlphaImage();
+		}
+	}
+
+	const uint32 byte  = m_Header.imageBit >> 3;
+	const bool   bTop  = (m_Header.discripter & 0x20) ? true : false;
+	const bool   bRL   = (m_Header.discripter & 0x10) ? true : false;
+	const sint32 count = static_cast<sint32>(num);
+	uint32 outNum = 0;
+	int ret = ERROR_NONE;
+
+#pragma omp parallel for schedule(dynamic)
+	for (sint32 i = 0; i < count; i++) {
+		if (ret != ERROR_NONE) continue;
+
+		const TGARect &rect = pRect[i];
+
+		if (bSkip && this->IsClearRect(rect, bIndex ? clearIndex : NULL)) continue;
+
+		// 範囲のラインだけコピー(ラインの並びは元と同じ)
+		const uint32 line = rect.w * byte;
+		const uint32 sx   = bRL ? (m_Header.imageW - rect.x - rect.w) : rect.x;
+		uint8 *pImage   = new uint8[line * rect.h];
+		uint8 *pPalette = (m_pPalette != NULL) ? new uint8[m_PaletteSize] : NULL;
+		int err = ERROR_MEMORY;
+
+		if (pImage != NULL && (m_pPalette == NULL || pPalette != NULL)) {
+			for (uint32 y = 0; y < rect.h; y++) {
+				const uint32 ty = bTop ? y : (rect.h - y - 1);
+				memcpy(&pImage[y * line], &this->GetLinePtr(rect.y + ty)[sx * byte], line);
+			}
+			if (pPalette != NULL) memcpy(pPalette, m_pPalette, m_PaletteSize);
+
+			TGAHeader header = m_Header;
+			header.IDField = 0;
+			header.imageW  = rect.w;
+			header.imageH  = rect.h;
+
+			CTga tga;
+			err = tga.Create(header, pImage, line * rect.h, pPalette, (pPalette != NULL) ? m_PaletteSize : 0);
+
+			if (err == ERROR_NONE) {
+				// イメージとパレットはtgaが削除する
+				pImage   = NULL;
+				pPalette = NULL;
+
+				char path[SLICE_PATH_MAX_LEN];
+				if (!CTga::ExpandPattern(path, sizeof(path), pPattern, i)) {
+					err = ERROR_OUTPUT;
+				} else {
+					tga.m_bRGBA          = m_bRGBA;
+					tga.m_bPremultiplied = m_bPremultiplied;
+					tga.setRLE((flag & SLICE_FLAG_RLE) ? true : false);
+					err = tga.Output(path);
+				}
+			}
+		}
+
+		SAFE_DELETES(pImage);
+		SAFE_DELETES(pPalette);
+
+#pragma omp critical
+		{
+			if (err == ERROR_NONE) {
+				outNum++;
+			} else if (ret == ERROR_NONE) {
+				ret = err;
+			}
+		}
+	}
+
+	if (pOutNum != NULL) *pOutNum = outNum;
+
+	return ret;
+}
+
+/*=======================================================================
+【機能】同じ大きさの格子に切り出してファイル出力
+【引数】pPattern    ：ファイル名のパターン(左上から右へ数えた番号が入る)
+        cellW、cellH：1つの大きさ
+        flag        ：切り出しフラグ(SLICE_FLAG_*)
+        pOutNum     ：出力したファイル数の格納先(NULLなら格納しない)
+【戻値】エラータイプ
+【備考】右と下の端で大きさに満たない部分は出力しません。
+ =======================================================================*/
+int CTga::SliceGrid(const char *pPattern, const uint32 cellW, const uint32 cellH, const uint32 flag, uint32 *pOutNum) const
+{
+	if (pOutNum != NULL) *pOutNum = 0;
+
+	if (!this->Decode()) return ERROR_IMAGE;
+	if (m_pImage == NULL || cellW == 0 || cellH == 0) return ERROR_IMAGE;
+
+	const uint32 col = m_Header.imageW / cellW;
+	const uint32 row = m_Header.imageH / cellH;
+	if (col == 0 || row == 0) return ERROR_NONE;
+
+	TGARect *pRect;
+	if ((pRect = new TGARect[col * row]) == NULL) return ERROR_MEMORY;
+
+	for (uint32 y = 0; y < row; y++) {
+		for (uint32 x = 0; x < col; x++) {
+			TGARect &rect = pRect[y * col + x];
+			rect.x = static_cast<uint16>(x * cellW);
+			rect.y = static_cast<uint16>(y * cellH);
+			rect.w = static_cast<uint16>(cellW);
+			rect.h = static_cast<uint16>(cellH);
+		}
+	}
+
+	int ret = this->Slice(pPattern, pRect, col * row, flag, pOutNum);
+	SAFE_DELETES(pRect);
+
+	return ret;
+}
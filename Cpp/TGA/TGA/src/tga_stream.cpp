@@ -0,0 +1,442 @@
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_kernel.h"
+#include "tga_stream.h"
+
+#include <errno.h>
+#if defined(_WIN32)
+#include <io.h>
+#endif
+
+
+namespace {
+
+enum {
+	FD_IO_MAX = 0x40000000		// 1回のread/writeの最大サイズ(Windowsはintなので)
+};
+
+} // namespace
+
+
+/*=======================================================================
+【機能】ファイルディスクリプタから読み込み
+【引数】pDst ：格納先
+        size ：サイズ
+        pUser：ファイルディスクリプタ(int*)
+【戻値】読み込んだバイト数(0：終わりかエラー)
+【備考】シグナルで中断された場合は読み直します。
+ =======================================================================*/
+uint32 TgaStreamReadFd(void *pDst, const uint32 size, void *pUser)
+{
+	const int fd = *static_cast<const int*>(pUser);
+	const uint32 len = (size < FD_IO_MAX) ? size : FD_IO_MAX;
+
+	for (;;) {
+#if defined(_WIN32)
+		const int n = _read(fd, pDst, len);
+#else
+		const ssize_t n = read(fd, pDst, len);
+#endif
+		if (n >= 0) return static_cast<uint32>(n);
+		if (errno != EINTR) return 0;
+	}
+}
+
+/*=======================================================================
+【機能】ファイルディスクリプタへ書き込み
+【引数】pSrc ：書き込むデータ
+        size ：サイズ
+        pUser：ファイルディスクリプタ(int*)
+【戻値】書き込んだバイト数(0：エラー)
+ =======================================================================*/
+uint32 TgaStreamWriteFd(const void *pSrc, const uint32 size, void *pUser)
+{
+	const int fd = *static_cast<const int*>(pUser);
+	const uint32 len = (size < FD_IO_MAX) ? size : FD_IO_MAX;
+
+	for (;;) {
+#if defined(_WIN32)
+		const int n = _write(fd, pSrc, len);
+#else
+		const ssize_t n = write(fd, pSrc, len);
+#endif
+		if (n >= 0) return static_cast<uint32>(n);
+		if (errno != EINTR) return 0;
+	}
+}
+
+/*=======================================================================
+【機能】FILEポインタから読み込み
+【引数】pDst ：格納先
+        size ：サイズ
+        pUser：FILEポインタ
+【戻値】読み込んだバイト数(0：終わりかエラー)
+ =======================================================================*/
+uint32 TgaStreamReadFILE(void *pDst, const uint32 size, void *pUser)
+{
+	return static_cast<uint32>(fread(pDst, 1, size, static_cast<FILE*>(pUser)));
+}
+
+/*=======================================================================
+【機能】FILEポインタへ書き込み
+【引数】pSrc ：書き込むデータ
+        size ：サイズ
+        pUser：FILEポインタ
+【戻値】書き込んだバイト数(0：エラー)
+ =======================================================================*/
+uint32 TgaStreamWriteFILE(const void *pSrc, const uint32 size, void *pUser)
+{
+	return static_cast<uint32>(fwrite(pSrc, 1, size, static_cast<FILE*>(pUser)));
+}
+
+
+/*=======================================================================
+【機能】
+【引数】func ：読み込み関数
+        pUser：funcに渡す値
+ =======================================================================*/
+CTgaStreamReader::CTgaStreamReader(TgaStreamReadFunc func, void *pUser)
+{
+	m_Func    = func;
+	m_pUser   = pUser;
+	m_pBuffer = new uint8[BUFFER_SIZE];
+	m_Pos     = 0;
+	m_End     = 0;
+	m_bEnd    = (func == NULL || m_pBuffer == NULL);
+}
+
+/*=======================================================================
+【機能】
+ =======================================================================*/
+CTgaStreamReader::~CTgaStreamReader(void)
+{
+	SAFE_DELETES(m_pBuffer);
+}
+
+/*=======================================================================
+【機能】先読み
+【引数】size：サイズ(BUFFER_SIZE以下)
+【戻値】バッファ内のアドレス(NULL：sizeバイト読めない)
+【備考】読み込み位置は進めないので、Skipで進めてください。
+ =======================================================================*/
+const uint8 *CTgaStreamReader::Peek(const uint32 size)
+{
+	if (m_End - m_Pos >= size) return &m_pBuffer[m_Pos];
+	if (size > BUFFER_SIZE || m_bEnd) return NULL;
+
+	// 残りを先頭に詰めて、足りない分を読む
+	memmove(m_pBuffer, &m_pBuffer[m_Pos], m_End - m_Pos);
+	m_End -= m_Pos;
+	m_Pos  = 0;
+
+	while (m_End < size) {
+		const uint32 n = m_Func(&m_pBuffer[m_End], BUFFER_SIZE - m_End, m_pUser);
+		if (n == 0) {
+			m_bEnd = true;
+			return NULL;
+		}
+		m_End += n;
+	}
+
+	return m_pBuffer;
+}
+
+/*=======================================================================
+【機能】読み飛ばし
+【引数】size：サイズ
+ =======================================================================*/
+void CTgaStreamReader::Skip(const uint32 size)
+{
+	uint32 rest = size;
+
+	while (rest > 0) {
+		if (m_Pos == m_End && this->Peek(1) == NULL) return;
+
+		const uint32 n = (m_End - m_Pos < rest) ? (m_End - m_Pos) : rest;
+		m_Pos += n;
+		rest  -= n;
+	}
+}
+
+/*=======================================================================
+【機能】読み込み
+【引数】pDst：格納先
+        size：サイズ
+【戻値】読み込んだバイト数(sizeより少なければ終わりに達した)
+【備考】BUFFER_SIZE以上残っている分はバッファを通さずに直接読み込みます。
+ =======================================================================*/
+uint32 CTgaStreamReader::Read(void *pDst, const uint32 size)
+{
+	uint8 *pWork = static_cast<uint8*>(pDst);
+	uint32 rest = size;
+
+	// バッファに残っている分
+	const uint32 n = (m_End - m_Pos < rest) ? (m_End - m_Pos) : rest;
+	memcpy(pWork, &m_pBuffer[m_Pos], n);
+	m_Pos += n;
+	pWork += n;
+	rest  -= n;
+
+	// 大きければ直接
+	while (rest >= BUFFER_SIZE && !m_bEnd) {
+		const uint32 len = m_Func(pWork, rest, m_pUser);
+		if (len == 0) {
+			m_bEnd = true;
+			break;
+		}
+		pWork += len;
+		rest  -= len;
+	}
+
+	// 残りはバッファから
+	while (rest > 0) {
+		const uint32 len = (rest < BUFFER_SIZE) ? rest : BUFFER_SIZE;
+		const uint8 *pSrc = this->Peek(len);
+		if (pSrc == NULL) {
+			// 足りなければ読めた分だけ
+			const uint32 last = (m_End - m_Pos < rest) ? (m_End - m_Pos) : rest;
+			memcpy(pWork, &m_pBuffer[m_Pos], last);
+			m_Pos += last;
+			rest  -= last;
+			break;
+		}
+		memcpy(pWork, pSrc, len);
+		m_Pos += len;
+		pWork += len;
+		rest  -= len;
+	}
+
+	return size - rest;
+}
+
+
+/*=======================================================================
+【機能】
+【引数】func ：書き込み関数
+        pUser：funcに渡す値
+ =======================================================================*/
+CTgaStreamWriter::CTgaStreamWriter(TgaStreamWriteFunc func, void *pUser)
+{
+	m_Func    = func;
+	m_pUser   = pUser;
+	m_pBuffer = new uint8[BUFFER_SIZE];
+	m_Size    = 0;
+	m_bError  = (func == NULL || m_pBuffer == NULL);
+}
+
+/*=======================================================================
+【機能】
+【備考】書き込んでいない分は捨てるので、先にFlushを呼んでください。
+ =======================================================================*/
+CTgaStreamWriter::~CTgaStreamWriter(void)
+{
+	SAFE_DELETES(m_pBuffer);
+}
+
+/*=======================================================================
+【機能】書き込み関数で全部書く
+【引数】pSrc：書き込むデータ
+        size：サイズ
+【戻値】true：成功
+【備考】非公開
+ =======================================================================*/
+bool CTgaStreamWriter::WriteDirect(const uint8 *pSrc, uint32 size)
+{
+	while (size > 0) {
+		const uint32 n = m_Func(pSrc, size, m_pUser);
+		if (n == 0) {
+			m_bError = true;
+			return false;
+		}
+		pSrc += n;
+		size -= n;
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】書き込み
+【引数】pSrc：書き込むデータ
+        size：サイズ
+【戻値】true：成功(一度失敗したら以降は全部false)
+【備考】BUFFER_SIZE以上のデータはバッファを通さずに直接書き込みます。
+ =======================================================================*/
+bool CTgaStreamWriter::Write(const void *pSrc, const uint32 size)
+{
+	if (m_bError) return false;
+
+	// 入りきらなければ先に書き出す
+	if (m_Size + static_cast<uint64>(size) > BUFFER_SIZE) {
+		if (!this->Flush()) return false;
+	}
+
+	if (size >= BUFFER_SIZE) {
+		return this->WriteDirect(static_cast<const uint8*>(pSrc), size);
+	}
+
+	memcpy(&m_pBuffer[m_Size], pSrc, size);
+	m_Size += size;
+
+	return true;
+}
+
+/*=======================================================================
+【機能】バッファに溜まっている分を書き出す
+【戻値】true：成功
+ =======================================================================*/
+bool CTgaStreamWriter::Flush(void)
+{
+	if (m_bError) return false;
+
+	const uint32 size = m_Size;
+	m_Size = 0;
+
+	return this->WriteDirect(m_pBuffer, size);
+}
+
+
+/*=======================================================================
+【機能】ストリームから作成
+【引数】pReader：読み込み元
+【備考】ファイルの終わりを調べられないので、フッターはイメージの直後に
+        FOOTER_SIZEバイト読めた場合だけ読み込みます(Create(メモリ)と同じ位置)。
+        それ以降は読まないので、続けて次の画像を読むこともできます。
+        CREATE_FLAG_LAZYとsetSidecarのキャッシュは使いません。
+ =======================================================================*/
+int CTga::Create(CTgaStreamReader *pReader)
+{
+#ifndef NDEBUG
+	_ASSERT(pReader != NULL);
+#else
+	if (pReader == NULL) return ERROR_OPEN;
+#endif
+
+	// 既に作成しているなら削除
+	if (m_pImage != NULL || m_pLazy != NULL) {
+		this->Clear();
+	}
+
+	// ヘッダー読み込み
+	uint8 head[HEADER_SIZE];
+	if (pReader->Read(head, HEADER_SIZE) != HEADER_SIZE || !this->ReadHeader(head)) {
+		return ERROR_HEADER;
+	}
+
+	// ImageとPaletteのサイズを求める
+	if (!this->CalcSize(true)) {
+		this->Clear();
+		return ERROR_MEMORY;
+	}
+
+	// IDフィールドとパレット読み込み(ReadPaletteは先頭からのアドレスを受け取るので、ヘッダーも含める)
+	const uint32 infoSize = HEADER_SIZE + m_Header.IDField + m_PaletteSize;
+	uint8 *pInfo = new uint8[infoSize];
+	int ret = ERROR_NONE;
+
+	if (pInfo == NULL) {
+		ret = ERROR_MEMORY;
+	} else {
+		memcpy(pInfo, head, HEADER_SIZE);
+		if (pReader->Read(&pInfo[HEADER_SIZE], infoSize - HEADER_SIZE) != infoSize - HEADER_SIZE || !this->ReadPalette(pInfo)) {
+			ret = ERROR_PALETTE;
+		}
+		SAFE_DELETES(pInfo);
+	}
+
+	if (ret != ERROR_NONE) {
+		this->Clear();
+		return ret;
+	}
+
+	m_bPremultiplied = (m_CreateFlag & CREATE_FLAG_PREMULTIPLY) ? true : false;
+
+	// イメージ読み込み
+	if (this->isRLE()) {
+		if (!this->UnpackRLE(pReader)) ret = ERROR_IMAGE;
+	} else if (pReader->Read(m_pImage, m_ImageSize) != m_ImageSize) {
+		ret = ERROR_IMAGE;
+	} else if ((m_CreateFlag & CREATE_FLAG_PREMULTIPLY) && this->IsAlphaImage()) {
+		if (m_Header.imageBit == 32) {
+			TgaKernelPremultiply32(m_pImage, m_pImage, m_ImageSize >> 2);
+		} else {
+			TgaKernelPremultiply16(m_pImage, m_pImage, m_ImageSize >> 1);
+		}
+	}
+
+	if (ret != ERROR_NONE) {
+		this->Clear();
+		return ret;
+	}
+
+	// フッター読み込み
+	uint8 foot[FOOTER_SIZE];
+	if (pReader->Read(foot, FOOTER_SIZE) == FOOTER_SIZE) {
+		this->ReadFooter(foot, 0);
+	}
+
+	if (m_CreateFlag & CREATE_FLAG_HASH) {
+		this->HashAll();
+	}
+
+	return ERROR_NONE;
+}
+
+/*=======================================================================
+【機能】ストリームからRLE圧縮解凍
+【引数】pReader：読み込み元
+【戻値】true：成功
+【備考】非公開
+        1パケットずつバッファに先読みして展開します。
+        イメージの終わりを超えるパケットはエラーにします。
+ =======================================================================*/
+bool CTga::UnpackRLE(CTgaStreamReader *pReader)
+{
+	const uint32 byte = m_Header.imageBit >> 3;
+	const bool bPremultiply = ((m_CreateFlag & CREATE_FLAG_PREMULTIPLY) && this->IsAlphaImage());
+	uint32 count = 0;
+	uint8 pixel[4];
+
+	while (count < m_ImageSize) {
+		const uint8 *pSrc = pReader->Peek(1);
+		if (pSrc == NULL) return false;
+
+		const bool bFlg   = (pSrc[0] & 0x80) ? false : true; // 上位ビットが0ならリテラルグループ
+		const uint32 loop = (pSrc[0] & 0x7f) + 1;
+		const uint32 size = bFlg ? (loop * byte) : byte;
+
+		if (loop * byte > m_ImageSize - count) return false;
+		if ((pSrc = pReader->Peek(1 + size)) == NULL) return false;
+
+		if (bFlg) {
+			// リテラルグループ
+			memcpy(&m_pImage[count], &pSrc[1], size);
+			if (bPremultiply) {
+				if (byte == 4) {
+					TgaKernelPremultiply32(&m_pImage[count], &m_pImage[count], loop);
+				} else {
+					TgaKernelPremultiply16(&m_pImage[count], &m_pImage[count], loop);
+				}
+			}
+		} else {
+			// 反復
+			const uint8 *pPixel = &pSrc[1];
+
+			if (bPremultiply) {
+				if (byte == 4) {
+					TgaKernelPremultiply32(pixel, pPixel, 1);
+				} else {
+					TgaKernelPremultiply16(pixel, pPixel, 1);
+				}
+				pPixel = pixel;
+			}
+			TgaKernelFill(&m_pImage[count], pPixel, loop, byte);
+		}
+
+		pReader->Skip(1 + size);
+		count += loop * byte;
+	}
+
+	return true;
+}
@@ -0,0 +1,81 @@
+/*=============================================================================
+ * ストリーム入出力
+ * パイプやソケットのようにシークできない入出力から、CTgaを作成・出力します。
+ * 読み書きはコールバックで行い、バッファは読み込み・書き込みそれぞれ
+ * BUFFER_SIZEバイトだけ使います(大きな読み書きはバッファを通しません)。
+ * ファイルディスクリプタとFILEポインタ用のコールバックを用意しています。
+ * mto_common.h、tga.hの順にインクルードしてから使用してください。
+=============================================================================*/
+#ifndef _TGA_STREAM_H_
+#define _TGA_STREAM_H_
+
+// 読み込み(戻値は読み込んだバイト数、sizeより少なくても良い、0なら終わりかエラー)
+typedef uint32 (*TgaStreamReadFunc)(void *pDst, const uint32 size, void *pUser);
+
+// 書き込み(戻値は書き込んだバイト数、sizeより少なくても良い、0ならエラー)
+typedef uint32 (*TgaStreamWriteFunc)(const void *pSrc, const uint32 size, void *pUser);
+
+uint32 TgaStreamReadFd(void *pDst, const uint32 size, void *pUser);				// pUser：int*(ファイルディスクリプタ)
+uint32 TgaStreamWriteFd(const void *pSrc, const uint32 size, void *pUser);		// pUser：int*(ファイルディスクリプタ)
+uint32 TgaStreamReadFILE(void *pDst, const uint32 size, void *pUser);			// pUser：FILE*
+uint32 TgaStreamWriteFILE(const void *pSrc, const uint32 size, void *pUser);	// pUser：FILE*
+
+
+class CTgaStreamReader {
+public:
+	enum {
+		BUFFER_SIZE = 0x10000		// バッファサイズ(RLEの1パケットより大きいこと)
+	};
+
+private:
+	TgaStreamReadFunc	m_Func;
+	void				*m_pUser;
+	uint8				*m_pBuffer;
+	uint32				m_Pos;		// バッファ内の読み込み位置
+	uint32				m_End;		// バッファ内のデータの終わり
+	bool				m_bEnd;		// 終わりまで読んだ？
+
+	// コピー禁止
+	CTgaStreamReader(const CTgaStreamReader&);
+	CTgaStreamReader &operator=(const CTgaStreamReader&);
+
+public:
+	CTgaStreamReader(TgaStreamReadFunc func, void *pUser);
+	virtual ~CTgaStreamReader(void);
+
+	const uint8 *Peek(const uint32 size);
+	void   Skip(const uint32 size);
+	uint32 Read(void *pDst, const uint32 size);
+};
+
+
+class CTgaStreamWriter {
+public:
+	enum {
+		BUFFER_SIZE = 0x10000		// バッファサイズ
+	};
+
+private:
+	TgaStreamWriteFunc	m_Func;
+	void				*m_pUser;
+	uint8				*m_pBuffer;
+	uint32				m_Size;		// バッファ内のデータサイズ
+	bool				m_bError;	// 書き込みに失敗した？
+
+	// コピー禁止
+	CTgaStreamWriter(const CTgaStreamWriter&);
+	CTgaStreamWriter &operator=(const CTgaStreamWriter&);
+
+	bool WriteDirect(const uint8 *pSrc, uint32 size);
+
+public:
+	CTgaStreamWriter(TgaStreamWriteFunc func, void *pUser);
+	virtual ~CTgaStreamWriter(void);
+
+	bool isError(void) const {return m_bError;}
+
+	bool Write(const void *pSrc, const uint32 size);
+	bool Flush(void);
+};
+
+#endif
@@ -0,0 +1,383 @@
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+
+
+namespace {
+
+// フッター、エクステンションエリア内の位置
+enum {
+	FOOTER_EXTENSION = 0,		// エクステンションエリアの位置
+	FOOTER_DEVELOPER = 4,		// デベロッパーディレクトリの位置
+	FOOTER_SIGNATURE = 8,		// 署名
+	EXT_COLOR        = 482,		// カラーコレクションテーブルの位置
+	EXT_STAMP        = 486,		// ポステージスタンプの位置
+	EXT_SCANLINE     = 490,		// スキャンラインテーブルの位置
+	EXT_ATTRIBUTE    = 494		// アルファの種類
+};
+
+enum {
+	COLOR_TABLE_SIZE = 256 * 4 * 2,	// カラーコレクションテーブルのサイズ
+	DEVELOPER_TAG_SIZE = 10,		// デベロッパーディレクトリの1タグのサイズ
+	ATTRIBUTE_MAX = 4,				// アルファの種類の最大
+	INDEX_BLOCK = 4096				// パレット番号をまとめて調べる数
+};
+
+MTOINLINE uint32 Get16(const uint8 *p) {return p[0] | (p[1] << 8);}
+MTOINLINE uint32 Get32(const uint8 *p) {return Get16(p) | (Get16(&p[2]) << 16);}
+
+/*=======================================================================
+【機能】範囲の確認
+【戻値】true：offsetからsizeバイトがbegin～endに収まる
+ =======================================================================*/
+MTOINLINE bool IsInside(const uint64 offset, const uint64 size, const uint64 begin, const uint64 end)
+{
+	return (begin <= offset && offset <= end && size <= end - offset);
+}
+
+/*=======================================================================
+【機能】エラーの記録
+ =======================================================================*/
+MTOINLINE sint32 SetError(CTga::TGAValidation *pResult, const sint32 error, const uint64 offset)
+{
+	pResult->error       = error;
+	pResult->errorOffset = offset;
+	return error;
+}
+
+/*=======================================================================
+【機能】パレットの色数を超える番号を探す
+【引数】pSrc ：パレットの番号の並び
+        num  ：数
+        color：パレットの色数
+【戻値】最初に超えた位置(なければnum)
+【備考】まとめて最大値を調べ、超えていたまとまりだけ位置を探す。
+ =======================================================================*/
+uint64 FindIndexOver(const uint8 *pSrc, const uint64 num, const uint32 color)
+{
+	if (color >= 256) return num;
+
+	for (uint64 i = 0; i < num; i += INDEX_BLOCK) {
+		const uint32 n = (num - i < INDEX_BLOCK) ? static_cast<uint32>(num - i) : INDEX_BLOCK;
+		const uint8 *p = &pSrc[i];
+		uint32 max = 0;
+
+		for (uint32 j = 0; j < n; j++) {
+			if (p[j] > max) max = p[j];
+		}
+		if (max < color) continue;
+
+		for (uint32 j = 0; j < n; j++) {
+			if (p[j] >= color) return i + j;
+		}
+	}
+
+	return num;
+}
+
+/*=======================================================================
+【機能】イメージの確認
+【引数】pSrc    ：画像データアドレス
+        size    ：画像データサイズ
+        offset  ：イメージの位置
+        pixelNum：ピクセル数
+        byte    ：1ピクセルのバイト数
+        bRLE    ：RLE圧縮？
+        color   ：パレットの色数(パレットの番号を調べないなら0)
+        pResult ：結果(imageSize、packetNumを格納)
+【戻値】検証結果
+【備考】RLEはパケットのヘッダーだけをたどり、ピクセルは展開しない。
+ =======================================================================*/
+sint32 CheckImage(const uint8 *pSrc, const uint64 size, const uint64 offset, const uint64 pixelNum,
+				  const uint32 byte, const bool bRLE, const uint32 color, CTga::TGAValidation *pResult)
+{
+	if (!bRLE) {
+		const uint64 imageSize = pixelNum * byte;
+
+		if (imageSize > size - offset) return SetError(pResult, CTga::VALIDATE_TRUNCATED, size);
+
+		if (color != 0) {
+			const uint64 i = FindIndexOver(&pSrc[offset], imageSize, color);
+			if (i < imageSize) return SetError(pResult, CTga::VALIDATE_INDEX, offset + i);
+		}
+
+		pResult->imageSize = imageSize;
+		return CTga::VALIDATE_NONE;
+	}
+
+	uint64 offs  = offset;
+	uint64 count = 0;
+
+	while (count < pixelNum) {
+		if (offs >= size) return SetError(pResult, CTga::VALIDATE_TRUNCATED, size);
+
+		const uint32 num  = (pSrc[offs] & 0x7f) + 1;
+		const uint64 data = (pSrc[offs] & 0x80) ? byte : (num * byte);
+
+		if (count + num > pixelNum) return SetError(pResult, CTga::VALIDATE_RLE, offs);
+		if (data > size - offs - 1) return SetError(pResult, CTga::VALIDATE_TRUNCATED, size);
+
+		if (color != 0) {
+			const uint64 i = FindIndexOver(&pSrc[offs + 1], data, color);
+			if (i < data) return SetError(pResult, CTga::VALIDATE_INDEX, offs + 1 + i);
+		}
+
+		offs  += 1 + data;
+		count += num;
+		pResult->packetNum++;
+	}
+
+	pResult->imageSize = offs - offset;
+	return CTga::VALIDATE_NONE;
+}
+
+/*=======================================================================
+【機能】エクステンションエリアの確認
+【引数】pSrc    ：画像データアドレス
+        ext     ：エクステンションエリアの位置
+        imageEnd：イメージの終わり
+        end     ：フッターの位置
+        header  ：TGAヘッダー
+        pResult ：結果
+【戻値】検証結果
+【備考】各テーブルがイメージとフッターの間に収まっているかを調べる。
+        スキャンラインテーブルは各ラインの位置がイメージ内かも調べる。
+ =======================================================================*/
+sint32 CheckExtension(const uint8 *pSrc, const uint64 ext, const uint64 imageEnd, const uint64 end,
+					  const CTga::TGAHeader &header, CTga::TGAValidation *pResult)
+{
+	if (!IsInside(ext, CTga::EXTENSION_SIZE, imageEnd, end) || Get16(&pSrc[ext]) < CTga::EXTENSION_SIZE ||
+		!IsInside(ext, Get16(&pSrc[ext]), imageEnd, end)) {
+		return SetError(pResult, CTga::VALIDATE_EXTENSION, ext);
+	}
+
+	const uint8 *pExt = &pSrc[ext];
+
+	// カラーコレクションテーブル
+	const uint32 colorOffset = Get32(&pExt[EXT_COLOR]);
+	if (colorOffset != 0 && !IsInside(colorOffset, COLOR_TABLE_SIZE, imageEnd, end)) {
+		return SetError(pResult, CTga::VALIDATE_EXTENSION, ext + EXT_COLOR);
+	}
+
+	// ポステージスタンプ(幅、高さの後にイメージと同じ形式で並ぶ)
+	const uint32 stampOffset = Get32(&pExt[EXT_STAMP]);
+	if (stampOffset != 0) {
+		if (!IsInside(stampOffset, 2, imageEnd, end) ||
+			!IsInside(stampOffset, 2 + pSrc[stampOffset] * pSrc[stampOffset + 1] * (header.imageBit >> 3), imageEnd, end)) {
+			return SetError(pResult, CTga::VALIDATE_EXTENSION, ext + EXT_STAMP);
+		}
+	}
+
+	// スキャンラインテーブル
+	const uint32 lineOffset = Get32(&pExt[EXT_SCANLINE]);
+	if (lineOffset != 0) {
+		if (!IsInside(lineOffset, static_cast<uint64>(header.imageH) * 4, imageEnd, end)) {
+			return SetError(pResult, CTga::VALIDATE_SCANLINE, ext + EXT_SCANLINE);
+		}
+		for (uint32 y = 0; y < header.imageH; y++) {
+			const uint32 line = Get32(&pSrc[lineOffset + y * 4]);
+			if (line < pResult->imageOffset || line >= imageEnd) {
+				return SetError(pResult, CTga::VALIDATE_SCANLINE, lineOffset + y * 4);
+			}
+		}
+	}
+
+	// アルファの種類
+	if (pExt[EXT_ATTRIBUTE] > ATTRIBUTE_MAX) {
+		return SetError(pResult, CTga::VALIDATE_EXTENSION, ext + EXT_ATTRIBUTE);
+	}
+
+	return CTga::VALIDATE_NONE;
+}
+
+/*=======================================================================
+【機能】デベロッパーディレクトリの確認
+【引数】pSrc    ：画像データアドレス
+        dev     ：デベロッパーディレクトリの位置
+        imageEnd：イメージの終わり
+        end     ：フッターの位置
+        pResult ：結果
+【戻値】検証結果
+【備考】タグ数、タグごとの位置(4byte)とサイズ(4byte)が収まっているかを調べる。
+ =======================================================================*/
+sint32 CheckDeveloper(const uint8 *pSrc, const uint64 dev, const uint64 imageEnd, const uint64 end, CTga::TGAValidation *pResult)
+{
+	if (!IsInside(dev, 2, imageEnd, end) ||
+		!IsInside(dev + 2, static_cast<uint64>(Get16(&pSrc[dev])) * DEVELOPER_TAG_SIZE, imageEnd, end)) {
+		return SetError(pResult, CTga::VALIDATE_DEVELOPER, dev);
+	}
+
+	const uint32 tagNum = Get16(&pSrc[dev]);
+
+	for (uint32 i = 0; i < tagNum; i++) {
+		const uint64 tag = dev + 2 + i * DEVELOPER_TAG_SIZE;
+		const uint32 tagOffset = Get32(&pSrc[tag + 2]);
+		const uint32 tagSize   = Get32(&pSrc[tag + 6]);
+
+		if (tagSize != 0 && !IsInside(tagOffset, tagSize, imageEnd, end)) {
+			return SetError(pResult, CTga::VALIDATE_DEVELOPER, tag);
+		}
+	}
+
+	return CTga::VALIDATE_NONE;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】メモリ上の画像データの検証
+【引数】pSrc   ：画像データアドレス
+        size   ：画像データサイズ
+        pResult：結果(NULLなら格納しない)
+【戻値】検証結果(VALIDATE_*)
+【備考】ヘッダー、パレット、RLEのパケットをたどるだけで、メモリ確保も展開もしません。
+        読み込み時の確認に加えて、パレット番号がパレットの範囲内か、
+        署名付きのフッターがあればエクステンションエリア、スキャンラインテーブル、
+        デベロッパーディレクトリの位置とサイズが正しいかを調べます。
+        非圧縮のフルカラー画像はイメージを読まないので、ファイルの大きさに関係なくすぐに終わります。
+ =======================================================================*/
+sint32 CTga::Validate(const void *pSrc, const uint64 size, TGAValidation *pResult)
+{
+	TGAValidation result;
+
+	if (pResult == NULL) pResult = &result;
+	memset(pResult, 0, sizeof(TGAValidation));
+
+	if (pSrc == NULL) return SetError(pResult, VALIDATE_OPEN, 0);
+
+	const uint8 *p = static_cast<const uint8*>(pSrc);
+
+	// ヘッダー
+	if (size < HEADER_SIZE) return SetError(pResult, VALIDATE_TRUNCATED, size);
+
+	CTga tga;
+
+	if (!tga.ReadHeader(p) || tga.m_Header.usePalette > 1) return SetError(pResult, VALIDATE_HEADER, 0);
+	if (!tga.CalcSize(false) || tga.m_Header.imageW == 0 || tga.m_Header.imageH == 0) return SetError(pResult, VALIDATE_SIZE, 12);
+
+	const TGAHeader &header = tga.m_Header;
+	const bool bIndex = (header.imageType == IMAGE_TYPE_INDEX || header.imageType == IMAGE_TYPE_INDEX_RLE);
+
+	if (bIndex && (!header.usePalette || header.paletteColor == 0)) return SetError(pResult, VALIDATE_PALETTE, 1);
+
+	// IDフィールドとパレット
+	const uint64 imageOffset = HEADER_SIZE + header.IDField + tga.m_PaletteSize;
+	if (imageOffset > size) return SetError(pResult, VALIDATE_TRUNCATED, size);
+
+	pResult->imageOffset = imageOffset;
+
+	// イメージ
+	const uint64 pixelNum = static_cast<uint64>(header.imageW) * header.imageH;
+	const uint32 byte     = header.imageBit >> 3;
+	const bool   bRLE     = (header.imageType >= IMAGE_TYPE_INDEX_RLE);
+	const uint32 color    = (bIndex && byte == 1) ? header.paletteColor : 0;
+
+	if (CheckImage(p, size, imageOffset, pixelNum, byte, bRLE, color, pResult) != VALIDATE_NONE) return pResult->error;
+
+	// フッター(署名があるものだけ)
+	const uint64 imageEnd = imageOffset + pResult->imageSize;
+
+	if (size - imageEnd < FOOTER_SIZE || memcmp(&p[size - FOOTER_SIZE + FOOTER_SIGNATURE], "TRUEVISION-", 11) != 0) {
+		return VALIDATE_NONE;
+	}
+
+	const uint64 end = size - FOOTER_SIZE;
+	const uint32 ext = Get32(&p[end + FOOTER_EXTENSION]);
+	const uint32 dev = Get32(&p[end + FOOTER_DEVELOPER]);
+
+	pResult->bFooter = true;
+
+	if (ext != 0) {
+		if (CheckExtension(p, ext, imageEnd, end, header, pResult) != VALIDATE_NONE) return pResult->error;
+		pResult->bExtension = true;
+	}
+	if (dev != 0) {
+		if (CheckDeveloper(p, dev, imageEnd, end, pResult) != VALIDATE_NONE) return pResult->error;
+	}
+
+	return VALIDATE_NONE;
+}
+
+/*=======================================================================
+【機能】ファイルの検証
+【引数】pFileName：ファイル名
+        pResult  ：結果(NULLなら格納しない)
+【戻値】検証結果(VALIDATE_*)
+【備考】ファイルをマップして検証するので、読み込み用のメモリは確保しません。
+        読まれるのはヘッダー、パレット、RLEのパケット、フッター周りのページだけです。
+ =======================================================================*/
+sint32 CTga::Validate(const char *pFileName, TGAValidation *pResult)
+{
+	CMtoFileMap map;
+
+	if (!map.Open(pFileName)) {
+		TGAValidation result;
+		MtoFileStatus status;
+
+		if (pResult == NULL) pResult = &result;
+		memset(pResult, 0, sizeof(TGAValidation));
+
+		// 空のファイルはマップできないので、あれば途中で終わっているものとする
+		if (pFileName != NULL && MtoFileGetStatus(pFileName, &status) && status.size == 0) {
+			return SetError(pResult, VALIDATE_TRUNCATED, 0);
+		}
+		return SetError(pResult, VALIDATE_OPEN, 0);
+	}
+
+	return Validate(map.getData(), map.getSize(), pResult);
+}
+
+/*=======================================================================
+【機能】複数ファイルの検証
+【引数】ppFile ：ファイル名の配列
+        num    ：ファイル数
+        pResult：ファイルごとの結果(num個)
+【戻値】問題があったファイル数
+【備考】ファイルごとに並列で検証します。
+ =======================================================================*/
+uint32 CTga::ValidateFiles(const char *const *ppFile, const uint32 num, TGAValidation *pResult)
+{
+#ifndef NDEBUG
+	_ASSERT(ppFile != NULL || num == 0);
+	_ASSERT(pResult != NULL || num == 0);
+#else
+	if (num != 0 && (ppFile == NULL || pResult == NULL)) return num;
+#endif
+
+	const sint32 count = static_cast<sint32>(num);
+	uint32 errorNum = 0;
+
+#pragma omp parallel for schedule(dynamic) reduction(+:errorNum)
+	for (sint32 i = 0; i < count; i++) {
+		if (Validate(ppFile[i], &pResult[i]) != VALIDATE_NONE) errorNum++;
+	}
+
+	return errorNum;
+}
+
+/*=======================================================================
+【機能】検証結果のメッセージ
+【引数】error：検証結果(VALIDATE_*)
+【戻値】メッセージ
+ =======================================================================*/
+const char *CTga::GetValidateMessage(const sint32 error)
+{
+	static const char *s_Message[VALIDATE_MAX] = {
+		"OK",
+		"File open error",
+		"Truncated data",
+		"Not support header",
+		"Invalid image size",
+		"Missing palette",
+		"RLE packet overrun",
+		"Palette index out of range",
+		"Invalid extension area",
+		"Invalid scan line table",
+		"Invalid developer directory",
+	};
+
+	if (error < 0 || error >= VALIDATE_MAX) return "Unknown error";
+
+	return s_Message[error];
+}
@@ -0,0 +1,181 @@
+/*=============================================================================
+ * ピクセルの型付きビュー
+ * CTgaのイメージを、ピクセルの型を決めた2次元配列として扱います。
+ * ラインは保存の並び(下→上/上→下)に関係なく上から数え、ピッチ(負もあり)で
+ * 次のラインに進むので、getImageBitやイメージ記述子で分岐する必要はありません。
+ * 1ラインはピクセルが連続して並ぶので、ラインごとのループは素直な配列の処理になります。
+ * 右→左のイメージはConvertTypeで左→右にしてから使用してください。
+ * ビューはイメージを指すだけなので、元のCTgaより長く使わないでください。
+ * mto_common.h、tga.hの順にインクルードしてから使用してください。
+=============================================================================*/
+#ifndef _TGA_VIEW_H_
+#define _TGA_VIEW_H_
+
+/*=======================================================================
+ ピクセルの型
+ IsMatchはその型でCTgaのイメージを扱えるか調べる。
+ =======================================================================*/
+
+// 32bit(BGRA)
+struct TgaBgra8 {
+	uint8	b, g, r, a;
+
+	enum { BIT = 32 };
+	static bool IsMatch(const CTga &tga)
+	{
+		return (tga.getImageBit() == BIT && !tga.isRGBA());
+	}
+};
+
+// 32bit(RGBA、ConvertRGBA後)
+struct TgaRgba8 {
+	uint8	r, g, b, a;
+
+	enum { BIT = 32 };
+	static bool IsMatch(const CTga &tga)
+	{
+		return (tga.getImageBit() == BIT && tga.isRGBA());
+	}
+};
+
+// 24bit(BGR)
+struct TgaBgr8 {
+	uint8	b, g, r;
+
+	enum { BIT = 24 };
+	static bool IsMatch(const CTga &tga)
+	{
+		return (tga.getImageBit() == BIT && !tga.isRGBA());
+	}
+};
+
+// 24bit(RGB、ConvertRGBA後)
+struct TgaRgb8 {
+	uint8	r, g, b;
+
+	enum { BIT = 24 };
+	static bool IsMatch(const CTga &tga)
+	{
+		return (tga.getImageBit() == BIT && tga.isRGBA());
+	}
+};
+
+// 16bit(ARGB:1555、リトルエンディアン)
+struct TgaArgb1555 {
+	uint16	value;
+
+	enum { BIT = 16 };
+	static bool IsMatch(const CTga &tga)
+	{
+		return (tga.getImageBit() == BIT && !tga.isRGBA());
+	}
+
+	uint32 getB(void) const {return (value      ) & 0x1f;}
+	uint32 getG(void) const {return (value >>  5) & 0x1f;}
+	uint32 getR(void) const {return (value >> 10) & 0x1f;}
+	uint32 getA(void) const {return (value >> 15);}
+};
+
+// 8bit(パレットの番号)
+struct TgaIndex8 {
+	uint8	index;
+
+	enum { BIT = 8 };
+	static bool IsMatch(const CTga &tga)
+	{
+		const uint8 type = tga.getHeader().imageType;
+		return (tga.getImageBit() == BIT && (type == CTga::IMAGE_TYPE_INDEX || type == CTga::IMAGE_TYPE_INDEX_RLE));
+	}
+};
+
+// 8bit(白黒)
+struct TgaGray8 {
+	uint8	y;
+
+	enum { BIT = 8 };
+	static bool IsMatch(const CTga &tga)
+	{
+		const uint8 type = tga.getHeader().imageType;
+		return (tga.getImageBit() == BIT && (type == CTga::IMAGE_TYPE_GRAY || type == CTga::IMAGE_TYPE_GRAY_RLE));
+	}
+};
+
+
+/*=======================================================================
+ ビュー
+ Tはピクセルの型(TgaBgra8など)。
+ =======================================================================*/
+template <class T>
+class CTgaView {
+public:
+	typedef T Pixel;
+
+private:
+	uint8	*m_pTop;		// 一番上のラインの先頭
+	sint32	m_Pitch;		// 1つ下のラインまでのバイト数(下→上の並びなら負)
+	uint32	m_Width;		// 幅
+	uint32	m_Height;		// 高さ
+
+public:
+	CTgaView(void) : m_pTop(NULL), m_Pitch(0), m_Width(0), m_Height(0) {}
+	CTgaView(T *pTop, const uint32 width, const uint32 height, const sint32 pitch)
+		: m_pTop(reinterpret_cast<uint8*>(pTop)), m_Pitch(pitch), m_Width(width), m_Height(height) {}
+
+	uint32 getWidth(void)  const {return m_Width;}
+	uint32 getHeight(void) const {return m_Height;}
+	sint32 getPitch(void)  const {return m_Pitch;}
+	bool   isValid(void)   const {return (m_pTop != NULL);}
+
+	// 上から数えたライン(ピクセルはm_Width個連続している)
+	T *getLine(const uint32 y) const {return reinterpret_cast<T*>(m_pTop + static_cast<sint32>(y) * m_Pitch);}
+	T &at(const uint32 x, const uint32 y) const {return this->getLine(y)[x];}
+
+	bool      Create(const CTga &tga);
+	CTgaView  Sub(const uint32 x, const uint32 y, const uint32 width, const uint32 height) const;
+};
+
+/*=======================================================================
+【機能】CTgaのイメージからビューを作成
+【引数】tga：元のイメージ
+【戻値】true:成功 / false:失敗(イメージなし、型が違う、右→左の並び)
+【備考】遅延デコード中ならここでデコードします。
+        getImageと同じくイメージを直接指すので、書き換えるとCTgaも変わります。
+ =======================================================================*/
+template <class T>
+bool CTgaView<T>::Create(const CTga &tga)
+{
+	*this = CTgaView();
+
+	uint8 *pTop = tga.getLine(0);
+
+	if (pTop == NULL) return false;
+	if (!T::IsMatch(tga)) return false;
+	if (tga.getHeader().discripter & 0x10) return false;
+
+	m_pTop   = pTop;
+	m_Pitch  = tga.getPitch();
+	m_Width  = tga.getWidth();
+	m_Height = tga.getHeight();
+
+	return true;
+}
+
+/*=======================================================================
+【機能】一部分のビューを作成
+【引数】x、y         ：左上の位置
+        width、height：大きさ
+【戻値】一部分のビュー(範囲外ははみ出さないように切り詰め、全部外なら無効なビュー)
+【備考】同じイメージを指すだけなのでコピーはしません。
+ =======================================================================*/
+template <class T>
+CTgaView<T> CTgaView<T>::Sub(const uint32 x, const uint32 y, const uint32 width, const uint32 height) const
+{
+	if (m_pTop == NULL || x >= m_Width || y >= m_Height) return CTgaView();
+
+	const uint32 w = (width  < m_Width  - x) ? width  : (m_Width  - x);
+	const uint32 h = (height < m_Height - y) ? height : (m_Height - y);
+
+	return CTgaView(&this->getLine(y)[x], w, h, m_Pitch);
+}
+
+#endif
@@ -0,0 +1,145 @@
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_index.h"
+
+#include <stdlib.h>
+
+
+/*=======================================================================
+【機能】使い方の表示
+ =======================================================================*/
+static void Usage(void)
+{
+	printf("usage: tgaindex build <index> <dir>\n");
+	printf("       tgaindex query <index> [-minw N] [-maxw N] [-minh N] [-maxh N] [-bit N] [-type N] [-line N]\n");
+	printf("       tgaindex find  <index> <path>\n");
+}
+
+/*=======================================================================
+【機能】1ファイル分の情報を表示
+ =======================================================================*/
+static void PrintEntry(const CTgaIndex::Entry &entry)
+{
+	printf("%s\t%ux%u\ttype=%u\tbit=%u\tline=0x%02x\timage=%u\text=%u\tdev=%u\n",
+		entry.pPath, entry.imageW, entry.imageH, entry.imageType, entry.imageBit, entry.discripter & 0x30,
+		entry.imageOffset, entry.extensionOffset, entry.developerOffset);
+}
+
+/*=======================================================================
+【機能】目録ファイルを作る
+ =======================================================================*/
+static int Build(const char *pIndex, const char *pDir)
+{
+	uint32 update;
+
+	if (!CTgaIndex::Build(pIndex, pDir, &update)) {
+		printf("Build error!!\n");
+		return 1;
+	}
+
+	CTgaIndex index;
+	if (index.Open(pIndex)) {
+		printf("%u files (%u read)\n", index.getNum(), update);
+	}
+
+	return 0;
+}
+
+/*=======================================================================
+【機能】条件に合うファイルを表示
+ =======================================================================*/
+static int Query(const char *pIndex, const int argc, char *argv[])
+{
+	CTgaIndex index;
+	CTgaIndex::Query query;
+
+	if (!index.Open(pIndex)) {
+		printf("File open error!!\n");
+		return 1;
+	}
+
+	for (int i = 0; i + 1 < argc; i += 2) {
+		const int n = atoi(argv[i + 1]);
+
+		if (strcmp(argv[i], "-minw") == 0) {
+			query.minW = static_cast<uint16>(n);
+		} else if (strcmp(argv[i], "-maxw") == 0) {
+			query.maxW = static_cast<uint16>(n);
+		} else if (strcmp(argv[i], "-minh") == 0) {
+			query.minH = static_cast<uint16>(n);
+		} else if (strcmp(argv[i], "-maxh") == 0) {
+			query.maxH = static_cast<uint16>(n);
+		} else if (strcmp(argv[i], "-bit") == 0) {
+			query.imageBit = static_cast<uint8>(n);
+		} else if (strcmp(argv[i], "-type") == 0) {
+			query.imageType = static_cast<uint8>(n);
+		} else if (strcmp(argv[i], "-line") == 0) {
+			query.line = static_cast<sint32>(strtol(argv[i + 1], NULL, 0));
+		} else {
+			Usage();
+			return 1;
+		}
+	}
+
+	// 数えてから取得
+	const uint32 num = index.Select(query, NULL, 0);
+	uint32 *pFound = new uint32[num + 1];
+	if (pFound == NULL) {
+		printf("Memory alloc error!!\n");
+		return 1;
+	}
+
+	index.Select(query, pFound, num);
+	for (uint32 i = 0; i < num; i++) {
+		CTgaIndex::Entry entry;
+		if (index.GetEntry(pFound[i], &entry)) PrintEntry(entry);
+	}
+	printf("%u / %u files\n", num, index.getNum());
+
+	SAFE_DELETES(pFound);
+
+	return 0;
+}
+
+/*=======================================================================
+【機能】パスで探して表示
+ =======================================================================*/
+static int Find(const char *pIndex, const char *pPath)
+{
+	CTgaIndex index;
+	CTgaIndex::Entry entry;
+
+	if (!index.Open(pIndex)) {
+		printf("File open error!!\n");
+		return 1;
+	}
+
+	const sint32 i = index.Find(pPath);
+	if (i < 0 || !index.GetEntry(i, &entry)) {
+		printf("Not found\n");
+		return 1;
+	}
+	PrintEntry(entry);
+
+	return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+	SET_CRTDBG();
+
+	// 引数チェック
+	if (argc < 3) {
+		Usage();
+		return 1;
+	}
+
+	if (strcmp(argv[1], "build") == 0 && argc == 4) return Build(argv[2], argv[3]);
+	if (strcmp(argv[1], "query") == 0) return Query(argv[2], argc - 3, &argv[3]);
+	if (strcmp(argv[1], "find") == 0 && argc == 4) return Find(argv[2], argv[3]);
+
+	Usage();
+	return 1;
+}
@@ -0,0 +1,262 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+#include <stdlib.h>
+
+
+/*---------------------------------------------------------------------------
+ * 結果の集計
+ *--------------------------------------------------------------------------*/
+static uint32 s_CheckNum = 0;		// 確認した数
+static uint32 s_FailNum  = 0;		// 失敗した数
+static uint32 s_Random   = 1;		// 乱数の状態
+
+/*---------------------------------------------------------------------------
+ * テストの一覧(機能ごと)
+ *--------------------------------------------------------------------------*/
+struct TestEntry {
+	const char	*pName;				// 名前(コマンドラインで指定すると、それだけ実行する)
+	void		(*pFunc)(const char *pDatDir, const char *pWorkDir);
+};
+
+static const TestEntry s_Test[] = {
+	{"premultiply", TestPremultiply},
+	{"quantize",    TestQuantize},
+	{"mipmap",      TestMipmap},
+	{"resize",      TestResize},
+	{"atlas",       TestAtlas},
+	{"compare",     TestCompare},
+	{"hash",        TestHash},
+	{"cache",       TestCache},
+	{"sidecar",     TestSidecar},
+	{"lazy",        TestLazy},
+	{"sequence",    TestSequence},
+	{"rle",         TestRLE},
+	{"kernel",      TestKernel},
+	{"large",       TestLarge},
+	{"index",       TestIndex},
+	{"stream",      TestStream},
+	{"pack",        TestPack},
+	{"bc",          TestBC},
+	{"optimize",    TestOptimize},
+	{"view",        TestView},
+	{"orientation", TestOrientation},
+	{"rotate",      TestRotate},
+	{"slice",       TestSlice}
+};
+
+/*=======================================================================
+【機能】結果の確認
+【引数】bResult：結果
+        pExpr  ：条件の文字列
+        pFile  ：ファイル名
+        line   ：行番号
+【戻値】bResult
+ =======================================================================*/
+bool Check(const bool bResult, const char *pExpr, const char *pFile, const int line)
+{
+	s_CheckNum++;
+	if (!bResult) {
+		s_FailNum++;
+
+		const char *pName = strrchr(pFile, '/');
+		printf("  NG %s(%d): %s\n", (pName != NULL) ? pName + 1 : pFile, line, pExpr);
+	}
+
+	return bResult;
+}
+
+/*=======================================================================
+【機能】乱数の初期化
+【引数】seed：種(同じなら同じ並びになる)
+ =======================================================================*/
+void SetRandom(const uint32 seed)
+{
+	s_Random = seed * 2654435761U + 1;
+}
+
+/*=======================================================================
+【機能】乱数(xorshift、環境によらず同じ並び)
+ =======================================================================*/
+uint32 Random(void)
+{
+	s_Random ^= s_Random << 13;
+	s_Random ^= s_Random >> 17;
+	s_Random ^= s_Random << 5;
+
+	return s_Random;
+}
+
+/*=======================================================================
+【機能】テスト画像を作る
+【引数】pTga      ：作成先
+        w、h      ：大きさ
+        type      ：イメージタイプ(IMAGE_TYPE_INDEX/FULL/GRAY)
+        bit       ：ビット数(フルカラーのみ、16/24/32)
+        discripter：ピクセルの並び(IMAGE_LINE_*)
+        fill      ：埋め方(FILL_*)
+        seed      ：乱数の種(同じなら同じ画像になる)
+【戻値】true：成功
+【備考】TGAファイルの形でメモリに作ってからCreateに渡します。
+ =======================================================================*/
+bool MakeTga(CTga *pTga, const uint32 w, const uint32 h, const uint8 type, const uint8 bit,
+					const uint8 discripter, const sint32 fill, const uint32 seed)
+{
+	const uint32 color    = (type == CTga::IMAGE_TYPE_INDEX) ? 16 : 0;
+	const uint32 imageBit = (type == CTga::IMAGE_TYPE_FULL) ? bit : 8;
+	const uint32 byte     = imageBit >> 3;
+	const uint32 size     = CTga::HEADER_SIZE + color * 3 + w * h * byte;
+	uint8 *pBuf = new uint8[size];
+
+	if (pBuf == NULL) return false;
+	memset(pBuf, 0, CTga::HEADER_SIZE);
+
+	uint8 alpha = 0;
+	if (imageBit == 32) alpha = 8;
+	if (imageBit == 16) alpha = 1;
+
+	pBuf[1]  = (color != 0) ? 1 : 0;
+	pBuf[2]  = type;
+	pBuf[5]  = static_cast<uint8>(color);
+	pBuf[7]  = (color != 0) ? 24 : 0;
+	pBuf[12] = static_cast<uint8>(w);
+	pBuf[13] = static_cast<uint8>(w >> 8);
+	pBuf[14] = static_cast<uint8>(h);
+	pBuf[15] = static_cast<uint8>(h >> 8);
+	pBuf[16] = static_cast<uint8>(imageBit);
+	pBuf[17] = static_cast<uint8>(discripter | alpha);
+
+	SetRandom(seed);
+	uint8 *p = &pBuf[CTga::HEADER_SIZE];
+	for (uint32 i = 0; i < color * 3; i++) *p++ = static_cast<uint8>(Random());
+
+	uint8 pix[4] = {0, 0, 0, 0};
+	for (uint32 y = 0; y < h; y++) {
+		for (uint32 x = 0; x < w; x++) {
+			bool bNew = (fill == FILL_RANDOM) || (fill == FILL_RUN && (x % 7) == 0) || (x == 0);
+			if (bNew) {
+				for (uint32 c = 0; c < byte; c++) pix[c] = static_cast<uint8>(Random());
+				if (color != 0) pix[0] = static_cast<uint8>(pix[0] % color);
+			}
+			for (uint32 c = 0; c < byte; c++) *p++ = pix[c];
+		}
+	}
+
+	int ret = pTga->Create(pBuf, size);
+	delete[] pBuf;
+
+	return (ret == CTga::ERROR_NONE);
+}
+
+/*=======================================================================
+【機能】見た目の位置のピクセルを取得
+【引数】tga ：画像
+        x、y：位置(左上から)
+【戻値】ピクセルのアドレス
+ =======================================================================*/
+uint8 *GetPixel(const CTga &tga, const uint32 x, const uint32 y)
+{
+	const uint32 byte = tga.getImageBit() >> 3;
+	const uint32 px   = (tga.getHeader().discripter & 0x10) ? (tga.getWidth() - 1 - x) : x;
+
+	return &tga.getLine(static_cast<sint32>(y))[px * byte];
+}
+
+/*=======================================================================
+【機能】見た目が同じか(大きさ、ビット数、パレット、全ピクセル)
+ =======================================================================*/
+bool IsSameImage(const CTga &a, const CTga &b)
+{
+	if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) return false;
+	if (a.getImageBit() != b.getImageBit()) return false;
+	if (a.getPaletteSize() != b.getPaletteSize()) return false;
+	if (a.getPaletteSize() != 0 && memcmp(a.getPalette(), b.getPalette(), a.getPaletteSize()) != 0) return false;
+
+	const uint32 byte = a.getImageBit() >> 3;
+	for (uint32 y = 0; y < a.getHeight(); y++) {
+		for (uint32 x = 0; x < a.getWidth(); x++) {
+			if (memcmp(GetPixel(a, x, y), GetPixel(b, x, y), byte) != 0) return false;
+		}
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】ファイルサイズ
+ =======================================================================*/
+long GetFileSize(const char *pFileName)
+{
+	FILE *fp = fopen(pFileName, "rb");
+	if (fp == NULL) return -1;
+
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fclose(fp);
+
+	return size;
+}
+
+/*=======================================================================
+【機能】ファイルを全部読み込む
+【引数】pFileName：ファイル名
+        ppBuf    ：読み込み先の格納先(delete[]で解放する)
+        pSize    ：サイズの格納先
+【戻値】true：成功
+ =======================================================================*/
+bool ReadFile(const char *pFileName, uint8 **ppBuf, uint32 *pSize)
+{
+	*ppBuf = NULL;
+	*pSize = 0;
+
+	const long size = GetFileSize(pFileName);
+	if (size < 0) return false;
+
+	FILE *fp = fopen(pFileName, "rb");
+	if (fp == NULL) return false;
+
+	uint8 *pBuf = new uint8[size + 1];
+	if (pBuf == NULL || fread(pBuf, 1, size, fp) != static_cast<size_t>(size)) {
+		SAFE_DELETES(pBuf);
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+
+	*ppBuf = pBuf;
+	*pSize = static_cast<uint32>(size);
+
+	return true;
+}
+
+/*=======================================================================
+【機能】メイン
+【引数】argv[1]：テスト画像のディレクトリ(C/dat)
+        argv[2]：作業ディレクトリ(出力したファイルは残す)
+        argv[3]～：実行するテストの名前(省略時はすべて)
+ =======================================================================*/
+int main(int argc, char *argv[])
+{
+	if (argc < 3) {
+		printf("usage: tgatest <datdir> <workdir> [test...]\n");
+		return 1;
+	}
+
+	for (uint32 i = 0; i < sizeof(s_Test) / sizeof(s_Test[0]); i++) {
+		bool bRun = (argc == 3);
+		for (sint32 n = 3; n < argc; n++) {
+			if (strcmp(argv[n], s_Test[i].pName) == 0) bRun = true;
+		}
+		if (!bRun) continue;
+
+		printf("%s\n", s_Test[i].pName);
+		s_Test[i].pFunc(argv[1], argv[2]);
+	}
+
+	printf("%u checks, %u failed\n", s_CheckNum, s_FailNum);
+
+	return (s_FailNum == 0) ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+/*=============================================================================
+ * TGAのテスト
+ * 機能ごとのテスト(test_*.cpp)と、テスト画像を作る共通の処理です。
+ * mto_thread.h、mto_file.h、mto_common.h、tga.hの順にインクルードしてから使用してください。
+=============================================================================*/
+#ifndef _TEST_H_
+#define _TEST_H_
+
+// 結果の確認(失敗したら行番号と条件を表示して数える)
+#define TEST_CHECK(cond)		Check((cond), #cond, __FILE__, __LINE__)
+
+// テスト画像の埋め方
+enum {
+	FILL_RANDOM = 0,				// ピクセルごとに乱数
+	FILL_RUN,						// 横に7ピクセルずつ同じ値(RLEのパケットが混ざる)
+	FILL_SOLID						// ラインごとに同じ値(128ピクセルを超えるパケット)
+};
+
+bool   Check(const bool bResult, const char *pExpr, const char *pFile, const int line);
+void   SetRandom(const uint32 seed);
+uint32 Random(void);
+bool   MakeTga(CTga *pTga, const uint32 w, const uint32 h, const uint8 type, const uint8 bit,
+			   const uint8 discripter, const sint32 fill, const uint32 seed);
+uint8 *GetPixel(const CTga &tga, const uint32 x, const uint32 y);
+bool   IsSameImage(const CTga &a, const CTga &b);
+long   GetFileSize(const char *pFileName);
+bool   ReadFile(const char *pFileName, uint8 **ppBuf, uint32 *pSize);
+
+// 機能ごとのテスト(pDatDir：C/datのテスト画像、pWorkDir：作業ディレクトリ)
+void TestPremultiply(const char *pDatDir, const char *pWorkDir);
+void TestQuantize(const char *pDatDir, const char *pWorkDir);
+void TestMipmap(const char *pDatDir, const char *pWorkDir);
+void TestResize(const char *pDatDir, const char *pWorkDir);
+void TestAtlas(const char *pDatDir, const char *pWorkDir);
+void TestCompare(const char *pDatDir, const char *pWorkDir);
+void TestHash(const char *pDatDir, const char *pWorkDir);
+void TestCache(const char *pDatDir, const char *pWorkDir);
+void TestSidecar(const char *pDatDir, const char *pWorkDir);
+void TestLazy(const char *pDatDir, const char *pWorkDir);
+void TestSequence(const char *pDatDir, const char *pWorkDir);
+void TestRLE(const char *pDatDir, const char *pWorkDir);
+void TestKernel(const char *pDatDir, const char *pWorkDir);
+void TestLarge(const char *pDatDir, const char *pWorkDir);
+void TestIndex(const char *pDatDir, const char *pWorkDir);
+void TestStream(const char *pDatDir, const char *pWorkDir);
+void TestPack(const char *pDatDir, const char *pWorkDir);
+void TestBC(const char *pDatDir, const char *pWorkDir);
+void TestOptimize(const char *pDatDir, const char *pWorkDir);
+void TestView(const char *pDatDir, const char *pWorkDir);
+void TestOrientation(const char *pDatDir, const char *pWorkDir);
+void TestRotate(const char *pDatDir, const char *pWorkDir);
+void TestSlice(const char *pDatDir, const char *pWorkDir);
+
+#endif
@@ -0,0 +1,128 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_atlas.h"
+#include "test.h"
+
+
+namespace {
+
+enum {
+	SPRITE_NUM = 40,					// スプライト数
+	ATLAS_W = 200,						// アトラスの幅
+	PADDING = 2							// スプライト間の隙間
+};
+
+} // namespace
+
+
+/*=======================================================================
+【機能】テクスチャアトラス(トリミング、重なり、転送、テーブル)
+ =======================================================================*/
+void TestAtlas(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	CTga sprite[SPRITE_NUM];
+	uint32 rect[SPRITE_NUM][4];
+	CTgaAtlas atlas;
+	char name[32];
+
+	// アルファが0ではない範囲をずらした画像(最後は全部アルファ0)
+	for (uint32 i = 0; i < SPRITE_NUM; i++) {
+		const uint32 w = 8 + i % 13 * 3;
+		const uint32 h = 5 + i % 7 * 4;
+		if (!TEST_CHECK(MakeTga(&sprite[i], w, h, CTga::IMAGE_TYPE_FULL, 32, (i & 1) ? CTga::IMAGE_LINE_LRDU : CTga::IMAGE_LINE_LRUD, FILL_RANDOM, i))) return;
+
+		rect[i][0] = i % 5;
+		rect[i][1] = i % 3;
+		rect[i][2] = w - rect[i][0] - i % 4;
+		rect[i][3] = h - rect[i][1] - i % 2;
+		for (uint32 y = 0; y < h; y++) {
+			for (uint32 x = 0; x < w; x++) {
+				const bool bIn = (x >= rect[i][0] && x < rect[i][0] + rect[i][2] && y >= rect[i][1] && y < rect[i][1] + rect[i][3]);
+				uint8 *p = GetPixel(sprite[i], x, y);
+				if (!bIn || i == SPRITE_NUM - 1) {
+					p[3] = 0;
+				} else if (p[3] == 0) {
+					p[3] = 1;
+				}
+			}
+		}
+
+		sprintf(name, "sprite%02u", i);
+		TEST_CHECK(atlas.Add(sprite[i], name) == CTga::ERROR_NONE);
+	}
+
+	// 収まらない
+	TEST_CHECK(atlas.Pack(ATLAS_W, 16, PADDING) == CTgaAtlas::ERROR_PACK);
+
+	if (!TEST_CHECK(atlas.Pack(ATLAS_W, 0, PADDING) == CTga::ERROR_NONE)) return;
+	const CTga *pAtlas = atlas.getAtlas();
+	TEST_CHECK(atlas.getSpriteNum() == SPRITE_NUM);
+	TEST_CHECK(pAtlas->getWidth() == ATLAS_W);
+
+	uint32 badRect = 0, badPixel = 0, badName = 0, overlap = 0, outside = 0;
+	for (uint32 i = 0; i < SPRITE_NUM; i++) {
+		const CTgaAtlas::TGASprite &s = atlas.getSprite(i);
+
+		sprintf(name, "sprite%02u", i);
+		if (strcmp(atlas.getName(i), name) != 0) badName++;
+		if (s.srcW != sprite[i].getWidth() || s.srcH != sprite[i].getHeight()) badRect++;
+
+		if (i == SPRITE_NUM - 1) {
+			if (s.w != 0 || s.h != 0) badRect++;
+			continue;
+		}
+		if (s.trimX != rect[i][0] || s.trimY != rect[i][1] || s.w != rect[i][2] || s.h != rect[i][3]) badRect++;
+		if (s.x + s.w > pAtlas->getWidth() || s.y + s.h > pAtlas->getHeight()) {
+			outside++;
+			continue;
+		}
+
+		// 隙間を空けて重ならない
+		for (uint32 j = 0; j < i; j++) {
+			const CTgaAtlas::TGASprite &t = atlas.getSprite(j);
+			if (t.w == 0) continue;
+			if (s.x < t.x + t.w + PADDING && t.x < s.x + s.w + PADDING &&
+				s.y < t.y + t.h + PADDING && t.y < s.y + s.h + PADDING) overlap++;
+		}
+
+		for (uint32 y = 0; y < s.h; y++) {
+			for (uint32 x = 0; x < s.w; x++) {
+				if (memcmp(GetPixel(*pAtlas, s.x + x, s.y + y), GetPixel(sprite[i], s.trimX + x, s.trimY + y), 4) != 0) badPixel++;
+			}
+		}
+	}
+	TEST_CHECK(badName == 0);
+	TEST_CHECK(badRect == 0);
+	TEST_CHECK(outside == 0);
+	TEST_CHECK(overlap == 0);
+	TEST_CHECK(badPixel == 0);
+
+	// テーブル：ヘッダー、スプライト情報、名前テーブル
+	char imageFile[1024], tableFile[1024];
+	sprintf(imageFile, "%s/atlas.tga", pWorkDir);
+	sprintf(tableFile, "%s/atlas.bin", pWorkDir);
+	if (!TEST_CHECK(atlas.Output(imageFile, tableFile) == CTga::ERROR_NONE)) return;
+
+	uint8 *pTable;
+	uint32 size;
+	if (!TEST_CHECK(ReadFile(tableFile, &pTable, &size))) return;
+	const uint32 nameSize = SPRITE_NUM * 9;
+	TEST_CHECK(size == CTgaAtlas::TABLE_HEADER_SIZE + CTgaAtlas::TABLE_SPRITE_SIZE * SPRITE_NUM + nameSize);
+	if (size >= CTgaAtlas::TABLE_HEADER_SIZE + CTgaAtlas::TABLE_SPRITE_SIZE) {
+		TEST_CHECK(memcmp(pTable, "TGAA", 4) == 0);
+		TEST_CHECK((pTable[8] | (pTable[9] << 8)) == SPRITE_NUM);
+		TEST_CHECK((pTable[12] | (pTable[13] << 8)) == ATLAS_W);
+
+		const uint8 *p = &pTable[CTgaAtlas::TABLE_HEADER_SIZE];
+		const CTgaAtlas::TGASprite &s = atlas.getSprite(0);
+		TEST_CHECK((p[0] | (p[1] << 8)) == s.x && (p[2] | (p[3] << 8)) == s.y);
+	}
+	SAFE_DELETES(pTable);
+
+	CTga out;
+	TEST_CHECK(out.Create(imageFile) == CTga::ERROR_NONE && IsSameImage(out, *pAtlas));
+}
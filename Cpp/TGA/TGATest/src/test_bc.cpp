@@ -0,0 +1,138 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+
+namespace {
+
+const uint32 s_BlockByte[CTga::BC_FORMAT_MAX] = {8, 16, 8, 16};	// 1ブロックのバイト数
+
+/*=======================================================================
+【機能】ブロック圧縮
+【引数】tga   ：画像
+        format：形式
+        ppBC  ：圧縮したデータの格納先(delete[]で破棄する)
+【戻値】false：圧縮できなかった
+ =======================================================================*/
+bool Encode(const CTga &tga, const sint32 format, uint8 **ppBC)
+{
+	*ppBC = new uint8[tga.CalcBCSize(format)];
+	if (*ppBC == NULL) return false;
+
+	if (!tga.EncodeBC(*ppBC, format, CTga::BC_FLAG_NONE)) {
+		SAFE_DELETES(*ppBC);
+		return false;
+	}
+	return true;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】ブロック圧縮のサイズと並び、RGBA配列の画像
+ =======================================================================*/
+void TestBC(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	static const uint32 size[][2] = {{1, 1}, {4, 4}, {5, 9}, {13, 8}};
+
+	// サイズ(4の倍数に切り上げ)
+	for (uint32 s = 0; s < sizeof(size) / sizeof(size[0]); s++) {
+		CTga tga;
+		MakeTga(&tga, size[s][0], size[s][1], CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, s);
+
+		for (sint32 format = CTga::BC_FORMAT_BC1; format < CTga::BC_FORMAT_MAX; format++) {
+			const uint32 block = ((size[s][0] + 3) / 4) * ((size[s][1] + 3) / 4);
+			TEST_CHECK(tga.CalcBCSize(format) == block * s_BlockByte[format]);
+		}
+	}
+
+	// 並び(左上から右へ)：12x8の画像で右下から2番目のブロックだけ色を変える
+	static const uint8 line[] = {CTga::IMAGE_LINE_LRDU, CTga::IMAGE_LINE_LRUD, CTga::IMAGE_LINE_RLUD};
+	for (uint32 l = 0; l < sizeof(line); l++) {
+		CTga tga;
+		MakeTga(&tga, 12, 8, CTga::IMAGE_TYPE_FULL, 32, line[l], FILL_SOLID, 0);
+
+		for (uint32 y = 0; y < 8; y++) {
+			for (uint32 x = 0; x < 12; x++) {
+				uint8 *p = GetPixel(tga, x, y);
+				bool bMark = (x >= 4 && x < 8 && y >= 4);
+				p[0] = bMark ? 0x20 : 0xe0;
+				p[1] = 0x80;
+				p[2] = bMark ? 0xe0 : 0x20;
+				p[3] = 0xff;
+			}
+		}
+
+		for (sint32 format = CTga::BC_FORMAT_BC1; format < CTga::BC_FORMAT_MAX; format++) {
+			const uint32 bcSize = tga.CalcBCSize(format);
+			const uint32 byte   = s_BlockByte[format];
+			uint8 *pBC;
+
+			if (!TEST_CHECK(Encode(tga, format, &pBC))) continue;
+
+			// 3x2ブロックの4番目(下の段の真ん中)だけ違う
+			bool bOk = true;
+			for (uint32 b = 1; b < bcSize / byte; b++) {
+				const bool bSame = (memcmp(&pBC[0], &pBC[b * byte], byte) == 0);
+				if (bSame == (b == 4)) bOk = false;
+			}
+			if (!TEST_CHECK(bOk)) printf("  line 0x%02x format %d\n", line[l], format);
+			SAFE_DELETES(pBC);
+		}
+
+		// DDSは128バイトのヘッダー付き、BC_FLAG_RAWならブロック列だけ
+		char path[1024];
+		sprintf(path, "%s/bc.dds", pWorkDir);
+		TEST_CHECK(tga.OutputBC(path, CTga::BC_FORMAT_BC3, CTga::BC_FLAG_NONE) == CTga::ERROR_NONE);
+		TEST_CHECK(GetFileSize(path) == static_cast<long>(128 + tga.CalcBCSize(CTga::BC_FORMAT_BC3)));
+		TEST_CHECK(tga.OutputBC(path, CTga::BC_FORMAT_BC1, CTga::BC_FLAG_RAW) == CTga::ERROR_NONE);
+		TEST_CHECK(GetFileSize(path) == static_cast<long>(tga.CalcBCSize(CTga::BC_FORMAT_BC1)));
+	}
+
+	// RGBA配列に変更した赤一色の4x4(BC4は赤のチャンネルなので端点は255)
+	{
+		CTga tga;
+		uint8 *pBC;
+
+		MakeTga(&tga, 4, 4, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRUD, FILL_SOLID, 0);
+		for (uint32 y = 0; y < 4; y++) {
+			for (uint32 x = 0; x < 4; x++) {
+				uint8 *p = GetPixel(tga, x, y);
+				p[0] = 0x00;
+				p[1] = 0x00;
+				p[2] = 0xff;
+				p[3] = 0xff;
+			}
+		}
+		TEST_CHECK(tga.ConvertRGBA());
+		if (TEST_CHECK(Encode(tga, CTga::BC_FORMAT_BC4, &pBC))) {
+			TEST_CHECK(pBC[0] == 255);
+			SAFE_DELETES(pBC);
+		}
+	}
+
+	// RGBA配列に変更しても圧縮結果は同じ
+	{
+		CTga tga;
+		MakeTga(&tga, 13, 8, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 43);
+
+		for (sint32 format = CTga::BC_FORMAT_BC1; format < CTga::BC_FORMAT_MAX; format++) {
+			const uint32 bcSize = tga.CalcBCSize(format);
+			uint8 *pBGRA, *pRGBA;
+
+			if (!TEST_CHECK(Encode(tga, format, &pBGRA))) continue;
+			TEST_CHECK(tga.ConvertRGBA());
+			if (TEST_CHECK(Encode(tga, format, &pRGBA))) {
+				if (!TEST_CHECK(memcmp(pBGRA, pRGBA, bcSize) == 0)) printf("  format %d\n", format);
+				SAFE_DELETES(pRGBA);
+			}
+			TEST_CHECK(tga.ConvertRGBA());
+			SAFE_DELETES(pBGRA);
+		}
+	}
+}
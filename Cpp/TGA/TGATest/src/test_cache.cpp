@@ -0,0 +1,163 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_cache.h"
+#include "test.h"
+
+
+namespace {
+
+enum {
+	THREAD_NUM = 8						// 同時に読み込むスレッド数
+};
+
+/*=======================================================================
+【機能】同時に読み込むスレッドの引数
+ =======================================================================*/
+struct AcquireArg {
+	CTgaCache		*pCache;			// キャッシュ
+	const char		*pPath;				// ファイル名
+	CMtoSemaphore	*pStart;			// 開始の合図
+	const CTga		*pTga;				// 取得したTGA
+	int				error;				// エラータイプ
+};
+
+/*=======================================================================
+【機能】合図を待ってから取得
+ =======================================================================*/
+void AcquireThread(void *p)
+{
+	AcquireArg *pArg = static_cast<AcquireArg*>(p);
+
+	pArg->pStart->Wait();
+	pArg->pTga = pArg->pCache->Acquire(pArg->pPath, &pArg->error);
+}
+
+/*=======================================================================
+【機能】テスト画像をファイルに出力
+ =======================================================================*/
+bool WriteTga(const char *pPath, const uint32 w, const uint32 h, const uint32 seed)
+{
+	CTga tga;
+	if (!MakeTga(&tga, w, h, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, seed)) return false;
+
+	return (tga.Output(pPath) == CTga::ERROR_NONE);
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】デコード済みTGAのキャッシュ(共有、LRUの破棄、同時読み込み、更新)
+ =======================================================================*/
+void TestCache(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	char path[3][1024];
+	for (uint32 i = 0; i < 3; i++) {
+		sprintf(path[i], "%s/cache%u.tga", pWorkDir, i);
+		if (!TEST_CHECK(WriteTga(path[i], 32, 32, i))) return;
+	}
+
+	// 1エントリーの使用メモリ(3つ目を入れると上限を超える)
+	const uint64 bytes = sizeof(CTga) + 32 * 32 * 4;
+
+	{
+		CTgaCache cache(bytes * 2 + bytes / 2);
+		int error;
+
+		// 同じファイルは同じTGAを返す
+		const CTga *pA = cache.Acquire(path[0], &error);
+		TEST_CHECK(pA != NULL && error == CTga::ERROR_NONE);
+		TEST_CHECK(cache.Acquire(path[0], &error) == pA);
+		TEST_CHECK(cache.getMissCount() == 1 && cache.getHitCount() == 1);
+		TEST_CHECK(cache.getUsage() == bytes);
+		cache.Release(pA);
+		cache.Release(pA);
+
+		// A、Bの順に使ってからAを使うと、一番使われていないのはB
+		const CTga *pB = cache.Acquire(path[1], NULL);
+		cache.Release(pB);
+		cache.Release(cache.Acquire(path[0], NULL));
+		TEST_CHECK(cache.getMissCount() == 2 && cache.getHitCount() == 2);
+
+		// Cを入れるとBが破棄される
+		const CTga *pC = cache.Acquire(path[2], NULL);
+		TEST_CHECK(pC != NULL);
+		TEST_CHECK(cache.getUsage() == bytes * 2);
+		cache.Release(pC);
+
+		cache.Release(cache.Acquire(path[0], NULL));
+		TEST_CHECK(cache.getMissCount() == 3 && cache.getHitCount() == 3);
+		cache.Release(cache.Acquire(path[1], NULL));
+		TEST_CHECK(cache.getMissCount() == 4);
+
+		// 参照中のものは上限を超えても破棄しない
+		const CTga *pHold[3];
+		for (uint32 i = 0; i < 3; i++) pHold[i] = cache.Acquire(path[i], NULL);
+		TEST_CHECK(cache.getUsage() == bytes * 3);
+		for (uint32 i = 0; i < 3; i++) cache.Release(pHold[i]);
+		TEST_CHECK(cache.getUsage() <= bytes * 2);
+
+		// 全部破棄
+		cache.Flush();
+		TEST_CHECK(cache.getUsage() == 0);
+
+		// ないファイル、ディレクトリは失敗
+		char missing[1024];
+		sprintf(missing, "%s/cache_missing.tga", pWorkDir);
+		TEST_CHECK(cache.Acquire(missing, &error) == NULL && error == CTga::ERROR_OPEN);
+		TEST_CHECK(cache.Acquire(pWorkDir, &error) == NULL && error == CTga::ERROR_OPEN);
+	}
+
+	// 同じファイルを同時に要求しても読み込みは1回
+	{
+		char large[1024];
+		sprintf(large, "%s/cache_large.tga", pWorkDir);
+		if (!TEST_CHECK(WriteTga(large, 1024, 512, 3))) return;
+
+		CTgaCache cache(0);
+		CMtoSemaphore start;
+		CMtoThread thread[THREAD_NUM];
+		AcquireArg arg[THREAD_NUM];
+
+		for (uint32 i = 0; i < THREAD_NUM; i++) {
+			arg[i].pCache = &cache;
+			arg[i].pPath  = large;
+			arg[i].pStart = &start;
+			arg[i].pTga   = NULL;
+			arg[i].error  = CTga::ERROR_OPEN;
+			thread[i].Start(AcquireThread, &arg[i]);
+		}
+		for (uint32 i = 0; i < THREAD_NUM; i++) start.Post();
+		for (uint32 i = 0; i < THREAD_NUM; i++) thread[i].Join();
+
+		uint32 bad = 0;
+		for (uint32 i = 0; i < THREAD_NUM; i++) {
+			if (arg[i].pTga == NULL || arg[i].pTga != arg[0].pTga || arg[i].error != CTga::ERROR_NONE) bad++;
+		}
+		TEST_CHECK(bad == 0);
+		TEST_CHECK(cache.getMissCount() == 1 && cache.getHitCount() == THREAD_NUM - 1);
+		if (arg[0].pTga != NULL) TEST_CHECK(arg[0].pTga->getWidth() == 1024);
+
+		// 上限0でも参照中は残り、全部解放したら破棄される
+		for (uint32 i = 0; i < THREAD_NUM; i++) cache.Release(arg[i].pTga);
+		TEST_CHECK(cache.getUsage() == 0);
+	}
+
+	// ファイルが更新されたら読み直す(古いものは解放するまで使える)
+	{
+		CTgaCache cache(bytes * 4);
+		const CTga *pOld = cache.Acquire(path[0], NULL);
+		if (!TEST_CHECK(WriteTga(path[0], 16, 16, 9))) return;
+
+		const CTga *pNew = cache.Acquire(path[0], NULL);
+		TEST_CHECK(pOld != NULL && pNew != NULL && pOld != pNew);
+		TEST_CHECK(pOld->getWidth() == 32 && pNew->getWidth() == 16);
+		TEST_CHECK(cache.getMissCount() == 2);
+		cache.Release(pOld);
+		cache.Release(pNew);
+	}
+}
@@ -0,0 +1,89 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+#include <math.h>
+
+
+/*=======================================================================
+【機能】画像の比較(素直に求めた誤差と一致、並びの違い、差分画像)
+ =======================================================================*/
+void TestCompare(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+	NOTHING(pWorkDir);
+
+	// 乱数の画像同士(SIMDの単位に満たない幅を含む)
+	for (uint32 w = 1; w <= 41; w += 5) {
+		CTga a, b, heat;
+		CTga::TGACompare result;
+		if (!TEST_CHECK(MakeTga(&a, w, 9, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, w))) continue;
+		if (!TEST_CHECK(MakeTga(&b, w, 9, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, w))) continue;
+
+		// 半分くらいのピクセルに小さい差を付ける
+		SetRandom(w + 100);
+		for (uint32 y = 0; y < 9; y++) {
+			for (uint32 x = 0; x < w; x++) {
+				uint8 *p = GetPixel(b, x, y);
+				for (uint32 c = 0; c < 4; c++) {
+					if (Random() & 1) p[c] = static_cast<uint8>(p[c] + Random() % 9);
+				}
+			}
+		}
+		if (!TEST_CHECK(a.Compare(b, &result, &heat))) continue;
+
+		uint32 diffPixel = 0, maxCh[4] = {0, 0, 0, 0}, badHeat = 0;
+		double sum[4] = {0.0, 0.0, 0.0, 0.0};
+		for (uint32 y = 0; y < 9; y++) {
+			for (uint32 x = 0; x < w; x++) {
+				const uint8 *p0 = GetPixel(a, x, y);
+				const uint8 *p1 = GetPixel(b, x, y);
+				uint32 max = 0;
+				for (uint32 c = 0; c < 4; c++) {
+					const uint32 d = (p0[c] > p1[c]) ? (p0[c] - p1[c]) : (p1[c] - p0[c]);
+					if (d > maxCh[c]) maxCh[c] = d;
+					if (d > max) max = d;
+					sum[c] += d * d;
+				}
+				if (max != 0) diffPixel++;
+
+				const uint8 *h = GetPixel(heat, x, y);
+				if ((max == 0) != (h[0] == 0 && h[1] == 0 && h[2] == 0)) badHeat++;
+			}
+		}
+
+		bool bOk = TEST_CHECK(result.diffPixel == diffPixel);
+		for (uint32 c = 0; c < 4; c++) {
+			bOk &= TEST_CHECK(result.maxDiffCh[c] == maxCh[c]);
+			bOk &= TEST_CHECK(fabs(result.mse[c] - sum[c] / (w * 9)) < 1e-9);
+		}
+		bOk &= TEST_CHECK(fabs(result.mseAll - (sum[0] + sum[1] + sum[2] + sum[3]) / (w * 9 * 4)) < 1e-9);
+		bOk &= TEST_CHECK(heat.getWidth() == w && heat.getHeight() == 9 && heat.getImageBit() == 24);
+		bOk &= TEST_CHECK(badHeat == 0);
+		if (!bOk) printf("  width %u\n", w);
+	}
+
+	// 並びとビット数が違っても見た目が同じなら一致
+	CTga lrdu, lrud, rgba;
+	CTga::TGACompare result;
+	MakeTga(&lrdu, 23, 11, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 7);
+	MakeTga(&lrud, 23, 11, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_RLUD, FILL_SOLID, 0);
+	MakeTga(&rgba, 23, 11, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 7);
+	for (uint32 y = 0; y < 11; y++) {
+		for (uint32 x = 0; x < 23; x++) {
+			memcpy(GetPixel(lrud, x, y), GetPixel(lrdu, x, y), 3);
+			GetPixel(lrud, x, y)[3] = 255;
+		}
+	}
+	TEST_CHECK(rgba.ConvertRGBA());
+	TEST_CHECK(lrdu.Compare(lrud, &result, NULL) && result.diffPixel == 0);
+	TEST_CHECK(lrdu.Compare(rgba, &result, NULL) && result.diffPixel == 0);
+	TEST_CHECK(result.maxDiff == 0 && result.psnrAll == HUGE_VAL);
+
+	// 大きさが違うと失敗
+	CTga other;
+	MakeTga(&other, 23, 12, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 7);
+	TEST_CHECK(!lrdu.Compare(other, &result, NULL));
+}
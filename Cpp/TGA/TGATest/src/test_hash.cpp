@@ -0,0 +1,83 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+
+/*=======================================================================
+【機能】ハッシュ値(並び・RLE・RGBA配列によらない、内容が違えば変わる)
+ =======================================================================*/
+void TestHash(const char *pDatDir, const char *pWorkDir)
+{
+	static const uint8 format[][2] = {
+		{CTga::IMAGE_TYPE_INDEX, 8}, {CTga::IMAGE_TYPE_GRAY, 8},
+		{CTga::IMAGE_TYPE_FULL, 16}, {CTga::IMAGE_TYPE_FULL, 24}, {CTga::IMAGE_TYPE_FULL, 32}
+	};
+
+	NOTHING(pDatDir);
+
+	char path[1024];
+	sprintf(path, "%s/hash.tga", pWorkDir);
+
+	for (uint32 i = 0; i < sizeof(format) / sizeof(format[0]); i++) {
+		CTga lrdu, rlud;
+		if (!TEST_CHECK(MakeTga(&lrdu, 37, 13, format[i][0], format[i][1], CTga::IMAGE_LINE_LRDU, FILL_RUN, i))) continue;
+		if (!TEST_CHECK(MakeTga(&rlud, 37, 13, format[i][0], format[i][1], CTga::IMAGE_LINE_RLUD, FILL_RUN, i))) continue;
+
+		// 同じ見た目にする
+		const uint32 byte = format[i][1] >> 3;
+		for (uint32 y = 0; y < 13; y++) {
+			for (uint32 x = 0; x < 37; x++) memcpy(GetPixel(rlud, x, y), GetPixel(lrdu, x, y), byte);
+		}
+
+		const uint64 hash = lrdu.CalcHash();
+		bool bOk = TEST_CHECK(hash != 0 && hash == lrdu.getHash());
+		bOk &= TEST_CHECK(rlud.CalcHash() == hash);
+
+		// RLEで保存して、読み込み時に計算しても同じ
+		lrdu.setRLE(true);
+		if (TEST_CHECK(lrdu.Output(path) == CTga::ERROR_NONE)) {
+			CTga rle;
+			rle.setCreateFlag(CTga::CREATE_FLAG_HASH);
+			bOk &= TEST_CHECK(rle.Create(path) == CTga::ERROR_NONE);
+			bOk &= TEST_CHECK(rle.getHeader().imageType >= CTga::IMAGE_TYPE_INDEX_RLE);
+			bOk &= TEST_CHECK(rle.getHash() == hash);
+		}
+
+		// 非圧縮を読み込み時に計算
+		CTga raw;
+		rlud.setRLE(false);
+		rlud.Output(path);
+		raw.setCreateFlag(CTga::CREATE_FLAG_HASH);
+		bOk &= TEST_CHECK(raw.Create(path) == CTga::ERROR_NONE && raw.getHash() == hash);
+
+		// RGBA配列
+		if (byte >= 2) {
+			CTga rgba;
+			MakeTga(&rgba, 37, 13, format[i][0], format[i][1], CTga::IMAGE_LINE_LRDU, FILL_RUN, i);
+			rgba.ConvertRGBA();
+			bOk &= TEST_CHECK(rgba.CalcHash() == hash);
+		}
+
+		// 1ピクセル変えると変わる
+		GetPixel(lrdu, 36, 12)[0] ^= 1;
+		bOk &= TEST_CHECK(lrdu.CalcHash() != hash);
+
+		if (!bOk) printf("  type %u %ubit\n", format[i][0], format[i][1]);
+	}
+
+	// 乗算済みアルファかどうかで変わる
+	CTga a, b;
+	MakeTga(&a, 8, 8, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_SOLID, 1);
+	MakeTga(&b, 8, 8, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_SOLID, 1);
+	for (uint32 y = 0; y < 8; y++) {
+		for (uint32 x = 0; x < 8; x++) {
+			GetPixel(a, x, y)[3] = 255;
+			GetPixel(b, x, y)[3] = 255;
+		}
+	}
+	b.Premultiply();
+	TEST_CHECK(IsSameImage(a, b));
+	TEST_CHECK(a.CalcHash() != b.CalcHash());
+}
@@ -0,0 +1,149 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_index.h"
+#include "test.h"
+
+
+namespace {
+
+/*=======================================================================
+【機能】目録に入れる画像
+ =======================================================================*/
+const struct {
+	const char	*pName;
+	uint32		w, h;
+	uint8		type, bit, discripter;
+	bool		bRLE;
+	uint32		flag;
+} s_Image[] = {
+	{"index_a.tga",  40,  20, CTga::IMAGE_TYPE_FULL,  32, CTga::IMAGE_LINE_LRUD | 8, false, CTga::OUTPUT_FLAG_SCANLINE},
+	{"index_b.tga", 1237,  3, CTga::IMAGE_TYPE_FULL,  24, CTga::IMAGE_LINE_LRDU,     true,  CTga::OUTPUT_FLAG_NONE},
+	{"index_c.tga",  16,  16, CTga::IMAGE_TYPE_INDEX,  8, CTga::IMAGE_LINE_RLUD,     false, CTga::OUTPUT_FLAG_NONE}
+};
+
+/*=======================================================================
+【機能】目録の情報が画像と同じか
+ =======================================================================*/
+bool IsSameEntry(const CTgaIndex::Entry &entry, const uint32 i)
+{
+	const uint8 type = static_cast<uint8>(s_Image[i].type + (s_Image[i].bRLE ? 8 : 0));
+
+	if (entry.imageW != s_Image[i].w || entry.imageH != s_Image[i].h) return false;
+	if (entry.imageType != type || entry.imageBit != s_Image[i].bit) return false;
+	if ((entry.discripter & 0x30) != (s_Image[i].discripter & 0x30)) return false;
+
+	// スキャンラインテーブル付きはエクステンションエリアからアルファの種類が分かる
+	if (s_Image[i].flag & CTga::OUTPUT_FLAG_SCANLINE) {
+		return (entry.extensionOffset != 0 && entry.alphaType == 3);
+	}
+	return (entry.extensionOffset == 0 && entry.alphaType == CTgaIndex::ALPHA_UNKNOWN);
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】目録の作成、検索、作り直し
+【備考】作業ディレクトリには他のテストのファイルもあるので、
+        このテストで作ったファイルだけ確認します。
+ =======================================================================*/
+void TestIndex(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	const uint32 imageNum = sizeof(s_Image) / sizeof(s_Image[0]);
+	char path[1024];
+
+	for (uint32 i = 0; i < imageNum; i++) {
+		CTga tga;
+
+		sprintf(path, "%s/%s", pWorkDir, s_Image[i].pName);
+		if (!TEST_CHECK(MakeTga(&tga, s_Image[i].w, s_Image[i].h, s_Image[i].type, s_Image[i].bit, s_Image[i].discripter, FILL_RUN, 40 + i))) return;
+		tga.setRLE(s_Image[i].bRLE);
+		if (!TEST_CHECK(tga.Output(path, s_Image[i].flag) == CTga::ERROR_NONE)) return;
+	}
+
+	// 目録ファイル名が長すぎる場合は作らない
+	char indexName[2048];
+	sprintf(indexName, "%s/", pWorkDir);
+	memset(&indexName[strlen(indexName)], 'i', 1500);
+	indexName[sizeof(indexName) - 1] = '\0';
+	TEST_CHECK(!CTgaIndex::Build(indexName, pWorkDir, NULL));
+
+	// 作成と検索
+	char indexPath[1024];
+	CTgaIndex index;
+	uint32 update;
+
+	sprintf(indexPath, "%s/images.idx", pWorkDir);
+	remove(indexPath);
+	TEST_CHECK(CTgaIndex::Build(indexPath, pWorkDir, &update));
+	TEST_CHECK(update >= imageNum);
+	if (!TEST_CHECK(index.Open(indexPath))) return;
+	TEST_CHECK(index.getNum() >= imageNum);
+
+	for (uint32 i = 0; i < imageNum; i++) {
+		const sint32 n = index.Find(s_Image[i].pName);
+		CTgaIndex::Entry entry;
+
+		if (!TEST_CHECK(n >= 0) || !TEST_CHECK(index.GetEntry(n, &entry))) continue;
+		TEST_CHECK(strcmp(entry.pPath, s_Image[i].pName) == 0);
+		TEST_CHECK(IsSameEntry(entry, i));
+
+		// 1ファイルだけ読み込んでも同じ情報
+		sprintf(path, "%s/%s", pWorkDir, s_Image[i].pName);
+		TEST_CHECK(CTgaIndex::ReadEntry(path, &entry));
+		TEST_CHECK(IsSameEntry(entry, i));
+	}
+	TEST_CHECK(index.Find("index_x.tga") < 0);
+	TEST_CHECK(index.Find("") < 0);
+	{
+		CTgaIndex::Entry entry;
+		TEST_CHECK(!index.GetEntry(index.getNum(), &entry));
+	}
+
+	// 条件で絞り込む(RLE圧縮の有無は問わない)
+	{
+		CTgaIndex::Query query;
+		uint32 found[16];
+
+		query.minW = query.maxW = 1237;
+		query.minH = query.maxH = 3;
+		query.imageType = CTga::IMAGE_TYPE_FULL;
+		TEST_CHECK(index.Select(query, found, 16) == 1);
+		TEST_CHECK(static_cast<sint32>(found[0]) == index.Find("index_b.tga"));
+
+		query.imageBit = 32;
+		TEST_CHECK(index.Select(query, found, 16) == 0);
+
+		query = CTgaIndex::Query();
+		query.minW = query.maxW = 40;
+		query.imageBit = 32;
+		query.line = CTga::IMAGE_LINE_LRUD;
+		TEST_CHECK(index.Select(query, found, 16) >= 1);
+		query.line = CTga::IMAGE_LINE_LRDU;
+		TEST_CHECK(index.Select(query, found, 16) == 0);
+	}
+	index.Close();
+	TEST_CHECK(index.getNum() == 0);
+
+	// 作り直す時は変わったファイルだけ読み込む
+	TEST_CHECK(CTgaIndex::Build(indexPath, pWorkDir, &update));
+	TEST_CHECK(update == 0);
+
+	{
+		CTga tga;
+		sprintf(path, "%s/%s", pWorkDir, s_Image[0].pName);
+		TEST_CHECK(MakeTga(&tga, 41, 20, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRUD | 8, FILL_RUN, 43));
+		TEST_CHECK(tga.Output(path) == CTga::ERROR_NONE);
+	}
+	TEST_CHECK(CTgaIndex::Build(indexPath, pWorkDir, &update));
+	TEST_CHECK(update == 1);
+	if (TEST_CHECK(index.Open(indexPath))) {
+		CTgaIndex::Entry entry;
+		TEST_CHECK(index.GetEntry(index.Find(s_Image[0].pName), &entry));
+		TEST_CHECK(entry.imageW == 41);
+	}
+}
@@ -0,0 +1,297 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_atlas.h"
+#include "tga_kernel.h"
+#include "test.h"
+
+
+namespace {
+
+enum {
+	RESULT_MAX = 128					// 比較する結果の最大数
+};
+
+/*=======================================================================
+【機能】処理結果の一覧
+【備考】命令セットごとに同じ順で積んで、通常版の結果と比べる。
+        チェックサムはカーネルを使わずに求める。
+ =======================================================================*/
+struct Result {
+	const char	*pName[RESULT_MAX];		// 処理の名前
+	uint64		sum[RESULT_MAX];		// 結果のチェックサム
+	uint32		num;					// 結果の数
+
+	void Clear(void) {num = 0;}
+
+	// FNV-1a
+	static uint64 Checksum(const void *pSrc, const uint32 size, uint64 sum)
+	{
+		const uint8 *p = static_cast<const uint8*>(pSrc);
+		for (uint32 i = 0; i < size; i++) {
+			sum = (sum ^ p[i]) * 0x100000001b3ULL;
+		}
+		return sum;
+	}
+
+	void Add(const char *pLabel, const void *pSrc, const uint32 size)
+	{
+		if (num >= RESULT_MAX) return;
+		pName[num] = pLabel;
+		sum[num]   = Checksum(pSrc, size, 0xcbf29ce484222325ULL);
+		num++;
+	}
+
+	void AddValue(const char *pLabel, const uint64 value)
+	{
+		this->Add(pLabel, &value, sizeof(value));
+	}
+
+	void AddImage(const char *pLabel, const CTga &tga)
+	{
+		if (num >= RESULT_MAX) return;
+
+		const CTga::TGAHeader header = tga.getHeader();
+		const uint32 info[6] = {header.imageW, header.imageH, header.imageBit, header.imageType, header.discripter, header.paletteColor};
+		uint64 value = Checksum(info, sizeof(info), 0xcbf29ce484222325ULL);
+
+		if (tga.getImage() != NULL) value = Checksum(tga.getImage(), tga.getImageSize(), value);
+		if (tga.getPalette() != NULL) value = Checksum(tga.getPalette(), tga.getPaletteSize(), value);
+
+		pName[num] = pLabel;
+		sum[num]   = value;
+		num++;
+	}
+};
+
+/*=======================================================================
+【機能】テスト画像を複製
+ =======================================================================*/
+bool CopyTga(CTga *pDst, const CTga &src)
+{
+	if (!MakeTga(pDst, src.getWidth(), src.getHeight(), src.getHeader().imageType, src.getImageBit(),
+				 src.getHeader().discripter & 0x30, FILL_SOLID, 0)) return false;
+
+	memcpy(pDst->getImage(), src.getImage(), src.getImageSize());
+	if (src.getPalette() != NULL) memcpy(pDst->getPalette(), src.getPalette(), src.getPaletteSize());
+
+	return true;
+}
+
+/*=======================================================================
+【機能】カーネルを使う処理を一通り行って、結果を積む
+【引数】pResult ：結果の格納先
+        pWorkDir：作業ディレクトリ
+【備考】幅は16ピクセル単位に揃えず、SIMDの余りの処理も通るようにする。
+ =======================================================================*/
+void RunAll(Result *pResult, const char *pWorkDir)
+{
+	static const struct {
+		const char	*pName;
+		uint8		type, bit, discripter;
+	} image[] = {
+		{"32bit",    CTga::IMAGE_TYPE_FULL,  32, CTga::IMAGE_LINE_LRDU},
+		{"32bit RL", CTga::IMAGE_TYPE_FULL,  32, CTga::IMAGE_LINE_RLUD},
+		{"24bit",    CTga::IMAGE_TYPE_FULL,  24, CTga::IMAGE_LINE_RLDU},
+		{"16bit",    CTga::IMAGE_TYPE_FULL,  16, CTga::IMAGE_LINE_LRUD},
+		{"8bit",     CTga::IMAGE_TYPE_GRAY,   8, CTga::IMAGE_LINE_RLUD},
+		{"index",    CTga::IMAGE_TYPE_INDEX,  8, CTga::IMAGE_LINE_LRDU}
+	};
+	const uint32 w = 83;
+	const uint32 h = 37;
+	char path[1024];
+
+	pResult->Clear();
+	sprintf(path, "%s/kernel.tga", pWorkDir);
+
+	for (uint32 i = 0; i < sizeof(image) / sizeof(image[0]); i++) {
+		CTga src;
+		if (!MakeTga(&src, w, h, image[i].type, image[i].bit, image[i].discripter, FILL_RANDOM, 38 + i)) continue;
+
+		// 32bitに展開
+		uint8 *pImage32 = new uint8[w * h * 4];
+		if (pImage32 != NULL && src.GetImage32(pImage32)) pResult->Add(image[i].pName, pImage32, w * h * 4);
+		SAFE_DELETES(pImage32);
+
+		// RGBA配列
+		{
+			CTga tga;
+			if (CopyTga(&tga, src) && tga.ConvertRGBA()) pResult->AddImage("ConvertRGBA", tga);
+		}
+
+		// 乗算済みアルファと戻し
+		{
+			CTga tga;
+			if (CopyTga(&tga, src) && tga.Premultiply()) {
+				pResult->AddImage("Premultiply", tga);
+				if (tga.Unpremultiply()) pResult->AddImage("Unpremultiply", tga);
+			}
+		}
+
+		// 回転
+		for (sint32 rotate = 0; rotate < CTga::ROTATE_MAX; rotate++) {
+			CTga tga;
+			if (CopyTga(&tga, src) && tga.Rotate(rotate)) pResult->AddImage("Rotate", tga);
+		}
+
+		// 縮小
+		for (sint32 filter = 0; filter < CTga::MIPMAP_FILTER_MAX; filter++) {
+			CTga mip;
+			if (src.CreateMipmap(&mip, filter)) pResult->AddImage("CreateMipmap", mip);
+		}
+
+		// サイズ変更(縮小と拡大)
+		for (sint32 filter = 0; filter < CTga::RESIZE_FILTER_MAX; filter++) {
+			CTga small, large;
+			if (src.Resize(&small, 29, 13, filter)) pResult->AddImage("Resize small", small);
+			if (src.Resize(&large, 131, 70, filter)) pResult->AddImage("Resize large", large);
+		}
+
+		// RLE圧縮して出力、読み込み
+		{
+			CTga tga, back;
+			uint8 *pBuf;
+			uint32 size;
+			if (CopyTga(&tga, src)) {
+				tga.setRLE(true);
+				if (tga.Output(path, CTga::OUTPUT_FLAG_SCANLINE) == CTga::ERROR_NONE && ReadFile(path, &pBuf, &size)) {
+					pResult->Add("Output RLE", pBuf, size);
+					if (back.Create(pBuf, size) == CTga::ERROR_NONE) pResult->AddImage("Create RLE", back);
+					SAFE_DELETES(pBuf);
+				}
+			}
+		}
+
+		// 解析
+		{
+			CTga::TGAAnalysis analysis;
+			CTga opt;
+			if (src.Analyze(&analysis)) {
+				const uint32 value[5] = {analysis.bOpaque, analysis.bBinaryAlpha, analysis.bGray, analysis.b5Bit, analysis.colorNum};
+				pResult->Add("Analyze", value, sizeof(value));
+			}
+			if (src.Optimize(&opt)) pResult->AddImage("Optimize", opt);
+		}
+
+		// ハッシュ
+		{
+			CTga tga;
+			if (CopyTga(&tga, src)) pResult->AddValue("CalcHash", tga.CalcHash());
+		}
+
+		// 比較(少しずらした画像と)
+		{
+			CTga other;
+			CTga heat;
+			CTga::TGACompare compare;
+			if (CopyTga(&other, src)) {
+				uint8 *p = other.getImage();
+				for (uint32 n = 0; n < other.getImageSize(); n += 7) p[n] = static_cast<uint8>(p[n] + n);
+				if (src.Compare(other, &compare, &heat)) {
+					pResult->AddValue("Compare diffPixel", compare.diffPixel);
+					pResult->AddValue("Compare maxDiff", compare.maxDiff);
+					pResult->AddImage("Compare heatmap", heat);
+				}
+			}
+		}
+
+		// 減色
+		if (image[i].bit >= 24) {
+			CTga tga;
+			if (CopyTga(&tga, src) && tga.Quantize(37, 1)) pResult->AddImage("Quantize", tga);
+		}
+
+		// ブロック圧縮
+		for (sint32 format = 0; format < CTga::BC_FORMAT_MAX; format++) {
+			const uint32 size = src.CalcBCSize(format);
+			uint8 *pBC = new uint8[size];
+			if (pBC != NULL && src.EncodeBC(pBC, format, CTga::BC_FLAG_NONE)) pResult->Add("EncodeBC", pBC, size);
+			SAFE_DELETES(pBC);
+		}
+	}
+
+	// アトラス(周りが透明なスプライトのトリミング)
+	{
+		CTga sprite;
+		CTgaAtlas atlas;
+
+		if (MakeTga(&sprite, 45, 33, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRUD, FILL_RANDOM, 37)) {
+			for (uint32 y = 0; y < sprite.getHeight(); y++) {
+				for (uint32 x = 0; x < sprite.getWidth(); x++) {
+					if (x < 19 || x >= 41 || y < 3 || y >= 30) GetPixel(sprite, x, y)[3] = 0;
+				}
+			}
+			GetPixel(sprite, 19, 3)[3] = 1;
+			if (atlas.Add(sprite, "sprite") == CTga::ERROR_NONE && atlas.Pack(64, 64, 1) == CTga::ERROR_NONE) {
+				const CTgaAtlas::TGASprite &s = atlas.getSprite(0);
+				const uint32 rect[4] = {s.trimX, s.trimY, s.w, s.h};
+				pResult->Add("Atlas trim", rect, sizeof(rect));
+				pResult->AddImage("Atlas", *atlas.getAtlas());
+			}
+		}
+	}
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】命令セットごとの結果の比較
+【備考】TgaKernelSetLevelで1つずつ切り替えて、通常版と同じ結果になるか確認します。
+        CPUが対応していない命令セットは使える所まで下がるので、その場合は飛ばします。
+ =======================================================================*/
+void TestKernel(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	const sint32 oldLevel = TgaKernelGetLevel();
+	Result *pRef = new Result;
+	Result *pResult = new Result;
+
+	if (!TEST_CHECK(pRef != NULL && pResult != NULL)) {
+		SAFE_DELETE(pRef);
+		SAFE_DELETE(pResult);
+		return;
+	}
+
+	// 名前と命令セットの対応
+	for (sint32 level = TGA_KERNEL_LEVEL_NONE; level < TGA_KERNEL_LEVEL_MAX; level++) {
+		TEST_CHECK(TgaKernelGetLevelName(level)[0] != '\0');
+	}
+	TEST_CHECK(TgaKernelGetLevelName(TGA_KERNEL_LEVEL_MAX)[0] == '\0');
+
+	// 範囲外と対応していない命令セットは使える所まで下げる
+	TEST_CHECK(TgaKernelSetLevel(-1) == TGA_KERNEL_LEVEL_NONE);
+	TEST_CHECK(TgaKernelSetLevel(TGA_KERNEL_LEVEL_MAX) == TgaKernelGetSupportLevel());
+	TEST_CHECK(TgaKernelSetLevel(TGA_KERNEL_LEVEL_NONE) == TGA_KERNEL_LEVEL_NONE);
+	RunAll(pRef, pWorkDir);
+	TEST_CHECK(pRef->num > 100);
+
+	for (sint32 level = TGA_KERNEL_LEVEL_NONE + 1; level < TGA_KERNEL_LEVEL_MAX; level++) {
+		const sint32 actual = TgaKernelSetLevel(level);
+
+		TEST_CHECK(actual <= level);
+		TEST_CHECK(TgaKernelGetLevel() == actual);
+		if (actual != level) {
+			printf("  %s: not supported\n", TgaKernelGetLevelName(level));
+			continue;
+		}
+
+		RunAll(pResult, pWorkDir);
+		if (!TEST_CHECK(pResult->num == pRef->num)) continue;
+
+		uint32 bad = 0;
+		for (uint32 i = 0; i < pRef->num; i++) {
+			if (pResult->sum[i] != pRef->sum[i]) {
+				printf("  %s: %s (%u)\n", TgaKernelGetLevelName(level), pRef->pName[i], i);
+				bad++;
+			}
+		}
+		TEST_CHECK(bad == 0);
+	}
+
+	TgaKernelSetLevel(oldLevel);
+	SAFE_DELETE(pRef);
+	SAFE_DELETE(pResult);
+}
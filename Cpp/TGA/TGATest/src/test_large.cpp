@@ -0,0 +1,140 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_large.h"
+#include "test.h"
+
+
+namespace {
+
+/*=======================================================================
+【機能】2つのファイルの中身が同じか
+ =======================================================================*/
+bool IsSameFile(const char *pFileA, const char *pFileB)
+{
+	uint8 *pA, *pB;
+	uint32 sizeA, sizeB;
+
+	if (!ReadFile(pFileA, &pA, &sizeA)) return false;
+	if (!ReadFile(pFileB, &pB, &sizeB)) {
+		SAFE_DELETES(pA);
+		return false;
+	}
+
+	const bool bSame = (sizeA == sizeB && memcmp(pA, pB, sizeA) == 0);
+
+	SAFE_DELETES(pA);
+	SAFE_DELETES(pB);
+
+	return bSame;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】CTgaLargeのファイル間変換
+【備考】同じ変換をCTgaで行って出力したファイルと、バイト単位で比べます。
+        作業メモリの上限を小さくして、数ラインずつの帯に分かれる場合も確認します。
+ =======================================================================*/
+void TestLarge(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	struct {
+		uint32	w, h;
+		uint8	type, bit, discripter;
+		sint32	fill;
+		bool	bRLE;
+	} const image[] = {
+		{ 83, 37, CTga::IMAGE_TYPE_FULL,  32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, false},
+		{300, 70, CTga::IMAGE_TYPE_FULL,  32, CTga::IMAGE_LINE_LRUD, FILL_SOLID,  true},
+		{129, 33, CTga::IMAGE_TYPE_FULL,  24, CTga::IMAGE_LINE_RLDU, FILL_RUN,    true},
+		{ 77, 65, CTga::IMAGE_TYPE_FULL,  16, CTga::IMAGE_LINE_RLUD, FILL_RUN,    false},
+		{200, 40, CTga::IMAGE_TYPE_INDEX,  8, CTga::IMAGE_LINE_LRDU, FILL_RUN,    true},
+		{ 50, 90, CTga::IMAGE_TYPE_GRAY,   8, CTga::IMAGE_LINE_LRUD, FILL_SOLID,  false}
+	};
+	static const uint32 limit[] = {CTgaLarge::MEMORY_LIMIT_DEFAULT, 1024, 1};
+	char src[1024], dst[1024], ref[1024];
+
+	sprintf(src, "%s/large_src.tga", pWorkDir);
+	sprintf(dst, "%s/large_dst.tga", pWorkDir);
+	sprintf(ref, "%s/large_ref.tga", pWorkDir);
+
+	for (uint32 i = 0; i < sizeof(image) / sizeof(image[0]); i++) {
+		CTga tga;
+		CTgaLarge large;
+
+		if (!TEST_CHECK(MakeTga(&tga, image[i].w, image[i].h, image[i].type, image[i].bit, image[i].discripter, image[i].fill, 39 + i))) continue;
+		tga.setRLE(image[i].bRLE);
+		tga.setFileDev(0x1234 + i);
+		if (!TEST_CHECK(tga.Output(src) == CTga::ERROR_NONE)) continue;
+
+		// そのまま出力すると元ファイルと同じ(フッターも引き継ぐ)
+		if (!TEST_CHECK(large.Open(src) == CTga::ERROR_NONE)) continue;
+		TEST_CHECK(large.getFooter().fileDev == 0x1234 + i);
+		TEST_CHECK(large.Output(dst) == CTga::ERROR_NONE);
+		if (!TEST_CHECK(IsSameFile(src, dst))) printf("  image %u: copy\n", i);
+
+		// 並び、RLE、RGBAを変えて出力(CTgaで同じ変換をしたものと同じ)
+		for (sint32 type = CTga::IMAGE_LINE_LRDU; type < CTga::IMAGE_LINE_MAX; type += 0x10) {
+			for (uint32 n = 0; n < sizeof(limit) / sizeof(limit[0]); n++) {
+				const bool bRGBA = (image[i].bit >= 24 && (type & 0x10) != 0);
+				CTga back;
+
+				if (!TEST_CHECK(back.Create(src) == CTga::ERROR_NONE)) continue;
+				back.setRLE(!image[i].bRLE);
+				TEST_CHECK(back.ConvertType(type));
+				if (bRGBA) TEST_CHECK(back.ConvertRGBA());
+				if (!TEST_CHECK(back.Output(ref) == CTga::ERROR_NONE)) continue;
+
+				if (!TEST_CHECK(large.Open(src) == CTga::ERROR_NONE)) continue;
+				large.setMemoryLimit(limit[n]);
+				large.setRLE(!image[i].bRLE);
+				TEST_CHECK(large.ConvertType(type));
+				if (bRGBA) TEST_CHECK(large.ConvertRGBA());
+				TEST_CHECK(large.Output(dst) == CTga::ERROR_NONE);
+				if (!TEST_CHECK(IsSameFile(ref, dst))) printf("  image %u: type 0x%02x, limit %u\n", i, type, limit[n]);
+			}
+		}
+	}
+
+	// フッターのないファイルは署名だけのフッターを付ける
+	{
+		CTga tga;
+		CTgaLarge large;
+		uint8 *pBuf;
+		uint32 size;
+
+		if (TEST_CHECK(MakeTga(&tga, 16, 8, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRUD, FILL_RANDOM, 45)) &&
+			TEST_CHECK(tga.Output(src) == CTga::ERROR_NONE) && TEST_CHECK(ReadFile(src, &pBuf, &size))) {
+			FILE *fp = fopen(src, "wb");
+			if (TEST_CHECK(fp != NULL)) {
+				fwrite(pBuf, size - CTga::FOOTER_SIZE, 1, fp);
+				fclose(fp);
+			}
+			SAFE_DELETES(pBuf);
+
+			TEST_CHECK(large.Open(src) == CTga::ERROR_NONE);
+			TEST_CHECK(large.getFooter().fileDev == 0);
+			TEST_CHECK(large.Output(dst) == CTga::ERROR_NONE);
+			TEST_CHECK(GetFileSize(dst) == static_cast<long>(size));
+		}
+	}
+
+	// 対応していないヘッダーはCTgaと同じく読めない
+	{
+		static const uint8 head[CTga::HEADER_SIZE] = {0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4, 0, 4, 0, 12, 0x20};
+		CTgaLarge large;
+
+		FILE *fp = fopen(src, "wb");
+		if (TEST_CHECK(fp != NULL)) {
+			fwrite(head, sizeof(head), 1, fp);
+			fclose(fp);
+		}
+		TEST_CHECK(large.Open(src) == CTga::ERROR_HEADER);
+		TEST_CHECK(large.getWidth() == 0);
+		TEST_CHECK(large.Open(NULL) == CTga::ERROR_OPEN);
+	}
+}
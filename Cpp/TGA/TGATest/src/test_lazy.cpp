@@ -0,0 +1,146 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+
+namespace {
+
+enum {
+	THREAD_NUM = 8,						// 同時に読むスレッド数
+	READ_LOOP  = 1000					// 1スレッドが読む回数
+};
+
+/*=======================================================================
+【機能】同時に読むスレッドの引数
+ =======================================================================*/
+struct ReadArg {
+	const CTga		*pTga;				// 遅延デコードのTGA
+	const CTga		*pRef;				// 普通に読み込んだTGA
+	CMtoSemaphore	*pStart;			// 開始の合図
+	uint32			bad;				// 一致しなかった回数
+};
+
+/*=======================================================================
+【機能】合図を待ってから、イメージ・ライン・フッターを読む
+ =======================================================================*/
+void ReadThread(void *p)
+{
+	ReadArg *pArg = static_cast<ReadArg*>(p);
+	const CTga &tga = *pArg->pTga;
+	const CTga &ref = *pArg->pRef;
+	const uint32 pitch = ref.getWidth() * (ref.getImageBit() >> 3);
+
+	pArg->pStart->Wait();
+
+	for (uint32 i = 0; i < READ_LOOP; i++) {
+		const sint32 y = static_cast<sint32>(i % ref.getHeight());
+
+		if (tga.getImage() == NULL) {
+			pArg->bad++;
+			continue;
+		}
+		if (memcmp(tga.getLine(y), ref.getLine(y), pitch) != 0) pArg->bad++;
+		if (tga.getFooter().filePos != ref.getFooter().filePos) pArg->bad++;
+	}
+}
+
+/*=======================================================================
+【機能】複数のスレッドから同時に読む
+【戻値】一致しなかった回数
+ =======================================================================*/
+uint32 ReadParallel(const CTga &tga, const CTga &ref)
+{
+	CMtoSemaphore start;
+	CMtoThread thread[THREAD_NUM];
+	ReadArg arg[THREAD_NUM];
+
+	for (uint32 i = 0; i < THREAD_NUM; i++) {
+		arg[i].pTga   = &tga;
+		arg[i].pRef   = &ref;
+		arg[i].pStart = &start;
+		arg[i].bad    = 0;
+		thread[i].Start(ReadThread, &arg[i]);
+	}
+	for (uint32 i = 0; i < THREAD_NUM; i++) start.Post();
+
+	uint32 bad = 0;
+	for (uint32 i = 0; i < THREAD_NUM; i++) {
+		thread[i].Join();
+		bad += arg[i].bad;
+	}
+
+	return bad;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】遅延デコード(初回アクセスでデコード、同時アクセス、更新されたファイル)
+ =======================================================================*/
+void TestLazy(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	char path[1024];
+	sprintf(path, "%s/lazy.tga", pWorkDir);
+
+	CTga src;
+	if (!TEST_CHECK(MakeTga(&src, 300, 200, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RUN, 35))) return;
+	src.setRLE(true);
+	src.setFilePos(0);
+	if (!TEST_CHECK(src.Output(path) == CTga::ERROR_NONE)) return;
+
+	CTga ref;
+	if (!TEST_CHECK(ref.Create(path) == CTga::ERROR_NONE)) return;
+
+	// 最初のアクセスを複数のスレッドから同時に
+	{
+		CTga lazy;
+		lazy.setCreateFlag(CTga::CREATE_FLAG_LAZY);
+		TEST_CHECK(lazy.Create(path) == CTga::ERROR_NONE);
+		TEST_CHECK(lazy.getWidth() == 300 && lazy.getHeight() == 200);
+		TEST_CHECK(ReadParallel(lazy, ref) == 0);
+		TEST_CHECK(IsSameImage(lazy, ref));
+	}
+
+	// デコードしてから複数のスレッドで読む
+	{
+		CTga lazy;
+		lazy.setCreateFlag(CTga::CREATE_FLAG_LAZY);
+		TEST_CHECK(lazy.Create(path) == CTga::ERROR_NONE);
+		TEST_CHECK(lazy.Decode());
+		TEST_CHECK(ReadParallel(lazy, ref) == 0);
+	}
+
+	// メモリから
+	{
+		uint8 *pBuf;
+		uint32 size;
+		if (TEST_CHECK(ReadFile(path, &pBuf, &size))) {
+			CTga lazy;
+			lazy.setCreateFlag(CTga::CREATE_FLAG_LAZY);
+			TEST_CHECK(lazy.Create(pBuf, size) == CTga::ERROR_NONE);
+			memset(pBuf, 0, size);
+			SAFE_DELETES(pBuf);
+			TEST_CHECK(ReadParallel(lazy, ref) == 0);
+		}
+	}
+
+	// デコード前にファイルが更新されたら失敗
+	{
+		CTga lazy;
+		lazy.setCreateFlag(CTga::CREATE_FLAG_LAZY);
+		TEST_CHECK(lazy.Create(path) == CTga::ERROR_NONE);
+
+		CTga other;
+		MakeTga(&other, 10, 10, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 1);
+		other.Output(path);
+
+		TEST_CHECK(!lazy.Decode());
+		TEST_CHECK(lazy.getImage() == NULL);
+		TEST_CHECK(!lazy.Decode());
+	}
+}
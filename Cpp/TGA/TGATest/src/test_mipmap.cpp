@@ -0,0 +1,114 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+#include <math.h>
+
+
+namespace {
+
+/*=======================================================================
+【機能】sRGB→リニア、リニア→sRGB(浮動小数点で求めた期待値)
+ =======================================================================*/
+double ToLinear(const uint32 c)
+{
+	const double v = c / 255.0;
+	return (v <= 0.04045) ? (v / 12.92) : pow((v + 0.055) / 1.055, 2.4);
+}
+
+double ToSRGB(const double v)
+{
+	return ((v <= 0.0031308) ? (v * 12.92) : (1.055 * pow(v, 1.0 / 2.4) - 0.055)) * 255.0;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】ミップマップ(2x2の平均、ガンマ補正、段階数)
+ =======================================================================*/
+void TestMipmap(const char *pDatDir, const char *pWorkDir)
+{
+	static const uint8 bit[] = {16, 24, 32};
+
+	NOTHING(pDatDir);
+	NOTHING(pWorkDir);
+
+	// BOX：2x2の平均(SIMDの単位に満たない幅、奇数の幅を含む)
+	for (uint32 w = 1; w <= 19; w += 3) {
+		CTga src, mip;
+		if (!TEST_CHECK(MakeTga(&src, w, 6, CTga::IMAGE_TYPE_GRAY, 8, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, w))) continue;
+		if (!TEST_CHECK(src.CreateMipmap(&mip, CTga::MIPMAP_FILTER_BOX))) continue;
+
+		const uint32 dstW = (w > 1) ? (w >> 1) : 1;
+		TEST_CHECK(mip.getWidth() == dstW && mip.getHeight() == 3);
+
+		uint32 bad = 0;
+		for (uint32 y = 0; y < 3; y++) {
+			for (uint32 x = 0; x < dstW; x++) {
+				const uint32 x0 = (w > 1) ? x * 2 : 0;
+				const uint32 x1 = (w > 1) ? x * 2 + 1 : 0;
+				const uint32 sum = *GetPixel(src, x0, y * 2) + *GetPixel(src, x1, y * 2) +
+								   *GetPixel(src, x0, y * 2 + 1) + *GetPixel(src, x1, y * 2 + 1);
+				if (*GetPixel(mip, x, y) != (sum + 2) / 4) bad++;
+			}
+		}
+		if (!TEST_CHECK(bad == 0)) printf("  width %u\n", w);
+	}
+
+	// ガンマ補正：リニアで平均した値とほぼ同じ(テーブルの誤差は1まで)、アルファはそのまま平均
+	for (uint32 i = 0; i < sizeof(bit) / sizeof(bit[0]); i++) {
+		CTga src, mip;
+		if (!TEST_CHECK(MakeTga(&src, 130, 34, CTga::IMAGE_TYPE_FULL, bit[i], CTga::IMAGE_LINE_LRUD, FILL_RANDOM, bit[i]))) continue;
+		if (!TEST_CHECK(src.CreateMipmap(&mip, CTga::MIPMAP_FILTER_GAMMA))) continue;
+		if (bit[i] == 16) {
+			// 16bitはBOXと同じ
+			CTga box;
+			src.CreateMipmap(&box, CTga::MIPMAP_FILTER_BOX);
+			TEST_CHECK(IsSameImage(mip, box));
+			continue;
+		}
+
+		const uint32 byte = bit[i] >> 3;
+		uint32 bad = 0, badAlpha = 0;
+		for (uint32 y = 0; y < mip.getHeight(); y++) {
+			for (uint32 x = 0; x < mip.getWidth(); x++) {
+				const uint8 *s[4] = {
+					GetPixel(src, x * 2, y * 2),     GetPixel(src, x * 2 + 1, y * 2),
+					GetPixel(src, x * 2, y * 2 + 1), GetPixel(src, x * 2 + 1, y * 2 + 1)
+				};
+				const uint8 *d = GetPixel(mip, x, y);
+
+				for (uint32 c = 0; c < 3; c++) {
+					const double v = ToSRGB((ToLinear(s[0][c]) + ToLinear(s[1][c]) + ToLinear(s[2][c]) + ToLinear(s[3][c])) / 4.0);
+					if (fabs(d[c] - v) > 1.0) bad++;
+				}
+				if (byte == 4 && d[3] != (s[0][3] + s[1][3] + s[2][3] + s[3][3] + 2) / 4) badAlpha++;
+			}
+		}
+		if (!TEST_CHECK(bad == 0 && badAlpha == 0)) printf("  %ubit: %u %u\n", bit[i], bad, badAlpha);
+	}
+
+	// 白黒の市松模様はリニアの50%(sRGBで188前後)になる(BOXは128)
+	CTga check, gamma, box;
+	if (TEST_CHECK(MakeTga(&check, 8, 8, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRDU, FILL_SOLID, 0))) {
+		for (uint32 y = 0; y < 8; y++) {
+			for (uint32 x = 0; x < 8; x++) memset(GetPixel(check, x, y), ((x + y) & 1) ? 255 : 0, 3);
+		}
+		TEST_CHECK(check.CreateMipmap(&gamma, CTga::MIPMAP_FILTER_GAMMA));
+		TEST_CHECK(check.CreateMipmap(&box, CTga::MIPMAP_FILTER_BOX));
+		const uint8 g = GetPixel(gamma, 1, 2)[1];
+		TEST_CHECK(g >= 187 && g <= 189);
+		TEST_CHECK(GetPixel(box, 1, 2)[1] == 128);
+	}
+
+	// 段階数：1x1まで作る
+	CTga src, level[CTga::MIPMAP_LEVEL_MAX];
+	if (TEST_CHECK(MakeTga(&src, 40, 5, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 9))) {
+		const sint32 num = src.CreateMipmapChain(level, CTga::MIPMAP_LEVEL_MAX, CTga::MIPMAP_FILTER_GAMMA);
+		TEST_CHECK(num == 5);
+		if (num == 5) TEST_CHECK(level[4].getWidth() == 1 && level[4].getHeight() == 1);
+	}
+}
@@ -0,0 +1,207 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+
+namespace {
+
+// 作るピクセルの種類
+enum {
+	PIXEL_RANDOM = 0,				// 乱数(アルファも)
+	PIXEL_OPAQUE,					// 乱数、不透明
+	PIXEL_5BIT,						// 5bitで表せる色、不透明
+	PIXEL_5BIT_ALPHA,				// 5bitで表せる色、アルファは0か255
+	PIXEL_GRAY,						// 白黒、不透明
+	PIXEL_FEW,						// 37色、不透明
+	PIXEL_FEW_ALPHA,				// 37色、アルファも色ごとに違う
+	PIXEL_SOLID						// 1色
+};
+
+/*=======================================================================
+【機能】32bit(BGRA)のテスト画像を作る
+【引数】pTga      ：作成先
+        w, h      ：大きさ
+        discripter：ピクセルの並び
+        pixel     ：ピクセルの種類(PIXEL_*)
+        seed      ：乱数の種
+ =======================================================================*/
+bool MakeImage(CTga *pTga, const uint32 w, const uint32 h, const uint8 discripter, const sint32 pixel, const uint32 seed)
+{
+	if (!MakeTga(pTga, w, h, CTga::IMAGE_TYPE_FULL, 32, discripter, FILL_SOLID, seed)) return false;
+
+	SetRandom(seed);
+	for (uint32 y = 0; y < h; y++) {
+		for (uint32 x = 0; x < w; x++) {
+			uint8 *p = GetPixel(*pTga, x, y);
+			const uint32 r = Random();
+
+			switch (pixel) {
+			case PIXEL_RANDOM:
+				p[0] = static_cast<uint8>(r);       p[1] = static_cast<uint8>(r >> 8);
+				p[2] = static_cast<uint8>(r >> 16); p[3] = static_cast<uint8>(r >> 24);
+				break;
+			case PIXEL_OPAQUE:
+				p[0] = static_cast<uint8>(r);       p[1] = static_cast<uint8>(r >> 8);
+				p[2] = static_cast<uint8>(r >> 16); p[3] = 255;
+				break;
+			case PIXEL_5BIT:
+			case PIXEL_5BIT_ALPHA:
+				for (uint32 c = 0; c < 3; c++) p[c] = static_cast<uint8>(((r >> (c * 5)) & 31) * 255 / 31);
+				p[3] = (pixel == PIXEL_5BIT || (r & 0x8000)) ? 255 : 0;
+				break;
+			case PIXEL_GRAY:
+				p[0] = p[1] = p[2] = static_cast<uint8>(r);
+				p[3] = 255;
+				break;
+			case PIXEL_FEW:
+			case PIXEL_FEW_ALPHA:
+				{
+					const uint32 c = (r % 37) * 0x9e3779b1;
+					p[0] = static_cast<uint8>(c >> 8);  p[1] = static_cast<uint8>(c >> 16);
+					p[2] = static_cast<uint8>(c >> 24); p[3] = (pixel == PIXEL_FEW) ? 255 : static_cast<uint8>(c);
+				}
+				break;
+			default:
+				p[0] = 0x10; p[1] = 0x80; p[2] = 0xf0; p[3] = 255;
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+/*=======================================================================
+【機能】32bitに展開して同じか
+ =======================================================================*/
+bool IsSamePixel(const CTga &a, const CTga &b)
+{
+	if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) return false;
+
+	const uint32 size = a.getWidth() * a.getHeight() * 4;
+	uint8 *pA = new uint8[size];
+	uint8 *pB = new uint8[size];
+	const bool bSame = (pA != NULL && pB != NULL && a.GetImage32(pA) && b.GetImage32(pB) && memcmp(pA, pB, size) == 0);
+
+	SAFE_DELETES(pA);
+	SAFE_DELETES(pB);
+
+	return bSame;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】解析と、劣化しない一番小さい形式への変換
+ =======================================================================*/
+void TestOptimize(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	// ピクセルの種類ごとに選ばれる形式
+	struct {
+		sint32	pixel;
+		uint8	type, bit, paletteBit, alphaBit;
+		bool	bOpaque, bBinaryAlpha, bGray, b5Bit;
+		uint32	colorNum;
+	} const image[] = {
+		{PIXEL_RANDOM,     CTga::IMAGE_TYPE_FULL,  32,  0, 8, false, false, false, false, CTga::ANALYSIS_COLOR_MAX + 1},
+		{PIXEL_OPAQUE,     CTga::IMAGE_TYPE_FULL,  24,  0, 0, true,  true,  false, false, CTga::ANALYSIS_COLOR_MAX + 1},
+		{PIXEL_5BIT,       CTga::IMAGE_TYPE_FULL,  16,  0, 0, true,  true,  false, true,  CTga::ANALYSIS_COLOR_MAX + 1},
+		{PIXEL_5BIT_ALPHA, CTga::IMAGE_TYPE_FULL,  16,  0, 1, false, true,  false, true,  CTga::ANALYSIS_COLOR_MAX + 1},
+		{PIXEL_GRAY,       CTga::IMAGE_TYPE_GRAY,   8,  0, 0, true,  true,  true,  false, 256},
+		{PIXEL_FEW,        CTga::IMAGE_TYPE_INDEX,  8, 24, 0, true,  true,  false, false, 37},
+		{PIXEL_FEW_ALPHA,  CTga::IMAGE_TYPE_INDEX,  8, 32, 8, false, false, false, false, 37}
+	};
+	static const uint8 line[] = {CTga::IMAGE_LINE_LRDU, CTga::IMAGE_LINE_RLUD};
+
+	for (uint32 i = 0; i < sizeof(image) / sizeof(image[0]); i++) {
+		for (uint32 l = 0; l < sizeof(line); l++) {
+			CTga src, opt;
+			CTga::TGAAnalysis analysis;
+
+			if (!TEST_CHECK(MakeImage(&src, 64, 48, line[l], image[i].pixel, 44 + i))) continue;
+
+			// 解析
+			bool bOk = TEST_CHECK(src.Analyze(&analysis));
+			bOk &= TEST_CHECK(analysis.bOpaque == image[i].bOpaque);
+			bOk &= TEST_CHECK(analysis.bBinaryAlpha == image[i].bBinaryAlpha);
+			bOk &= TEST_CHECK(analysis.bGray == image[i].bGray);
+			bOk &= TEST_CHECK(analysis.b5Bit == image[i].b5Bit);
+			bOk &= TEST_CHECK(analysis.colorNum == image[i].colorNum);
+
+			// 変換(並びは元のまま、乱数なのでRLE圧縮しない)
+			bOk &= TEST_CHECK(src.Optimize(&opt));
+			bOk &= TEST_CHECK(IsSamePixel(src, opt));
+			bOk &= TEST_CHECK(!opt.isRLE());
+			bOk &= TEST_CHECK((opt.getHeader().imageType & ~8) == image[i].type);
+			bOk &= TEST_CHECK(opt.getImageBit() == image[i].bit);
+			bOk &= TEST_CHECK(opt.getHeader().paletteBit == image[i].paletteBit);
+			bOk &= TEST_CHECK((opt.getHeader().discripter & 0x0f) == image[i].alphaBit);
+			bOk &= TEST_CHECK((opt.getHeader().discripter & 0x30) == line[l]);
+			if (!bOk) printf("  image %u line 0x%02x\n", i, line[l]);
+		}
+	}
+
+	// 1色ならRLE圧縮、RGBA配列でもBGRA配列で変換
+	{
+		CTga src, opt;
+
+		if (TEST_CHECK(MakeImage(&src, 300, 20, CTga::IMAGE_LINE_LRUD, PIXEL_SOLID, 51))) {
+			TEST_CHECK(src.ConvertRGBA());
+			TEST_CHECK(src.Optimize(&opt));
+			TEST_CHECK(opt.isRLE());
+			TEST_CHECK(opt.getHeader().imageType == CTga::IMAGE_TYPE_INDEX_RLE);
+			TEST_CHECK(opt.getPaletteSize() == 3);
+			TEST_CHECK(opt.getPalette()[0] == 0x10 && opt.getPalette()[2] == 0xf0);
+			TEST_CHECK(IsSamePixel(src, opt));
+		}
+	}
+
+	// 他の形式から(減らせないものはそのまま)
+	{
+		CTga src, opt;
+
+		if (TEST_CHECK(MakeTga(&src, 33, 17, CTga::IMAGE_TYPE_FULL, 16, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 52))) {
+			TEST_CHECK(src.Optimize(&opt));
+			TEST_CHECK(IsSamePixel(src, opt));
+			TEST_CHECK(opt.getImageBit() <= 16);
+		}
+		if (TEST_CHECK(MakeTga(&src, 33, 17, CTga::IMAGE_TYPE_GRAY, 8, CTga::IMAGE_LINE_RLDU, FILL_RUN, 53))) {
+			TEST_CHECK(src.Optimize(&opt));
+			TEST_CHECK(IsSamePixel(src, opt));
+			TEST_CHECK((opt.getHeader().imageType & ~8) == CTga::IMAGE_TYPE_GRAY);
+		}
+	}
+
+	// OUTPUT_FLAG_OPTIMIZEはOptimizeしたものを出力して、自身は変わらない
+	{
+		CTga src, opt, back;
+		char path[1024], optPath[1024];
+
+		sprintf(path, "%s/optimize.tga", pWorkDir);
+		sprintf(optPath, "%s/optimize_ref.tga", pWorkDir);
+		if (TEST_CHECK(MakeImage(&src, 64, 48, CTga::IMAGE_LINE_LRDU, PIXEL_FEW, 54))) {
+			TEST_CHECK(src.Output(path, CTga::OUTPUT_FLAG_OPTIMIZE) == CTga::ERROR_NONE);
+			TEST_CHECK(src.getImageBit() == 32);
+			TEST_CHECK(src.Optimize(&opt));
+			TEST_CHECK(opt.Output(optPath) == CTga::ERROR_NONE);
+			TEST_CHECK(GetFileSize(path) == GetFileSize(optPath));
+			TEST_CHECK(GetFileSize(path) < static_cast<long>(src.getImageSize()));
+			TEST_CHECK(back.Create(path) == CTga::ERROR_NONE);
+			TEST_CHECK(IsSamePixel(src, back));
+		}
+	}
+
+	// 画像がなければ失敗
+	{
+		CTga empty, opt;
+		CTga::TGAAnalysis analysis;
+
+		TEST_CHECK(!empty.Analyze(&analysis));
+		TEST_CHECK(!empty.Optimize(&opt));
+	}
+}
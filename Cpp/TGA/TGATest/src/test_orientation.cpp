@@ -0,0 +1,164 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+
+namespace {
+
+const uint8 s_Line[] = {CTga::IMAGE_LINE_LRDU, CTga::IMAGE_LINE_RLDU, CTga::IMAGE_LINE_LRUD, CTga::IMAGE_LINE_RLUD};
+
+/*=======================================================================
+【機能】上から数えたラインとピッチが保存の並びと合っているか
+ =======================================================================*/
+bool IsLineMatch(const CTga &tga)
+{
+	const sint32 h    = tga.getHeight();
+	const sint32 line = tga.getWidth() * (tga.getImageBit() >> 3);
+	const bool   bUD  = (tga.getHeader().discripter & 0x20) != 0;
+
+	if (tga.getPitch() != (bUD ? line : -line)) return false;
+
+	for (sint32 y = 0; y < h; y++) {
+		const sint32 sy = bUD ? y : (h - y - 1);
+		if (tga.getLine(y) != tga.getImage() + sy * line) return false;
+		if (y > 0 && tga.getLine(y) - tga.getLine(y - 1) != tga.getPitch()) return false;
+	}
+	return true;
+}
+
+/*=======================================================================
+【機能】見た目(GetPixelで上から、左から数えたピクセル)が同じか
+ =======================================================================*/
+bool IsSameLook(const CTga &a, const CTga &b)
+{
+	const uint32 byte = a.getImageBit() >> 3;
+
+	for (uint32 y = 0; y < a.getHeight(); y++) {
+		for (uint32 x = 0; x < a.getWidth(); x++) {
+			if (memcmp(GetPixel(a, x, y), GetPixel(b, x, y), byte) != 0) return false;
+		}
+	}
+	return true;
+}
+
+/*=======================================================================
+【機能】2つのファイルの中身が同じか
+ =======================================================================*/
+bool IsSameFile(const char *pFileA, const char *pFileB)
+{
+	uint8 *pA, *pB;
+	uint32 sizeA, sizeB;
+
+	if (!ReadFile(pFileA, &pA, &sizeA)) return false;
+	if (!ReadFile(pFileB, &pB, &sizeB)) {
+		SAFE_DELETES(pA);
+		return false;
+	}
+
+	const bool bSame = (sizeA == sizeB && memcmp(pA, pB, sizeA) == 0);
+
+	SAFE_DELETES(pA);
+	SAFE_DELETES(pB);
+
+	return bSame;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】ピクセルの並びとライン(getLine、getPitch、OutputBMP)
+【備考】上→下の画像をConvertTypeで4つの並びにして、見た目とBMP出力が
+        変わらないか、OutputBMPが画像を書き換えないかを確認します。
+ =======================================================================*/
+void TestOrientation(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	// BMPのラインが4バイトの倍数になるもの、ならないもの
+	struct {
+		uint32	w, h;
+		uint8	type, bit;
+	} const image[] = {
+		{ 5, 3, CTga::IMAGE_TYPE_FULL,  24},
+		{ 7, 6, CTga::IMAGE_TYPE_INDEX,  8},
+		{ 9, 4, CTga::IMAGE_TYPE_FULL,  32},
+		{ 3, 5, CTga::IMAGE_TYPE_FULL,  16},
+		{16, 2, CTga::IMAGE_TYPE_GRAY,   8}
+	};
+	char refPath[1024], path[1024];
+
+	sprintf(refPath, "%s/orientation_ref.bmp", pWorkDir);
+	sprintf(path, "%s/orientation.bmp", pWorkDir);
+
+	for (uint32 i = 0; i < sizeof(image) / sizeof(image[0]); i++) {
+		CTga ref;
+
+		if (!TEST_CHECK(MakeTga(&ref, image[i].w, image[i].h, image[i].type, image[i].bit, CTga::IMAGE_LINE_LRUD, FILL_RANDOM, 46 + i))) continue;
+
+		// BMPはラインを4バイト境界まで埋める
+		const uint32 line = (image[i].w * (image[i].bit >> 3) + 3) & ~3;
+		const uint32 pal  = ref.getHeader().paletteColor * 4;
+		TEST_CHECK(ref.OutputBMP(refPath) == CTga::ERROR_NONE);
+		TEST_CHECK(GetFileSize(refPath) == static_cast<long>(14 + 40 + pal + line * image[i].h));
+
+		for (uint32 l = 0; l < sizeof(s_Line); l++) {
+			CTga tga;
+			bool bOk = true;
+
+			bOk &= TEST_CHECK(MakeTga(&tga, image[i].w, image[i].h, image[i].type, image[i].bit, CTga::IMAGE_LINE_LRUD, FILL_RANDOM, 46 + i));
+			bOk &= TEST_CHECK(tga.ConvertType(s_Line[l]));
+			bOk &= TEST_CHECK((tga.getHeader().discripter & 0x30) == s_Line[l]);
+			bOk &= TEST_CHECK(IsLineMatch(tga));
+			bOk &= TEST_CHECK(IsSameLook(ref, tga));
+
+			// BMPは並びに関係なく同じで、画像はそのまま
+			const uint32 size = tga.getImageSize();
+			uint8 *pCopy = new uint8[size];
+			memcpy(pCopy, tga.getImage(), size);
+			bOk &= TEST_CHECK(tga.OutputBMP(path) == CTga::ERROR_NONE);
+			bOk &= TEST_CHECK(IsSameFile(refPath, path));
+			bOk &= TEST_CHECK((tga.getHeader().discripter & 0x30) == s_Line[l]);
+			bOk &= TEST_CHECK(memcmp(pCopy, tga.getImage(), size) == 0);
+			SAFE_DELETES(pCopy);
+
+			if (!bOk) printf("  image %u line 0x%02x\n", i, s_Line[l]);
+		}
+	}
+
+	// BMPの最初のラインは一番下のライン
+	{
+		CTga tga;
+		uint8 *pBuf;
+		uint32 size;
+
+		if (TEST_CHECK(MakeTga(&tga, 4, 3, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_RLUD, FILL_RANDOM, 51)) &&
+			TEST_CHECK(tga.OutputBMP(path) == CTga::ERROR_NONE) && TEST_CHECK(ReadFile(path, &pBuf, &size))) {
+			TEST_CHECK(size == 14 + 40 + 4 * 4 * 3);
+			TEST_CHECK(memcmp(&pBuf[14 + 40], GetPixel(tga, 0, 2), 4) == 0);
+			TEST_CHECK(memcmp(&pBuf[14 + 40 + 3 * 4], GetPixel(tga, 3, 2), 4) == 0);
+			TEST_CHECK(memcmp(&pBuf[size - 4], GetPixel(tga, 3, 0), 4) == 0);
+			SAFE_DELETES(pBuf);
+		}
+	}
+
+	// 遅延デコードはgetLineでデコード、画像がなければNULL
+	{
+		CTga tga, lazy, empty;
+		char tgaPath[1024];
+
+		sprintf(tgaPath, "%s/orientation.tga", pWorkDir);
+		if (TEST_CHECK(MakeTga(&tga, 10, 6, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRDU, FILL_RUN, 52)) &&
+			TEST_CHECK(tga.Output(tgaPath) == CTga::ERROR_NONE)) {
+			lazy.setCreateFlag(CTga::CREATE_FLAG_LAZY);
+			TEST_CHECK(lazy.Create(tgaPath) == CTga::ERROR_NONE);
+			TEST_CHECK(lazy.getPitch() == -30);
+			TEST_CHECK(lazy.getLine(0) != NULL);
+			TEST_CHECK(IsLineMatch(lazy));
+			TEST_CHECK(IsSameLook(tga, lazy));
+		}
+		TEST_CHECK(empty.getLine(0) == NULL);
+	}
+}
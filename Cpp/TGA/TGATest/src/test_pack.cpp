@@ -0,0 +1,168 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_pack.h"
+#include "test.h"
+
+
+namespace {
+
+enum {
+	IMAGE_NUM = 4					// パックする画像の数
+};
+
+/*=======================================================================
+【機能】パックする画像
+ =======================================================================*/
+const struct {
+	const char	*pName;
+	uint32		w, h;
+	uint8		type, bit, discripter;
+} s_Image[IMAGE_NUM] = {
+	{"icon/a",  40,  20, CTga::IMAGE_TYPE_FULL,  32, CTga::IMAGE_LINE_LRUD},
+	{"icon/b", 129,  33, CTga::IMAGE_TYPE_FULL,  24, CTga::IMAGE_LINE_RLDU},
+	{"pal",     16,  16, CTga::IMAGE_TYPE_INDEX,  8, CTga::IMAGE_LINE_LRDU},
+	{"gray",    50,   9, CTga::IMAGE_TYPE_GRAY,   8, CTga::IMAGE_LINE_RLUD}
+};
+
+/*=======================================================================
+【機能】パックの中身の確認
+【引数】pack：開いたパックファイル
+        pRef：元の画像(IMAGE_NUM個)
+        bRLE：RLE圧縮して格納した？
+ =======================================================================*/
+void CheckPack(const CTgaPack &pack, const CTga *pRef, const bool bRLE)
+{
+	TEST_CHECK(pack.getNum() == IMAGE_NUM);
+
+	for (uint32 i = 0; i < IMAGE_NUM; i++) {
+		CTgaPack::Entry entry;
+		CTga byIndex, byName;
+
+		if (!TEST_CHECK(pack.Find(s_Image[i].pName) == static_cast<sint32>(i))) continue;
+		if (!TEST_CHECK(pack.GetEntry(i, &entry))) continue;
+		TEST_CHECK(strcmp(entry.pName, s_Image[i].pName) == 0);
+		TEST_CHECK((entry.offset % CTgaPack::PAGE_SIZE) == 0);
+		TEST_CHECK(entry.flag == (bRLE ? CTgaPack::ENTRY_FLAG_RLE : CTgaPack::ENTRY_FLAG_NONE));
+		TEST_CHECK(entry.header.imageW == s_Image[i].w && entry.header.imageH == s_Image[i].h);
+
+		// 展開済みならマップの中を指す
+		TEST_CHECK(pack.Load(&byIndex, i) == CTga::ERROR_NONE);
+		TEST_CHECK(pack.Load(&byName, s_Image[i].pName) == CTga::ERROR_NONE);
+		TEST_CHECK(IsSameImage(pRef[i], byIndex));
+		TEST_CHECK(IsSameImage(pRef[i], byName));
+		TEST_CHECK(byIndex.isMapped() == !bRLE);
+	}
+
+	CTga tga;
+	TEST_CHECK(pack.Find("icon") < 0);
+	TEST_CHECK(pack.Find("") < 0);
+	TEST_CHECK(pack.Load(&tga, "none") == CTga::ERROR_OPEN);
+	TEST_CHECK(pack.Load(&tga, IMAGE_NUM) == CTga::ERROR_OPEN);
+	TEST_CHECK(!pack.GetEntry(IMAGE_NUM, NULL));
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】パックファイルの作成、検索、読み込みと、閉じた後の読み込み済み画像
+ =======================================================================*/
+void TestPack(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	CTga ref[IMAGE_NUM];
+	char file[IMAGE_NUM][1024];
+	const char *pFile[IMAGE_NUM];
+	const char *pName[IMAGE_NUM];
+	char packPath[1024];
+
+	for (uint32 i = 0; i < IMAGE_NUM; i++) {
+		sprintf(file[i], "%s/pack_%u.tga", pWorkDir, i);
+		pFile[i] = file[i];
+		pName[i] = s_Image[i].pName;
+		if (!TEST_CHECK(MakeTga(&ref[i], s_Image[i].w, s_Image[i].h, s_Image[i].type, s_Image[i].bit, s_Image[i].discripter, FILL_RUN, 42 + i))) return;
+		ref[i].setRLE((i & 1) != 0);
+		if (!TEST_CHECK(ref[i].Output(pFile[i]) == CTga::ERROR_NONE)) return;
+	}
+	sprintf(packPath, "%s/images.pack", pWorkDir);
+
+	// 展開済みとRLE圧縮
+	for (sint32 rle = 0; rle < 2; rle++) {
+		CTgaPack pack;
+
+		if (!TEST_CHECK(CTgaPack::Build(packPath, pFile, pName, IMAGE_NUM, rle != 0))) continue;
+		if (!TEST_CHECK(pack.Open(packPath))) continue;
+		CheckPack(pack, ref, rle != 0);
+	}
+
+	// 同じ名前、読めないファイルがあれば作らない
+	{
+		const char *pSame[IMAGE_NUM] = {"a", "b", "a", "c"};
+		const char *pBad[IMAGE_NUM]  = {pFile[0], pFile[1], packPath, pFile[3]};
+
+		TEST_CHECK(!CTgaPack::Build(packPath, pFile, pSame, IMAGE_NUM, false));
+		TEST_CHECK(!CTgaPack::Build(packPath, pBad, pName, IMAGE_NUM, false));
+	}
+
+	// パックファイルでないものは開けない
+	{
+		CTgaPack pack;
+		TEST_CHECK(!pack.Open(pFile[0]));
+		TEST_CHECK(!pack.Open(NULL));
+		TEST_CHECK(pack.getNum() == 0);
+	}
+
+	// 閉じた後も、読み込んだ画像はマップを共有しているので使える
+	{
+		CTga keep[IMAGE_NUM];
+		CTga copy;
+		CTgaPack *pPack = new CTgaPack;
+
+		if (TEST_CHECK(pPack != NULL) && TEST_CHECK(CTgaPack::Build(packPath, pFile, pName, IMAGE_NUM, false)) && TEST_CHECK(pPack->Open(packPath))) {
+			for (uint32 i = 0; i < IMAGE_NUM; i++) {
+				TEST_CHECK(pPack->Load(&keep[i], i) == CTga::ERROR_NONE);
+			}
+			TEST_CHECK(pPack->Load(&copy, static_cast<uint32>(0)) == CTga::ERROR_NONE);
+
+			pPack->Close();
+			TEST_CHECK(pPack->getNum() == 0);
+			TEST_CHECK(pPack->Load(&copy, static_cast<uint32>(0)) == CTga::ERROR_OPEN);
+			SAFE_DELETE(pPack);
+
+			for (uint32 i = 0; i < IMAGE_NUM; i++) {
+				TEST_CHECK(keep[i].isMapped());
+				TEST_CHECK(IsSameImage(ref[i], keep[i]));
+			}
+
+			// 書き換えるものはコピーしてから(同じ画像を読み込んだ他のCTgaは変わらない)
+			TEST_CHECK(keep[0].ConvertRGBA());
+			TEST_CHECK(!keep[0].isMapped());
+			TEST_CHECK(IsSameImage(ref[0], copy));
+
+			// 1つずつ破棄して、最後の1つでアンマップ
+			for (uint32 i = 0; i < IMAGE_NUM; i++) {
+				keep[i].Create(pFile[i]);
+				TEST_CHECK(IsSameImage(ref[i], keep[i]));
+			}
+			TEST_CHECK(copy.isMapped());
+			TEST_CHECK(IsSameImage(ref[0], copy));
+		}
+		SAFE_DELETE(pPack);
+	}
+
+	// 開き直しても、前に読み込んだ画像は前のマップを使い続ける
+	{
+		CTgaPack pack;
+		CTga tga;
+
+		if (TEST_CHECK(pack.Open(packPath)) && TEST_CHECK(pack.Load(&tga, s_Image[2].pName) == CTga::ERROR_NONE)) {
+			TEST_CHECK(pack.Open(packPath));
+			TEST_CHECK(IsSameImage(ref[2], tga));
+			TEST_CHECK(pack.Load(&tga, s_Image[3].pName) == CTga::ERROR_NONE);
+			TEST_CHECK(IsSameImage(ref[3], tga));
+		}
+	}
+}
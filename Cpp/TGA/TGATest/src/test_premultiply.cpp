@@ -0,0 +1,180 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+
+namespace {
+
+/*=======================================================================
+【機能】c * a / 255 を四捨五入(浮動小数点で求めた期待値)
+ =======================================================================*/
+uint32 RoundMul(const uint32 c, const uint32 a)
+{
+	return static_cast<uint32>(c * a / 255.0 + 0.5);
+}
+
+/*=======================================================================
+【機能】全部の色とアルファの組み合わせの画像を作る
+【引数】pTga：作成先(256x256、32bit、x=色、y=アルファ、上→下)
+ =======================================================================*/
+bool MakeAllPairs(CTga *pTga)
+{
+	if (!MakeTga(pTga, 256, 256, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRUD, FILL_SOLID, 0)) return false;
+
+	for (uint32 y = 0; y < 256; y++) {
+		for (uint32 x = 0; x < 256; x++) {
+			uint8 *p = GetPixel(*pTga, x, y);
+			p[0] = static_cast<uint8>(x);
+			p[1] = static_cast<uint8>(255 - x);
+			p[2] = static_cast<uint8>(x ^ 0x5a);
+			p[3] = static_cast<uint8>(y);
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】乗算済みアルファの変換(丸め、往復、端数、16bit、パレット)
+ =======================================================================*/
+void TestPremultiply(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pWorkDir);
+
+	// 丸め：全部の組み合わせで c * a / 255 の四捨五入と一致
+	CTga src, pre;
+	if (!TEST_CHECK(MakeAllPairs(&src) && MakeAllPairs(&pre))) return;
+	TEST_CHECK(pre.Premultiply());
+	TEST_CHECK(pre.isPremultiplied());
+
+	uint32 bad = 0;
+	for (uint32 y = 0; y < 256; y++) {
+		for (uint32 x = 0; x < 256; x++) {
+			const uint8 *s = GetPixel(src, x, y);
+			const uint8 *d = GetPixel(pre, x, y);
+			for (uint32 c = 0; c < 3; c++) {
+				if (d[c] != RoundMul(s[c], s[3])) bad++;
+			}
+			if (d[3] != s[3]) bad++;
+		}
+	}
+	TEST_CHECK(bad == 0);
+
+	// 2回目は何もしない
+	CTga twice;
+	MakeAllPairs(&twice);
+	twice.Premultiply();
+	twice.Premultiply();
+	TEST_CHECK(IsSameImage(twice, pre));
+
+	// 往復：戻した色をもう一度乗算すると同じ値になる(アルファ0は色も0)、アルファ255は元の色
+	CTga back;
+	MakeAllPairs(&back);
+	back.Premultiply();
+	TEST_CHECK(back.Unpremultiply());
+	TEST_CHECK(!back.isPremultiplied());
+
+	bad = 0;
+	uint32 bad255 = 0, bad0 = 0;
+	for (uint32 y = 0; y < 256; y++) {
+		for (uint32 x = 0; x < 256; x++) {
+			const uint8 *s = GetPixel(src, x, y);
+			const uint8 *p = GetPixel(pre, x, y);
+			const uint8 *b = GetPixel(back, x, y);
+			for (uint32 c = 0; c < 3; c++) {
+				if (RoundMul(b[c], b[3]) != p[c]) bad++;
+				if (y == 255 && b[c] != s[c]) bad255++;
+				if (y == 0 && b[c] != 0) bad0++;
+			}
+		}
+	}
+	TEST_CHECK(bad == 0);
+	TEST_CHECK(bad255 == 0);
+	TEST_CHECK(bad0 == 0);
+
+	// 端数(SIMDの単位に満たない幅)も同じ結果
+	for (uint32 w = 1; w <= 9; w++) {
+		CTga tga, ref;
+		MakeTga(&tga, w, 3, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, w);
+		MakeTga(&ref, w, 3, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, w);
+		tga.Premultiply();
+
+		bad = 0;
+		for (uint32 y = 0; y < 3; y++) {
+			for (uint32 x = 0; x < w; x++) {
+				const uint8 *s = GetPixel(ref, x, y);
+				const uint8 *d = GetPixel(tga, x, y);
+				for (uint32 c = 0; c < 3; c++) {
+					if (d[c] != RoundMul(s[c], s[3])) bad++;
+				}
+			}
+		}
+		if (!TEST_CHECK(bad == 0)) printf("  width %u\n", w);
+	}
+
+	// 16bit：アルファ0のピクセルだけ0になり、元に戻す処理では変化しない
+	CTga t16, r16;
+	MakeTga(&t16, 19, 5, CTga::IMAGE_TYPE_FULL, 16, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 16);
+	MakeTga(&r16, 19, 5, CTga::IMAGE_TYPE_FULL, 16, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 16);
+	t16.Premultiply();
+
+	bad = 0;
+	for (uint32 y = 0; y < 5; y++) {
+		for (uint32 x = 0; x < 19; x++) {
+			const uint8 *s = GetPixel(r16, x, y);
+			const uint8 *d = GetPixel(t16, x, y);
+			const bool bAlpha = (s[1] & 0x80) != 0;
+			if (bAlpha ? (d[0] != s[0] || d[1] != s[1]) : (d[0] != 0 || d[1] != 0)) bad++;
+		}
+	}
+	TEST_CHECK(bad == 0);
+
+	CTga u16;
+	MakeTga(&u16, 19, 5, CTga::IMAGE_TYPE_FULL, 16, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 16);
+	u16.Premultiply();
+	u16.Unpremultiply();
+	TEST_CHECK(IsSameImage(u16, t16));
+
+	// アルファのない24bitは変化しない
+	CTga t24, r24;
+	MakeTga(&t24, 7, 7, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 24);
+	MakeTga(&r24, 7, 7, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 24);
+	TEST_CHECK(t24.Premultiply());
+	TEST_CHECK(IsSameImage(t24, r24));
+
+	// 32bitパレットのインデックスカラーはパレットを変換する
+	CTga pal;
+	MakeTga(&pal, 8, 8, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 32);
+	if (TEST_CHECK(pal.Quantize(16, 0) && pal.getPaletteBit() == 32)) {
+		uint8 before[16 * 4];
+		const uint32 color = pal.getPaletteColor();
+		memcpy(before, pal.getPalette(), color * 4);
+		pal.Premultiply();
+
+		bad = 0;
+		for (uint32 i = 0; i < color; i++) {
+			const uint8 *s = &before[i * 4];
+			const uint8 *d = &pal.getPalette()[i * 4];
+			for (uint32 c = 0; c < 3; c++) {
+				if (d[c] != RoundMul(s[c], s[3])) bad++;
+			}
+		}
+		TEST_CHECK(bad == 0);
+	}
+
+	// 読み込み時の変換(CREATE_FLAG_PREMULTIPLY)も同じ結果
+	char path[1024];
+	CTga flag, ref;
+	sprintf(path, "%s/pen1_ico32a.tga", pDatDir);
+	flag.setCreateFlag(CTga::CREATE_FLAG_PREMULTIPLY);
+	if (TEST_CHECK(flag.Create(path) == CTga::ERROR_NONE && ref.Create(path) == CTga::ERROR_NONE)) {
+		TEST_CHECK(flag.isPremultiplied());
+		ref.Premultiply();
+		TEST_CHECK(IsSameImage(flag, ref));
+	}
+}
@@ -0,0 +1,70 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+
+/*=======================================================================
+【機能】減色(パレット番号が色数の範囲内か、色数以下の画像は元の色のまま)
+ =======================================================================*/
+void TestQuantize(const char *pDatDir, const char *pWorkDir)
+{
+	static const uint32 colorMax[] = {2, 16, 100, 223, 256};
+
+	NOTHING(pDatDir);
+	NOTHING(pWorkDir);
+
+	for (uint8 bit = 24; bit <= 32; bit += 8) {
+		for (uint32 seed = 0; seed < 4; seed++) {
+			for (uint32 i = 0; i < sizeof(colorMax) / sizeof(colorMax[0]); i++) {
+				CTga tga;
+
+				if (!TEST_CHECK(MakeTga(&tga, 64, 64, CTga::IMAGE_TYPE_FULL, bit, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, seed))) continue;
+				if (!TEST_CHECK(tga.Quantize(colorMax[i], seed & 3))) continue;
+
+				const uint32 color = tga.getPaletteColor();
+				bool bOk = true;
+
+				bOk &= TEST_CHECK(tga.getImageBit() == 8);
+				bOk &= TEST_CHECK(color >= 1 && color <= colorMax[i]);
+				bOk &= TEST_CHECK(tga.getPaletteSize() == color * (tga.getPaletteBit() >> 3));
+
+				uint32 over = 0;
+				const uint8 *pImage = tga.getImage();
+				for (uint32 n = 0; n < tga.getImageSize(); n++) {
+					if (pImage[n] >= color) over++;
+				}
+				bOk &= TEST_CHECK(over == 0);
+				if (!bOk) printf("  %ubit seed %u colorMax %u: color %u over %u\n", bit, seed, colorMax[i], color, over);
+			}
+		}
+	}
+
+	// 最大色数より色が少なければ、減色しても元の色のまま
+	CTga few, ref;
+	if (!TEST_CHECK(MakeTga(&few, 33, 17, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RUN, 5))) return;
+	SetRandom(6);
+	uint8 table[12][4];
+	for (uint32 n = 0; n < 12; n++) {
+		for (uint32 c = 0; c < 4; c++) table[n][c] = static_cast<uint8>(Random());
+	}
+	for (uint32 y = 0; y < few.getHeight(); y++) {
+		for (uint32 x = 0; x < few.getWidth(); x++) {
+			memcpy(GetPixel(few, x, y), table[(x / 3 + y) % 12], 4);
+		}
+	}
+
+	const uint32 pixel = few.getWidth() * few.getHeight();
+	uint8 *pBefore = new uint8[pixel * 4];
+	uint8 *pAfter  = new uint8[pixel * 4];
+	if (TEST_CHECK(pBefore != NULL && pAfter != NULL)) {
+		few.GetImage32(pBefore);
+		TEST_CHECK(few.Quantize(16, 1));
+		TEST_CHECK(few.getPaletteColor() <= 16);
+		TEST_CHECK(few.GetImage32(pAfter));
+		TEST_CHECK(memcmp(pBefore, pAfter, pixel * 4) == 0);
+	}
+	SAFE_DELETES(pBefore);
+	SAFE_DELETES(pAfter);
+}
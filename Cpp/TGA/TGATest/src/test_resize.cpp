@@ -0,0 +1,93 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+
+/*=======================================================================
+【機能】サイズ変更(同じ大きさ、単色、出力形式、範囲外のパレット番号)
+ =======================================================================*/
+void TestResize(const char *pDatDir, const char *pWorkDir)
+{
+	static const uint8 format[][2] = {
+		{CTga::IMAGE_TYPE_GRAY, 8}, {CTga::IMAGE_TYPE_FULL, 24}, {CTga::IMAGE_TYPE_FULL, 32}
+	};
+
+	NOTHING(pDatDir);
+	NOTHING(pWorkDir);
+
+	// 同じ大きさなら係数は中心だけなので元の画像のまま(SIMDの単位に満たない幅を含む)
+	for (sint32 filter = 0; filter < CTga::RESIZE_FILTER_MAX; filter++) {
+		for (uint32 i = 0; i < sizeof(format) / sizeof(format[0]); i++) {
+			for (uint32 w = 1; w <= 9; w += 4) {
+				CTga src, dst;
+				if (!TEST_CHECK(MakeTga(&src, w, 70, format[i][0], format[i][1], CTga::IMAGE_LINE_LRDU, FILL_RANDOM, w))) continue;
+
+				// 乗算済みアルファの往復で色が変わらないようにアルファは255
+				if (format[i][1] == 32) {
+					for (uint32 y = 0; y < 70; y++) {
+						for (uint32 x = 0; x < w; x++) GetPixel(src, x, y)[3] = 255;
+					}
+				}
+				if (!TEST_CHECK(src.Resize(&dst, w, 70, filter))) continue;
+				if (!TEST_CHECK(IsSameImage(src, dst))) printf("  filter %d %ubit width %u\n", filter, format[i][1], w);
+			}
+		}
+	}
+
+	// 単色は縮小・拡大しても同じ色
+	for (sint32 filter = 0; filter < CTga::RESIZE_FILTER_MAX; filter++) {
+		CTga src, dst;
+		if (!TEST_CHECK(MakeTga(&src, 37, 21, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRUD, FILL_SOLID, 0))) continue;
+		for (uint32 y = 0; y < 21; y++) {
+			for (uint32 x = 0; x < 37; x++) {
+				uint8 *p = GetPixel(src, x, y);
+				p[0] = 10; p[1] = 200; p[2] = 99; p[3] = 128;
+			}
+		}
+
+		const uint32 size[][2] = {{13, 5}, {80, 64}};
+		for (uint32 n = 0; n < 2; n++) {
+			if (!TEST_CHECK(src.Resize(&dst, size[n][0], size[n][1], filter))) continue;
+			TEST_CHECK(dst.getWidth() == size[n][0] && dst.getHeight() == size[n][1]);
+
+			uint32 bad = 0;
+			for (uint32 y = 0; y < size[n][1]; y++) {
+				for (uint32 x = 0; x < size[n][0]; x++) {
+					const uint8 *p = GetPixel(dst, x, y);
+					if (p[0] != 10 || p[1] != 200 || p[2] != 99 || p[3] != 128) bad++;
+				}
+			}
+			if (!TEST_CHECK(bad == 0)) printf("  filter %d size %ux%u\n", filter, size[n][0], size[n][1]);
+		}
+	}
+
+	// 16bitはアルファの有無で24bit/32bitになる
+	CTga s16, d16;
+	if (TEST_CHECK(MakeTga(&s16, 16, 16, CTga::IMAGE_TYPE_FULL, 16, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 16))) {
+		TEST_CHECK(s16.Resize(&d16, 8, 8, CTga::RESIZE_FILTER_BILINEAR));
+		TEST_CHECK(d16.getImageBit() == 32);
+	}
+
+	// インデックスカラーはパレットのビット数で展開、範囲外の番号はパレット0の色
+	CTga index, dst;
+	if (TEST_CHECK(MakeTga(&index, 6, 4, CTga::IMAGE_TYPE_INDEX, 8, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 3))) {
+		GetPixel(index, 2, 1)[0] = 200;
+		GetPixel(index, 5, 3)[0] = static_cast<uint8>(index.getPaletteColor());
+
+		if (TEST_CHECK(index.Resize(&dst, 6, 4, CTga::RESIZE_FILTER_BILINEAR))) {
+			TEST_CHECK(dst.getImageBit() == 24);
+
+			uint32 bad = 0;
+			for (uint32 y = 0; y < 4; y++) {
+				for (uint32 x = 0; x < 6; x++) {
+					const uint8 i = GetPixel(index, x, y)[0];
+					const uint8 *pPal = &index.getPalette()[((i < index.getPaletteColor()) ? i : 0) * 3];
+					if (memcmp(GetPixel(dst, x, y), pPal, 3) != 0) bad++;
+				}
+			}
+			TEST_CHECK(bad == 0);
+		}
+	}
+}
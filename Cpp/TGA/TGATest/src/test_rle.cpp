@@ -0,0 +1,93 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+
+namespace {
+
+/*=======================================================================
+【機能】1つの画像の出力、読み込みの往復
+【引数】tga      ：画像(RLEの有無は変更する)
+        pWorkDir ：作業ディレクトリ
+        pName    ：表示名
+ =======================================================================*/
+void RoundTrip(CTga &tga, const char *pWorkDir, const char *pName)
+{
+	char path[1024];
+	sprintf(path, "%s/roundtrip.tga", pWorkDir);
+
+	// 非圧縮、非圧縮+スキャンライン、RLE、RLE+スキャンライン
+	for (uint32 mode = 0; mode < 4; mode++) {
+		const bool   bRLE = (mode & 2) != 0;
+		const uint32 flag = (mode & 1) ? CTga::OUTPUT_FLAG_SCANLINE : CTga::OUTPUT_FLAG_NONE;
+		CTga back;
+		CTga::TGAValidation result;
+
+		tga.setRLE(bRLE);
+		if (!TEST_CHECK(tga.Output(path, flag) == CTga::ERROR_NONE)) {
+			printf("  %s mode %u\n", pName, mode);
+			continue;
+		}
+
+		bool bOk = true;
+		bOk &= TEST_CHECK(back.Create(path) == CTga::ERROR_NONE);
+		bOk &= TEST_CHECK(back.isRLE() == bRLE);
+		bOk &= TEST_CHECK((back.getHeader().discripter & 0x30) == (tga.getHeader().discripter & 0x30));
+		bOk &= TEST_CHECK(IsSameImage(tga, back));
+		bOk &= TEST_CHECK(CTga::Validate(path, &result) == CTga::VALIDATE_NONE);
+		bOk &= TEST_CHECK(result.bExtension == ((flag & CTga::OUTPUT_FLAG_SCANLINE) != 0));
+		if (!bOk) printf("  %s mode %u\n", pName, mode);
+	}
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】Output/Createの往復(非圧縮、RLE、スキャンラインテーブル)
+ =======================================================================*/
+void TestRLE(const char *pDatDir, const char *pWorkDir)
+{
+	static const char *pFile[] = {"pen1_ico16", "pen1_ico24", "pen1_ico256", "pen1_ico32", "pen1_ico32a", "pen1_icoRLE"};
+
+	for (uint32 i = 0; i < sizeof(pFile) / sizeof(pFile[0]); i++) {
+		char path[1024];
+		CTga tga;
+
+		sprintf(path, "%s/%s.tga", pDatDir, pFile[i]);
+		if (!TEST_CHECK(tga.Create(path) == CTga::ERROR_NONE)) {
+			printf("  %s\n", path);
+			continue;
+		}
+		RoundTrip(tga, pWorkDir, pFile[i]);
+	}
+
+	// 帯(RLE_BAND_LINE)とパケット(128ピクセル)の境目をまたぐ大きさ
+	struct {
+		uint32	w, h;
+		uint8	type, bit, discripter;
+		sint32	fill;
+	} const image[] = {
+		{  1,  1, CTga::IMAGE_TYPE_FULL,  32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM},
+		{300, 70, CTga::IMAGE_TYPE_FULL,  32, CTga::IMAGE_LINE_LRUD, FILL_SOLID},
+		{129, 33, CTga::IMAGE_TYPE_FULL,  24, CTga::IMAGE_LINE_LRDU, FILL_RUN},
+		{ 77, 65, CTga::IMAGE_TYPE_FULL,  16, CTga::IMAGE_LINE_RLUD, FILL_RUN},
+		{200, 40, CTga::IMAGE_TYPE_INDEX,  8, CTga::IMAGE_LINE_LRDU, FILL_RUN},
+		{ 50, 90, CTga::IMAGE_TYPE_GRAY,   8, CTga::IMAGE_LINE_LRUD, FILL_SOLID},
+		{ 64, 64, CTga::IMAGE_TYPE_FULL,  32, CTga::IMAGE_LINE_RLDU, FILL_RANDOM}
+	};
+
+	for (uint32 i = 0; i < sizeof(image) / sizeof(image[0]); i++) {
+		char name[64];
+		CTga tga;
+
+		sprintf(name, "image %u (%ux%u)", i, image[i].w, image[i].h);
+		if (!TEST_CHECK(MakeTga(&tga, image[i].w, image[i].h, image[i].type, image[i].bit, image[i].discripter, image[i].fill, i))) {
+			printf("  %s\n", name);
+			continue;
+		}
+		RoundTrip(tga, pWorkDir, name);
+	}
+}
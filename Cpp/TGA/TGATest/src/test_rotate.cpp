@@ -0,0 +1,102 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+
+/*=======================================================================
+【機能】回転を素直な実装と比較
+ =======================================================================*/
+void TestRotate(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	static const uint32 size[][2] = {{1, 1}, {3, 7}, {64, 64}, {65, 130}, {130, 3}};
+	static const uint8 line[] = {CTga::IMAGE_LINE_LRDU, CTga::IMAGE_LINE_LRUD, CTga::IMAGE_LINE_RLUD};
+	static const uint8 format[][2] = {
+		{CTga::IMAGE_TYPE_INDEX, 8}, {CTga::IMAGE_TYPE_GRAY, 8},
+		{CTga::IMAGE_TYPE_FULL, 16}, {CTga::IMAGE_TYPE_FULL, 24}, {CTga::IMAGE_TYPE_FULL, 32}
+	};
+
+	for (uint32 s = 0; s < sizeof(size) / sizeof(size[0]); s++) {
+		for (uint32 l = 0; l < sizeof(line); l++) {
+			for (uint32 f = 0; f < sizeof(format) / sizeof(format[0]); f++) {
+				for (sint32 rotate = CTga::ROTATE_90; rotate < CTga::ROTATE_MAX; rotate++) {
+					const uint32 w = size[s][0];
+					const uint32 h = size[s][1];
+					const uint32 seed = s * 100 + f;
+					CTga src, dst;
+
+					MakeTga(&src, w, h, format[f][0], format[f][1], line[l], FILL_RANDOM, seed);
+					MakeTga(&dst, w, h, format[f][0], format[f][1], line[l], FILL_RANDOM, seed);
+					if (!TEST_CHECK(dst.Rotate(rotate))) continue;
+
+					const bool bSwap = (rotate != CTga::ROTATE_180);
+					if (!TEST_CHECK(dst.getWidth() == (bSwap ? h : w) && dst.getHeight() == (bSwap ? w : h))) continue;
+					TEST_CHECK((dst.getHeader().discripter & 0x30) == line[l]);
+
+					// 回転後の(x, y)に来る元の位置
+					const uint32 byte = src.getImageBit() >> 3;
+					uint32 diff = 0;
+					for (uint32 y = 0; y < dst.getHeight(); y++) {
+						for (uint32 x = 0; x < dst.getWidth(); x++) {
+							uint32 sx, sy;
+							switch (rotate) {
+							case CTga::ROTATE_90:  sx = y;         sy = h - 1 - x; break;
+							case CTga::ROTATE_180: sx = w - 1 - x; sy = h - 1 - y; break;
+							case CTga::ROTATE_270: sx = w - 1 - y; sy = x;         break;
+							default:               sx = y;         sy = x;         break;
+							}
+							if (memcmp(GetPixel(dst, x, y), GetPixel(src, sx, sy), byte) != 0) diff++;
+						}
+					}
+					if (!TEST_CHECK(diff == 0)) {
+						printf("  %ux%u line 0x%02x bit %u rotate %d: %u pixels\n", w, h, line[l], format[f][1], rotate, diff);
+					}
+				}
+			}
+		}
+	}
+
+	// 4回で元に戻る、転置は2回で元に戻る
+	{
+		CTga src, dst;
+
+		MakeTga(&src, 77, 45, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 47);
+		MakeTga(&dst, 77, 45, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 47);
+		for (sint32 n = 0; n < 4; n++) TEST_CHECK(dst.Rotate(CTga::ROTATE_270));
+		TEST_CHECK(IsSameImage(src, dst));
+		TEST_CHECK(dst.Rotate(CTga::ROTATE_TRANSPOSE) && dst.Rotate(CTga::ROTATE_TRANSPOSE));
+		TEST_CHECK(IsSameImage(src, dst));
+	}
+
+	// 遅延デコードはRotateでデコード(ファイルはそのまま)
+	{
+		CTga src, lazy, back;
+		char path[1024];
+
+		sprintf(path, "%s/rotate.tga", pWorkDir);
+		MakeTga(&src, 33, 20, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRUD, FILL_RUN, 47);
+		src.setRLE(true);
+		if (TEST_CHECK(src.Output(path) == CTga::ERROR_NONE)) {
+			lazy.setCreateFlag(CTga::CREATE_FLAG_LAZY);
+			TEST_CHECK(lazy.Create(path) == CTga::ERROR_NONE);
+			TEST_CHECK(lazy.Rotate(CTga::ROTATE_90));
+			TEST_CHECK(lazy.getWidth() == 20 && lazy.getHeight() == 33);
+			TEST_CHECK(memcmp(GetPixel(lazy, 19, 0), GetPixel(src, 0, 0), 4) == 0);
+			TEST_CHECK(back.Create(path) == CTga::ERROR_NONE);
+			TEST_CHECK(IsSameImage(src, back));
+		}
+	}
+
+	// 範囲外の種類、画像がなければ失敗
+	{
+		CTga tga, empty;
+
+		MakeTga(&tga, 4, 4, CTga::IMAGE_TYPE_GRAY, 8, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 47);
+		TEST_CHECK(!tga.Rotate(-1));
+		TEST_CHECK(!tga.Rotate(CTga::ROTATE_MAX));
+		TEST_CHECK(!empty.Rotate(CTga::ROTATE_90));
+	}
+}
@@ -0,0 +1,175 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_sequence.h"
+#include "test.h"
+
+
+namespace {
+
+enum {
+	FRAME_NUM     = 5,					// 連番のフレーム数
+	FRAME_MISSING = 3,					// ファイルを作らないフレーム
+	FRAME_SMALL   = 4					// 他と大きさが違うフレーム
+};
+
+/*=======================================================================
+【機能】連番のファイルを作る
+【引数】pRef   ：フレームごとの画像の格納先(FRAME_NUM個)
+        pPattern：ファイル名のパターン
+【戻値】false：作れなかった
+ =======================================================================*/
+bool MakeFrames(CTga *pRef, const char *pPattern)
+{
+	char path[1024];
+
+	for (sint32 i = 0; i < FRAME_NUM; i++) {
+		sprintf(path, pPattern, i);
+		remove(path);
+		if (i == FRAME_MISSING) continue;
+
+		const uint32 size = (i == FRAME_SMALL) ? 8 : 16;
+		if (!MakeTga(&pRef[i], size, size, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 36 + i)) return false;
+		if (pRef[i].Output(path) != CTga::ERROR_NONE) return false;
+	}
+
+	return true;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】連番TGAの先読み(順方向・逆順、欠けたフレーム、範囲、メモリの使い回し)
+ =======================================================================*/
+void TestSequence(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	char pattern[1024];
+	sprintf(pattern, "%s/seq_%%04d.tga", pWorkDir);
+
+	CTga ref[FRAME_NUM];
+	if (!TEST_CHECK(MakeFrames(ref, pattern))) return;
+
+	// 順方向と逆順
+	for (sint32 order = 0; order < 2; order++) {
+		const sint32 first = order ? FRAME_NUM - 1 : 0;
+		const sint32 last  = order ? 0 : FRAME_NUM - 1;
+		const uint8 *pFirstImage = NULL;
+		sint32 count = 0;
+
+		// 先読み1つならスロットは2つ(フレーム0と2は同じスロット)
+		CTgaSequence seq;
+		if (!TEST_CHECK(seq.Open(pattern, first, last, 1, 2))) continue;
+		TEST_CHECK(seq.getFrameNum() == FRAME_NUM);
+
+		for (;;) {
+			sint32 frame = -1;
+			int error = CTga::ERROR_NONE;
+			const CTga *pFrame = seq.Next(&frame, &error);
+			const sint32 expect = order ? (FRAME_NUM - 1 - count) : count;
+
+			if (count == FRAME_NUM) {
+				TEST_CHECK(pFrame == NULL && error == CTgaSequence::ERROR_END);
+				break;
+			}
+			count++;
+
+			TEST_CHECK(frame == expect);
+			if (expect == FRAME_MISSING) {
+				TEST_CHECK(pFrame == NULL && error == CTga::ERROR_OPEN);
+				continue;
+			}
+			if (!TEST_CHECK(pFrame != NULL && error == CTga::ERROR_NONE)) continue;
+			TEST_CHECK(IsSameImage(*pFrame, ref[expect]));
+
+			// 同じ大きさのフレームは同じスロットのメモリに読み込む
+			if (order == 0 && expect == 0) pFirstImage = pFrame->getImage();
+			if (order == 0 && expect == 2) TEST_CHECK(pFrame->getImage() == pFirstImage);
+		}
+
+		// 最後まで取り出した後も終わりのまま
+		int error = CTga::ERROR_NONE;
+		TEST_CHECK(seq.Next(NULL, &error) == NULL && error == CTgaSequence::ERROR_END);
+	}
+
+	// 同じ大きさなら前のイメージのメモリに作り直す
+	{
+		char path[1024];
+		uint8 *pBuf[3];
+		uint32 size[3];
+		const sint32 frame[3] = {0, 1, FRAME_SMALL};
+		bool bRead = true;
+
+		for (sint32 i = 0; i < 3; i++) {
+			sprintf(path, pattern, frame[i]);
+			pBuf[i] = NULL;
+			if (!ReadFile(path, &pBuf[i], &size[i])) bRead = false;
+		}
+
+		if (TEST_CHECK(bRead)) {
+			CTga tga;
+			TEST_CHECK(tga.Create(pBuf[0], size[0]) == CTga::ERROR_NONE);
+			const uint8 *pImage = tga.getImage();
+			TEST_CHECK(tga.Create(pBuf[1], size[1]) == CTga::ERROR_NONE);
+			TEST_CHECK(tga.getImage() == pImage);
+			TEST_CHECK(IsSameImage(tga, ref[1]));
+			TEST_CHECK(tga.Create(pBuf[2], size[2]) == CTga::ERROR_NONE);
+			TEST_CHECK(IsSameImage(tga, ref[FRAME_SMALL]));
+
+			// 失敗したら前のイメージは残らない
+			const uint8 type = pBuf[1][2];
+			pBuf[1][2] = 0x55;
+			TEST_CHECK(tga.Create(pBuf[1], size[1]) == CTga::ERROR_HEADER);
+			TEST_CHECK(tga.getImage() == NULL);
+			pBuf[1][2] = type;
+
+			TEST_CHECK(tga.Create(pBuf[0], size[0]) == CTga::ERROR_NONE);
+			TEST_CHECK(IsSameImage(tga, ref[0]));
+		}
+
+		for (sint32 i = 0; i < 3; i++) SAFE_DELETES(pBuf[i]);
+	}
+
+	// フレーム数が多すぎる範囲は開かない
+	{
+		const sint32 minFrame = -0x7fffffff - 1;
+		const sint32 maxFrame = 0x7fffffff;
+		CTgaSequence seq;
+
+		TEST_CHECK(!seq.Open(pattern, minFrame, maxFrame, 1, 1));
+		TEST_CHECK(!seq.Open(pattern, maxFrame, minFrame, 1, 1));
+		TEST_CHECK(!seq.Open(pattern, -1, maxFrame, 1, 1));
+		TEST_CHECK(seq.Next(NULL, NULL) == NULL);
+
+		// 端のフレーム番号
+		if (TEST_CHECK(seq.Open(pattern, maxFrame, maxFrame - 1, 1, 1))) {
+			sint32 frame = 0;
+			int error = CTga::ERROR_NONE;
+			TEST_CHECK(seq.getFrameNum() == 2);
+			TEST_CHECK(seq.Next(&frame, &error) == NULL && frame == maxFrame && error == CTga::ERROR_OPEN);
+			TEST_CHECK(seq.Next(&frame, &error) == NULL && frame == maxFrame - 1 && error == CTga::ERROR_OPEN);
+			TEST_CHECK(seq.Next(&frame, &error) == NULL && error == CTgaSequence::ERROR_END);
+		}
+		if (TEST_CHECK(seq.Open(pattern, 0, maxFrame - 1, 1, 1))) {
+			TEST_CHECK(seq.getFrameNum() == static_cast<uint32>(CTgaSequence::FRAME_NUM_MAX));
+			seq.Close();
+		}
+	}
+
+	// 使えないパターン(幅が広い、展開すると入らない)
+	{
+		char wide[1024];
+		char longPattern[1100];
+		sprintf(wide, "%s/x%%02000d.tga", pWorkDir);
+		memset(longPattern, 'a', sizeof(longPattern));
+		sprintf(&longPattern[1010], "%%d.tga");
+
+		CTgaSequence seq;
+		TEST_CHECK(!seq.Open(wide, 0, 3, 2, 1));
+		TEST_CHECK(!seq.Open(longPattern, 0, 3, 2, 1));
+		TEST_CHECK(!seq.Open(NULL, 0, 3, 2, 1));
+	}
+}
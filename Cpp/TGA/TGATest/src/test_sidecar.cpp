@@ -0,0 +1,148 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_sidecar.h"
+#include "test.h"
+
+
+namespace {
+
+enum {
+	FILE_NUM = 12						// 保存するファイル数
+};
+
+/*=======================================================================
+【機能】キャッシュファイルを数える
+ =======================================================================*/
+struct SidecarList {
+	const char	*pDir;					// ディレクトリ
+	uint32		num;					// ファイル数
+	uint64		total;					// 合計サイズ
+	bool		bRemove;				// 削除する？
+};
+
+void CountScan(const char *pName, const MtoFileStatus &status, void *pUser)
+{
+	SidecarList *pList = static_cast<SidecarList*>(pUser);
+	const size_t len = strlen(pName);
+
+	if (len <= 5 || strcmp(&pName[len - 5], ".tgac") != 0) return;
+
+	if (pList->bRemove) {
+		char path[1024];
+		sprintf(path, "%s/%s", pList->pDir, pName);
+		MtoFileRemove(path);
+		return;
+	}
+
+	pList->num++;
+	pList->total += status.size;
+}
+
+SidecarList CountFile(const char *pDir, const bool bRemove)
+{
+	SidecarList list;
+	list.pDir    = pDir;
+	list.num     = 0;
+	list.total   = 0;
+	list.bRemove = bRemove;
+	MtoDirScan(pDir, CountScan, &list);
+
+	return list;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】デコード済みTGAのファイルキャッシュ(保存、読み込み、更新、Trim)
+ =======================================================================*/
+void TestSidecar(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	// 前回の残りは削除
+	CountFile(pWorkDir, true);
+
+	char path[FILE_NUM][1024];
+	CTga src[FILE_NUM];
+	for (uint32 i = 0; i < FILE_NUM; i++) {
+		sprintf(path[i], "%s/sidecar%02u.tga", pWorkDir, i);
+		if (!TEST_CHECK(MakeTga(&src[i], 64, 32, (i == 0) ? CTga::IMAGE_TYPE_INDEX : CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRUD, FILL_RUN, i))) return;
+		src[i].setRLE(true);
+		if (!TEST_CHECK(src[i].Output(path[i]) == CTga::ERROR_NONE)) return;
+	}
+
+	// 保存と読み込み
+	{
+		CTgaSidecar sidecar(pWorkDir, 0);
+		CTga tga, cached;
+		MtoFileStatus status;
+
+		TEST_CHECK(sidecar.Load(&cached, path[0], &status) != CTga::ERROR_NONE);
+
+		tga.setSidecar(&sidecar);
+		TEST_CHECK(tga.Create(path[0]) == CTga::ERROR_NONE);
+		TEST_CHECK(CountFile(pWorkDir, false).num == 1);
+
+		TEST_CHECK(sidecar.Load(&cached, path[0], &status) == CTga::ERROR_NONE);
+		TEST_CHECK(IsSameImage(cached, src[0]));
+		TEST_CHECK(cached.getPaletteColor() == src[0].getPaletteColor());
+
+		// setSidecarしたCTgaはキャッシュから作成
+		CTga again;
+		again.setSidecar(&sidecar);
+		TEST_CHECK(again.Create(path[0]) == CTga::ERROR_NONE && IsSameImage(again, src[0]));
+
+		// 作成フラグが違うものは使わない
+		CTga pre;
+		pre.setCreateFlag(CTga::CREATE_FLAG_PREMULTIPLY);
+		TEST_CHECK(sidecar.Load(&pre, path[0], &status) != CTga::ERROR_NONE);
+
+		// 元ファイルが更新されたら使わない
+		CTga other;
+		MakeTga(&other, 10, 10, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 99);
+		other.Output(path[0]);
+		TEST_CHECK(sidecar.Load(&cached, path[0], &status) == CTga::ERROR_HEADER);
+
+		CTga reload;
+		reload.setSidecar(&sidecar);
+		TEST_CHECK(reload.Create(path[0]) == CTga::ERROR_NONE && IsSameImage(reload, other));
+		TEST_CHECK(sidecar.Load(&cached, path[0], &status) == CTga::ERROR_NONE && IsSameImage(cached, other));
+	}
+	CountFile(pWorkDir, true);
+
+	// 上限を超えたら古いものから削除
+	{
+		// 1ファイルはヘッダー128バイト+イメージ64x32x4バイト
+		const uint64 fileSize = CTgaSidecar::FILE_HEADER_SIZE + 64 * 32 * 4;
+		const uint64 limit    = fileSize * 5 + fileSize / 2;
+		CTgaSidecar sidecar(pWorkDir, limit);
+		uint32 over = 0;
+
+		for (uint32 i = 1; i < FILE_NUM; i++) {
+			CTga tga;
+			tga.setSidecar(&sidecar);
+			TEST_CHECK(tga.Create(path[i]) == CTga::ERROR_NONE);
+
+			const SidecarList list = CountFile(pWorkDir, false);
+			if (list.total > limit || list.num == 0) over++;
+		}
+		TEST_CHECK(over == 0);
+
+		// 上限より大きいものは保存しない
+		CTgaSidecar small(pWorkDir, fileSize - 1);
+		CTga tga;
+		MtoFileStatus status;
+		TEST_CHECK(tga.Create(path[1]) == CTga::ERROR_NONE);
+		MtoFileGetStatus(path[1], &status);
+		TEST_CHECK(!small.Store(tga, path[1], status));
+
+		// Trimは上限の1/TRIM_MARGINの余裕を作る
+		CTgaSidecar trim(pWorkDir, fileSize * 3);
+		trim.Trim();
+		TEST_CHECK(CountFile(pWorkDir, false).total <= fileSize * 3 - fileSize * 3 / CTgaSidecar::TRIM_MARGIN);
+	}
+	CountFile(pWorkDir, true);
+}
@@ -0,0 +1,144 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "test.h"
+
+
+namespace {
+
+/*=======================================================================
+【機能】切り出したファイルが元の範囲と同じか
+【引数】tga     ：元の画像
+        pPattern：ファイル名のパターン
+        number  ：範囲の番号
+        rect    ：範囲
+ =======================================================================*/
+bool IsSameCell(const CTga &tga, const char *pPattern, const sint32 number, const CTga::TGARect &rect)
+{
+	char path[1024];
+	CTga cell;
+
+	if (!CTga::ExpandPattern(path, sizeof(path), pPattern, number)) return false;
+	if (cell.Create(path) != CTga::ERROR_NONE) return false;
+	if (cell.getWidth() != rect.w || cell.getHeight() != rect.h) return false;
+	if (cell.getImageBit() != tga.getImageBit()) return false;
+	if ((cell.getHeader().discripter & 0x30) != (tga.getHeader().discripter & 0x30)) return false;
+
+	const uint32 byte = tga.getImageBit() >> 3;
+	for (uint32 y = 0; y < rect.h; y++) {
+		for (uint32 x = 0; x < rect.w; x++) {
+			if (memcmp(GetPixel(cell, x, y), GetPixel(tga, rect.x + x, rect.y + y), byte) != 0) return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】ファイル名のパターンと切り出し(格子、透明な範囲、はみ出す範囲)
+ =======================================================================*/
+void TestSlice(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	// パターンの形式と幅
+	TEST_CHECK(CTga::CheckPattern("cell_%d.tga", 1024));
+	TEST_CHECK(CTga::CheckPattern("cell_%%_%016d.tga", 1024));
+	TEST_CHECK(CTga::CheckPattern("cell_%-16i.tga", 1024));
+	TEST_CHECK(!CTga::CheckPattern("x%02000d.tga", 1024));
+	TEST_CHECK(!CTga::CheckPattern("x%017d.tga", 1024));
+	TEST_CHECK(!CTga::CheckPattern("x%d_%d.tga", 1024));
+	TEST_CHECK(!CTga::CheckPattern("x%s.tga", 1024));
+	TEST_CHECK(!CTga::CheckPattern("x.tga", 1024));
+	TEST_CHECK(!CTga::CheckPattern("x%", 1024));
+
+	// 展開(収まらなければ空文字列)
+	{
+		char path[16];
+
+		TEST_CHECK(CTga::ExpandPattern(path, sizeof(path), "cell_%d.tga", 12) && strcmp(path, "cell_12.tga") == 0);
+		TEST_CHECK(CTga::ExpandPattern(path, sizeof(path), "c_%%_%04d.tga", -3) && strcmp(path, "c_%_-003.tga") == 0);
+		TEST_CHECK(CTga::ExpandPattern(path, sizeof(path), "cell_%06d.tga", 7) && strlen(path) == 15);
+		TEST_CHECK(!CTga::ExpandPattern(path, sizeof(path), "cell_%07d.tga", 7) && path[0] == '\0');
+		TEST_CHECK(!CTga::ExpandPattern(path, sizeof(path), "cell_%016d.tga", 7) && path[0] == '\0');
+	}
+
+	// 幅が広いパターン、展開すると入らない長いパターンでは何も出力しない
+	char wide[1024];
+	char longPattern[1100];
+	sprintf(wide, "%s/x%%02000d.tga", pWorkDir);
+	memset(longPattern, 'a', sizeof(longPattern));
+	sprintf(&longPattern[1010], "%%d.tga");
+
+	CTga tga;
+	uint32 num = 1;
+	if (!TEST_CHECK(MakeTga(&tga, 16, 16, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 48))) return;
+	TEST_CHECK(tga.SliceGrid(wide, 8, 8, CTga::SLICE_FLAG_NONE, &num) == CTga::ERROR_OUTPUT);
+	TEST_CHECK(num == 0);
+	num = 1;
+	TEST_CHECK(tga.SliceGrid(longPattern, 8, 8, CTga::SLICE_FLAG_NONE, &num) == CTga::ERROR_OUTPUT);
+	TEST_CHECK(num == 0);
+
+	// 最大幅のパターンで切り出して読み戻す(左上から右へ数えた番号)
+	char pattern[1024];
+	sprintf(pattern, "%s/cell_%%016d.tga", pWorkDir);
+	for (sint32 rle = 0; rle < 2; rle++) {
+		TEST_CHECK(tga.SliceGrid(pattern, 8, 8, rle ? CTga::SLICE_FLAG_RLE : CTga::SLICE_FLAG_NONE, &num) == CTga::ERROR_NONE);
+		TEST_CHECK(num == 4);
+		for (sint32 i = 0; i < 4; i++) {
+			const CTga::TGARect rect = {static_cast<uint16>((i % 2) * 8), static_cast<uint16>((i / 2) * 8), 8, 8};
+			if (!TEST_CHECK(IsSameCell(tga, pattern, i, rect))) printf("  rle %d cell %d\n", rle, i);
+		}
+	}
+
+	// 並びが違っても見た目の範囲を切り出す、端の余りは出力しない
+	{
+		CTga rl;
+		char rlPattern[1024];
+
+		sprintf(rlPattern, "%s/cell_rl_%%d.tga", pWorkDir);
+		if (TEST_CHECK(MakeTga(&rl, 21, 10, CTga::IMAGE_TYPE_INDEX, 8, CTga::IMAGE_LINE_RLUD, FILL_RUN, 49))) {
+			TEST_CHECK(rl.SliceGrid(rlPattern, 10, 5, CTga::SLICE_FLAG_SKIP, &num) == CTga::ERROR_NONE);
+			TEST_CHECK(num == 4);
+			for (sint32 i = 0; i < 4; i++) {
+				const CTga::TGARect rect = {static_cast<uint16>((i % 2) * 10), static_cast<uint16>((i / 2) * 5), 10, 5};
+				TEST_CHECK(IsSameCell(rl, rlPattern, i, rect));
+			}
+		}
+	}
+
+	// SLICE_FLAG_SKIPなら全部透明な範囲は番号を飛ばす
+	{
+		char path[1024];
+
+		for (uint32 y = 0; y < 8; y++) {
+			for (uint32 x = 8; x < 16; x++) GetPixel(tga, x, y)[3] = 0;
+		}
+		TEST_CHECK(CTga::ExpandPattern(path, sizeof(path), pattern, 1));
+		remove(path);
+		TEST_CHECK(tga.SliceGrid(pattern, 8, 8, CTga::SLICE_FLAG_SKIP, &num) == CTga::ERROR_NONE);
+		TEST_CHECK(num == 3);
+		TEST_CHECK(GetFileSize(path) < 0);
+		TEST_CHECK(tga.SliceGrid(pattern, 8, 8, CTga::SLICE_FLAG_NONE, &num) == CTga::ERROR_NONE);
+		TEST_CHECK(num == 4);
+		TEST_CHECK(GetFileSize(path) > 0);
+	}
+
+	// はみ出す範囲、大きさ0の範囲があれば何も出力しない
+	{
+		const CTga::TGARect rect[] = {{0, 0, 8, 8}, {10, 10, 8, 8}, {0, 0, 0, 4}};
+
+		num = 1;
+		TEST_CHECK(tga.Slice(pattern, rect, 2, CTga::SLICE_FLAG_NONE, &num) == CTga::ERROR_IMAGE);
+		TEST_CHECK(num == 0);
+		TEST_CHECK(tga.Slice(pattern, &rect[2], 1, CTga::SLICE_FLAG_NONE, &num) == CTga::ERROR_IMAGE);
+		TEST_CHECK(tga.Slice(pattern, rect, 1, CTga::SLICE_FLAG_NONE, &num) == CTga::ERROR_NONE);
+		TEST_CHECK(num == 1);
+		TEST_CHECK(tga.SliceGrid(pattern, 17, 8, CTga::SLICE_FLAG_NONE, &num) == CTga::ERROR_NONE);
+		TEST_CHECK(num == 0);
+		TEST_CHECK(tga.SliceGrid(pattern, 0, 8, CTga::SLICE_FLAG_NONE, &num) == CTga::ERROR_IMAGE);
+	}
+}
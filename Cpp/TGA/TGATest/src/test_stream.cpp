@@ -0,0 +1,267 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_stream.h"
+#include "test.h"
+
+
+namespace {
+
+/*=======================================================================
+【機能】メモリ上のストリーム
+【備考】1回の読み書きをchunkバイトまでにして、パイプのように
+        少しずつしか読み書きできない場合を真似る。
+        limitバイトを超えて書こうとすると失敗する。
+ =======================================================================*/
+struct MemStream {
+	uint8		*pBuf;
+	uint32		size;				// データサイズ(読み込み)、バッファサイズ(書き込み)
+	uint32		pos;
+	uint32		chunk;				// 1回に読み書きする最大バイト数
+	uint32		limit;				// 書き込める最大バイト数
+
+	MemStream(uint8 *pData, const uint32 dataSize, const uint32 chunkSize)
+	{
+		pBuf  = pData;
+		size  = dataSize;
+		pos   = 0;
+		chunk = chunkSize;
+		limit = dataSize;
+	}
+};
+
+uint32 MemRead(void *pDst, const uint32 size, void *pUser)
+{
+	MemStream *pStream = static_cast<MemStream*>(pUser);
+	uint32 n = pStream->size - pStream->pos;
+
+	if (n > size) n = size;
+	if (n > pStream->chunk) n = pStream->chunk;
+	memcpy(pDst, &pStream->pBuf[pStream->pos], n);
+	pStream->pos += n;
+
+	return n;
+}
+
+uint32 MemWrite(const void *pSrc, const uint32 size, void *pUser)
+{
+	MemStream *pStream = static_cast<MemStream*>(pUser);
+	uint32 n = pStream->limit - pStream->pos;
+
+	if (n > size) n = size;
+	if (n > pStream->chunk) n = pStream->chunk;
+	memcpy(&pStream->pBuf[pStream->pos], pSrc, n);
+	pStream->pos += n;
+
+	return n;
+}
+
+/*=======================================================================
+【機能】1つの画像のストリーム出力、読み込み
+【引数】tga     ：画像(RLEの有無は変更する)
+        pWorkDir：作業ディレクトリ
+        pName   ：表示名
+【備考】ファイル出力と同じバイト列になるか、読み込むと同じ画像になるか。
+ =======================================================================*/
+void RoundTrip(CTga &tga, const char *pWorkDir, const char *pName)
+{
+	static const uint32 chunk[] = {1, 13, 0x10001, 0xffffffff};
+	char path[1024];
+
+	sprintf(path, "%s/stream.tga", pWorkDir);
+
+	for (uint32 mode = 0; mode < 4; mode++) {
+		const bool   bRLE = (mode & 2) != 0;
+		const uint32 flag = (mode & 1) ? CTga::OUTPUT_FLAG_SCANLINE : CTga::OUTPUT_FLAG_NONE;
+		uint8 *pFile;
+		uint32 fileSize;
+
+		tga.setRLE(bRLE);
+		if (!TEST_CHECK(tga.Output(path, flag) == CTga::ERROR_NONE) || !TEST_CHECK(ReadFile(path, &pFile, &fileSize))) continue;
+
+		for (uint32 c = 0; c < sizeof(chunk) / sizeof(chunk[0]); c++) {
+			uint8 *pBuf = new uint8[fileSize];
+			bool bOk = true;
+
+			// 出力(ファイル出力と同じ)
+			{
+				MemStream stream(pBuf, fileSize, chunk[c]);
+				CTgaStreamWriter writer(MemWrite, &stream);
+
+				bOk &= TEST_CHECK(tga.Output(&writer, flag) == CTga::ERROR_NONE);
+				bOk &= TEST_CHECK(!writer.isError());
+				bOk &= TEST_CHECK(stream.pos == fileSize && memcmp(pBuf, pFile, fileSize) == 0);
+			}
+
+			// 読み込み(同じ画像とフッター)
+			{
+				MemStream stream(pBuf, fileSize, chunk[c]);
+				CTgaStreamReader reader(MemRead, &stream);
+				CTga back;
+
+				bOk &= TEST_CHECK(back.Create(&reader) == CTga::ERROR_NONE);
+				bOk &= TEST_CHECK(back.isRLE() == bRLE);
+				bOk &= TEST_CHECK(IsSameImage(tga, back));
+				if (flag == CTga::OUTPUT_FLAG_NONE) {
+					bOk &= TEST_CHECK(back.getFooter().fileDev == tga.getFooter().fileDev);
+				}
+			}
+
+			if (!bOk) printf("  %s mode %u chunk %u\n", pName, mode, chunk[c]);
+			SAFE_DELETES(pBuf);
+		}
+		SAFE_DELETES(pFile);
+	}
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】ストリーム入出力(少しずつの読み書き、続けて読む、途中で終わる)
+ =======================================================================*/
+void TestStream(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	// BUFFER_SIZEより大きいもの(バッファを通さない読み書き)と小さいもの
+	struct {
+		uint32	w, h;
+		uint8	type, bit, discripter;
+		sint32	fill;
+	} const image[] = {
+		{ 83, 37, CTga::IMAGE_TYPE_FULL,  32, CTga::IMAGE_LINE_LRDU, FILL_RANDOM},
+		{300, 70, CTga::IMAGE_TYPE_FULL,  32, CTga::IMAGE_LINE_LRUD, FILL_RANDOM},
+		{129, 33, CTga::IMAGE_TYPE_FULL,  24, CTga::IMAGE_LINE_RLDU, FILL_RUN},
+		{ 77, 65, CTga::IMAGE_TYPE_FULL,  16, CTga::IMAGE_LINE_RLUD, FILL_RUN},
+		{200, 40, CTga::IMAGE_TYPE_INDEX,  8, CTga::IMAGE_LINE_LRDU, FILL_RUN},
+		{ 50, 90, CTga::IMAGE_TYPE_GRAY,   8, CTga::IMAGE_LINE_LRUD, FILL_SOLID}
+	};
+
+	for (uint32 i = 0; i < sizeof(image) / sizeof(image[0]); i++) {
+		char name[64];
+		CTga tga;
+
+		sprintf(name, "image %u (%ux%u)", i, image[i].w, image[i].h);
+		if (!TEST_CHECK(MakeTga(&tga, image[i].w, image[i].h, image[i].type, image[i].bit, image[i].discripter, image[i].fill, 41 + i))) {
+			printf("  %s\n", name);
+			continue;
+		}
+		tga.setFileDev(0x5678 + i);
+		RoundTrip(tga, pWorkDir, name);
+	}
+
+	// 2つ続けて出力して、続けて読む(フッターの後ろは読まない)
+	{
+		CTga a, b;
+		const uint32 bufSize = 64 * 1024 * 2;
+		uint8 *pBuf = new uint8[bufSize];
+
+		MakeTga(&a, 60, 30, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRUD, FILL_RUN, 47);
+		MakeTga(&b, 20, 50, CTga::IMAGE_TYPE_GRAY,  8, CTga::IMAGE_LINE_LRDU, FILL_RANDOM, 48);
+		b.setRLE(true);
+
+		MemStream out(pBuf, bufSize, 0xffffffff);
+		CTgaStreamWriter writer(MemWrite, &out);
+		TEST_CHECK(a.Output(&writer, CTga::OUTPUT_FLAG_NONE) == CTga::ERROR_NONE);
+		TEST_CHECK(b.Output(&writer, CTga::OUTPUT_FLAG_NONE) == CTga::ERROR_NONE);
+
+		MemStream in(pBuf, out.pos, 7);
+		CTgaStreamReader reader(MemRead, &in);
+		CTga backA, backB, backC;
+		TEST_CHECK(backA.Create(&reader) == CTga::ERROR_NONE);
+		TEST_CHECK(backB.Create(&reader) == CTga::ERROR_NONE);
+		TEST_CHECK(IsSameImage(a, backA));
+		TEST_CHECK(IsSameImage(b, backB));
+		TEST_CHECK(in.pos == out.pos);
+		TEST_CHECK(backC.Create(&reader) == CTga::ERROR_HEADER);
+
+		SAFE_DELETES(pBuf);
+	}
+
+	// 途中で終わるストリームと書き込みの失敗
+	{
+		CTga tga;
+		const uint32 bufSize = 64 * 1024;
+		uint8 *pBuf = new uint8[bufSize];
+
+		MakeTga(&tga, 40, 40, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRDU, FILL_RUN, 49);
+		for (sint32 rle = 0; rle < 2; rle++) {
+			tga.setRLE(rle != 0);
+
+			MemStream out(pBuf, bufSize, 0xffffffff);
+			CTgaStreamWriter writer(MemWrite, &out);
+			if (!TEST_CHECK(tga.Output(&writer, CTga::OUTPUT_FLAG_NONE) == CTga::ERROR_NONE)) continue;
+
+			const uint32 cut[] = {5, CTga::HEADER_SIZE, CTga::HEADER_SIZE + 100, out.pos - CTga::FOOTER_SIZE - 1};
+			for (uint32 n = 0; n < sizeof(cut) / sizeof(cut[0]); n++) {
+				MemStream in(pBuf, cut[n], 0xffffffff);
+				CTgaStreamReader reader(MemRead, &in);
+				CTga back;
+				TEST_CHECK(back.Create(&reader) == ((cut[n] < CTga::HEADER_SIZE) ? CTga::ERROR_HEADER : CTga::ERROR_IMAGE));
+				TEST_CHECK(back.getImage() == NULL);
+			}
+
+			// フッターがなければフッターなしで読める
+			{
+				MemStream in(pBuf, out.pos - CTga::FOOTER_SIZE, 0xffffffff);
+				CTgaStreamReader reader(MemRead, &in);
+				CTga back;
+				TEST_CHECK(back.Create(&reader) == CTga::ERROR_NONE);
+				TEST_CHECK(IsSameImage(tga, back));
+			}
+
+			// 書き込める大きさを超えたら失敗
+			MemStream small(pBuf, bufSize, 0xffffffff);
+			small.limit = out.pos / 2;
+			CTgaStreamWriter fail(MemWrite, &small);
+			TEST_CHECK(tga.Output(&fail, CTga::OUTPUT_FLAG_NONE) != CTga::ERROR_NONE);
+			TEST_CHECK(fail.isError());
+			TEST_CHECK(!fail.Write(pBuf, 1));
+		}
+		SAFE_DELETES(pBuf);
+	}
+
+	// 先読みと読み飛ばし
+	{
+		uint8 data[256];
+		uint8 dst[16];
+
+		for (uint32 i = 0; i < sizeof(data); i++) data[i] = static_cast<uint8>(i);
+
+		MemStream in(data, sizeof(data), 3);
+		CTgaStreamReader reader(MemRead, &in);
+		const uint8 *p = reader.Peek(10);
+		TEST_CHECK(p != NULL && p[0] == 0 && p[9] == 9);
+		TEST_CHECK(reader.Peek(CTgaStreamReader::BUFFER_SIZE + 1) == NULL);
+		reader.Skip(100);
+		TEST_CHECK(reader.Read(dst, 16) == 16 && dst[0] == 100 && dst[15] == 115);
+		reader.Skip(130);
+		TEST_CHECK(reader.Read(dst, 16) == 10 && dst[0] == 246);
+		TEST_CHECK(reader.Peek(1) == NULL);
+		TEST_CHECK(reader.Read(dst, 16) == 0);
+	}
+
+	// FILEポインタ用のコールバック
+	{
+		CTga tga, back;
+		char path[1024];
+		FILE *fp;
+
+		sprintf(path, "%s/stream_file.tga", pWorkDir);
+		MakeTga(&tga, 90, 20, CTga::IMAGE_TYPE_INDEX, 8, CTga::IMAGE_LINE_LRUD, FILL_RUN, 50);
+		tga.setRLE(true);
+		if (TEST_CHECK((fp = fopen(path, "wb")) != NULL)) {
+			CTgaStreamWriter writer(TgaStreamWriteFILE, fp);
+			TEST_CHECK(tga.Output(&writer, CTga::OUTPUT_FLAG_NONE) == CTga::ERROR_NONE);
+			fclose(fp);
+		}
+		if (TEST_CHECK((fp = fopen(path, "rb")) != NULL)) {
+			CTgaStreamReader reader(TgaStreamReadFILE, fp);
+			TEST_CHECK(back.Create(&reader) == CTga::ERROR_NONE);
+			TEST_CHECK(IsSameImage(tga, back));
+			fclose(fp);
+		}
+	}
+}
@@ -0,0 +1,159 @@
+#include "mto_thread.h"
+#include "mto_file.h"
+#include "mto_common.h"
+#include "tga.h"
+#include "tga_view.h"
+#include "test.h"
+
+
+namespace {
+
+/*=======================================================================
+【機能】ビューの全ピクセルがGetPixelと同じ場所を指すか
+ =======================================================================*/
+template <class T>
+bool IsSamePlace(const CTgaView<T> &view, const CTga &tga)
+{
+	if (view.getWidth() != tga.getWidth() || view.getHeight() != tga.getHeight()) return false;
+	if (view.getPitch() != tga.getPitch()) return false;
+
+	for (uint32 y = 0; y < view.getHeight(); y++) {
+		for (uint32 x = 0; x < view.getWidth(); x++) {
+			if (reinterpret_cast<uint8*>(&view.at(x, y)) != GetPixel(tga, x, y)) return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+
+/*=======================================================================
+【機能】ピクセルの型付きビュー(型の確認、並び、一部分、書き込み)
+ =======================================================================*/
+void TestView(const char *pDatDir, const char *pWorkDir)
+{
+	NOTHING(pDatDir);
+
+	// ピクセルの型はパディングなし
+	TEST_CHECK(sizeof(TgaBgra8) == 4 && sizeof(TgaRgba8) == 4);
+	TEST_CHECK(sizeof(TgaBgr8) == 3 && sizeof(TgaRgb8) == 3);
+	TEST_CHECK(sizeof(TgaArgb1555) == 2);
+	TEST_CHECK(sizeof(TgaIndex8) == 1 && sizeof(TgaGray8) == 1);
+
+	// 下→上、上→下のどちらも上から数える
+	static const uint8 line[] = {CTga::IMAGE_LINE_LRDU, CTga::IMAGE_LINE_LRUD};
+	for (uint32 l = 0; l < sizeof(line); l++) {
+		CTga tga32, tga24, tga16, index, gray;
+		CTgaView<TgaBgra8> bgra;
+		CTgaView<TgaBgr8> bgr;
+		CTgaView<TgaArgb1555> argb;
+		CTgaView<TgaIndex8> idx;
+		CTgaView<TgaGray8> y8;
+
+		MakeTga(&tga32, 23, 11, CTga::IMAGE_TYPE_FULL,  32, line[l], FILL_RANDOM, 45);
+		MakeTga(&tga24, 23, 11, CTga::IMAGE_TYPE_FULL,  24, line[l], FILL_RANDOM, 46);
+		MakeTga(&tga16, 23, 11, CTga::IMAGE_TYPE_FULL,  16, line[l], FILL_RANDOM, 47);
+		MakeTga(&index, 23, 11, CTga::IMAGE_TYPE_INDEX,  8, line[l], FILL_RANDOM, 48);
+		MakeTga(&gray,  23, 11, CTga::IMAGE_TYPE_GRAY,   8, line[l], FILL_RANDOM, 49);
+
+		TEST_CHECK(bgra.Create(tga32) && IsSamePlace(bgra, tga32));
+		TEST_CHECK(bgr.Create(tga24) && IsSamePlace(bgr, tga24));
+		TEST_CHECK(argb.Create(tga16) && IsSamePlace(argb, tga16));
+		TEST_CHECK(idx.Create(index) && IsSamePlace(idx, index));
+		TEST_CHECK(y8.Create(gray) && IsSamePlace(y8, gray));
+		TEST_CHECK((bgra.getPitch() < 0) == (line[l] == CTga::IMAGE_LINE_LRDU));
+
+		// 16bitのチャンネル
+		{
+			const TgaArgb1555 &p = argb.at(3, 2);
+			const uint8 *pSrc = GetPixel(tga16, 3, 2);
+			const uint32 value = pSrc[0] | (pSrc[1] << 8);
+			TEST_CHECK(p.getB() == (value & 0x1f) && p.getG() == ((value >> 5) & 0x1f));
+			TEST_CHECK(p.getR() == ((value >> 10) & 0x1f) && p.getA() == (value >> 15));
+		}
+
+		// 型が違うものは作れない(失敗したら無効なビュー)
+		TEST_CHECK(!bgra.Create(tga24) && !bgra.isValid());
+		TEST_CHECK(!bgr.Create(tga32));
+		TEST_CHECK(!argb.Create(index));
+		TEST_CHECK(!idx.Create(gray));
+		TEST_CHECK(!y8.Create(index));
+	}
+
+	// RGBA配列と右→左の並び
+	{
+		CTga tga;
+		CTgaView<TgaBgra8> bgra;
+		CTgaView<TgaRgba8> rgba;
+
+		MakeTga(&tga, 17, 9, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_RLUD, FILL_RANDOM, 50);
+		TEST_CHECK(!bgra.Create(tga));
+		TEST_CHECK(tga.ConvertType(CTga::IMAGE_LINE_LRUD));
+		TEST_CHECK(bgra.Create(tga));
+		TEST_CHECK(!rgba.Create(tga));
+
+		const TgaBgra8 before = bgra.at(5, 4);
+		TEST_CHECK(tga.ConvertRGBA());
+		TEST_CHECK(!bgra.Create(tga));
+		if (TEST_CHECK(rgba.Create(tga))) {
+			const TgaRgba8 &after = rgba.at(5, 4);
+			TEST_CHECK(after.r == before.r && after.g == before.g && after.b == before.b && after.a == before.a);
+		}
+	}
+
+	// 一部分(はみ出す分は切り詰め)と書き込み
+	{
+		CTga tga;
+		CTgaView<TgaBgra8> view;
+
+		MakeTga(&tga, 20, 10, CTga::IMAGE_TYPE_FULL, 32, CTga::IMAGE_LINE_LRDU, FILL_SOLID, 51);
+		if (TEST_CHECK(view.Create(tga))) {
+			CTgaView<TgaBgra8> sub = view.Sub(15, 6, 10, 10);
+
+			TEST_CHECK(sub.isValid() && sub.getWidth() == 5 && sub.getHeight() == 4);
+			TEST_CHECK(sub.getPitch() == view.getPitch());
+			TEST_CHECK(&sub.at(0, 0) == &view.at(15, 6));
+			TEST_CHECK(&sub.at(4, 3) == &view.at(19, 9));
+
+			// 一部分だけ塗ると元の画像も変わる
+			for (uint32 y = 0; y < sub.getHeight(); y++) {
+				TgaBgra8 *p = sub.getLine(y);
+				for (uint32 x = 0; x < sub.getWidth(); x++) {
+					p[x].b = 1; p[x].g = 2; p[x].r = 3; p[x].a = 4;
+				}
+			}
+			uint32 count = 0;
+			for (uint32 y = 0; y < tga.getHeight(); y++) {
+				for (uint32 x = 0; x < tga.getWidth(); x++) {
+					const uint8 *p = GetPixel(tga, x, y);
+					const bool bIn = (x >= 15 && y >= 6);
+					if ((p[0] == 1 && p[1] == 2 && p[2] == 3 && p[3] == 4) == bIn) count++;
+				}
+			}
+			TEST_CHECK(count == tga.getWidth() * tga.getHeight());
+
+			TEST_CHECK(!view.Sub(20, 0, 1, 1).isValid());
+			TEST_CHECK(!view.Sub(0, 10, 1, 1).isValid());
+			TEST_CHECK(!CTgaView<TgaBgra8>().Sub(0, 0, 1, 1).isValid());
+		}
+	}
+
+	// 遅延デコードならCreateでデコード、画像がなければ失敗
+	{
+		CTga tga, lazy, empty;
+		CTgaView<TgaBgr8> view;
+		char path[1024];
+
+		sprintf(path, "%s/view.tga", pWorkDir);
+		MakeTga(&tga, 31, 7, CTga::IMAGE_TYPE_FULL, 24, CTga::IMAGE_LINE_LRUD, FILL_RUN, 52);
+		tga.setRLE(true);
+		if (TEST_CHECK(tga.Output(path) == CTga::ERROR_NONE)) {
+			lazy.setCreateFlag(CTga::CREATE_FLAG_LAZY);
+			TEST_CHECK(lazy.Create(path) == CTga::ERROR_NONE);
+			TEST_CHECK(view.Create(lazy) && IsSamePlace(view, lazy));
+			TEST_CHECK(IsSameImage(tga, lazy));
+		}
+		TEST_CHECK(!view.Create(empty) && !view.isValid());
+	}
+}
@@ -0,0 +1,1775 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "tga_kernel.h"
+
+// mto_common.hから使うものだけ(カーネルはC版、C++版のどちらのmto_common.hにも依存しない)
+#define MTOINLINE				inline
+#define NOTHING(arg)			((void)(arg))
+#define A_MAX					0xff
+
+// 実行時に判定するので、VC++ではSSE2の指定がなくてもSSE2版を入れておく
+// (C版のmto_common.hは_USE_SSE2を決めないので、ここでも調べる)
+#if !defined(_USE_SSE2) && (defined(__SSE2__) || defined(_M_X64) || defined(_MSC_VER) && defined(_M_IX86))
+#define _USE_SSE2
+#endif
+
+// SSSE3はVC++2008以降と、関数単位で命令セットを指定できるGCC4.9以降
+#if defined(_USE_SSE2) && (defined(_MSC_VER) && (_MSC_VER >= 1500) || defined(__GNUC__) && !defined(__clang__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define _USE_SSSE3
+#endif
+
+// AVX2はVC++2013以降と、SSSE3と同じGCC
+#if defined(_USE_SSSE3) && (defined(_MSC_VER) && (_MSC_VER >= 1800) || defined(__GNUC__))
+#define _USE_AVX2
+#endif
+
+// AVX-512(F/BW)はVC++2017以降と、GCC5以降
+#if defined(_USE_AVX2) && (defined(_MSC_VER) && (_MSC_VER >= 1910) || defined(__GNUC__) && (__GNUC__ >= 5))
+#define _USE_AVX512
+#endif
+
+// NEONはコンパイラが対応している場合だけ(AArch64は常に、32bitのARMは-mfpu=neonなどの指定が必要)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define _USE_NEON
+#endif
+
+#ifdef _USE_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _USE_SSSE3
+#include <tmmintrin.h>
+#endif
+#ifdef _USE_AVX2
+#include <immintrin.h>
+#endif
+#ifdef _USE_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+#endif
+
+#if defined(_USE_SSSE3) && defined(__GNUC__)
+#define SSSE3_FUNC				__attribute__((target("ssse3")))
+#else
+#define SSSE3_FUNC				
+#endif
+
+#if defined(_USE_AVX2) && defined(__GNUC__)
+#define AVX2_FUNC				__attribute__((target("avx2")))
+#else
+#define AVX2_FUNC				
+#endif
+
+#if defined(_USE_AVX512) && defined(__GNUC__)
+#define AVX512_FUNC				__attribute__((target("avx512f,avx512bw")))
+#else
+#define AVX512_FUNC				
+#endif
+
+
+/*---------------------------------------------------------------------------
+ * 使用する命令セット
+ *--------------------------------------------------------------------------*/
+static sint32 DetectLevel(void);
+static sint32 InitLevel(void);
+
+static const sint32 s_Support = DetectLevel();		// CPUとコンパイラが対応している命令セット
+static sint32 s_Level = InitLevel();				// 使用する命令セット
+
+#ifdef _USE_AVX2
+/*=======================================================================
+【機能】拡張機能(CPUIDの7番)とOSが保存するレジスタ(XCR0)を取得
+【引数】pEbx ：CPUIDの7番のEBXの格納先
+        pXcr0：XCR0の格納先
+【戻値】false：CPUIDの7番がない
+【備考】非公開
+        CPUIDの1番でOSXSAVEとAVXを確認してから呼ぶこと。
+ =======================================================================*/
+static bool GetExtFeature(uint32 *pEbx, uint32 *pXcr0)
+{
+#if defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuidex(info, 7, 0);
+	*pEbx  = static_cast<uint32>(info[1]);
+	*pXcr0 = static_cast<uint32>(_xgetbv(0));
+#else
+	unsigned int eax, ebx, ecx, edx;
+
+	if (__get_cpuid_max(0, NULL) < 7) return false;
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	*pEbx = ebx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	*pXcr0 = eax;
+#endif
+
+	return true;
+}
+#endif
+
+/*=======================================================================
+【機能】CPUとコンパイラが対応している命令セットを調べる
+【戻値】命令セット
+【備考】非公開
+ =======================================================================*/
+static sint32 DetectLevel(void)
+{
+	uint32 ecx, edx;
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 1) return TGA_KERNEL_LEVEL_NONE;
+	__cpuid(info, 1);
+	ecx = static_cast<uint32>(info[2]);
+	edx = static_cast<uint32>(info[3]);
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	unsigned int eax, ebx;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return TGA_KERNEL_LEVEL_NONE;
+#else
+	ecx = edx = 0;
+#endif
+
+	sint32 level = TGA_KERNEL_LEVEL_NONE;
+
+#ifdef _USE_SSE2
+	if (edx & (1 << 26)) {
+		level = TGA_KERNEL_LEVEL_SSE2;
+#ifdef _USE_SSSE3
+		if (ecx & (1 << 9)) level = TGA_KERNEL_LEVEL_SSSE3;
+#endif
+	}
+#endif
+
+#ifdef _USE_AVX2
+	// CPUの対応に加えて、OSがレジスタを保存するか(OSXSAVEとXCR0)も確認する
+	uint32 ebx7, xcr0;
+	if (level == TGA_KERNEL_LEVEL_SSSE3 && (ecx & (1 << 27)) && (ecx & (1 << 28)) && GetExtFeature(&ebx7, &xcr0)) {
+		// XMMとYMM
+		if ((xcr0 & 0x06) == 0x06 && (ebx7 & (1 << 5))) level = TGA_KERNEL_LEVEL_AVX2;
+#ifdef _USE_AVX512
+		// さらにopmaskとZMM(AVX-512FとAVX-512BW)
+		if (level == TGA_KERNEL_LEVEL_AVX2 && (xcr0 & 0xe6) == 0xe6 && (ebx7 & (1 << 16)) && (ebx7 & (1 << 30))) {
+			level = TGA_KERNEL_LEVEL_AVX512;
+		}
+#endif
+	}
+#endif
+
+#ifdef _USE_NEON
+	level = TGA_KERNEL_LEVEL_NEON;
+#endif
+
+	NOTHING(ecx);
+	NOTHING(edx);
+
+	return level;
+}
+
+/*=======================================================================
+【機能】命令セットが使えるか
+【引数】level：命令セット
+【備考】非公開
+        NEONとx86の命令セットは並びが別系統なので、どちらか一方だけ使える。
+ =======================================================================*/
+static bool IsAvailable(const sint32 level)
+{
+	if (level == TGA_KERNEL_LEVEL_NONE) return true;
+	if (level < TGA_KERNEL_LEVEL_NONE || level > s_Support) return false;
+
+	return ((level == TGA_KERNEL_LEVEL_NEON) == (s_Support == TGA_KERNEL_LEVEL_NEON));
+}
+
+/*=======================================================================
+【機能】起動時の命令セットを決める
+【戻値】命令セット
+【備考】非公開
+        環境変数TGA_SIMDが指定されていれば、その命令セットまでに制限する。
+ =======================================================================*/
+static sint32 InitLevel(void)
+{
+	sint32 level = s_Support;
+	const char *pEnv = getenv("TGA_SIMD");
+
+	if (pEnv != NULL) {
+		for (sint32 i = TGA_KERNEL_LEVEL_NONE; i < TGA_KERNEL_LEVEL_MAX; i++) {
+			if (strcmp(pEnv, TgaKernelGetLevelName(i)) == 0) {
+				if (i < level) level = i;
+				break;
+			}
+		}
+	}
+
+	// ARMでx86の命令セットが指定された場合など
+	while (!IsAvailable(level)) level--;
+
+	return level;
+}
+
+/*=======================================================================
+【機能】使用中の命令セットを取得
+ =======================================================================*/
+sint32 TgaKernelGetLevel(void)
+{
+	return s_Level;
+}
+
+/*=======================================================================
+【機能】CPUとコンパイラが対応している命令セットを取得
+ =======================================================================*/
+sint32 TgaKernelGetSupportLevel(void)
+{
+	return s_Support;
+}
+
+/*=======================================================================
+【機能】使用する命令セットを変更
+【引数】level：命令セット
+【戻値】実際に使用する命令セット(使えなければ使える所まで下げる)
+【備考】カーネルの処理中に変更しないでください。
+ =======================================================================*/
+sint32 TgaKernelSetLevel(const sint32 level)
+{
+	sint32 newLevel = (level < TGA_KERNEL_LEVEL_NONE) ? TGA_KERNEL_LEVEL_NONE : level;
+	if (newLevel >= TGA_KERNEL_LEVEL_MAX) newLevel = TGA_KERNEL_LEVEL_MAX - 1;
+	while (!IsAvailable(newLevel)) newLevel--;
+
+	s_Level = newLevel;
+
+	return s_Level;
+}
+
+/*=======================================================================
+【機能】命令セットの名前を取得
+【引数】level：命令セット
+【戻値】名前(環境変数TGA_SIMDに指定する文字列)
+ =======================================================================*/
+const char *TgaKernelGetLevelName(const sint32 level)
+{
+	static const char *pName[TGA_KERNEL_LEVEL_MAX] = {"none", "sse2", "ssse3", "avx2", "avx512", "neon"};
+
+	if (level < TGA_KERNEL_LEVEL_NONE || level >= TGA_KERNEL_LEVEL_MAX) return "";
+
+	return pName[level];
+}
+
+
+/*=======================================================================
+【機能】1色分の乗算(c * a / 255 を四捨五入)
+【引数】c：色
+        a：アルファ
+【備考】非公開
+ =======================================================================*/
+static MTOINLINE uint8 MulDiv255(const uint32 c, const uint32 a)
+{
+	uint32 t = c * a + 128;
+	return static_cast<uint8>((t + (t >> 8)) >> 8);
+}
+
+/*=======================================================================
+【機能】1色分の除算(c * 255 / a を四捨五入)
+【引数】c：色
+        a：アルファ(0以外)
+【備考】非公開
+ =======================================================================*/
+static MTOINLINE uint8 DivMul255(const uint32 c, const uint32 a)
+{
+	uint32 t = (c * 255 + (a >> 1)) / a;
+	return static_cast<uint8>((t > 255) ? 255 : t);
+}
+
+/*---------------------------------------------------------------------------
+ * ハッシュ用の定数
+ *--------------------------------------------------------------------------*/
+enum {
+	HASH_STRIPE = 64,								// 1回に処理するバイト数
+	HASH_BLOCK  = 16								// 攪拌するまでの回数
+};
+
+static const uint64 HASH_PRIME1 = 0x9e3779b185ebca87ULL;
+static const uint64 HASH_PRIME2 = 0xc2b2ae3d27d4eb4fULL;
+static const uint64 HASH_PRIME3 = 0x165667b19e3779f9ULL;
+static const uint32 HASH_PRIME4 = 0x9e3779b1;
+
+// 各回でずらしながら使う鍵(8 + HASH_BLOCK個)
+static const uint64 HashKey[24] = {
+	0x2cb0f69f4abea221ULL, 0x9417034723148989ULL, 0xdd555950609dfe03ULL, 0xdbafb150deb12800ULL,
+	0x7e789b2e6c442cb6ULL, 0xf41e5636c7e4f8c4ULL, 0x0959d150f8fba7e4ULL, 0xa97316f13cdb9eeaULL,
+	0x74cd8258f9520068ULL, 0x55c74a62e116868bULL, 0xd2f4c799a2023cbdULL, 0xdf98cb79a37b51b9ULL,
+	0x396f5885524f3905ULL, 0xaf1d56386ca3b276ULL, 0xa9ffbe6b5104e85aULL, 0x6bd0c51b9fd533b3ULL,
+	0x980ce91c50ab4b56ULL, 0x28ac395780fe62c5ULL, 0x768912e3a6bcedc7ULL, 0x50b3e8c9332c7c88ULL,
+	0xce3bbfe520bd47daULL, 0xcba6c8e8e0bb7c4fULL, 0xbf194db8434a346dULL, 0x7d8f2a7b60416d7fULL
+};
+
+
+#ifdef _USE_SSSE3
+/*=======================================================================
+【機能】SSSE3版の並び替え/展開
+【戻値】処理したピクセル数(残りは呼び出し元で処理する)
+【備考】非公開
+        pshufbで1回に16バイトずつ並び替える。
+        24bitは5ピクセル(15バイト)ずつ処理して、16バイト目は次の回で上書きする。
+ =======================================================================*/
+static SSSE3_FUNC uint32 SwapRB32Ssse3(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	const __m128i shuf = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	uint32 i = 0;
+
+	for (; i + 4 <= num; i += 4) {
+		__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_shuffle_epi8(src, shuf));
+	}
+
+	return i;
+}
+
+static SSSE3_FUNC uint32 SwapRB24Ssse3(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	const __m128i shuf = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+	uint32 i = 0;
+
+	// 16バイト目は元の値のまま書くので、pDstとpSrcが同じでも可
+	for (; (i + 5) * 3 + 1 <= num * 3; i += 5) {
+		__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 3), _mm_shuffle_epi8(src, shuf));
+	}
+
+	return i;
+}
+
+static SSSE3_FUNC uint32 Reverse8Ssse3(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	const __m128i shuf = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	uint32 i = 0;
+
+	for (; i + 16 <= num; i += 16) {
+		__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + num - i - 16));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm_shuffle_epi8(src, shuf));
+	}
+
+	return i;
+}
+
+static SSSE3_FUNC uint32 Reverse24Ssse3(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	// 読み込みは1バイト前から(5ピクセル後ろを読みすぎないように)
+	const __m128i shuf = _mm_setr_epi8(13, 14, 15, 10, 11, 12, 7, 8, 9, 4, 5, 6, 1, 2, 3, -128);
+	uint32 i = 0;
+
+	// 16バイト目は次の回(最後は呼び出し元)で上書きされる
+	for (; i + 6 <= num; i += 5) {
+		__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + (num - i - 5) * 3 - 1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 3), _mm_shuffle_epi8(src, shuf));
+	}
+
+	return i;
+}
+
+static SSSE3_FUNC uint32 Expand24Ssse3(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	const __m128i shuf  = _mm_setr_epi8(0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128);
+	const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+	uint32 i = 0;
+
+	// 16バイト読むので、最後の4バイトを超えないところまで
+	for (; i * 3 + 16 <= num * 3; i += 4) {
+		__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_or_si128(_mm_shuffle_epi8(src, shuf), alpha));
+	}
+
+	return i;
+}
+#endif
+
+#ifdef _USE_AVX2
+/*=======================================================================
+【機能】AVX2版の32bitの処理
+【戻値】処理したピクセル数(残りはSSE2版と呼び出し元で処理する)
+【備考】非公開
+        8ピクセル(32バイト)ずつ処理する。vpshufbなどは128bitの
+        レーンごとに働くので、レーンをまたがない処理だけをここに置く。
+ =======================================================================*/
+static AVX2_FUNC uint32 SwapRB32Avx2(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	const __m256i shuf = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+										  2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	uint32 i = 0;
+
+	for (; i + 8 <= num; i += 8) {
+		__m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + i * 4));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i * 4), _mm256_shuffle_epi8(src, shuf));
+	}
+
+	return i;
+}
+
+static AVX2_FUNC uint32 Reverse32Avx2(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	const __m256i perm = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	uint32 i = 0;
+
+	for (; i + 8 <= num; i += 8) {
+		__m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + (num - i - 8) * 4));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i * 4), _mm256_permutevar8x32_epi32(src, perm));
+	}
+
+	return i;
+}
+
+static AVX2_FUNC uint32 Premultiply32Avx2(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	const __m256i zero  = _mm256_setzero_si256();
+	const __m256i round = _mm256_set1_epi16(128);
+	const __m256i maskA = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+	const __m256i full  = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+	uint32 i = 0;
+
+	// unpack/packはレーンごとなので、並びは元に戻る
+	for (; i + 8 <= num; i += 8) {
+		__m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + i * 4));
+		__m256i lo  = _mm256_unpacklo_epi8(src, zero);
+		__m256i hi  = _mm256_unpackhi_epi8(src, zero);
+
+		__m256i aLo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, 0xff), 0xff);
+		__m256i aHi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, 0xff), 0xff);
+		aLo = _mm256_or_si256(_mm256_andnot_si256(maskA, aLo), full);
+		aHi = _mm256_or_si256(_mm256_andnot_si256(maskA, aHi), full);
+
+		lo = _mm256_add_epi16(_mm256_mullo_epi16(lo, aLo), round);
+		hi = _mm256_add_epi16(_mm256_mullo_epi16(hi, aHi), round);
+		lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+		hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i * 4), _mm256_packus_epi16(lo, hi));
+	}
+
+	return i;
+}
+
+static AVX2_FUNC uint32 FindAlpha32Avx2(const uint8 *pSrc, const uint32 num)
+{
+	const __m256i maskA = _mm256_set1_epi32(static_cast<int>(0xff000000));
+	uint32 i = 0;
+
+	// 全部アルファ0の8ピクセルを読み飛ばす(見つかった8ピクセルの中は呼び出し元で探す)
+	for (; i + 8 <= num; i += 8) {
+		__m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + i * 4));
+		if (!_mm256_testz_si256(src, maskA)) break;
+	}
+
+	return i;
+}
+#endif
+
+#ifdef _USE_AVX512
+/*=======================================================================
+【機能】AVX-512版の32bitの処理
+【戻値】処理したピクセル数(残りはAVX2版から順に処理する)
+【備考】非公開
+        16ピクセル(64バイト)ずつ処理する。AVX2版と同じく、vpshufbなどは
+        128bitのレーンごとに働く。
+        GCCのヘッダーは一部の組み込み関数で未初期化の警告を出すので、
+        定数はテーブルから読み、並び替えはマスク付きのものを使う。
+ =======================================================================*/
+static AVX512_FUNC uint32 SwapRB32Avx512(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	static const uint8 ShufTable[64] = {
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+	};
+	const __m512i shuf = _mm512_loadu_si512(ShufTable);
+	uint32 i = 0;
+
+	for (; i + 16 <= num; i += 16) {
+		__m512i src = _mm512_loadu_si512(pSrc + i * 4);
+		_mm512_storeu_si512(pDst + i * 4, _mm512_shuffle_epi8(src, shuf));
+	}
+
+	return i;
+}
+
+static AVX512_FUNC uint32 Reverse32Avx512(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	const __m512i perm = _mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	uint32 i = 0;
+
+	for (; i + 16 <= num; i += 16) {
+		__m512i src = _mm512_loadu_si512(pSrc + (num - i - 16) * 4);
+		_mm512_storeu_si512(pDst + i * 4, _mm512_maskz_permutexvar_epi32(0xffff, perm, src));
+	}
+
+	return i;
+}
+
+static AVX512_FUNC uint32 Premultiply32Avx512(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	const __m512i zero  = _mm512_setzero_si512();
+	const __m512i round = _mm512_set1_epi16(128);
+	const __m512i maskC = _mm512_set1_epi64(static_cast<long long>(0x0000ffffffffffffULL));
+	const __m512i full  = _mm512_set1_epi64(static_cast<long long>(0x00ff000000000000ULL));
+	uint32 i = 0;
+
+	// unpack/packはレーンごとなので、並びは元に戻る
+	for (; i + 16 <= num; i += 16) {
+		__m512i src = _mm512_loadu_si512(pSrc + i * 4);
+		__m512i lo  = _mm512_unpacklo_epi8(src, zero);
+		__m512i hi  = _mm512_unpackhi_epi8(src, zero);
+
+		__m512i aLo = _mm512_shufflehi_epi16(_mm512_shufflelo_epi16(lo, 0xff), 0xff);
+		__m512i aHi = _mm512_shufflehi_epi16(_mm512_shufflelo_epi16(hi, 0xff), 0xff);
+		aLo = _mm512_or_si512(_mm512_and_si512(maskC, aLo), full);
+		aHi = _mm512_or_si512(_mm512_and_si512(maskC, aHi), full);
+
+		lo = _mm512_add_epi16(_mm512_mullo_epi16(lo, aLo), round);
+		hi = _mm512_add_epi16(_mm512_mullo_epi16(hi, aHi), round);
+		lo = _mm512_srli_epi16(_mm512_add_epi16(lo, _mm512_srli_epi16(lo, 8)), 8);
+		hi = _mm512_srli_epi16(_mm512_add_epi16(hi, _mm512_srli_epi16(hi, 8)), 8);
+
+		_mm512_storeu_si512(pDst + i * 4, _mm512_packus_epi16(lo, hi));
+	}
+
+	return i;
+}
+
+static AVX512_FUNC uint32 FindAlpha32Avx512(const uint8 *pSrc, const uint32 num)
+{
+	const __m512i maskA = _mm512_set1_epi32(static_cast<int>(0xff000000));
+	uint32 i = 0;
+
+	// 全部アルファ0の16ピクセルを読み飛ばす
+	for (; i + 16 <= num; i += 16) {
+		__m512i src = _mm512_loadu_si512(pSrc + i * 4);
+		if (_mm512_test_epi32_mask(src, maskA) != 0) break;
+	}
+
+	return i;
+}
+#endif
+
+#ifdef _USE_NEON
+/*=======================================================================
+【機能】NEON版の処理
+【戻値】処理したピクセル数(残りは呼び出し元で処理する)
+【備考】非公開
+        vld3/vld4でチャンネルごとに分けて読み、16ピクセルずつ処理する。
+ =======================================================================*/
+static uint32 SwapRB32Neon(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+	for (; i + 16 <= num; i += 16) {
+		uint8x16x4_t v = vld4q_u8(pSrc + i * 4);
+		uint8x16_t t = v.val[0];
+		v.val[0] = v.val[2];
+		v.val[2] = t;
+		vst4q_u8(pDst + i * 4, v);
+	}
+
+	return i;
+}
+
+static uint32 SwapRB24Neon(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+	for (; i + 16 <= num; i += 16) {
+		uint8x16x3_t v = vld3q_u8(pSrc + i * 3);
+		uint8x16_t t = v.val[0];
+		v.val[0] = v.val[2];
+		v.val[2] = t;
+		vst3q_u8(pDst + i * 3, v);
+	}
+
+	return i;
+}
+
+static uint32 Reverse32Neon(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+	// 64bitの中で入れ替えてから、上下の64bitを入れ替える
+	for (; i + 4 <= num; i += 4) {
+		uint32x4_t v = vrev64q_u32(vld1q_u32(reinterpret_cast<const uint32_t*>(pSrc + (num - i - 4) * 4)));
+		vst1q_u32(reinterpret_cast<uint32_t*>(pDst + i * 4), vcombine_u32(vget_high_u32(v), vget_low_u32(v)));
+	}
+
+	return i;
+}
+
+static uint32 Premultiply32Neon(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	const uint16x8_t round = vdupq_n_u16(128);
+	uint32 i = 0;
+
+	// c * a / 255 の四捨五入(SSE2版と同じ計算)
+	for (; i + 16 <= num; i += 16) {
+		uint8x16x4_t v = vld4q_u8(pSrc + i * 4);
+
+		for (sint32 c = 0; c < 3; c++) {
+			uint16x8_t lo = vaddq_u16(vmull_u8(vget_low_u8(v.val[c]), vget_low_u8(v.val[3])), round);
+			uint16x8_t hi = vaddq_u16(vmull_u8(vget_high_u8(v.val[c]), vget_high_u8(v.val[3])), round);
+			lo = vaddq_u16(lo, vshrq_n_u16(lo, 8));
+			hi = vaddq_u16(hi, vshrq_n_u16(hi, 8));
+			v.val[c] = vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+		}
+		vst4q_u8(pDst + i * 4, v);
+	}
+
+	return i;
+}
+
+static uint32 FindAlpha32Neon(const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+	// 全部アルファ0の16ピクセルを読み飛ばす
+	for (; i + 16 <= num; i += 16) {
+		uint64x2_t a = vreinterpretq_u64_u8(vld4q_u8(pSrc + i * 4).val[3]);
+		if ((vgetq_lane_u64(a, 0) | vgetq_lane_u64(a, 1)) != 0) break;
+	}
+
+	return i;
+}
+#endif
+
+/*=======================================================================
+【機能】32bit(BGRA)の赤と青を入れ替える
+【引数】pDst：変換先(pSrcと同じでも可)
+        pSrc：変換元
+        num ：ピクセル数
+ =======================================================================*/
+void TgaKernelSwapRB32(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+#ifdef _USE_NEON
+	if (s_Level == TGA_KERNEL_LEVEL_NEON) {
+		i = SwapRB32Neon(pDst, pSrc, num);
+	}
+#endif
+#ifdef _USE_AVX512
+	if (s_Level >= TGA_KERNEL_LEVEL_AVX512) {
+		i = SwapRB32Avx512(pDst, pSrc, num);
+	}
+#endif
+#ifdef _USE_AVX2
+	if (s_Level >= TGA_KERNEL_LEVEL_AVX2) {
+		i += SwapRB32Avx2(pDst + i * 4, pSrc + i * 4, num - i);
+	}
+#endif
+#ifdef _USE_SSSE3
+	if (s_Level >= TGA_KERNEL_LEVEL_SSSE3) {
+		i += SwapRB32Ssse3(pDst + i * 4, pSrc + i * 4, num - i);
+	}
+#endif
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i maskGA = _mm_set1_epi32(static_cast<int>(0xff00ff00));
+
+		// 4ピクセルずつ、赤と青を16bitの単位で入れ替える
+		for (; i + 4 <= num; i += 4) {
+			__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4));
+			__m128i rb  = _mm_andnot_si128(maskGA, src);
+			rb = _mm_shufflehi_epi16(_mm_shufflelo_epi16(rb, 0xb1), 0xb1);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_or_si128(_mm_and_si128(src, maskGA), rb));
+		}
+	}
+#endif
+
+	for (; i < num; i++) {
+		const uint8 *s = &pSrc[i * 4];
+		uint8 *d = &pDst[i * 4];
+		uint8 r = s[2];
+		uint8 b = s[0];
+
+		d[0] = r;
+		d[1] = s[1];
+		d[2] = b;
+		d[3] = s[3];
+	}
+}
+
+/*=======================================================================
+【機能】24bit(BGR)の赤と青を入れ替える
+【引数】pDst：変換先(pSrcと同じでも可)
+        pSrc：変換元
+        num ：ピクセル数
+ =======================================================================*/
+void TgaKernelSwapRB24(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+#ifdef _USE_NEON
+	if (s_Level == TGA_KERNEL_LEVEL_NEON) {
+		i = SwapRB24Neon(pDst, pSrc, num);
+	}
+#endif
+#ifdef _USE_SSSE3
+	if (s_Level >= TGA_KERNEL_LEVEL_SSSE3) {
+		i = SwapRB24Ssse3(pDst, pSrc, num);
+	}
+#endif
+
+	for (; i < num; i++) {
+		const uint8 *s = &pSrc[i * 3];
+		uint8 *d = &pDst[i * 3];
+		uint8 r = s[2];
+		uint8 b = s[0];
+
+		d[0] = r;
+		d[1] = s[1];
+		d[2] = b;
+	}
+}
+
+/*=======================================================================
+【機能】16bit(ARGB:1555)の赤と青を入れ替える
+【引数】pDst：変換先(pSrcと同じでも可)
+        pSrc：変換元
+        num ：ピクセル数
+ =======================================================================*/
+void TgaKernelSwapRB16(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i maskAG = _mm_set1_epi16(static_cast<short>(0x83e0));
+		const __m128i mask5  = _mm_set1_epi16(0x1f);
+
+		// 8ピクセルずつ
+		for (; i + 8 <= num; i += 8) {
+			__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 2));
+			__m128i r   = _mm_and_si128(_mm_srli_epi16(src, 10), mask5);
+			__m128i b   = _mm_slli_epi16(_mm_and_si128(src, mask5), 10);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 2), _mm_or_si128(_mm_and_si128(src, maskAG), _mm_or_si128(r, b)));
+		}
+	}
+#endif
+
+	for (; i < num; i++) {
+		uint16 pix = static_cast<uint16>(pSrc[i * 2] | (pSrc[i * 2 + 1] << 8));
+		pix = static_cast<uint16>((pix & 0x83e0) | ((pix >> 10) & 0x1f) | ((pix & 0x1f) << 10));
+		pDst[i * 2 + 0] = static_cast<uint8>(pix);
+		pDst[i * 2 + 1] = static_cast<uint8>(pix >> 8);
+	}
+}
+
+/*=======================================================================
+【機能】ピクセルを逆順に並べる(左右反転)
+【引数】pDst：変換先(pSrcと重ならないこと)
+        pSrc：変換元
+        num ：ピクセル数
+        byte：1ピクセルのバイト数(1～4)
+ =======================================================================*/
+void TgaKernelReverse(uint8 *pDst, const uint8 *pSrc, const uint32 num, const uint32 byte)
+{
+	uint32 i = 0;
+
+#ifdef _USE_NEON
+	if (s_Level == TGA_KERNEL_LEVEL_NEON && byte == 4) {
+		i = Reverse32Neon(pDst, pSrc, num);
+	}
+#endif
+#ifdef _USE_AVX512
+	if (s_Level >= TGA_KERNEL_LEVEL_AVX512 && byte == 4) {
+		i = Reverse32Avx512(pDst, pSrc, num);
+	}
+#endif
+#ifdef _USE_AVX2
+	if (s_Level >= TGA_KERNEL_LEVEL_AVX2 && byte == 4) {
+		i += Reverse32Avx2(pDst + i * 4, pSrc, num - i);
+	}
+#endif
+#ifdef _USE_SSSE3
+	if (s_Level >= TGA_KERNEL_LEVEL_SSSE3) {
+		if (byte == 1) {
+			i = Reverse8Ssse3(pDst, pSrc, num);
+		} else if (byte == 3) {
+			i = Reverse24Ssse3(pDst, pSrc, num);
+		}
+	}
+#endif
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		if (byte == 4) {
+			// 4ピクセルずつ
+			for (; i + 4 <= num; i += 4) {
+				__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + (num - i - 4) * 4));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_shuffle_epi32(src, 0x1b));
+			}
+		} else if (byte == 2) {
+			// 8ピクセルずつ
+			for (; i + 8 <= num; i += 8) {
+				__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + (num - i - 8) * 2));
+				src = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, 0x1b), 0x1b);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 2), _mm_shuffle_epi32(src, 0x4e));
+			}
+		}
+	}
+#endif
+
+	for (; i < num; i++) {
+		const uint8 *s = &pSrc[(num - i - 1) * byte];
+		uint8 *d = &pDst[i * byte];
+
+		for (uint32 j = 0; j < byte; j++) {
+			d[j] = s[j];
+		}
+	}
+}
+
+#ifdef _USE_SSE2
+/*=======================================================================
+【機能】8x8ピクセル(8bit)の転置
+【備考】非公開
+        8バイトずつ読み、8bit→16bit→32bitの順に組み合わせる。
+ =======================================================================*/
+static void Transpose8Sse2(uint8 *pDst, const sint32 dstPitch, const uint8 *pSrc, const sint32 srcPitch)
+{
+	__m128i r[8];
+	for (sint32 i = 0; i < 8; i++) r[i] = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSrc + i * srcPitch));
+
+	const __m128i a0 = _mm_unpacklo_epi8(r[0], r[1]);
+	const __m128i a1 = _mm_unpacklo_epi8(r[2], r[3]);
+	const __m128i a2 = _mm_unpacklo_epi8(r[4], r[5]);
+	const __m128i a3 = _mm_unpacklo_epi8(r[6], r[7]);
+	const __m128i b0 = _mm_unpacklo_epi16(a0, a1);
+	const __m128i b1 = _mm_unpackhi_epi16(a0, a1);
+	const __m128i b2 = _mm_unpacklo_epi16(a2, a3);
+	const __m128i b3 = _mm_unpackhi_epi16(a2, a3);
+	const __m128i c[4] = {
+		_mm_unpacklo_epi32(b0, b2), _mm_unpackhi_epi32(b0, b2),
+		_mm_unpacklo_epi32(b1, b3), _mm_unpackhi_epi32(b1, b3)
+	};
+
+	for (sint32 i = 0; i < 4; i++) {
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(pDst + (i * 2 + 0) * dstPitch), c[i]);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(pDst + (i * 2 + 1) * dstPitch), _mm_srli_si128(c[i], 8));
+	}
+}
+
+/*=======================================================================
+【機能】8x8ピクセル(16bit)の転置
+【備考】非公開
+ =======================================================================*/
+static void Transpose16Sse2(uint8 *pDst, const sint32 dstPitch, const uint8 *pSrc, const sint32 srcPitch)
+{
+	__m128i r[8];
+	for (sint32 i = 0; i < 8; i++) r[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * srcPitch));
+
+	__m128i a[8], b[8];
+	for (sint32 i = 0; i < 4; i++) {
+		a[i * 2 + 0] = _mm_unpacklo_epi16(r[i * 2], r[i * 2 + 1]);
+		a[i * 2 + 1] = _mm_unpackhi_epi16(r[i * 2], r[i * 2 + 1]);
+	}
+	for (sint32 i = 0; i < 2; i++) {
+		b[i * 4 + 0] = _mm_unpacklo_epi32(a[i * 4 + 0], a[i * 4 + 2]);
+		b[i * 4 + 1] = _mm_unpackhi_epi32(a[i * 4 + 0], a[i * 4 + 2]);
+		b[i * 4 + 2] = _mm_unpacklo_epi32(a[i * 4 + 1], a[i * 4 + 3]);
+		b[i * 4 + 3] = _mm_unpackhi_epi32(a[i * 4 + 1], a[i * 4 + 3]);
+	}
+	for (sint32 i = 0; i < 4; i++) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + (i * 2 + 0) * dstPitch), _mm_unpacklo_epi64(b[i], b[i + 4]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + (i * 2 + 1) * dstPitch), _mm_unpackhi_epi64(b[i], b[i + 4]));
+	}
+}
+
+/*=======================================================================
+【機能】4x4ピクセル(32bit)の転置
+【備考】非公開
+ =======================================================================*/
+static void Transpose32Sse2(uint8 *pDst, const sint32 dstPitch, const uint8 *pSrc, const sint32 srcPitch)
+{
+	const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc));
+	const __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + srcPitch));
+	const __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + srcPitch * 2));
+	const __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + srcPitch * 3));
+	const __m128i a0 = _mm_unpacklo_epi32(r0, r1);
+	const __m128i a1 = _mm_unpackhi_epi32(r0, r1);
+	const __m128i a2 = _mm_unpacklo_epi32(r2, r3);
+	const __m128i a3 = _mm_unpackhi_epi32(r2, r3);
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst),                _mm_unpacklo_epi64(a0, a2));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + dstPitch),     _mm_unpackhi_epi64(a0, a2));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + dstPitch * 2), _mm_unpacklo_epi64(a1, a3));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + dstPitch * 3), _mm_unpackhi_epi64(a1, a3));
+}
+#endif
+
+/*=======================================================================
+【機能】転置(ラインと列を入れ替える)
+【引数】pDst    ：変換先(pSrcと重ならないこと)
+        dstPitch：変換先の次のラインまでのバイト数(負もあり)
+        pSrc    ：変換元
+        srcPitch：変換元の次のラインまでのバイト数(負もあり)
+        w、h    ：変換元の幅と高さ(変換先はh×wになる)
+        byte    ：1ピクセルのバイト数(1～4)
+【備考】変換先の(x, y)に変換元の(y, x)を置きます。
+        ピッチを負にすると上下を入れ替えて読み書きできるので、
+        90度回転などの反転はピッチで指定してください。
+        キャッシュに収まる大きさ(64x64程度)に分けて呼ぶことを想定しています。
+ =======================================================================*/
+void TgaKernelTranspose(uint8 *pDst, const sint32 dstPitch, const uint8 *pSrc, const sint32 srcPitch, const uint32 w, const uint32 h, const uint32 byte)
+{
+	uint32 x0 = 0;
+	uint32 y0 = 0;
+
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2 && byte != 3) {
+		// 8bitと16bitは8x8、32bitは4x4ずつ
+		const uint32 n = (byte == 4) ? 4 : 8;
+
+		for (y0 = 0; y0 + n <= h; y0 += n) {
+			for (x0 = 0; x0 + n <= w; x0 += n) {
+				const uint8 *s = pSrc + static_cast<sint32>(y0) * srcPitch + x0 * byte;
+				uint8 *d = pDst + static_cast<sint32>(x0) * dstPitch + y0 * byte;
+
+				switch (byte) {
+				case 1:  Transpose8Sse2(d, dstPitch, s, srcPitch);  break;
+				case 2:  Transpose16Sse2(d, dstPitch, s, srcPitch); break;
+				default: Transpose32Sse2(d, dstPitch, s, srcPitch); break;
+				}
+			}
+
+			// 右の端数
+			for (uint32 y = y0; y < y0 + n; y++) {
+				const uint8 *s = pSrc + static_cast<sint32>(y) * srcPitch;
+				for (uint32 x = x0; x < w; x++) {
+					memcpy(pDst + static_cast<sint32>(x) * dstPitch + y * byte, &s[x * byte], byte);
+				}
+			}
+		}
+	}
+#endif
+
+	// 下の端数(SIMDなしなら全部)
+	for (uint32 y = y0; y < h; y++) {
+		const uint8 *s = pSrc + static_cast<sint32>(y) * srcPitch;
+		uint8 *d = pDst + y * byte;
+
+		switch (byte) {
+		case 1:
+			for (uint32 x = 0; x < w; x++) d[static_cast<sint32>(x) * dstPitch] = s[x];
+			break;
+		case 4:
+			for (uint32 x = 0; x < w; x++) memcpy(d + static_cast<sint32>(x) * dstPitch, &s[x * 4], 4);
+			break;
+		default:
+			for (uint32 x = 0; x < w; x++) {
+				uint8 *p = d + static_cast<sint32>(x) * dstPitch;
+				for (uint32 j = 0; j < byte; j++) p[j] = s[x * byte + j];
+			}
+			break;
+		}
+	}
+}
+
+/*=======================================================================
+【機能】同じピクセルを並べる(RLEの反復の展開)
+【引数】pDst  ：展開先
+        pPixel：ピクセル
+        num   ：ピクセル数
+        byte  ：1ピクセルのバイト数(1～4)
+ =======================================================================*/
+void TgaKernelFill(uint8 *pDst, const uint8 *pPixel, const uint32 num, const uint32 byte)
+{
+	const uint32 size = num * byte;
+	uint32 i = 0;
+
+#ifdef _USE_SSE2
+	// 48バイト(1～4バイトの公倍数)の模様を作って書き込む
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2 && size >= 48) {
+		uint8 pattern[48];
+
+		for (uint32 j = 0; j < 48; j++) {
+			pattern[j] = pPixel[j % byte];
+		}
+
+		const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pattern[ 0]));
+		const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pattern[16]));
+		const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pattern[32]));
+
+		for (; i + 48 <= size; i += 48) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i +  0), v0);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i + 16), v1);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i + 32), v2);
+		}
+	}
+#endif
+
+	for (; i < size; i += byte) {
+		for (uint32 j = 0; j < byte; j++) {
+			pDst[i + j] = pPixel[j];
+		}
+	}
+}
+
+/*=======================================================================
+【機能】8bit(グレースケール)を32bit(BGRA)に展開
+【引数】pDst：展開先
+        pSrc：展開元
+        num ：ピクセル数
+ =======================================================================*/
+void TgaKernelExpand8(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+
+		// 16ピクセルずつ
+		for (; i + 16 <= num; i += 16) {
+			__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+			__m128i lo  = _mm_unpacklo_epi8(src, src);
+			__m128i hi  = _mm_unpackhi_epi8(src, src);
+			__m128i *d  = reinterpret_cast<__m128i*>(pDst + i * 4);
+
+			_mm_storeu_si128(d + 0, _mm_or_si128(_mm_srli_epi32(_mm_unpacklo_epi16(lo, lo), 8), alpha));
+			_mm_storeu_si128(d + 1, _mm_or_si128(_mm_srli_epi32(_mm_unpackhi_epi16(lo, lo), 8), alpha));
+			_mm_storeu_si128(d + 2, _mm_or_si128(_mm_srli_epi32(_mm_unpacklo_epi16(hi, hi), 8), alpha));
+			_mm_storeu_si128(d + 3, _mm_or_si128(_mm_srli_epi32(_mm_unpackhi_epi16(hi, hi), 8), alpha));
+		}
+	}
+#endif
+
+	for (; i < num; i++) {
+		uint8 *d = &pDst[i * 4];
+		d[0] = d[1] = d[2] = pSrc[i];
+		d[3] = A_MAX;
+	}
+}
+
+/*=======================================================================
+【機能】16bit(ARGB:1555)を32bit(BGRA)に展開
+【引数】pDst  ：展開先
+        pSrc  ：展開元
+        num   ：ピクセル数
+        bAlpha：アルファを使う？(falseならアルファは255)
+【備考】各色は c * 255 / 31 (切り捨て)で8bitにする。
+        SSE2版は (c * 1053) >> 7 で同じ結果になる。
+ =======================================================================*/
+void TgaKernelExpand16(uint8 *pDst, const uint8 *pSrc, const uint32 num, const bool bAlpha)
+{
+	uint32 i = 0;
+
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i mask5 = _mm_set1_epi16(0x1f);
+		const __m128i mul   = _mm_set1_epi16(1053);
+		const __m128i alpha = bAlpha ? _mm_setzero_si128() : _mm_set1_epi16(static_cast<short>(0xff00));
+
+		// 8ピクセルずつ
+		for (; i + 8 <= num; i += 8) {
+			__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 2));
+			__m128i b = _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(src, mask5), mul), 7);
+			__m128i g = _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(src, 5), mask5), mul), 7);
+			__m128i r = _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(src, 10), mask5), mul), 7);
+			__m128i a = _mm_or_si128(_mm_slli_epi16(_mm_srai_epi16(src, 15), 8), alpha);
+
+			// 16bitの(B,G)と(R,A)を組み合わせて32bitにする
+			__m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+			__m128i ra = _mm_or_si128(r, a);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4 +  0), _mm_unpacklo_epi16(bg, ra));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4 + 16), _mm_unpackhi_epi16(bg, ra));
+		}
+	}
+#endif
+
+	for (; i < num; i++) {
+		uint32 pix = pSrc[i * 2] | (pSrc[i * 2 + 1] << 8);
+		uint8 *d = &pDst[i * 4];
+
+		d[0] = static_cast<uint8>(((pix      ) & 0x1f) * 255 / 31);
+		d[1] = static_cast<uint8>(((pix >>  5) & 0x1f) * 255 / 31);
+		d[2] = static_cast<uint8>(((pix >> 10) & 0x1f) * 255 / 31);
+		d[3] = (!bAlpha || (pix & 0x8000)) ? A_MAX : 0;
+	}
+}
+
+/*=======================================================================
+【機能】24bit(BGR)を32bit(BGRA)に展開
+【引数】pDst：展開先
+        pSrc：展開元
+        num ：ピクセル数
+【備考】アルファは255にします。
+ =======================================================================*/
+void TgaKernelExpand24(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+#ifdef _USE_SSSE3
+	if (s_Level >= TGA_KERNEL_LEVEL_SSSE3) {
+		i = Expand24Ssse3(pDst, pSrc, num);
+	}
+#endif
+
+	for (; i < num; i++) {
+		const uint8 *s = &pSrc[i * 3];
+		uint8 *d = &pDst[i * 4];
+
+		d[0] = s[0];
+		d[1] = s[1];
+		d[2] = s[2];
+		d[3] = A_MAX;
+	}
+}
+
+/*=======================================================================
+【機能】RLE圧縮の展開
+【引数】pDst   ：展開先
+        dstSize：展開先のサイズ(イメージサイズ)
+        pSrc   ：圧縮データ
+        srcSize：圧縮データのサイズ
+        byte   ：1ピクセルのバイト数(1～4)
+【戻値】読み込んだ圧縮データのサイズ(失敗なら0xffffffff)
+【備考】リテラルグループはまとめてコピー、反復はTgaKernelFillで並べる。
+        パケットが展開先を超えるか、圧縮データが足りなければ失敗。
+ =======================================================================*/
+uint32 TgaKernelUnpackRLE(uint8 *pDst, const uint32 dstSize, const uint8 *pSrc, const uint32 srcSize, const uint32 byte)
+{
+	uint32 offset = 0;
+	uint32 count  = 0;
+
+	while (count < dstSize) {
+		if (offset >= srcSize) return static_cast<uint32>(-1);
+
+		const bool   bRepeat = (pSrc[offset] & 0x80) ? true : false;	// 上位ビットが1なら反復
+		const uint32 loop    = (pSrc[offset] & 0x7f) + 1;
+		const uint32 size    = loop * byte;
+		const uint32 data    = bRepeat ? byte : size;
+
+		if (size > dstSize - count || data > srcSize - offset - 1) return static_cast<uint32>(-1);
+
+		if (bRepeat) {
+			TgaKernelFill(&pDst[count], &pSrc[offset + 1], loop, byte);
+		} else {
+			memcpy(&pDst[count], &pSrc[offset + 1], size);
+		}
+
+		offset += 1 + data;
+		count  += size;
+	}
+
+	return offset;
+}
+
+/*=======================================================================
+【機能】1ラインをRLE圧縮
+【引数】pDst：圧縮先(最大でnum×(byte＋1)バイト)
+        pSrc：1ラインのイメージ
+        num ：ピクセル数
+        byte：1ピクセルのバイト数(1～4)
+【戻値】圧縮後のサイズ
+【備考】同じピクセルが続けば反復、それ以外はリテラルグループにする。
+        8bitは2つの反復では縮まないので3つ以上続く場合だけ反復にする。
+        パケットはラインをまたがない(TGA 2.0の推奨)。
+ =======================================================================*/
+uint32 TgaKernelPackRLE(uint8 *pDst, const uint8 *pSrc, const uint32 num, const uint32 byte)
+{
+	const uint32 repeat = (byte == 1) ? 3 : 2;	// 反復にする最小の数
+	uint8 *pWork = pDst;
+	uint32 i = 0;
+
+	while (i < num) {
+		const uint8 *pPixel = &pSrc[i * byte];
+
+		// 同じピクセルが続く数
+		uint32 count = 1;
+		while (i + count < num && count < 128 && memcmp(pPixel, &pPixel[count * byte], byte) == 0) {
+			count++;
+		}
+
+		if (count >= repeat) {
+			// 反復
+			*pWork++ = static_cast<uint8>(0x80 | (count - 1));
+			memcpy(pWork, pPixel, byte);
+			pWork += byte;
+		} else {
+			// リテラルグループ(次に反復にできるところまで)
+			while (i + count < num && count < 128) {
+				const uint8 *p = &pSrc[(i + count) * byte];
+				uint32 same = 1;
+				while (same < repeat && i + count + same < num && memcmp(p, &p[same * byte], byte) == 0) same++;
+				if (same >= repeat) break;
+				count++;
+			}
+			*pWork++ = static_cast<uint8>(count - 1);
+			memcpy(pWork, pPixel, count * byte);
+			pWork += count * byte;
+		}
+
+		i += count;
+	}
+
+	return static_cast<uint32>(pWork - pDst);
+}
+
+/*=======================================================================
+【機能】32bit(BGRA)を乗算済みアルファに変換
+【引数】pDst：変換先(pSrcと同じでも可)
+        pSrc：変換元
+        num ：ピクセル数
+ =======================================================================*/
+void TgaKernelPremultiply32(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+#ifdef _USE_NEON
+	if (s_Level == TGA_KERNEL_LEVEL_NEON) {
+		i = Premultiply32Neon(pDst, pSrc, num);
+	}
+#endif
+#ifdef _USE_AVX512
+	if (s_Level >= TGA_KERNEL_LEVEL_AVX512) {
+		i = Premultiply32Avx512(pDst, pSrc, num);
+	}
+#endif
+#ifdef _USE_AVX2
+	if (s_Level >= TGA_KERNEL_LEVEL_AVX2) {
+		i += Premultiply32Avx2(pDst + i * 4, pSrc + i * 4, num - i);
+	}
+#endif
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i zero  = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi16(128);
+		const __m128i maskA = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+		const __m128i full  = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+		// 4ピクセルずつ処理
+		for (; i + 4 <= num; i += 4) {
+			__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4));
+			__m128i lo  = _mm_unpacklo_epi8(src, zero);
+			__m128i hi  = _mm_unpacklo_epi8(_mm_srli_si128(src, 8), zero);
+
+			// アルファを各色に展開(アルファ自身は255倍で変化させない)
+			__m128i aLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xff), 0xff);
+			__m128i aHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xff), 0xff);
+			aLo = _mm_or_si128(_mm_andnot_si128(maskA, aLo), full);
+			aHi = _mm_or_si128(_mm_andnot_si128(maskA, aHi), full);
+
+			// t = c * a + 128, (t + (t >> 8)) >> 8
+			lo = _mm_add_epi16(_mm_mullo_epi16(lo, aLo), round);
+			hi = _mm_add_epi16(_mm_mullo_epi16(hi, aHi), round);
+			lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+			hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_packus_epi16(lo, hi));
+		}
+	}
+#endif
+
+	for (; i < num; i++) {
+		const uint8 *s = &pSrc[i * 4];
+		uint8 *d = &pDst[i * 4];
+		uint8 a = s[3];
+
+		d[0] = MulDiv255(s[0], a);
+		d[1] = MulDiv255(s[1], a);
+		d[2] = MulDiv255(s[2], a);
+		d[3] = a;
+	}
+}
+
+/*=======================================================================
+【機能】32bit(BGRA)の乗算済みアルファを元に戻す
+【引数】pDst：変換先(pSrcと同じでも可)
+        pSrc：変換元
+        num ：ピクセル数
+【備考】アルファが0のピクセルは色も0になります。
+ =======================================================================*/
+void TgaKernelUnpremultiply32(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i zero  = _mm_setzero_si128();
+		const __m128i maskA = _mm_set_epi32(-1, 0, 0, 0);
+		const __m128  f255  = _mm_set1_ps(255.0f);
+		const __m128  fzero = _mm_setzero_ps();
+
+		// 1ピクセルを4要素のfloatで処理
+		// (c * 255 + a / 2) / a は2^24未満なので、floatの除算でも切り捨て結果は整数演算と一致する
+		for (; i + 4 <= num; i += 4) {
+			__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4));
+			__m128i w16[2];
+			__m128i w32[4];
+
+			w16[0] = _mm_unpacklo_epi8(src, zero);
+			w16[1] = _mm_unpackhi_epi8(src, zero);
+			w32[0] = _mm_unpacklo_epi16(w16[0], zero);
+			w32[1] = _mm_unpackhi_epi16(w16[0], zero);
+			w32[2] = _mm_unpacklo_epi16(w16[1], zero);
+			w32[3] = _mm_unpackhi_epi16(w16[1], zero);
+
+			for (int j = 0; j < 4; j++) {
+				__m128i ai = _mm_shuffle_epi32(w32[j], 0xff);
+				__m128  a  = _mm_cvtepi32_ps(ai);
+				__m128  c  = _mm_cvtepi32_ps(w32[j]);
+				__m128  t  = _mm_add_ps(_mm_mul_ps(c, f255), _mm_cvtepi32_ps(_mm_srli_epi32(ai, 1)));
+
+				// a == 0 なら 0 にする
+				__m128 mask = _mm_cmpneq_ps(a, fzero);
+				t = _mm_and_ps(_mm_div_ps(t, _mm_or_ps(a, _mm_andnot_ps(mask, f255))), mask);
+				t = _mm_min_ps(t, f255);
+
+				// アルファは元の値を使う
+				__m128i v = _mm_cvttps_epi32(t);
+				w32[j] = _mm_or_si128(_mm_andnot_si128(maskA, v), _mm_and_si128(maskA, w32[j]));
+			}
+
+			w16[0] = _mm_packs_epi32(w32[0], w32[1]);
+			w16[1] = _mm_packs_epi32(w32[2], w32[3]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_packus_epi16(w16[0], w16[1]));
+		}
+	}
+#endif
+
+	for (; i < num; i++) {
+		const uint8 *s = &pSrc[i * 4];
+		uint8 *d = &pDst[i * 4];
+		uint8 a = s[3];
+
+		if (a == 0) {
+			d[0] = d[1] = d[2] = 0;
+		} else {
+			d[0] = DivMul255(s[0], a);
+			d[1] = DivMul255(s[1], a);
+			d[2] = DivMul255(s[2], a);
+		}
+		d[3] = a;
+	}
+}
+
+/*=======================================================================
+【機能】16bit(ARGB:1555)を乗算済みアルファに変換
+【引数】pDst：変換先(pSrcと同じでも可)
+        pSrc：変換元
+        num ：ピクセル数
+【備考】アルファが1bitなので、アルファ0のピクセルの色を0にするだけです。
+        元に戻す処理は存在しません(アルファ1のピクセルは変化しないため)。
+ =======================================================================*/
+void TgaKernelPremultiply16(uint8 *pDst, const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		// 8ピクセルずつ処理
+		for (; i + 8 <= num; i += 8) {
+			__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 2));
+			__m128i msk = _mm_srai_epi16(src, 15);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 2), _mm_and_si128(src, msk));
+		}
+	}
+#endif
+
+	for (; i < num; i++) {
+		uint16 pix = static_cast<uint16>(pSrc[i * 2] | (pSrc[i * 2 + 1] << 8));
+		if ((pix & 0x8000) == 0) pix = 0;
+		pDst[i * 2 + 0] = static_cast<uint8>(pix);
+		pDst[i * 2 + 1] = static_cast<uint8>(pix >> 8);
+	}
+}
+
+/*=======================================================================
+【機能】32bit(BGRA)でアルファが0ではない最初のピクセルを探す
+【引数】pSrc：検索元
+        num ：ピクセル数
+【戻値】見つかった位置(見つからない場合はnum)
+ =======================================================================*/
+uint32 TgaKernelFindAlpha32(const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+
+#ifdef _USE_NEON
+	if (s_Level == TGA_KERNEL_LEVEL_NEON) {
+		i = FindAlpha32Neon(pSrc, num);
+	}
+#endif
+#ifdef _USE_AVX512
+	if (s_Level >= TGA_KERNEL_LEVEL_AVX512) {
+		i = FindAlpha32Avx512(pSrc, num);
+	}
+#endif
+#ifdef _USE_AVX2
+	if (s_Level >= TGA_KERNEL_LEVEL_AVX2) {
+		i += FindAlpha32Avx2(pSrc + i * 4, num - i);
+	}
+#endif
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i zero  = _mm_setzero_si128();
+		const __m128i maskA = _mm_set1_epi32(static_cast<int>(0xff000000));
+
+		// 4ピクセルずつ、全部アルファ0なら読み飛ばす
+		for (; i + 4 <= num; i += 4) {
+			__m128i src = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4)), maskA);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(src, zero)) != 0xffff) break;
+		}
+	}
+#endif
+
+	for (; i < num; i++) {
+		if (pSrc[i * 4 + 3] != 0) return i;
+	}
+
+	return num;
+}
+
+/*=======================================================================
+【機能】32bit(BGRA)でアルファが0ではない最後のピクセルを探す
+【引数】pSrc：検索元
+        num ：ピクセル数
+【戻値】見つかった位置+1(見つからない場合は0)
+ =======================================================================*/
+uint32 TgaKernelFindAlphaLast32(const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = num;
+
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i zero  = _mm_setzero_si128();
+		const __m128i maskA = _mm_set1_epi32(static_cast<int>(0xff000000));
+
+		// 後ろから4ピクセルずつ、全部アルファ0なら読み飛ばす
+		for (; i >= 4; i -= 4) {
+			__m128i src = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + (i - 4) * 4)), maskA);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(src, zero)) != 0xffff) break;
+		}
+	}
+#endif
+
+	for (; i > 0; i--) {
+		if (pSrc[(i - 1) * 4 + 3] != 0) return i;
+	}
+
+	return 0;
+}
+
+/*=======================================================================
+【機能】32bit(BGRA)の比較
+【引数】pSrc0：比較元
+        pSrc1：比較先
+        num  ：ピクセル数
+        pMax ：チャンネルごとの最大差(4個、大きければ更新)
+        pSum ：チャンネルごとの差の2乗の合計(4個、加算)
+        pHeat：ピクセルごとの最大差の格納先(NULLなら格納しない)
+【戻値】一致しないピクセル数
+ =======================================================================*/
+uint32 TgaKernelCompare32(const uint8 *pSrc0, const uint8 *pSrc1, const uint32 num, uint32 *pMax, uint64 *pSum, uint8 *pHeat)
+{
+	uint32 i = 0;
+	uint32 count = 0;
+
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i zero  = _mm_setzero_si128();
+		const __m128i maskB = _mm_set1_epi32(0xff);
+		__m128i vmax = zero;
+
+		while (i + 4 <= num) {
+			// 32bitの合計があふれないように区切って64bitに足す
+			// (1回で1チャンネルあたり最大4×255^2なので、4096回ならあふれない)
+			uint32 end = i + 4 * 4096;
+			if (end > num) end = num;
+
+			__m128i vsum = zero;
+
+			for (; i + 4 <= end; i += 4) {
+				__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc0 + i * 4));
+				__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc1 + i * 4));
+				__m128i d = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+
+				vmax = _mm_max_epu8(vmax, d);
+
+				// 一致しないピクセル数
+				__m128i eq = _mm_cmpeq_epi32(a, b);
+				sint32 mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+				count += 4 - ((mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1));
+
+				// 差の2乗(チャンネルごとに32bitで合計)
+				__m128i lo = _mm_unpacklo_epi8(d, zero);
+				__m128i hi = _mm_unpackhi_epi8(d, zero);
+				lo = _mm_mullo_epi16(lo, lo);
+				hi = _mm_mullo_epi16(hi, hi);
+				vsum = _mm_add_epi32(vsum, _mm_add_epi32(_mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero)));
+				vsum = _mm_add_epi32(vsum, _mm_add_epi32(_mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)));
+
+				// ピクセルごとの最大差
+				if (pHeat != NULL) {
+					__m128i m = _mm_max_epu8(d, _mm_srli_epi32(d, 8));
+					m = _mm_and_si128(_mm_max_epu8(m, _mm_srli_epi32(m, 16)), maskB);
+					m = _mm_packs_epi32(m, m);
+					m = _mm_packus_epi16(m, m);
+					sint32 heat = _mm_cvtsi128_si32(m);
+					memcpy(pHeat + i, &heat, sizeof(heat));
+				}
+			}
+
+			uint32 sum[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(sum), vsum);
+			for (sint32 c = 0; c < 4; c++) pSum[c] += sum[c];
+		}
+
+		uint8 max[16];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(max), vmax);
+		for (sint32 j = 0; j < 16; j++) {
+			if (max[j] > pMax[j & 3]) pMax[j & 3] = max[j];
+		}
+	}
+#endif
+
+	for (; i < num; i++) {
+		const uint8 *a = &pSrc0[i * 4];
+		const uint8 *b = &pSrc1[i * 4];
+		uint32 heat = 0;
+
+		for (sint32 c = 0; c < 4; c++) {
+			uint32 d = (a[c] > b[c]) ? (a[c] - b[c]) : (b[c] - a[c]);
+			if (d > pMax[c]) pMax[c] = d;
+			if (d > heat) heat = d;
+			pSum[c] += d * d;
+		}
+		if (heat != 0) count++;
+		if (pHeat != NULL) pHeat[i] = static_cast<uint8>(heat);
+	}
+
+	return count;
+}
+
+/*=======================================================================
+【機能】5bitから展開した値か(TgaKernelExpand16と同じ c * 255 / 31 の値)
+【備考】非公開
+        (c * 31 + 127) / 255 で5bitに戻し、展開し直して一致するか調べる。
+ =======================================================================*/
+static MTOINLINE bool Is5Bit(const uint32 c)
+{
+	const uint32 v = (c * 31 + 127) / 255;
+	return (v * 255 / 31 == c);
+}
+
+/*=======================================================================
+【機能】32bit(BGRA)の解析
+【引数】pSrc：解析元
+        num ：ピクセル数
+【戻値】すべてのピクセルで成り立つ性質(TGA_KERNEL_ANALYZE_*)
+【備考】保存形式を決めるためのもの。1回読むだけで全部調べます。
+ =======================================================================*/
+uint32 TgaKernelAnalyze32(const uint8 *pSrc, const uint32 num)
+{
+	uint32 i = 0;
+	uint32 flag = TGA_KERNEL_ANALYZE_ALL;
+
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i zero  = _mm_setzero_si128();
+		const __m128i maskA = _mm_set1_epi32(static_cast<int>(0xff000000));
+		const __m128i maskG = _mm_set1_epi32(0xffff);
+		const __m128i c31   = _mm_set1_epi16(31);
+		const __m128i c127  = _mm_set1_epi16(127);
+		const __m128i div   = _mm_set1_epi16(static_cast<short>(8225));	// (x * 8225) >> 21 = x / 255
+		const __m128i mul   = _mm_set1_epi16(1053);						// (v * 1053) >> 7 = v * 255 / 31
+		const __m128i skipA = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);	// アルファは調べない
+		__m128i opaque = _mm_set1_epi32(-1);
+		__m128i binary = opaque;
+		__m128i gray   = opaque;
+		__m128i bit5   = opaque;
+
+		for (; i + 4 <= num; i += 4) {
+			const __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4));
+			const __m128i a   = _mm_and_si128(src, maskA);
+
+			opaque = _mm_and_si128(opaque, src);
+			binary = _mm_and_si128(binary, _mm_or_si128(_mm_cmpeq_epi32(a, zero), _mm_cmpeq_epi32(a, maskA)));
+
+			// B^G、G^Rが0
+			gray = _mm_and_si128(gray, _mm_cmpeq_epi32(_mm_and_si128(_mm_xor_si128(src, _mm_srli_epi32(src, 8)), maskG), zero));
+
+			// 5bitに戻して展開し直す
+			const __m128i lo = _mm_unpacklo_epi8(src, zero);
+			const __m128i hi = _mm_unpackhi_epi8(src, zero);
+			__m128i vlo = _mm_srli_epi16(_mm_mulhi_epu16(_mm_add_epi16(_mm_mullo_epi16(lo, c31), c127), div), 5);
+			__m128i vhi = _mm_srli_epi16(_mm_mulhi_epu16(_mm_add_epi16(_mm_mullo_epi16(hi, c31), c127), div), 5);
+			vlo = _mm_srli_epi16(_mm_mullo_epi16(vlo, mul), 7);
+			vhi = _mm_srli_epi16(_mm_mullo_epi16(vhi, mul), 7);
+			bit5 = _mm_and_si128(bit5, _mm_or_si128(_mm_and_si128(_mm_cmpeq_epi16(vlo, lo), _mm_cmpeq_epi16(vhi, hi)), skipA));
+		}
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(opaque, maskA), maskA)) != 0xffff) flag &= ~TGA_KERNEL_ANALYZE_OPAQUE;
+		if (_mm_movemask_epi8(binary) != 0xffff) flag &= ~TGA_KERNEL_ANALYZE_BINARY;
+		if (_mm_movemask_epi8(gray)   != 0xffff) flag &= ~TGA_KERNEL_ANALYZE_GRAY;
+		if (_mm_movemask_epi8(bit5)   != 0xffff) flag &= ~TGA_KERNEL_ANALYZE_5BIT;
+	}
+#endif
+
+	for (; i < num && flag != 0; i++) {
+		const uint8 *p = &pSrc[i * 4];
+
+		if (p[3] != 255) flag &= ~TGA_KERNEL_ANALYZE_OPAQUE;
+		if (p[3] != 0 && p[3] != 255) flag &= ~TGA_KERNEL_ANALYZE_BINARY;
+		if (p[0] != p[1] || p[1] != p[2]) flag &= ~TGA_KERNEL_ANALYZE_GRAY;
+		if (!Is5Bit(p[0]) || !Is5Bit(p[1]) || !Is5Bit(p[2])) flag &= ~TGA_KERNEL_ANALYZE_5BIT;
+	}
+
+	return flag;
+}
+
+/*=======================================================================
+【機能】64bitの読み込み/ローテート/攪拌
+【備考】非公開
+ =======================================================================*/
+static MTOINLINE uint64 HashRead64(const uint8 *p)
+{
+	uint64 n;
+	memcpy(&n, p, sizeof(n));
+	return n;
+}
+
+static MTOINLINE uint64 HashRotl64(const uint64 n, const uint32 r)
+{
+	return (n << r) | (n >> (64 - r));
+}
+
+static MTOINLINE uint64 HashAvalanche(uint64 h)
+{
+	h ^= h >> 33;
+	h *= HASH_PRIME2;
+	h ^= h >> 29;
+	h *= HASH_PRIME3;
+	h ^= h >> 32;
+	return h;
+}
+
+/*=======================================================================
+【機能】64バイト分をアキュムレータに足し込む
+【引数】pAcc：アキュムレータ(8個)
+        pSrc：データ(64バイト)
+        pKey：鍵(8個)
+【備考】非公開
+        acc[i ^ 1] += data[i]、acc[i] += 下位32bit(data ^ key) × 上位32bit(data ^ key)
+        SSE2版と通常版は同じ結果になります。
+ =======================================================================*/
+static MTOINLINE void HashStripe(uint64 *pAcc, const uint8 *pSrc, const uint64 *pKey)
+{
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		for (sint32 i = 0; i < 4; i++) {
+			__m128i acc  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pAcc[i * 2]));
+			__m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSrc[i * 16]));
+			__m128i key  = _mm_xor_si128(data, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pKey[i * 2])));
+			__m128i prod = _mm_mul_epu32(key, _mm_shuffle_epi32(key, 0xb1));
+
+			acc = _mm_add_epi64(acc, _mm_shuffle_epi32(data, 0x4e));
+			acc = _mm_add_epi64(acc, prod);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&pAcc[i * 2]), acc);
+		}
+		return;
+	}
+#endif
+
+	for (sint32 i = 0; i < 8; i++) {
+		uint64 data = HashRead64(&pSrc[i * 8]);
+		uint64 key  = data ^ pKey[i];
+
+		pAcc[i ^ 1] += data;
+		pAcc[i]     += (key & 0xffffffff) * (key >> 32);
+	}
+}
+
+/*=======================================================================
+【機能】アキュムレータの攪拌
+【引数】pAcc：アキュムレータ(8個)
+        pKey：鍵(8個)
+【備考】非公開
+ =======================================================================*/
+static MTOINLINE void HashScramble(uint64 *pAcc, const uint64 *pKey)
+{
+#ifdef _USE_SSE2
+	if (s_Level >= TGA_KERNEL_LEVEL_SSE2) {
+		const __m128i prime = _mm_set1_epi32(static_cast<int>(HASH_PRIME4));
+
+		for (sint32 i = 0; i < 4; i++) {
+			__m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pAcc[i * 2]));
+			acc = _mm_xor_si128(acc, _mm_srli_epi64(acc, 47));
+			acc = _mm_xor_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pKey[i * 2])));
+
+			// 64bit × 32bit
+			__m128i lo = _mm_mul_epu32(acc, prime);
+			__m128i hi = _mm_mul_epu32(_mm_srli_epi64(acc, 32), prime);
+			acc = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&pAcc[i * 2]), acc);
+		}
+		return;
+	}
+#endif
+
+	for (sint32 i = 0; i < 8; i++) {
+		uint64 acc = pAcc[i];
+		acc ^= acc >> 47;
+		acc ^= pKey[i];
+		pAcc[i] = acc * HASH_PRIME4;
+	}
+}
+
+/*=======================================================================
+【機能】64bitハッシュ
+【引数】pSrc：データ
+        size：バイト数
+        seed：シード
+【戻値】ハッシュ値
+【備考】64バイト単位で8個のアキュムレータに足し込むxxHash(XXH3)系の方式。
+        互換性はありませんが、SSE2の有無に関係なく同じ値になります。
+ =======================================================================*/
+uint64 TgaKernelHash64(const void *pSrc, const uint32 size, const uint64 seed)
+{
+	const uint8 *p = static_cast<const uint8*>(pSrc);
+	uint64 acc[8];
+
+	for (sint32 i = 0; i < 8; i++) {
+		acc[i] = HashKey[i] + seed;
+	}
+
+	// 64バイト単位
+	uint32 stripe = 0;
+	uint32 offset = 0;
+
+	for (; offset + HASH_STRIPE <= size; offset += HASH_STRIPE) {
+		HashStripe(acc, &p[offset], &HashKey[stripe]);
+		if (++stripe == HASH_BLOCK) {
+			HashScramble(acc, &HashKey[HASH_BLOCK]);
+			stripe = 0;
+		}
+	}
+
+	// 残りは0で埋めて処理
+	if (offset < size) {
+		uint8 last[HASH_STRIPE];
+		memset(last, 0, sizeof(last));
+		memcpy(last, &p[offset], size - offset);
+		HashStripe(acc, last, &HashKey[stripe]);
+	}
+
+	// まとめる
+	uint64 h = size * HASH_PRIME1 + seed;
+	for (sint32 i = 0; i < 8; i++) {
+		h ^= HashAvalanche(acc[i] * HASH_PRIME2);
+		h  = HashRotl64(h, 27) * HASH_PRIME1 + HASH_PRIME3;
+	}
+
+	return HashAvalanche(h);
+}
@@ -0,0 +1,96 @@
+/*=============================================================================
+ * TGAのピクセル処理カーネル
+ * CTgaの各処理から呼ばれる、ループの重い部分だけを集めたもの。
+ * 起動時にCPUが対応している命令セットを調べて、使える中で一番速い版で
+ * 処理します。x86/x64では"sse2"、"ssse3"、"avx2"、"avx512"、ARMでは"neon"が
+ * あり、環境変数TGA_SIMDに名前("none"も可)を指定すると、それ以下の命令セットに
+ * 制限できます(速度の比較やテスト用)。
+ * C版(tga.c)とC++版(CTga)で同じものを使うので、関数はCのリンケージです。
+ * C版のMakefileで静的ライブラリ(libtgakernel.a)と共有ライブラリ(libtgakernel.so)を作成します。
+ * mto_common.hがなくても使えるように、必要な型はここでも定義します。
+=============================================================================*/
+#ifndef _TGA_KERNEL_H_
+#define _TGA_KERNEL_H_
+
+// 整数型(mto_common.hと同じ定義、先にインクルードされていればそちらを使う)
+#ifndef _MTO_COMMON_H_
+typedef unsigned long long		uint64;
+typedef unsigned int			uint32;
+typedef signed int				sint32;
+typedef unsigned short			uint16;
+typedef unsigned char			uint8;
+
+#if !defined(__cplusplus)
+#include <stdbool.h>
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 命令セット(x86はSSE2～AVX512の順に上位が下位を含む、NEONはARMだけ)
+enum {
+	TGA_KERNEL_LEVEL_NONE = 0,		// 通常版
+	TGA_KERNEL_LEVEL_SSE2,
+	TGA_KERNEL_LEVEL_SSSE3,
+	TGA_KERNEL_LEVEL_AVX2,
+	TGA_KERNEL_LEVEL_AVX512,		// AVX-512FとAVX-512BW
+	TGA_KERNEL_LEVEL_NEON,
+	TGA_KERNEL_LEVEL_MAX
+};
+
+sint32 TgaKernelGetLevel(void);
+sint32 TgaKernelGetSupportLevel(void);
+sint32 TgaKernelSetLevel(const sint32 level);
+const char *TgaKernelGetLevelName(const sint32 level);
+
+// 並び替え
+void TgaKernelSwapRB32(uint8 *pDst, const uint8 *pSrc, const uint32 num);
+void TgaKernelSwapRB24(uint8 *pDst, const uint8 *pSrc, const uint32 num);
+void TgaKernelSwapRB16(uint8 *pDst, const uint8 *pSrc, const uint32 num);
+void TgaKernelReverse(uint8 *pDst, const uint8 *pSrc, const uint32 num, const uint32 byte);
+void TgaKernelTranspose(uint8 *pDst, const sint32 dstPitch, const uint8 *pSrc, const sint32 srcPitch, const uint32 w, const uint32 h, const uint32 byte);
+
+// 展開
+void TgaKernelFill(uint8 *pDst, const uint8 *pPixel, const uint32 num, const uint32 byte);
+void TgaKernelExpand8(uint8 *pDst, const uint8 *pSrc, const uint32 num);
+void TgaKernelExpand16(uint8 *pDst, const uint8 *pSrc, const uint32 num, const bool bAlpha);
+void TgaKernelExpand24(uint8 *pDst, const uint8 *pSrc, const uint32 num);
+
+// RLE圧縮、展開
+uint32 TgaKernelUnpackRLE(uint8 *pDst, const uint32 dstSize, const uint8 *pSrc, const uint32 srcSize, const uint32 byte);
+uint32 TgaKernelPackRLE(uint8 *pDst, const uint8 *pSrc, const uint32 num, const uint32 byte);
+
+// 乗算済みアルファ変換
+void TgaKernelPremultiply32(uint8 *pDst, const uint8 *pSrc, const uint32 num);
+void TgaKernelUnpremultiply32(uint8 *pDst, const uint8 *pSrc, const uint32 num);
+void TgaKernelPremultiply16(uint8 *pDst, const uint8 *pSrc, const uint32 num);
+
+// アルファの検索
+uint32 TgaKernelFindAlpha32(const uint8 *pSrc, const uint32 num);
+uint32 TgaKernelFindAlphaLast32(const uint8 *pSrc, const uint32 num);
+
+// 比較
+uint32 TgaKernelCompare32(const uint8 *pSrc0, const uint8 *pSrc1, const uint32 num, uint32 *pMax, uint64 *pSum, uint8 *pHeat);
+
+// 解析(TgaKernelAnalyze32の戻値、すべてのピクセルで成り立つもの)
+enum {
+	TGA_KERNEL_ANALYZE_OPAQUE = 0x01,	// アルファが255
+	TGA_KERNEL_ANALYZE_BINARY = 0x02,	// アルファが0か255
+	TGA_KERNEL_ANALYZE_GRAY   = 0x04,	// B=G=R
+	TGA_KERNEL_ANALYZE_5BIT   = 0x08,	// BGRが5bitから展開した値(16bitにしても変わらない)
+	TGA_KERNEL_ANALYZE_ALL    = 0x0f
+};
+
+uint32 TgaKernelAnalyze32(const uint8 *pSrc, const uint32 num);
+
+
+// ハッシュ
+uint64 TgaKernelHash64(const void *pSrc, const uint32 size, const uint64 seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif